@@ -0,0 +1,782 @@
+#include <iostream>
+#include <atomic>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define ATL_HAVE_IO_URING
+#endif
+#endif
+
+#include <AsyncWriter.h>
+#include <BaseContainer.h>
+#include <FileIO.h>
+
+namespace atl
+{
+   /**
+    * \brief One queued write
+    **/
+   struct AsyncWriter::Request
+   {
+      int                  m_fd = -1;                //!< Destination descriptor
+      uint64_t             m_offset = 0;             //!< File offset of the first pending byte
+      struct iovec         m_iov[2];                 //!< Pending data
+      int                  m_iovCount = 0;           //!< Number of pending iovec entries
+      int                  m_bufferIndex = -1;       //!< Registered buffer index (-1 if not registered)
+      ssize_t              m_written = 0;            //!< Bytes written so far
+      std::vector<uint8_t> m_header;                 //!< Encoded chunk header
+      BaseBuffer           m_buffer;                 //!< Keeps the payload alive
+      AsyncWriteCallback   m_callback;               //!< Completion callback
+   };
+
+   /**
+    * \brief Removes the given number of written bytes from the front of a request
+    **/
+   static void advanceRequest( struct iovec * iov, int & count, size_t bytes )
+   {
+      while(( count > 0 )&&( bytes >= iov[0].iov_len )) {
+         bytes -= iov[0].iov_len;
+         iov[0] = iov[1];
+         count--;
+      }
+
+      if( count > 0 ) {
+         iov[0].iov_base = (uint8_t *)iov[0].iov_base + bytes;
+         iov[0].iov_len -= bytes;
+      }
+   }
+
+#ifdef ATL_HAVE_IO_URING
+   static int ioUringSetup( unsigned entries, struct io_uring_params * params )
+   {
+      return (int)syscall( __NR_io_uring_setup, entries, params );
+   }
+
+   static int ioUringEnter( int fd, unsigned toSubmit, unsigned minComplete, unsigned flags )
+   {
+      return (int)syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0 );
+   }
+
+   static int ioUringRegister( int fd, unsigned opcode, const void * arg, unsigned count )
+   {
+      return (int)syscall( __NR_io_uring_register, fd, opcode, arg, count );
+   }
+
+   /**
+    * \brief Memory mapped submission and completion rings of an io_uring instance
+    **/
+   struct AsyncWriter::Ring
+   {
+      int                   m_fd       = -1;         //!< io_uring descriptor
+      uint8_t             * m_sq       = NULL;       //!< Submission ring mapping
+      size_t                m_sqBytes  = 0;          //!< Size of the submission ring mapping
+      uint8_t             * m_cq       = NULL;       //!< Completion ring mapping
+      size_t                m_cqBytes  = 0;          //!< Size of the completion ring mapping
+      struct io_uring_sqe * m_sqes     = NULL;       //!< Submission queue entries
+      size_t                m_sqeBytes = 0;          //!< Size of the entry mapping
+      unsigned            * m_sqHead   = NULL;       //!< Submission ring head (kernel)
+      unsigned            * m_sqTail   = NULL;       //!< Submission ring tail (writer)
+      unsigned            * m_sqMask   = NULL;       //!< Submission ring mask
+      unsigned            * m_sqArray  = NULL;       //!< Submission index array
+      unsigned            * m_cqHead   = NULL;       //!< Completion ring head (writer)
+      unsigned            * m_cqTail   = NULL;       //!< Completion ring tail (kernel)
+      unsigned            * m_cqMask   = NULL;       //!< Completion ring mask
+      struct io_uring_cqe * m_cqes     = NULL;       //!< Completion queue entries
+
+      ~Ring() { release(); }
+
+      /**
+       * \brief Creates the io_uring instance and maps its rings
+       * \param [in] entries minimum number of submission entries
+       * \return true on success, false if io_uring is not available
+       **/
+      bool setup( unsigned entries )
+      {
+         struct io_uring_params params;
+         memset( &params, 0, sizeof(params));
+         m_fd = ioUringSetup( entries, &params );
+         if( m_fd < 0 ) {
+            return false;
+         }
+
+         m_sqBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+         m_cqBytes = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+         bool single = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+         if( single ) {
+            m_sqBytes = m_cqBytes = ( m_sqBytes > m_cqBytes ) ? m_sqBytes : m_cqBytes;
+         }
+
+         void * sq = mmap( NULL, m_sqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+         if( sq == MAP_FAILED ) {
+            release();
+            return false;
+         }
+         m_sq = (uint8_t *)sq;
+
+         if( single ) {
+            m_cq = m_sq;
+         }
+         else {
+            void * cq = mmap( NULL, m_cqBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING );
+            if( cq == MAP_FAILED ) {
+               release();
+               return false;
+            }
+            m_cq = (uint8_t *)cq;
+         }
+
+         m_sqeBytes = params.sq_entries * sizeof(struct io_uring_sqe);
+         void * sqes = mmap( NULL, m_sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+         if( sqes == MAP_FAILED ) {
+            release();
+            return false;
+         }
+         m_sqes = (struct io_uring_sqe *)sqes;
+
+         m_sqHead  = (unsigned *)( m_sq + params.sq_off.head );
+         m_sqTail  = (unsigned *)( m_sq + params.sq_off.tail );
+         m_sqMask  = (unsigned *)( m_sq + params.sq_off.ring_mask );
+         m_sqArray = (unsigned *)( m_sq + params.sq_off.array );
+         m_cqHead  = (unsigned *)( m_cq + params.cq_off.head );
+         m_cqTail  = (unsigned *)( m_cq + params.cq_off.tail );
+         m_cqMask  = (unsigned *)( m_cq + params.cq_off.ring_mask );
+         m_cqes    = (struct io_uring_cqe *)( m_cq + params.cq_off.cqes );
+
+         return true;
+      }
+
+      /**
+       * \brief Unmaps the rings and closes the instance
+       **/
+      void release()
+      {
+         if( m_sqes != NULL ) {
+            munmap( m_sqes, m_sqeBytes );
+         }
+         if(( m_cq != NULL )&&( m_cq != m_sq )) {
+            munmap( m_cq, m_cqBytes );
+         }
+         if( m_sq != NULL ) {
+            munmap( m_sq, m_sqBytes );
+         }
+         if( m_fd >= 0 ) {
+            ::close( m_fd );
+         }
+
+         m_sq   = NULL;
+         m_cq   = NULL;
+         m_sqes = NULL;
+         m_fd   = -1;
+      }
+
+      /**
+       * \brief Returns the number of queued entries the kernel has not consumed yet
+       **/
+      unsigned getPending()
+      {
+         return __atomic_load_n( m_sqTail, __ATOMIC_ACQUIRE ) - __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE );
+      }
+
+      /**
+       * \brief Submits the queued entries to the kernel
+       * \return 1 if they were submitted, 0 if the kernel is busy and the call must be repeated
+       *
+       * On other errors the entries stay queued for the next submission.
+       **/
+      int flush()
+      {
+         while( ioUringEnter( m_fd, getPending(), 0, 0 ) < 0 ) {
+            if(( errno == EAGAIN )||( errno == EBUSY )) {
+               return 0;
+            }
+            if( errno != EINTR ) {
+               std::cerr << "AsyncWriter: io_uring_enter failed: "<<strerror(errno)<<std::endl;
+               return 1;
+            }
+         }
+         return 1;
+      }
+
+      /**
+       * \brief Queues one entry and submits it to the kernel
+       * \return 1 if it was submitted, 0 if the kernel is busy and flush must be
+       *         repeated, -1 if the kernel rejected the submission
+       **/
+      int push( uint8_t opcode, int fd, uint64_t addr, uint32_t length, uint64_t offset, int bufferIndex, uint64_t userData )
+      {
+         unsigned tail  = *m_sqTail;
+         unsigned index = tail & *m_sqMask;
+
+         struct io_uring_sqe * sqe = &m_sqes[index];
+         memset( sqe, 0, sizeof(*sqe));
+         sqe->opcode    = opcode;
+         sqe->fd        = fd;
+         sqe->addr      = addr;
+         sqe->len       = length;
+         sqe->off       = offset;
+         sqe->user_data = userData;
+         if( bufferIndex >= 0 ) {
+            sqe->buf_index = bufferIndex;
+         }
+
+         m_sqArray[index] = index;
+         __atomic_store_n( m_sqTail, tail + 1, __ATOMIC_RELEASE );
+
+         while( ioUringEnter( m_fd, getPending(), 0, 0 ) < 0 ) {
+            if(( errno == EAGAIN )||( errno == EBUSY )) {
+               return 0;
+            }
+            if( errno != EINTR ) {
+               std::cerr << "AsyncWriter: io_uring_enter failed: "<<strerror(errno)<<std::endl;
+
+               //Withdraw the entry if the kernel has not consumed it
+               if( __atomic_load_n( m_sqHead, __ATOMIC_ACQUIRE ) == tail ) {
+                  __atomic_store_n( m_sqTail, tail, __ATOMIC_RELEASE );
+                  return -1;
+               }
+               return 1;
+            }
+         }
+
+         return 1;
+      }
+   };
+#else
+   struct AsyncWriter::Ring
+   {
+   };
+#endif
+
+   AsyncWriter::AsyncWriter()
+   {
+   }
+
+   /**
+    * \brief Destructor. Waits for pending writes and releases the backend
+    **/
+   AsyncWriter::~AsyncWriter()
+   {
+      close();
+   }
+
+   /**
+    * \brief Returns true if the kernel allows io_uring instances to be created
+    **/
+   bool AsyncWriter::isIoUringSupported()
+   {
+#ifdef ATL_HAVE_IO_URING
+      static const bool supported = []() {
+         Ring ring;
+         return ring.setup( 1 );
+      }();
+      return supported;
+#else
+      return false;
+#endif
+   }
+
+   /**
+    * \brief Starts the backend
+    *
+    * \param [in] depth maximum number of writes in flight
+    * \param [in] backend backend to use (default = AUTO)
+    * \param [in] pool buffers to register with io_uring (default = NULL)
+    * \return true on success, false on failure
+    **/
+   bool AsyncWriter::open( size_t depth, Backend backend, BufferPool * pool )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( m_open ) {
+         std::cerr << "AsyncWriter: writer is already open"<<std::endl;
+         return false;
+      }
+      if( depth == 0 ) {
+         std::cerr << "AsyncWriter: depth must be non-zero"<<std::endl;
+         return false;
+      }
+
+      m_depth    = depth;
+      m_inFlight = 0;
+
+#ifdef ATL_HAVE_IO_URING
+      if( backend != THREAD_POOL ) {
+         std::unique_ptr<Ring> ring( new Ring );
+         if( ring->setup( depth )) {
+            m_ring.swap( ring );
+            m_backend = IO_URING;
+
+            //Registration is an optimization. Writes still work if it fails
+            if(( pool != NULL )&&( pool->getCount() > 0 )) {
+               std::vector<struct iovec> iov( pool->getCount());
+               for( size_t i = 0; i < iov.size(); i++ ) {
+                  iov[i].iov_base = pool->getStorage() + i * pool->getBufferSize();
+                  iov[i].iov_len  = pool->getBufferSize();
+               }
+               if( ioUringRegister( m_ring->m_fd, IORING_REGISTER_BUFFERS, iov.data(), iov.size()) == 0 ) {
+                  m_pool       = *pool;
+                  m_registered = true;
+               }
+               else {
+                  std::cerr << "AsyncWriter: unable to register buffers: "<<strerror(errno)<<std::endl;
+               }
+            }
+
+            m_reaper = std::thread( &AsyncWriter::reapLoop, this );
+            m_open   = true;
+            return true;
+         }
+      }
+#endif
+
+      if( backend == IO_URING ) {
+         std::cerr << "AsyncWriter: io_uring is not available"<<std::endl;
+         return false;
+      }
+
+      m_backend = THREAD_POOL;
+      m_threads.reset( new AThreadPool( depth ));
+      m_open = true;
+
+      return true;
+   }
+
+   /**
+    * \brief Waits for pending writes and stops the backend
+    **/
+   void AsyncWriter::close()
+   {
+      {
+         std::lock_guard<std::mutex> guard( m_mutex );
+         if( !m_open ) {
+            return;
+         }
+      }
+
+      wait();
+
+      std::unique_lock<std::mutex> lock( m_mutex );
+      m_open = false;
+
+#ifdef ATL_HAVE_IO_URING
+      if( m_ring ) {
+         //A no-op with no request attached stops the completion thread
+         int rc = m_ring->push( IORING_OP_NOP, -1, 0, 0, 0, -1, 0 );
+         while( rc == 0 ) {
+            lock.unlock();
+            usleep( 100 );
+            lock.lock();
+            rc = m_ring->flush();
+         }
+         lock.unlock();
+         m_reaper.join();
+         lock.lock();
+         m_ring.reset();
+      }
+#endif
+
+      std::unique_ptr<AThreadPool> threads;
+      threads.swap( m_threads );
+      m_pool       = BufferPool();
+      m_registered = false;
+      lock.unlock();
+
+      threads.reset();
+   }
+
+   /**
+    * \brief Queues a write of a whole buffer
+    *
+    * \param [in] fd destination descriptor
+    * \param [in] buffer data to write. The writer keeps a reference until completion
+    * \param [in] offset file offset of the first byte
+    * \param [in] callback called with the result when the write completes (optional)
+    * \return true if the write was queued, false on failure
+    *
+    * Blocks while depth writes are already in flight.
+    **/
+   bool AsyncWriter::write( int fd, BaseBuffer buffer, uint64_t offset, AsyncWriteCallback callback )
+   {
+      Request * request = new Request;
+      request->m_fd       = fd;
+      request->m_offset   = offset;
+      request->m_buffer   = buffer;
+      request->m_callback = callback;
+      request->m_iov[0].iov_base = buffer.m_buffer.get();
+      request->m_iov[0].iov_len  = buffer.getSize();
+      request->m_iovCount        = 1;
+
+      return submit( request );
+   }
+
+   /**
+    * \brief Queues a write of a chunk in the binary chunk format
+    *
+    * \param [in] fd destination descriptor
+    * \param [in] chunk chunk to write. The writer keeps a reference to the payload until completion
+    * \param [in] offset file offset of the chunk header
+    * \param [in] callback called with the result when the write completes (optional)
+    * \return true if the write was queued, false on failure
+    *
+    * The header is encoded by the calling thread. Blocks while depth writes
+    * are already in flight.
+    **/
+   bool AsyncWriter::writeChunk( int fd, BaseChunk chunk, uint64_t offset, AsyncWriteCallback callback )
+   {
+      Request * request = new Request;
+      request->m_fd       = fd;
+      request->m_offset   = offset;
+      request->m_buffer   = chunk.m_buffer;
+      request->m_callback = callback;
+
+      request->m_header.resize( chunk.getHeaderSize());
+      chunk.encodeHeader( request->m_header.data(), request->m_header.size());
+
+      request->m_iov[0].iov_base = request->m_header.data();
+      request->m_iov[0].iov_len  = request->m_header.size();
+      request->m_iov[1].iov_base = chunk.m_buffer.m_buffer.get();
+      request->m_iov[1].iov_len  = chunk.m_buffer.getSize();
+      request->m_iovCount        = ( chunk.m_buffer.getSize() > 0 ) ? 2 : 1;
+
+      return submit( request );
+   }
+
+   /**
+    * \brief Waits for a free slot and hands the request to the backend
+    **/
+   bool AsyncWriter::submit( Request * request )
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      while(( m_open )&&( m_inFlight >= m_depth )) {
+         m_cv.wait( lock );
+      }
+      if( !m_open ) {
+         std::cerr << "AsyncWriter: write to a closed writer"<<std::endl;
+         delete request;
+         return false;
+      }
+      m_inFlight++;
+
+      if( m_backend == IO_URING ) {
+         //Buffers registered by open are written without mapping them for each request
+         if(( m_registered )&&( request->m_iovCount == 1 )) {
+            uint8_t * data  = (uint8_t *)request->m_iov[0].iov_base;
+            int       index = m_pool.getIndex( data );
+            uint8_t * end   = m_pool.getStorage() + ( index + 1 ) * m_pool.getBufferSize();
+            if(( index >= 0 )&&( data + request->m_iov[0].iov_len <= end )) {
+               request->m_bufferIndex = index;
+            }
+         }
+
+         if( !submitRing( request, lock, true )) {
+            m_inFlight--;
+            delete request;
+            return false;
+         }
+         return true;
+      }
+
+      lock.unlock();
+      m_threads->submit( [this, request]() {
+         ssize_t bytes = request->m_iov[0].iov_len + (( request->m_iovCount > 1 ) ? request->m_iov[1].iov_len : 0 );
+         ssize_t result = bytes;
+         if( !pwritevFully( request->m_fd, request->m_iov, request->m_iovCount, request->m_offset )) {
+            int error = errno;
+            result = ( error != 0 ) ? -error : -EIO;
+         }
+         complete( request, result );
+      });
+
+      return true;
+   }
+
+   /**
+    * \brief Places a request in the submission ring
+    *
+    * \param [in] request request to submit
+    * \param [in] lock lock on m_mutex held by the caller
+    * \param [in] retry if the kernel is busy, release the lock and retry until
+    *        the request is submitted. Otherwise the request stays queued and is
+    *        submitted by the next io_uring_enter call of the completion thread
+    * \return true on success, false if the kernel rejected the request
+    **/
+   bool AsyncWriter::submitRing( Request * request, std::unique_lock<std::mutex> &lock, bool retry )
+   {
+#ifdef ATL_HAVE_IO_URING
+      int rc = 0;
+      if(( request->m_bufferIndex >= 0 )&&( request->m_iovCount == 1 )) {
+         rc = m_ring->push( IORING_OP_WRITE_FIXED
+                          , request->m_fd
+                          , (uintptr_t)request->m_iov[0].iov_base
+                          , request->m_iov[0].iov_len
+                          , request->m_offset
+                          , request->m_bufferIndex
+                          , (uintptr_t)request
+                          );
+      }
+      else {
+         rc = m_ring->push( IORING_OP_WRITEV
+                          , request->m_fd
+                          , (uintptr_t)request->m_iov
+                          , request->m_iovCount
+                          , request->m_offset
+                          , -1
+                          , (uintptr_t)request
+                          );
+      }
+
+      //The completion thread needs m_mutex to drain completions, so the lock is released while backing off
+      while(( rc == 0 )&&( retry )) {
+         lock.unlock();
+         usleep( 100 );
+         lock.lock();
+         rc = m_ring->flush();
+      }
+
+      return rc >= 0;
+#else
+      return false;
+#endif
+   }
+
+   /**
+    * \brief Runs the callback and releases the request
+    **/
+   void AsyncWriter::complete( Request * request, ssize_t result )
+   {
+      if( request->m_callback ) {
+         request->m_callback( result );
+      }
+      delete request;
+
+      std::lock_guard<std::mutex> guard( m_mutex );
+      m_inFlight--;
+      m_cv.notify_all();
+   }
+
+   /**
+    * \brief Completion thread for the io_uring backend
+    *
+    * Short writes and transient errors are resubmitted for the remaining data.
+    **/
+   void AsyncWriter::reapLoop()
+   {
+#ifdef ATL_HAVE_IO_URING
+      Ring & ring = *m_ring;
+      while( true ) {
+         unsigned head = *ring.m_cqHead;
+         unsigned tail = __atomic_load_n( ring.m_cqTail, __ATOMIC_ACQUIRE );
+         if( head == tail ) {
+            //Entries left queued by a busy kernel are submitted with the wait
+            if( ioUringEnter( ring.m_fd, ring.getPending(), 1, IORING_ENTER_GETEVENTS ) < 0 ) {
+               if( errno == EBUSY ) {
+                  ioUringEnter( ring.m_fd, 0, 1, IORING_ENTER_GETEVENTS );
+               }
+               else if( errno == EAGAIN ) {
+                  usleep( 100 );
+               }
+               else if( errno != EINTR ) {
+                  std::cerr << "AsyncWriter: io_uring_enter failed: "<<strerror(errno)<<std::endl;
+                  usleep( 1000 );
+               }
+            }
+            continue;
+         }
+
+         struct io_uring_cqe * cqe = &ring.m_cqes[head & *ring.m_cqMask];
+         Request * request = (Request *)(uintptr_t)cqe->user_data;
+         int       result  = cqe->res;
+         __atomic_store_n( ring.m_cqHead, head + 1, __ATOMIC_RELEASE );
+
+         if( request == NULL ) {
+            break;
+         }
+
+         bool retry = ( result == -EAGAIN )||( result == -EINTR );
+         if( result > 0 ) {
+            request->m_written += result;
+            request->m_offset  += result;
+            advanceRequest( request->m_iov, request->m_iovCount, result );
+            retry = ( request->m_iovCount > 0 );
+         }
+         else if(( result == 0 )&&( request->m_iovCount > 0 )&&( request->m_iov[0].iov_len > 0 )) {
+            result = -EIO;
+         }
+
+         if( retry ) {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            if( submitRing( request, lock, false )) {
+               continue;
+            }
+            result = -EIO;
+         }
+
+         complete( request, ( result < 0 ) ? result : request->m_written );
+      }
+#endif
+   }
+
+   /**
+    * \brief Waits until all queued writes have completed
+    **/
+   void AsyncWriter::wait()
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      while( m_inFlight > 0 ) {
+         m_cv.wait( lock );
+      }
+   }
+
+   /**
+    * \brief Returns the backend in use
+    **/
+   AsyncWriter::Backend AsyncWriter::getBackend()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_backend;
+   }
+
+   /**
+    * \brief Returns the number of writes in flight
+    **/
+   size_t AsyncWriter::getInFlight()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_inFlight;
+   }
+
+   /**
+    * \brief Writes pool buffers and chunks with one backend and verifies the file
+    **/
+   static bool testBackend( AsyncWriter::Backend backend )
+   {
+      char filename[] = "/tmp/AsyncWriterXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cout << "AsyncWriter unable to create temporary file"<<std::endl;
+         return false;
+      }
+
+      BufferPool pool;
+      AsyncWriter writer;
+      if(( !pool.allocate( 4096, 8 ))||( !writer.open( 4, backend, &pool ))) {
+         std::cout << "AsyncWriter open failed for backend "<<backend<<std::endl;
+         close( fd );
+         unlink( filename );
+         return false;
+      }
+
+      const size_t count = 32;
+      std::atomic<size_t> written( 0 );
+      std::atomic<size_t> failures( 0 );
+      AsyncWriteCallback callback = [&written, &failures]( ssize_t result ) {
+         if( result < 0 ) {
+            failures++;
+         }
+         else {
+            written += result;
+         }
+      };
+
+      bool rc = true;
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         BaseBuffer buffer;
+         rc = pool.acquire( buffer );
+         if( rc ) {
+            memset( buffer.m_buffer.get(), (int)i, buffer.getSize());
+            rc = writer.write( fd, buffer, i * 4096, callback );
+         }
+      }
+
+      BaseChunk chunk( 77 );
+      chunk.m_metadata.m_type = "async";
+      chunk.allocate( 1000 );
+      memset( chunk.m_buffer.m_buffer.get(), 0xA5, 1000 );
+      rc = rc && writer.writeChunk( fd, chunk, count * 4096, callback );
+
+      writer.wait();
+      if(( !rc )||( failures != 0 )||( written != count * 4096 + chunk.getHeaderSize() + 1000 )
+       ||( writer.getInFlight() != 0 )||( pool.getFreeCount() != 8 )) {
+         std::cout << "AsyncWriter writes did not complete: "<<written<<" bytes, "<<failures<<" failures"<<std::endl;
+         rc = false;
+      }
+
+      //Check the buffers and read the chunk back
+      uint8_t page[4096];
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         if(( !preadFully( fd, page, sizeof(page), i * 4096 ))||( page[0] != i )||( page[4095] != i )) {
+            std::cout << "AsyncWriter buffer "<<i<<" was not written"<<std::endl;
+            rc = false;
+         }
+      }
+
+      BaseChunk result;
+      if(( rc )&&(( lseek( fd, count * 4096, SEEK_SET ) < 0 )||( !result.read( fd ))
+                ||( result.m_metadata.m_id != 77 )||( result.m_buffer[999] != 0xA5 ))) {
+         std::cout << "AsyncWriter chunk was not written"<<std::endl;
+         rc = false;
+      }
+      close( fd );
+
+      //A container written through the writer matches the serial file
+      BaseContainer container;
+      for( size_t i = 0; i < 10; i++ ) {
+         BaseChunk item( i );
+         item.m_metadata.m_type.assign( i, 't' );
+         item.allocate( i * 3 + 1 );
+         memset( item.m_buffer.m_buffer.get(), (int)i, i * 3 + 1 );
+         container.push_back( item );
+      }
+
+      std::string serialName = std::string( filename ) + ".serial";
+      rc = rc && container.save( serialName ) && container.save( filename, writer );
+
+      std::vector<uint8_t> expected( 4096 );
+      std::vector<uint8_t> actual( 4096 );
+      int serialFd = ::open( serialName.c_str(), O_RDONLY );
+      fd = ::open( filename, O_RDONLY );
+      ssize_t expectedBytes = pread( serialFd, expected.data(), expected.size(), 0 );
+      ssize_t actualBytes   = pread( fd, actual.data(), actual.size(), 0 );
+      close( serialFd );
+      close( fd );
+      unlink( serialName.c_str());
+      unlink( filename );
+
+      if(( rc )&&(( expectedBytes <= 0 )||( expectedBytes != actualBytes )
+                ||( memcmp( expected.data(), actual.data(), expectedBytes )))) {
+         std::cout << "AsyncWriter container file does not match"<<std::endl;
+         rc = false;
+      }
+
+      writer.close();
+      if( writer.write( 1, BaseBuffer(), 0 )) {
+         std::cout << "AsyncWriter accepted a write after close"<<std::endl;
+         rc = false;
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Unit test for the AsyncWriter class
+    **/
+   bool testAsyncWriter()
+   {
+      if( !testBackend( AsyncWriter::THREAD_POOL )) {
+         return false;
+      }
+
+      if( !AsyncWriter::isIoUringSupported()) {
+         std::cout << "AsyncWriter: io_uring not supported, skipping"<<std::endl;
+         return true;
+      }
+
+      return testBackend( AsyncWriter::IO_URING );
+   }
+}
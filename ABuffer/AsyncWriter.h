@@ -0,0 +1,95 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <BaseBuffer.h>
+#include <BaseChunk.h>
+#include <BufferPool.h>
+#include <AThreadPool.h>
+
+namespace atl
+{
+   /**
+    * \brief Called when an asynchronous write completes
+    *
+    * The argument is the number of bytes written, or a negative errno value
+    * on failure.
+    **/
+   typedef std::function<void( ssize_t result )> AsyncWriteCallback;
+
+   /**
+    * \brief Asynchronous positional writer for buffers and chunks
+    *
+    * Writes are queued with write or writeChunk and complete in the background.
+    * At most depth writes are in flight at a time; further submissions block
+    * until a slot frees up. The data referenced by a request is kept alive by
+    * the writer until the request completes, so callers may drop their buffers
+    * right after submitting.
+    *
+    * Two backends are available:
+    *  - IO_URING submits writev requests to an io_uring instance created with
+    *    raw system calls and reaps completions on a dedicated thread. Buffers
+    *    from a BufferPool passed to open are registered with the kernel and
+    *    written with fixed-buffer requests.
+    *  - THREAD_POOL performs blocking pwritev calls on a pool of depth threads.
+    * AUTO uses io_uring when the kernel supports it and falls back otherwise.
+    *
+    * Callbacks run on the completion thread and must not call wait or close.
+    **/
+   class AsyncWriter
+   {
+      public:
+         enum Backend
+         {
+            AUTO,                                            //!< io_uring if available
+            IO_URING,                                        //!< Require io_uring
+            THREAD_POOL                                      //!< pwritev on worker threads
+         };
+
+      private:
+         struct Request;
+         struct Ring;
+
+         Backend                      m_backend = AUTO;      //!< Backend in use
+         size_t                       m_depth = 0;           //!< Maximum number of writes in flight
+         size_t                       m_inFlight = 0;        //!< Number of writes in flight
+         bool                         m_open = false;        //!< Flag set between open and close
+         std::mutex                   m_mutex;               //!< Protects the counters and submission
+         std::condition_variable      m_cv;                  //!< Signals completed writes
+         BufferPool                   m_pool;                //!< Registered buffers
+         bool                         m_registered = false;  //!< Flag that m_pool is registered
+         std::unique_ptr<Ring>        m_ring;                //!< io_uring state
+         std::unique_ptr<AThreadPool> m_threads;             //!< Fallback workers
+         std::thread                  m_reaper;              //!< io_uring completion thread
+
+         bool submit( Request * request );
+         bool submitRing( Request * request, std::unique_lock<std::mutex> &lock, bool retry );
+         void complete( Request * request, ssize_t result );
+         void reapLoop();
+
+      public:
+         AsyncWriter();
+         ~AsyncWriter();
+
+         bool    open( size_t depth = 64, Backend backend = AUTO, BufferPool * pool = NULL );
+         void    close();
+         bool    write( int fd, BaseBuffer buffer, uint64_t offset, AsyncWriteCallback callback = nullptr );
+         bool    writeChunk( int fd, BaseChunk chunk, uint64_t offset, AsyncWriteCallback callback = nullptr );
+         void    wait();
+         Backend getBackend();
+         size_t  getInFlight();
+
+         static bool isIoUringSupported();
+   };
+
+   //Test functions
+   bool testAsyncWriter();
+}
@@ -46,7 +46,23 @@ namespace atl {
          bufferSize = m_bufferSize;
       }
 
-      m_buffer.reset( static_cast<uint8_t *>(std::malloc(bytes)), std::free );
+      void * memory = NULL;
+      if( m_alignment > 0 ) {
+         if( posix_memalign( &memory, m_alignment, bytes ) != 0 ) {
+            memory = NULL;
+         }
+      }
+      else {
+         memory = std::malloc(bytes);
+      }
+
+      if( memory == NULL ) {
+         std::cerr << "BaseBuffer: unable to allocate "<<bytes<<" bytes"<<std::endl;
+         m_buffer.swap( buffer );
+         return false;
+      }
+
+      m_buffer.reset( static_cast<uint8_t *>(memory), std::free );
       m_bufferSize = bytes;
 
       size_t copySize = bytes;
@@ -58,6 +74,27 @@ namespace atl {
       return true;
    }
    
+   /**
+    * \brief Sets the alignment used for future allocations
+    *
+    * \param [in] alignment alignment in bytes. Must be 0 (malloc default) or a
+    *             power of two that is a multiple of sizeof(void *)
+    * \return true on success, false if the alignment is invalid
+    *
+    * Data that is already allocated is not moved.
+    **/
+   bool BaseBuffer::setAlignment( size_t alignment )
+   {
+      if(( alignment != 0 )
+       &&(( alignment & (alignment-1)) || ( alignment % sizeof(void *)))) {
+         std::cerr << "BaseBuffer: invalid alignment "<<alignment<<std::endl;
+         return false;
+      }
+
+      m_alignment = alignment;
+      return true;
+   }
+
    /**
     * \brief Deallocates and allocated data
     **/
@@ -119,6 +156,20 @@ namespace atl {
          return false;
       }
 
+      //Aligned allocations keep their alignment when resized
+      BaseBuffer aligned;
+      if(( aligned.setAlignment(3))||( !aligned.setAlignment(4096))) {
+         std::cerr << "baseBuffer alignment not validated"<<std::endl;
+         return false;
+      }
+      aligned.allocate(100);
+      aligned[99] = 99;
+      aligned.allocate(10000, true);
+      if(((uintptr_t)aligned.m_buffer.get() % 4096 != 0 )||( aligned[99] != 99 )) {
+         std::cerr << "baseBuffer aligned allocation failed"<<std::endl;
+         return false;
+      }
+
       return true;
    }
 }
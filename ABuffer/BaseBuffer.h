@@ -24,9 +24,11 @@ namespace atl
          
       public: 
          size_t m_bufferSize      = 0;                      //!< Number of elements in the buffer
+         size_t m_alignment       = 0;                      //!< Alignment of allocations in bytes (0 = malloc default)
          std::shared_ptr<uint8_t> m_buffer;                 //!< Actual data buffer
    
          bool allocate( size_t bytes, bool resizeFlag = false);
+         bool setAlignment( size_t alignment );
          void deallocate();
          size_t getSize();
    
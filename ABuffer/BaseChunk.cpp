@@ -1,8 +1,16 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <cstring>
+#include <cstdlib>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include "BaseChunk.h"
+#include "ByteOrder.h"
+#include "FileIO.h"
 
 namespace atl
 {
@@ -42,12 +50,239 @@ namespace atl
 
 
    /**
-    * \brief Function to save the base container
+    * \brief Returns the number of bytes before the payload (fixed header and type)
+    **/
+   size_t BaseChunk::getHeaderSize()
+   {
+      return BASECHUNK_HEADER_SIZE + m_metadata.m_type.length();
+   }
+
+   /**
+    * \brief Writes the binary header and type string into a buffer
+    *
+    * \param [in] buffer destination buffer
+    * \param [in] bytes size of the destination buffer
+    * \param [in] flags header flags (default = 0)
+    * \return number of bytes written (getHeaderSize), 0 if the buffer is too small
+    **/
+   size_t BaseChunk::encodeHeader( uint8_t * buffer, size_t bytes, uint16_t flags )
+   {
+      size_t headerSize = getHeaderSize();
+      if( bytes < headerSize ) {
+         std::cerr << "BaseChunk: header buffer too small ("<<bytes<<"<"<<headerSize<<")"<<std::endl;
+         return 0;
+      }
+
+      memcpy( buffer, MAGIC, 4 );
+      writeLE16( &buffer[4],  BASECHUNK_VERSION );
+      writeLE16( &buffer[6],  flags );
+      writeLE32( &buffer[8],  m_metadata.m_type.length() );
+      writeLE16( &buffer[12], m_metadata.m_typeId );
+      writeLE16( &buffer[14], 0 );
+      writeLE64( &buffer[16], m_metadata.m_id );
+      writeLE64( &buffer[24], m_metadata.m_elementSize );
+      writeLE64( &buffer[32], m_metadata.m_elementCount );
+      writeLE64( &buffer[40], m_metadata.m_offset );
+      writeLE64( &buffer[48], m_buffer.getSize() );
+      memcpy( &buffer[BASECHUNK_HEADER_SIZE], m_metadata.m_type.data(), m_metadata.m_type.length() );
+
+      return headerSize;
+   }
+
+   /**
+    * \brief Reads the metadata from a binary chunk header
+    *
+    * \param [in] buffer start of the header
+    * \param [in] bytes number of valid bytes in the buffer
+    * \param [out] typeLength optional pointer that receives the length of the type string
+    * \param [out] dataSize optional pointer that receives the payload size
+    * \param [out] flags optional pointer that receives the header flags
+    * \return true on success, false if the header is invalid
+    *
+    * The type string is only assigned if the buffer also contains it. The
+    * payload buffer is not modified.
+    **/
+   bool BaseChunk::decodeHeader( const uint8_t * buffer
+                               , size_t bytes
+                               , uint32_t * typeLength
+                               , uint64_t * dataSize
+                               , uint16_t * flags
+                               )
+   {
+      if( bytes < BASECHUNK_HEADER_SIZE ) {
+         std::cerr << "BaseChunk: chunk header is truncated"<<std::endl;
+         return false;
+      }
+
+      if( memcmp( buffer, MAGIC, 4 ) != 0 ) {
+         std::cerr << "BaseChunk: invalid chunk magic"<<std::endl;
+         return false;
+      }
+
+      uint16_t version = readLE16( &buffer[4] );
+      if( version != BASECHUNK_VERSION ) {
+         std::cerr << "BaseChunk: unsupported chunk version "<<version<<std::endl;
+         return false;
+      }
+
+      uint32_t length = readLE32( &buffer[8] );
+
+      m_metadata.m_typeId       = readLE16( &buffer[12] );
+      m_metadata.m_id           = readLE64( &buffer[16] );
+      m_metadata.m_elementSize  = readLE64( &buffer[24] );
+      m_metadata.m_elementCount = readLE64( &buffer[32] );
+      m_metadata.m_offset       = readLE64( &buffer[40] );
+      if( bytes >= BASECHUNK_HEADER_SIZE + (size_t)length ) {
+         m_metadata.m_type.assign( (const char *)&buffer[BASECHUNK_HEADER_SIZE], length );
+      }
+
+      if( typeLength != NULL ) {
+         *typeLength = length;
+      }
+      if( dataSize != NULL ) {
+         *dataSize = readLE64( &buffer[48] );
+      }
+      if( flags != NULL ) {
+         *flags = readLE16( &buffer[6] );
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Writes the chunk in the binary chunk format
+    *
+    * \param [in] fd descriptor to write to (file or socket)
+    * \return true on success, false on failure
+    *
+    * The header and payload are written with a single writev call without
+    * copying the payload.
+    **/
+   bool BaseChunk::write( int fd )
+   {
+      size_t  headerSize = getHeaderSize();
+      uint8_t fixed[BASECHUNK_HEADER_SIZE + 64];
+      uint8_t * header = fixed;
+      if( headerSize > sizeof(fixed)) {
+         header = (uint8_t *)malloc( headerSize );
+         if( header == NULL ) {
+            std::cerr << "BaseChunk: unable to allocate a "<<headerSize<<" byte header"<<std::endl;
+            return false;
+         }
+      }
+      encodeHeader( header, headerSize );
+
+      struct iovec iov[2];
+      iov[0].iov_base = header;
+      iov[0].iov_len  = headerSize;
+      iov[1].iov_base = m_buffer.m_buffer.get();
+      iov[1].iov_len  = m_buffer.getSize();
+
+      bool rc = writevFully( fd, iov, 2 );
+
+      if( header != fixed ) {
+         free( header );
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Reads a chunk in the binary chunk format
+    *
+    * \param [in] fd descriptor to read from (file or socket)
+    * \return true on success, false on failure
+    *
+    * The payload buffer is allocated once with the size from the header and
+    * the type and payload are filled by a single readv call. The chunk is
+    * only modified if the whole record was read.
+    **/
+   bool BaseChunk::read( int fd )
+   {
+      uint8_t header[BASECHUNK_HEADER_SIZE];
+      if( !readFully( fd, header, sizeof(header))) {
+         std::cerr << "BaseChunk: unable to read chunk header"<<std::endl;
+         return false;
+      }
+
+      BaseChunk record;
+      uint32_t typeLength = 0;
+      uint64_t dataSize   = 0;
+      uint16_t flags      = 0;
+      if( !record.decodeHeader( header, sizeof(header), &typeLength, &dataSize, &flags )) {
+         return false;
+      }
+      if( flags & BASECHUNK_FLAG_REFERENCE ) {
+         std::cerr << "BaseChunk: reference records can only be read from a container file"<<std::endl;
+         return false;
+      }
+      if( typeLength > BASECHUNK_MAX_TYPE_LENGTH ) {
+         std::cerr << "BaseChunk: type length "<<typeLength<<" exceeds "<<BASECHUNK_MAX_TYPE_LENGTH<<" bytes"<<std::endl;
+         return false;
+      }
+
+      record.m_metadata.m_type.resize( typeLength );
+      record.m_buffer.m_alignment = m_buffer.m_alignment;
+      if(( dataSize > 0 )&&( !record.m_buffer.allocate( dataSize ))) {
+         return false;
+      }
+
+      struct iovec iov[2];
+      iov[0].iov_base = &record.m_metadata.m_type[0];
+      iov[0].iov_len  = typeLength;
+      iov[1].iov_base = record.m_buffer.m_buffer.get();
+      iov[1].iov_len  = dataSize;
+
+      if( !readvFully( fd, iov, 2 )) {
+         std::cerr << "BaseChunk: chunk is truncated"<<std::endl;
+         return false;
+      }
+
+      m_metadata = record.m_metadata;
+      m_buffer   = record.m_buffer;
+      return true;
+   }
+
+   /**
+    * \brief Saves the chunk to a file in the binary chunk format
+    *
+    * \param [in] filename name of the file to write. An existing file is replaced
+    * \return true on success, false on failure
     **/
    bool BaseChunk::save( std::string filename ) 
    {
-      std::cerr << "saveBaseChunk not currently supported" <<std::endl;
-      return false;
+      int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "BaseChunk: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      bool rc = write( fd );
+      if( close( fd ) != 0 ) {
+         rc = false;
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Loads a chunk from a file written by save
+    *
+    * \param [in] filename name of the file to read
+    * \return true on success, false on failure
+    **/
+   bool BaseChunk::load( std::string filename )
+   {
+      int fd = open( filename.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         std::cerr << "BaseChunk: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      bool rc = read( fd );
+      close( fd );
+
+      return rc;
    }
 
    /**
@@ -90,6 +325,74 @@ namespace atl
          return false;
       }
 
+      //Binary round trip
+      container.m_metadata.m_elementSize  = 4;
+      container.m_metadata.m_elementCount = 25;
+      container.m_metadata.m_type         = "float";
+      for( size_t i = 0; i < 100; i++ ) {
+         container.m_buffer[i] = i;
+      }
+
+      char filename[] = "/tmp/BaseChunkXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cerr << "testBaseChunk unable to create temporary file"<<std::endl;
+         return false;
+      }
+      close( fd );
+
+      if( !container.save( filename )) {
+         unlink( filename );
+         return false;
+      }
+
+      BaseChunk loaded;
+      bool rc = loaded.load( filename );
+      if(( !rc )
+       ||( loaded.m_metadata.m_id != 1 )
+       ||( loaded.m_metadata.m_offset != 2 )
+       ||( loaded.m_metadata.m_elementSize != 4 )
+       ||( loaded.m_metadata.m_elementCount != 25 )
+       ||( loaded.m_metadata.m_type != "float" )
+       ||( loaded.m_buffer.getSize() != 100 )
+       ||( memcmp( loaded.m_buffer.m_buffer.get(), container.m_buffer.m_buffer.get(), 100 ))) {
+         std::cerr << "testBaseChunk binary round trip failed"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //An oversized type length is rejected and leaves the chunk unchanged
+      uint8_t length[4];
+      writeLE32( length, 0xFFFFFFFF );
+      fd = open( filename, O_WRONLY );
+      if(( fd < 0 )||( pwrite( fd, length, sizeof(length), 8 ) != sizeof(length))) {
+         std::cerr << "testBaseChunk unable to modify file"<<std::endl;
+      }
+      close( fd );
+
+      if(( loaded.load( filename ))
+       ||( loaded.m_metadata.m_id != container.m_metadata.m_id )
+       ||( loaded.m_buffer.getSize() != 100 )
+       ||( memcmp( loaded.m_buffer.m_buffer.get(), container.m_buffer.m_buffer.get(), 100 ))) {
+         std::cerr << "testBaseChunk accepted an oversized type length"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //A file with a damaged magic must be rejected
+      fd = open( filename, O_WRONLY );
+      if(( fd < 0 )||( pwrite( fd, "XXXX", 4, 0 ) != 4 )) {
+         std::cerr << "testBaseChunk unable to modify file"<<std::endl;
+      }
+      close( fd );
+
+      rc = loaded.load( filename );
+      unlink( filename );
+      if( rc ) {
+         std::cerr << "testBaseChunk loaded a chunk with an invalid magic"<<std::endl;
+         return false;
+      }
+
       return true;
  
    }
@@ -5,7 +5,40 @@
 #include <BaseChunkMetadata.h>
 #include <BaseBuffer.h>
 
-#define MAGIC "AGT"; //Aqueti Generic container
+#define MAGIC "AGT" //Aqueti Generic container
+#define BASECHUNK_VERSION     1           //!< Version of the binary chunk format
+#define BASECHUNK_HEADER_SIZE 56          //!< Size of the fixed binary chunk header
+#define BASECHUNK_MAX_TYPE_LENGTH 65536  //!< Longest type string accepted when reading a chunk
+
+#define BASECHUNK_FLAG_REFERENCE 0x0001   //!< Payload is a reference to the payload of another record
+#define BASECHUNK_REFERENCE_SIZE 16       //!< Payload size of a reference record
+
+/**
+ * Binary chunk format (all values little-endian):
+ *
+ *   offset  size  field
+ *        0     4  magic ("AGT\0")
+ *        4     2  version
+ *        6     2  flags
+ *        8     4  type length in bytes
+ *       12     2  metadata type id (see MetadataRegistry.tcc)
+ *       14     2  reserved (0)
+ *       16     8  id
+ *       24     8  elementSize
+ *       32     8  elementCount
+ *       40     8  offset
+ *       48     8  payload size in bytes
+ *       56     -  type string followed by the payload
+ *
+ * If BASECHUNK_FLAG_REFERENCE is set the record belongs to a container file
+ * and its payload holds the payload of another record of the same file:
+ *
+ *        0     8  container position of the record with the payload
+ *        8     8  payload size in bytes
+ *
+ * The referenced record precedes the reference and is not a reference.
+ * Metadata and type are those of the reference record itself.
+ **/
 
 namespace atl
 {
@@ -25,6 +58,17 @@ namespace atl
          virtual bool allocate(size_t bytes = 0 );
 
          virtual bool save( std::string filename );
+         virtual bool load( std::string filename );
+         bool     write( int fd );
+         bool     read( int fd );
+         size_t   getHeaderSize();
+         size_t   encodeHeader( uint8_t * buffer, size_t bytes, uint16_t flags = 0 );
+         bool     decodeHeader( const uint8_t * buffer
+                              , size_t bytes
+                              , uint32_t * typeLength = NULL
+                              , uint64_t * dataSize = NULL
+                              , uint16_t * flags = NULL
+                              );
          uint64_t getId();
          size_t getSize();
    };
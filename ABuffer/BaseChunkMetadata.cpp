@@ -1,8 +1,8 @@
 #include <iostream>
-#include <sstream>
 #include <string>
 
 #include "BaseChunkMetadata.h"
+#include "ByteOrder.h"
 
 namespace atl
 {
@@ -13,35 +13,169 @@ namespace atl
     **/
    std::string BaseChunkMetadata::getJsonString( bool brackets)
    {
-      std::stringstream ss;
+      char buffer[256];
+      JsonWriter writer( buffer, sizeof(buffer));
+      writeJson( writer, brackets );
 
+      return std::string( writer.getString(), writer.getLength());
+   }
+
+   /**
+    * \brief Appends the json representation of the metadata to a writer
+    * \param [in] writer writer to append to
+    * \param [in] brackets flag to indicate if surrounding brackets are needed (default = true)
+    * \return true on success, false if the writer buffer is too small
+    **/
+   bool BaseChunkMetadata::writeJson( JsonWriter &writer, bool brackets )
+   {
       if( brackets ) {
-         ss << "{";
+         writer.append('{');
       }
-      
-      ss << "\"id\":"     << m_id << ","
-         << "\"offset\":" << m_offset << ","
-         << "\"elementSize\":" << m_elementSize;
 
-      if(brackets) { 
-         ss << "}";
+      writer.appendKey("id").appendUInt( m_id ).append(',')
+            .appendKey("offset").appendUInt( m_offset ).append(',')
+            .appendKey("elementSize").appendUInt( m_elementSize );
+
+      if( brackets ) {
+         writer.append('}');
+      }
+
+      return writer.isValid();
+   }
+
+   /**
+    * \brief Reads one field of the json representation
+    *
+    * \param [in] reader reader positioned at the value of the field
+    * \param [in] key key of the field
+    * \param [in] length length of the key
+    * \return true if the key is a field of this class and its value was consumed
+    **/
+   bool BaseChunkMetadata::readJsonField( JsonReader &reader, const char * key, size_t length )
+   {
+      if( JsonReader::keyEquals( key, length, "id" )) {
+         reader.readUInt( m_id );
+      }
+      else if( JsonReader::keyEquals( key, length, "offset" )) {
+         reader.readUInt( m_offset );
+      }
+      else if( JsonReader::keyEquals( key, length, "elementSize" )) {
+         reader.readUInt( m_elementSize );
+      }
+      else {
+         return false;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Fills the metadata from the json representation written by writeJson
+    *
+    * \param [in] text json text (with brackets)
+    * \param [in] length number of characters in the text
+    * \return true on success, false on a syntax error
+    *
+    * Fields may appear in any order. Unknown fields are ignored and missing
+    * fields keep their current value.
+    **/
+   bool BaseChunkMetadata::parseJson( const char * text, size_t length )
+   {
+      JsonReader   reader( text, length );
+      const char * key;
+      size_t       keyLength;
+
+      reader.beginObject();
+      while( reader.nextKey( key, keyLength )) {
+         if( !readJsonField( reader, key, keyLength )) {
+            reader.skipValue();
+         }
       }
 
-      std::string result = ss.str();
-      return result;
+      return reader.isValid() && reader.atEnd();
    }
 
    /**
     * \brief Returns the size of the data contained in the metadata
     *
-    * This function must be implemented by all metadata classes to ensure that 
-    * the appropriate size is returned.
+    * Every metadata class defines its own getSize. The function is not virtual;
+    * code that only has a type id uses MetadataRegistry::getEncodedSize.
     **/
    size_t BaseChunkMetadata::getSize() 
    {
       return BASECONTAINERMETA_SIZE + m_type.length();
       
    }
+   /**
+    * \brief Writes the fixed fields (BASECONTAINERMETA_SIZE bytes) with a single store
+    **/
+   void BaseChunkMetadata::encodeRecord( uint8_t * buffer )
+   {
+      BaseChunkMetadataRecord record;
+      record.m_id           = toLittleEndian64( m_id );
+      record.m_elementSize  = toLittleEndian64( m_elementSize );
+      record.m_elementCount = toLittleEndian64( m_elementCount );
+      record.m_offset       = toLittleEndian64( m_offset );
+      memcpy( buffer, &record, sizeof(record));
+   }
+
+   /**
+    * \brief Reads the fixed fields (BASECONTAINERMETA_SIZE bytes) with a single load
+    **/
+   void BaseChunkMetadata::decodeRecord( const uint8_t * buffer )
+   {
+      BaseChunkMetadataRecord record;
+      memcpy( &record, buffer, sizeof(record));
+      m_id           = toLittleEndian64( record.m_id );
+      m_elementSize  = toLittleEndian64( record.m_elementSize );
+      m_elementCount = toLittleEndian64( record.m_elementCount );
+      m_offset       = toLittleEndian64( record.m_offset );
+   }
+
+   /**
+    * \brief Writes the binary representation of the metadata
+    *
+    * \param [in] buffer destination buffer
+    * \param [in] bytes size of the destination buffer
+    * \return number of bytes written (getSize), 0 if the buffer is too small
+    *
+    * The fixed fields are stored at the offsets of BaseChunkMetadataRecord and
+    * followed by the type string.
+    **/
+   size_t BaseChunkMetadata::encode( uint8_t * buffer, size_t bytes )
+   {
+      size_t size = BaseChunkMetadata::getSize();
+      if( bytes < size ) {
+         std::cerr << "BaseChunkMetadata: encode buffer too small ("<<bytes<<"<"<<size<<")"<<std::endl;
+         return 0;
+      }
+
+      encodeRecord( buffer );
+      memcpy( &buffer[BASECONTAINERMETA_SIZE], m_type.data(), m_type.length());
+
+      return size;
+   }
+
+   /**
+    * \brief Reads the binary representation written by encode
+    *
+    * \param [in] buffer encoded metadata
+    * \param [in] bytes size of the encoded metadata. Bytes past the fixed fields are the type
+    * \return true on success, false if the buffer is too small
+    **/
+   bool BaseChunkMetadata::decode( const uint8_t * buffer, size_t bytes )
+   {
+      if( bytes < BASECONTAINERMETA_SIZE ) {
+         std::cerr << "BaseChunkMetadata: encoded metadata is truncated"<<std::endl;
+         return false;
+      }
+
+      decodeRecord( buffer );
+      m_type.assign( (const char *)&buffer[BASECONTAINERMETA_SIZE], bytes - BASECONTAINERMETA_SIZE );
+
+      return true;
+   }
+
    /**
     * \brief test function for the BaseChunkMetadata class
     * \return true on success, false on failure
@@ -61,6 +195,34 @@ namespace atl
          return false;
       }
 
+      //Parse a reordered representation with an unknown field
+      BaseChunkMetadata parsed;
+      std::string json = "{\"elementSize\":8, \"unknown\":[1,2], \"offset\":1235,\"id\":1234}";
+      if(( !parsed.parseJson( json.data(), json.length()))
+       ||( parsed.m_id != 1234 )||( parsed.m_offset != 1235 )||( parsed.m_elementSize != 8 )) {
+         std::cout << "testBaseChunkMetadata failed to parse "<<json<<std::endl;
+         return false;
+      }
+
+      //Binary round trip at the documented offsets
+      metadata.m_elementCount = 7;
+      metadata.m_type = "raw";
+      uint8_t encoded[64];
+      BaseChunkMetadata decoded;
+      if(( metadata.encode( encoded, sizeof(encoded)) != BASECONTAINERMETA_SIZE + 3 )
+       ||( readLE64( &encoded[0] ) != 1234 )
+       ||( readLE64( &encoded[16] ) != 7 )
+       ||( !decoded.decode( encoded, BASECONTAINERMETA_SIZE + 3 ))
+       ||( decoded.m_id != 1234 )||( decoded.m_offset != 1235 )||( decoded.m_elementSize != 1 )
+       ||( decoded.m_elementCount != 7 )||( decoded.m_type != "raw" )) {
+         std::cout << "testBaseChunkMetadata binary round trip failed"<<std::endl;
+         return false;
+      }
+      if(( metadata.encode( encoded, BASECONTAINERMETA_SIZE ))||( decoded.decode( encoded, 8 ))) {
+         std::cout << "testBaseChunkMetadata accepted a short binary buffer"<<std::endl;
+         return false;
+      }
+
       expected.assign("\"id\":1234,\"offset\":1235,\"elementSize\":1");
       result.clear();
       result = metadata.getJsonString(false);
@@ -3,10 +3,40 @@
 #include <climits>
 #include <stddef.h>
 #include <string>
+#include <JsonWriter.h>
+#include <JsonReader.h>
 
 namespace atl
 {
-#define BASECONTAINERMETA_SIZE 4*8
+#define BASECONTAINERMETA_SIZE (4*8)
+
+   // Metadata type ids. Each registered metadata class has a unique id equal to
+   // its position in the registry (see MetadataRegistry.tcc)
+   const uint16_t METADATA_TYPE_BASE  = 0;      //!< BaseChunkMetadata
+   const uint16_t METADATA_TYPE_IMAGE = 1;      //!< ImageMetadata
+
+   /**
+    * \brief Compile-time description of a metadata class
+    *
+    * Every metadata class specializes this template with its type id, the size
+    * of its fixed binary fields and a display name.
+    **/
+   template <typename T> struct MetadataTraits;
+   /**
+    * \brief Fixed part of the binary metadata encoding (little-endian)
+    *
+    * The type string follows the fixed fields. The record can be copied from
+    * or to an encoded buffer with a single load or store on little-endian hosts.
+    **/
+   struct BaseChunkMetadataRecord
+   {
+      uint64_t m_id;                        //!< ID of the object
+      uint64_t m_elementSize;               //!< Size of a databuffer element
+      uint64_t m_elementCount;              //!< Number of elements
+      uint64_t m_offset;                    //!< Offset into the binary data
+   };
+   static_assert( sizeof(BaseChunkMetadataRecord) == BASECONTAINERMETA_SIZE, "BaseChunkMetadataRecord does not match BASECONTAINERMETA_SIZE" );
+
    /**
     * \brief Low level data structure to associate pointer with a data size
     *
@@ -18,16 +48,33 @@ namespace atl
    class BaseChunkMetadata
    {
       private:
-         
+
+      protected:
+         void encodeRecord( uint8_t * buffer );
+         void decodeRecord( const uint8_t * buffer );
+
       public: 
          uint64_t    m_id = 0;              //!< ID of the object
          uint64_t    m_elementSize = 1;     //!< Size of a databuffer element
          uint64_t    m_elementCount = 0;    //!< Number of elements in the associated buffer
          uint64_t    m_offset = 0;          //!< Offset into the binary data
-         std::string m_type;                //!< Indicates metadata type
+         uint16_t    m_typeId = METADATA_TYPE_BASE; //!< Metadata type id used for dispatch
+         std::string m_type;                //!< Type description for display
 
-         virtual size_t  getSize();         //!< Returns the size of the metadata container
+         size_t      getSize();             //!< Returns the size of the metadata container
+         size_t      encode( uint8_t * buffer, size_t bytes );
+         bool        decode( const uint8_t * buffer, size_t bytes );
          std::string getJsonString( bool brackets = true );
+         bool        writeJson( JsonWriter &writer, bool brackets = true );
+         bool        parseJson( const char * text, size_t length );
+         bool        readJsonField( JsonReader &reader, const char * key, size_t length );
+   };
+
+   template <> struct MetadataTraits<BaseChunkMetadata>
+   {
+      static const uint16_t id        = METADATA_TYPE_BASE;
+      static const size_t   fixedSize = BASECONTAINERMETA_SIZE;
+      static constexpr const char * getName() { return "base"; }
    };
 
 
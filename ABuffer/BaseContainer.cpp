@@ -1,4 +1,21 @@
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
 #include <BaseContainer.h>
+#include <ContainerReader.h>
+#include <ByteOrder.h>
+#include <Checksum.h>
+#include <FileIO.h>
+#include <ATimer.h>
 
 namespace atl
 {
@@ -8,16 +25,149 @@ namespace atl
     * \return number of elements in the array
     *
     * This function adds the specifed container to the end of the array and updates the 
-    * cumulative size of the data contained in the array.
+    * cumulative size of the data contained in the array. A chunk allocated from
+    * the arena is no longer pinned by compact once it is pushed and no other
+    * copy of it is held.
     **/ 
    size_t BaseContainer::push_back( BaseChunk chunk)
    {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
       m_metadata.m_elementCount = m_containerArray.push_back(chunk);
       m_metadata.m_size += chunk.getSize();
+      m_index.insert( chunk.m_metadata.m_id, m_metadata.m_elementCount - 1 );
+      m_version++;
 
       return m_metadata.m_elementCount;
    }
 
+   /**
+    * \brief Removes the last chunk from the container
+    * \return the removed chunk (an empty chunk if the container is empty)
+    **/
+   BaseChunk BaseContainer::pop()
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      BaseChunk chunk;
+      if( !m_containerArray.pop_back( &chunk )) {
+         std::cerr << "BaseContainer: pop from an empty container"<<std::endl;
+         return chunk;
+      }
+      m_version++;
+
+      //The index only points at the last position if this was the first chunk with its id
+      size_t position = 0;
+      m_metadata.m_elementCount = m_containerArray.getSize();
+      m_metadata.m_size -= chunk.getSize();
+      if(( m_index.find( chunk.m_metadata.m_id, &position ))&&( position == m_metadata.m_elementCount )) {
+         m_index.remove( chunk.m_metadata.m_id );
+      }
+
+      return chunk;
+   }
+
+   /**
+    * \brief Removes the chunk at the specified position
+    * \param [in] index position of the chunk
+    * \return true on success, false if the index is out of range
+    *
+    * Later chunks move down by one position, so the index is rebuilt. This
+    * is linear in the number of chunks.
+    **/
+   bool BaseContainer::erase( size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      return eraseLocked( index );
+   }
+
+   /**
+    * \brief Removes the chunk at the specified position
+    *
+    * The caller must hold m_indexMutex.
+    **/
+   bool BaseContainer::eraseLocked( size_t index )
+   {
+      BaseChunk chunk;
+      if(( !m_containerArray.getItem( &chunk, index ))||( !m_containerArray.erase( index ))) {
+         return false;
+      }
+
+      m_metadata.m_elementCount = m_containerArray.getSize();
+      m_metadata.m_size -= chunk.getSize();
+      m_version++;
+      rebuildIndex();
+
+      return true;
+   }
+
+   /**
+    * \brief Removes the first chunk with the specified id
+    * \param [in] id chunk id
+    * \return true on success, false if no chunk has the id
+    *
+    * The lookup and the removal happen under one hold of m_indexMutex, so a
+    * concurrent change cannot shift the chunk to another position in between.
+    **/
+   bool BaseContainer::remove( uint64_t id )
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      size_t index = 0;
+      if( !m_index.find( id, &index )) {
+         return false;
+      }
+
+      return eraseLocked( index );
+   }
+
+   /**
+    * \brief Looks up a chunk by id
+    *
+    * \param [in] id chunk id
+    * \param [out] chunk receives the chunk
+    * \return true if a chunk with the id was found
+    **/
+   bool BaseContainer::find( uint64_t id, BaseChunk * chunk )
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      size_t index = 0;
+      if( !m_index.find( id, &index )) {
+         return false;
+      }
+
+      return m_containerArray.getItem( chunk, index );
+   }
+
+   /**
+    * \brief Looks up the position of a chunk by id
+    *
+    * \param [in] id chunk id
+    * \param [out] index receives the position of the chunk
+    * \return true if a chunk with the id was found
+    **/
+   bool BaseContainer::findIndex( uint64_t id, size_t * index )
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      return m_index.find( id, index );
+   }
+
+   /**
+    * \brief Rebuilds the id index from the chunk array
+    *
+    * The caller must hold m_indexMutex.
+    **/
+   void BaseContainer::rebuildIndex()
+   {
+      m_index.clear();
+
+      size_t count = m_containerArray.getSize();
+      m_index.reserve( count );
+
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+      for( size_t i = 0; i < count; i++ ) {
+         m_index.insert( chunks[i].m_metadata.m_id, i );
+      }
+      m_containerArray.unlockBuffer();
+   }
+
    /** 
     * \brief Size of all of the data in the container
     **/
@@ -26,6 +176,1009 @@ namespace atl
       return m_metadata.getSize();
    }
 
+   /**
+    * \brief Returns the number of bytes a chunk record occupies in a container file or arena
+    *
+    * \param [in] typeLength length of the chunk type string
+    * \param [in] bytes payload size
+    * \return size of the record including alignment padding
+    **/
+   size_t BaseContainer::getRecordSize( size_t typeLength, size_t bytes )
+   {
+      size_t size = BASECHUNK_HEADER_SIZE + typeLength + bytes;
+      return ( size + BASECONTAINER_ALIGNMENT - 1 ) & ~(size_t)( BASECONTAINER_ALIGNMENT - 1 );
+   }
+
+   /**
+    * \brief Allocates the arena used by allocateChunk
+    *
+    * \param [in] bytes size of the arena. getRecordSize gives the space needed per chunk
+    * \return true on success, false on failure or if chunks were already allocated
+    **/
+   bool BaseContainer::reserveArena( size_t bytes )
+   {
+      std::lock_guard<std::mutex> guard( m_arenaMutex );
+      if( m_arenaUsed > 0 ) {
+         std::cerr << "BaseContainer: arena already in use"<<std::endl;
+         return false;
+      }
+
+      m_arenaRecords.clear();
+      m_compactPlan.clear();
+      m_compacting = false;
+      m_version++;
+
+      m_arena.deallocate();
+      m_arena.setAlignment( 64 );
+      return m_arena.allocate( bytes );
+   }
+
+   /**
+    * \brief Assigns a chunk a payload buffer from the arena
+    *
+    * \param [in] chunk chunk to allocate. The type must be set before this call
+    * \param [in] bytes payload size
+    * \return true on success, false if the arena does not have enough space
+    *
+    * Space for the chunk header is reserved in front of the payload. The chunk
+    * buffer shares ownership of the arena, which is released when the
+    * container and all chunks referencing it are gone. The record is pinned
+    * (compact does not move it) while the chunk is held outside the container.
+    **/
+   bool BaseContainer::allocateChunk( BaseChunk &chunk, size_t bytes )
+   {
+      std::lock_guard<std::mutex> guard( m_arenaMutex );
+
+      size_t headerSize = chunk.getHeaderSize();
+      size_t recordSize = getRecordSize( chunk.m_metadata.m_type.length(), bytes );
+      if( m_arenaUsed + recordSize > m_arena.getSize()) {
+         std::cerr << "BaseContainer: arena exhausted ("<<m_arenaUsed + recordSize<<">"<<m_arena.getSize()<<")"<<std::endl;
+         return false;
+      }
+
+      uint8_t * record  = m_arena.m_buffer.get() + m_arenaUsed;
+      uint8_t * payload = record + headerSize;
+      memset( payload + bytes, 0, recordSize - headerSize - bytes );
+
+      chunk.m_buffer.m_buffer     = getArenaPointer( payload );
+      chunk.m_buffer.m_bufferSize = bytes;
+
+      ArenaRecord allocated;
+      allocated.m_offset  = m_arenaUsed;
+      allocated.m_size    = recordSize;
+      allocated.m_payload = chunk.m_buffer.m_buffer;
+      m_arenaRecords.push_back( allocated );
+      m_arenaUsed += recordSize;
+      m_version++;
+
+      return true;
+   }
+
+   /**
+    * \brief Returns a pointer to a payload in the arena with its own use count
+    *
+    * The pointer shares ownership of the arena, but every record gets a
+    * separate control block, so its use count is the number of chunks that
+    * refer to the record.
+    **/
+   std::shared_ptr<uint8_t> BaseContainer::getArenaPointer( uint8_t * payload )
+   {
+      auto owner = std::make_shared<std::shared_ptr<uint8_t>>( m_arena.m_buffer );
+      return std::shared_ptr<uint8_t>( owner, payload );
+   }
+
+   /**
+    * \brief Locates the arena record of a chunk
+    *
+    * \param [in] chunk chunk to locate
+    * \param [out] record receives the offset and size of the record
+    * \return true if the chunk payload lies in the arena
+    *
+    * The record position is derived from the current header size, so this
+    * relies on the type not being changed after allocation.
+    **/
+   bool BaseContainer::getArenaRecord( BaseChunk &chunk, ArenaRecord &record )
+   {
+      uint8_t * arena   = m_arena.m_buffer.get();
+      uint8_t * payload = chunk.m_buffer.m_buffer.get();
+      size_t headerSize = chunk.getHeaderSize();
+      if(( arena == NULL )||( payload < arena + headerSize )||( payload >= arena + m_arena.getSize())) {
+         return false;
+      }
+
+      record.m_offset = payload - arena - headerSize;
+      record.m_size   = getRecordSize( chunk.m_metadata.m_type.length(), chunk.m_buffer.getSize());
+      return true;
+   }
+
+   /**
+    * \brief Lists the live arena records sorted by offset
+    *
+    * \param [out] records receives the records of the array chunks and of the pinned chunks
+    * \return true on success, false if records overlap or exceed the used arena
+    *
+    * Chunks that share a record appear once per array position. A record
+    * with more references than array positions is held outside the array
+    * and appears once as pinned. Records that nothing refers to any more are
+    * forgotten. The caller must hold m_indexMutex and m_arenaMutex.
+    **/
+   bool BaseContainer::collectArenaRecords( std::vector<ArenaRecord> &records )
+   {
+      records.clear();
+
+      size_t count = m_containerArray.getSize();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+      ArenaRecord record;
+      for( size_t i = 0; i < count; i++ ) {
+         if( getArenaRecord( chunks[i], record )) {
+            record.m_position = i;
+            records.push_back( record );
+         }
+      }
+      m_containerArray.unlockBuffer();
+
+      //Chunks are usually pushed in allocation order
+      auto before = []( const ArenaRecord &a, const ArenaRecord &b ) { return a.m_offset < b.m_offset; };
+      if( !std::is_sorted( records.begin(), records.end(), before )) {
+         std::stable_sort( records.begin(), records.end(), before );
+      }
+
+      auto expired = []( const ArenaRecord &a ) { return a.m_payload.expired(); };
+      m_arenaRecords.erase( std::remove_if( m_arenaRecords.begin(), m_arenaRecords.end(), expired )
+                          , m_arenaRecords.end());
+      if( !std::is_sorted( m_arenaRecords.begin(), m_arenaRecords.end(), before )) {
+         std::sort( m_arenaRecords.begin(), m_arenaRecords.end(), before );
+      }
+
+      std::vector<ArenaRecord> collected;
+      collected.reserve( records.size() + m_arenaRecords.size());
+      size_t next = 0;
+      for( size_t i = 0; i < m_arenaRecords.size(); i++ ) {
+         ArenaRecord & tracked = m_arenaRecords[i];
+         while(( next < records.size())&&( records[next].m_offset < tracked.m_offset )) {
+            collected.push_back( records[next++] );
+         }
+         size_t first = next;
+         while(( next < records.size())&&( records[next].m_offset == tracked.m_offset )) {
+            next++;
+         }
+
+         if( (size_t)tracked.m_payload.use_count() > next - first ) {
+            collected.push_back( tracked );
+            collected.back().m_position = SIZE_MAX;
+         }
+         else {
+            collected.insert( collected.end(), records.begin() + first, records.begin() + next );
+         }
+      }
+      collected.insert( collected.end(), records.begin() + next, records.end());
+      records.swap( collected );
+
+      size_t end = 0;
+      for( size_t i = 0; i < records.size(); i++ ) {
+         bool shared = ( i > 0 )&&( records[i].m_offset == records[i-1].m_offset );
+         if(( shared )&&(( records[i].m_size != records[i-1].m_size )||( records[i].m_position == SIZE_MAX ))) {
+            std::cerr << "BaseContainer: inconsistent arena record at offset "<<records[i].m_offset<<std::endl;
+            return false;
+         }
+         if(( !shared )&&( records[i].m_offset < end )) {
+            std::cerr << "BaseContainer: overlapping arena record at offset "<<records[i].m_offset<<std::endl;
+            return false;
+         }
+         end = records[i].m_offset + records[i].m_size;
+         if( end > m_arenaUsed ) {
+            std::cerr << "BaseContainer: arena record exceeds the used arena ("<<end<<">"<<m_arenaUsed<<")"<<std::endl;
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Moves the arena records of the chunks down over removed records
+    *
+    * \param [in] seconds time slice in seconds. 0 compacts the whole arena
+    * \return true when the arena is compact, false if the time slice ended
+    *         first or the arena is inconsistent
+    *
+    * Records are moved in arena order, so records that were already in
+    * place are not copied again. With a time slice the call returns after
+    * the first record that exceeds it, and later calls resume where it
+    * stopped. If the container was changed in between, the remaining work
+    * is planned again.
+    *
+    * Only records that are referenced by array chunks alone are moved, and
+    * the array chunks are updated to the new payload location. Records that
+    * are also held elsewhere (allocated but not yet pushed, popped or erased
+    * chunks that are still in use, or copies taken from the container) keep
+    * their place and contents, so the space in front of them may remain
+    * unused until they are released.
+    **/
+   bool BaseContainer::compact( double seconds )
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      std::lock_guard<std::mutex> arenaGuard( m_arenaMutex );
+
+      if(( !m_compacting )||( m_compactVersion != m_version )) {
+         if( !collectArenaRecords( m_compactPlan )) {
+            m_compactPlan.clear();
+            m_compacting = false;
+            return false;
+         }
+         m_compactNext    = 0;
+         m_compactCursor  = 0;
+         m_compactVersion = m_version;
+         m_compacting     = true;
+      }
+
+      Timer timer;
+      timer.start();
+
+      uint8_t   * arena  = m_arena.m_buffer.get();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+      while( m_compactNext < m_compactPlan.size()) {
+         ArenaRecord & record = m_compactPlan[m_compactNext];
+         size_t first = m_compactNext;
+         while(( m_compactNext < m_compactPlan.size())&&( m_compactPlan[m_compactNext].m_offset == record.m_offset )) {
+            m_compactNext++;
+         }
+         size_t positions = m_compactNext - first;
+
+         //Chunks may have been copied out of the array since the plan was made
+         if(( record.m_position == SIZE_MAX )
+          ||( (size_t)chunks[record.m_position].m_buffer.m_buffer.use_count() > positions )) {
+            m_compactCursor = record.m_offset + record.m_size;
+            continue;
+         }
+
+         if( m_compactCursor != record.m_offset ) {
+            memmove( arena + m_compactCursor, arena + record.m_offset, record.m_size );
+
+            //All chunks sharing the record move to one new payload, which releases the old one
+            std::shared_ptr<uint8_t> payload = getArenaPointer( arena + m_compactCursor + chunks[record.m_position].getHeaderSize());
+            ArenaRecord moved;
+            moved.m_offset  = m_compactCursor;
+            moved.m_size    = record.m_size;
+            moved.m_payload = payload;
+            for( size_t i = first; i < m_compactNext; i++ ) {
+               chunks[m_compactPlan[i].m_position].m_buffer.m_buffer = payload;
+            }
+            m_arenaRecords.push_back( moved );
+         }
+         m_compactCursor += record.m_size;
+
+         if(( seconds > 0 )&&( timer.elapsed() >= seconds )) {
+            break;
+         }
+      }
+      m_containerArray.unlockBuffer();
+
+      if( m_compactNext < m_compactPlan.size()) {
+         return false;
+      }
+
+      m_arenaUsed = m_compactCursor;
+      m_compactPlan.clear();
+      m_compacting = false;
+      m_version++;
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the number of used arena bytes that no chunk refers to
+    *
+    * Records of removed chunks count as garbage once no copy of them is held
+    * any more, until compact reclaims them. Returns 0 if the arena is
+    * inconsistent.
+    **/
+   size_t BaseContainer::getArenaGarbage()
+   {
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      std::lock_guard<std::mutex> arenaGuard( m_arenaMutex );
+
+      std::vector<ArenaRecord> records;
+      if( !collectArenaRecords( records )) {
+         return 0;
+      }
+
+      size_t live = 0;
+      for( size_t i = 0; i < records.size(); i++ ) {
+         if(( i == 0 )||( records[i].m_offset != records[i-1].m_offset )) {
+            live += records[i].m_size;
+         }
+      }
+
+      return m_arenaUsed - live;
+   }
+
+   /**
+    * \brief Checks that the chunks are exactly the arena records in order
+    *
+    * This is the case when all chunks were allocated from the arena, pushed in
+    * allocation order and their types were not changed after allocation. The
+    * caller must hold m_arenaMutex and the array lock.
+    **/
+   bool BaseContainer::isArenaContiguous( BaseChunk * chunks, size_t count )
+   {
+      if(( count == 0 )||( m_arenaUsed == 0 )) {
+         return false;
+      }
+
+      uint8_t * arena    = m_arena.m_buffer.get();
+      size_t    position = 0;
+      for( size_t i = 0; i < count; i++ ) {
+         BaseChunk & chunk = chunks[i];
+         if( chunk.m_buffer.m_buffer.get() != arena + position + chunk.getHeaderSize()) {
+            return false;
+         }
+         position += getRecordSize( chunk.m_metadata.m_type.length(), chunk.m_buffer.getSize());
+      }
+
+      return position == m_arenaUsed;
+   }
+
+   /**
+    * \brief Writes one index entry
+    **/
+   static void encodeIndexEntry( uint8_t * item, uint64_t id, uint64_t offset, uint64_t size, uint32_t checksum )
+   {
+      writeLE64( &item[0],  id );
+      writeLE64( &item[8],  offset );
+      writeLE64( &item[16], size );
+      writeLE32( &item[24], checksum );
+      writeLE32( &item[28], 0 );
+   }
+
+   /**
+    * \brief Writes the container file header
+    **/
+   static void encodeFileHeader( uint8_t * header, uint64_t id, uint64_t count )
+   {
+      memcpy( &header[0], BASECONTAINER_MAGIC, 4 );
+      writeLE16( &header[4],  BASECONTAINER_VERSION );
+      writeLE16( &header[6],  0 );
+      writeLE64( &header[8],  id );
+      writeLE64( &header[16], count );
+   }
+
+   /**
+    * \brief Writes the footer that follows an index of count entries
+    *
+    * \param [in] index encoded index. The footer is written directly after it
+    * \param [in] indexOffset file offset of the index
+    * \param [in] count number of index entries
+    **/
+   static void encodeFooter( uint8_t * index, uint64_t indexOffset, uint64_t count )
+   {
+      size_t    indexBytes = count * BASECONTAINER_INDEX_ENTRY_SIZE;
+      uint8_t * footer     = &index[indexBytes];
+      writeLE64( &footer[0],  indexOffset );
+      writeLE64( &footer[8],  count );
+      writeLE32( &footer[16], crc32c( index, indexBytes ));
+      writeLE16( &footer[20], BASECONTAINER_VERSION );
+      writeLE16( &footer[22], 0 );
+      writeLE32( &footer[24], 0 );
+      memcpy( &footer[28], BASECONTAINER_FOOTER_MAGIC, 4 );
+   }
+
+   /**
+    * \brief Finds the chunks that repeat the payload of an earlier chunk
+    *
+    * \param [in] chunks chunks in container order
+    * \param [in] count number of chunks
+    * \param [in] dedup deduplicator to use. May be NULL
+    * \return position of the referenced chunk for every chunk, SIZE_MAX if the
+    * payload is written. Empty if no chunk is written as a reference
+    **/
+   static std::vector<size_t> findReferences( BaseChunk * chunks, size_t count, ChunkDeduplicator * dedup )
+   {
+      std::vector<size_t> references;
+      if( dedup == NULL ) {
+         return references;
+      }
+
+      dedup->clear();
+      references.resize( count, SIZE_MAX );
+      bool found = false;
+      for( size_t i = 0; i < count; i++ ) {
+         if( dedup->findReference( chunks[i], i, &references[i] )) {
+            found = true;
+         }
+         else {
+            references[i] = SIZE_MAX;
+         }
+      }
+      dedup->clear();
+
+      if( !found ) {
+         references.clear();
+      }
+
+      return references;
+   }
+
+   /**
+    * \brief Returns true if the chunk at the given position is written as a reference
+    **/
+   static inline bool isReference( const std::vector<size_t> &references, size_t position )
+   {
+      return ( !references.empty())&&( references[position] != SIZE_MAX );
+   }
+
+   /**
+    * \brief Saves the container as an indexed container file
+    *
+    * \param [in] filename name of the file to write. An existing file is replaced
+    * \param [in] dedup optional deduplicator. Chunks that repeat an earlier payload are written as references
+    * \return true on success, false on failure
+    *
+    * Chunk records are written in container order followed by an index of all
+    * chunks and a fixed size footer (see BaseContainer.h).
+    *
+    * If the chunks are the contiguous records of the arena, the headers are
+    * encoded in place and the file is written with one writev of the file
+    * header, the arena and the index. Otherwise the headers are encoded into
+    * one buffer and the records are gathered with writev in batches of up to
+    * IOV_MAX buffers. Payloads are not copied in either case. Reference
+    * records are encoded completely into the header buffer.
+    *
+    * The contiguous path holds m_arenaMutex until the arena is written, so
+    * allocateChunk and compact cannot change the arena or its length in
+    * between.
+    **/
+   bool BaseContainer::save( std::string filename, ChunkDeduplicator * dedup )
+   {
+      static const uint8_t padding[BASECONTAINER_ALIGNMENT] = {0};
+
+      int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "BaseContainer: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      //The arena lock is taken before the array lock, as in compact
+      std::unique_lock<std::mutex> arenaGuard( m_arenaMutex );
+      size_t      count  = m_containerArray.getSize();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+
+      std::vector<size_t> references = findReferences( chunks, count, dedup );
+      bool contiguous = ( references.empty())&&( isArenaContiguous( chunks, count ));
+      if( !contiguous ) {
+         arenaGuard.unlock();
+      }
+
+      //Encode the file header and all chunk headers up front so the iovecs stay valid
+      size_t headerBytes = BASECONTAINER_HEADER_SIZE;
+      for( size_t i = 0; ( !contiguous )&&( i < count ); i++ ) {
+         headerBytes += isReference( references, i ) ? ChunkDeduplicator::getReferenceRecordSize( chunks[i] ) : chunks[i].getHeaderSize();
+      }
+
+      std::vector<uint8_t> headers( headerBytes );
+      encodeFileHeader( &headers[0], m_metadata.m_id, count );
+
+      std::vector<uint8_t> index( count * BASECONTAINER_INDEX_ENTRY_SIZE + BASECONTAINER_FOOTER_SIZE );
+      std::vector<struct iovec> iov;
+      iov.reserve( 3 * count + 1 );
+
+      struct iovec entry;
+      entry.iov_base = &headers[0];
+      entry.iov_len  = BASECONTAINER_HEADER_SIZE;
+      iov.push_back( entry );
+
+      uint64_t offset   = BASECONTAINER_HEADER_SIZE;
+      size_t   position = BASECONTAINER_HEADER_SIZE;
+      if( contiguous ) {
+         uint8_t * arena = m_arena.m_buffer.get();
+         for( size_t i = 0; i < count; i++ ) {
+            BaseChunk & chunk = chunks[i];
+            uint8_t * record = arena + offset - BASECONTAINER_HEADER_SIZE;
+            size_t recordSize = chunk.encodeHeader( record, chunk.getHeaderSize()) + chunk.m_buffer.getSize();
+
+            encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                            , chunk.m_metadata.m_id
+                            , offset
+                            , recordSize
+                            , crc32c( record, recordSize )
+                            );
+            offset += getRecordSize( chunk.m_metadata.m_type.length(), chunk.m_buffer.getSize());
+         }
+
+         entry.iov_base = arena;
+         entry.iov_len  = m_arenaUsed;
+         iov.push_back( entry );
+      }
+
+      for( size_t i = 0; ( !contiguous )&&( i < count ); i++ ) {
+         BaseChunk & chunk = chunks[i];
+         uint8_t * header = &headers[position];
+         size_t headerSize  = 0;
+         size_t payloadSize = 0;
+         if( isReference( references, i )) {
+            headerSize = ChunkDeduplicator::encodeReferenceRecord( chunk, references[i], header, headerBytes - position );
+         }
+         else {
+            headerSize  = chunk.encodeHeader( header, headerBytes - position );
+            payloadSize = chunk.m_buffer.getSize();
+         }
+         position += headerSize;
+
+         uint64_t recordSize  = headerSize + payloadSize;
+         uint32_t checksum    = crc32c( header, headerSize );
+         checksum = crc32c( chunk.m_buffer.m_buffer.get(), payloadSize, checksum );
+
+         encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                         , chunk.m_metadata.m_id
+                         , offset
+                         , recordSize
+                         , checksum
+                         );
+
+         entry.iov_base = header;
+         entry.iov_len  = headerSize;
+         iov.push_back( entry );
+
+         if( payloadSize > 0 ) {
+            entry.iov_base = chunk.m_buffer.m_buffer.get();
+            entry.iov_len  = payloadSize;
+            iov.push_back( entry );
+         }
+
+         size_t pad = ( BASECONTAINER_ALIGNMENT - recordSize % BASECONTAINER_ALIGNMENT ) % BASECONTAINER_ALIGNMENT;
+         if( pad > 0 ) {
+            entry.iov_base = (void *)padding;
+            entry.iov_len  = pad;
+            iov.push_back( entry );
+         }
+
+         offset += recordSize + pad;
+      }
+
+      //Append the footer to the index
+      encodeFooter( index.data(), offset, count );
+
+      entry.iov_base = index.data();
+      entry.iov_len  = index.size();
+      iov.push_back( entry );
+
+      bool rc = true;
+      for( size_t i = 0; ( rc )&&( i < iov.size() ); i += IOV_MAX ) {
+         size_t batch = iov.size() - i;
+         if( batch > IOV_MAX ) {
+            batch = IOV_MAX;
+         }
+         rc = writevFully( fd, &iov[i], batch );
+      }
+
+      m_containerArray.unlockBuffer();
+
+      if( close( fd ) != 0 ) {
+         rc = false;
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Computes the file offset of every chunk record from the metadata sizes
+    * \return count + 1 offsets. The last one is the offset of the index
+    **/
+   static std::vector<uint64_t> getRecordOffsets( BaseChunk * chunks, size_t count, const std::vector<size_t> &references )
+   {
+      std::vector<uint64_t> offsets( count + 1 );
+      offsets[0] = BASECONTAINER_HEADER_SIZE;
+      for( size_t i = 0; i < count; i++ ) {
+         size_t payloadSize = isReference( references, i ) ? BASECHUNK_REFERENCE_SIZE : chunks[i].m_buffer.getSize();
+         offsets[i+1] = offsets[i] + BaseContainer::getRecordSize( chunks[i].m_metadata.m_type.length(), payloadSize );
+      }
+
+      return offsets;
+   }
+
+   /**
+    * \brief Returns a parallelFor block size that gives each worker several blocks
+    **/
+   static size_t getBlockSize( size_t count, AThreadPool &pool )
+   {
+      size_t blocks = 4 * pool.getThreadCount();
+      return ( count + blocks - 1 ) / blocks;
+   }
+
+   /**
+    * \brief Saves the container as an indexed container file using a thread pool
+    *
+    * \param [in] filename name of the file to write. An existing file is replaced
+    * \param [in] pool workers that encode and write the chunks
+    * \param [in] dedup optional deduplicator. Chunks that repeat an earlier payload are written as references
+    * \return true on success, false on failure
+    *
+    * The file offset of every record is computed up front from the metadata
+    * sizes and the file is extended to its final size. The workers then encode
+    * and checksum the chunks and write each record to its final position with
+    * pwritev. The resulting file is identical to the one written by save.
+    * Payload hashing for deduplication runs on the calling thread before the
+    * layout is computed.
+    **/
+   bool BaseContainer::save( std::string filename, AThreadPool &pool, ChunkDeduplicator * dedup )
+   {
+      int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "BaseContainer: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      size_t      count  = m_containerArray.getSize();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+
+      std::vector<size_t>   references = findReferences( chunks, count, dedup );
+      std::vector<uint64_t> offsets    = getRecordOffsets( chunks, count, references );
+
+      //Record gaps are left as holes, which read back as the zero padding
+      uint64_t indexOffset = offsets[count];
+      std::vector<uint8_t> index( count * BASECONTAINER_INDEX_ENTRY_SIZE + BASECONTAINER_FOOTER_SIZE );
+      std::atomic<bool> rc( ftruncate( fd, indexOffset + index.size()) == 0 );
+      if( !rc ) {
+         std::cerr << "BaseContainer: unable to size "<<filename<<": "<<strerror(errno)<<std::endl;
+      }
+
+      if( rc ) {
+         pool.parallelFor( count, getBlockSize( count, pool ), [&]( size_t begin, size_t end ) {
+            std::vector<uint8_t> header;
+            for( size_t i = begin; ( rc )&&( i < end ); i++ ) {
+               BaseChunk & chunk = chunks[i];
+               if( isReference( references, i )) {
+                  header.resize( ChunkDeduplicator::getReferenceRecordSize( chunk ));
+                  size_t recordSize = ChunkDeduplicator::encodeReferenceRecord( chunk, references[i], header.data(), header.size());
+                  encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                                  , chunk.m_metadata.m_id
+                                  , offsets[i]
+                                  , recordSize
+                                  , crc32c( header.data(), recordSize )
+                                  );
+                  if( !pwriteFully( fd, header.data(), recordSize, offsets[i] )) {
+                     rc = false;
+                  }
+                  continue;
+               }
+
+               header.resize( chunk.getHeaderSize());
+               size_t headerSize = chunk.encodeHeader( header.data(), header.size());
+
+               size_t   payloadSize = chunk.m_buffer.getSize();
+               uint32_t checksum    = crc32c( header.data(), headerSize );
+               checksum = crc32c( chunk.m_buffer.m_buffer.get(), payloadSize, checksum );
+
+               encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                               , chunk.m_metadata.m_id
+                               , offsets[i]
+                               , headerSize + payloadSize
+                               , checksum
+                               );
+
+               struct iovec iov[2];
+               iov[0].iov_base = header.data();
+               iov[0].iov_len  = headerSize;
+               iov[1].iov_base = chunk.m_buffer.m_buffer.get();
+               iov[1].iov_len  = payloadSize;
+               if( !pwritevFully( fd, iov, 2, offsets[i] )) {
+                  rc = false;
+               }
+            }
+         });
+      }
+
+      uint8_t header[BASECONTAINER_HEADER_SIZE];
+      encodeFileHeader( header, m_metadata.m_id, count );
+      encodeFooter( index.data(), indexOffset, count );
+      m_containerArray.unlockBuffer();
+
+      bool result = ( rc )
+                 && ( pwriteFully( fd, header, sizeof(header), 0 ))
+                 && ( pwriteFully( fd, index.data(), index.size(), indexOffset ));
+
+      if( close( fd ) != 0 ) {
+         result = false;
+      }
+
+      return result;
+   }
+
+   /**
+    * \brief Saves the container as an indexed container file using an asynchronous writer
+    *
+    * \param [in] filename name of the file to write. An existing file is replaced
+    * \param [in] writer open writer that performs the chunk writes
+    * \param [in] dedup optional deduplicator. Chunks that repeat an earlier payload are written as references
+    * \return true on success, false on failure
+    *
+    * Record offsets are computed up front and every chunk record is queued on
+    * the writer, so the calling thread only encodes headers and checksums while
+    * the writes are in flight. The function waits for all writes of the writer
+    * to complete. The resulting file is identical to the one written by save.
+    **/
+   bool BaseContainer::save( std::string filename, AsyncWriter &writer, ChunkDeduplicator * dedup )
+   {
+      int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "BaseContainer: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      size_t      count  = m_containerArray.getSize();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+
+      std::vector<size_t>   references = findReferences( chunks, count, dedup );
+      std::vector<uint64_t> offsets    = getRecordOffsets( chunks, count, references );
+      uint64_t indexOffset = offsets[count];
+      std::vector<uint8_t> index( count * BASECONTAINER_INDEX_ENTRY_SIZE + BASECONTAINER_FOOTER_SIZE );
+      std::atomic<bool> rc( ftruncate( fd, indexOffset + index.size()) == 0 );
+      if( !rc ) {
+         std::cerr << "BaseContainer: unable to size "<<filename<<": "<<strerror(errno)<<std::endl;
+      }
+
+      AsyncWriteCallback callback = [&rc]( ssize_t result ) {
+         if( result < 0 ) {
+            rc = false;
+         }
+      };
+
+      std::vector<uint8_t> header;
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         BaseChunk & chunk = chunks[i];
+         if( isReference( references, i )) {
+            BaseBuffer record;
+            size_t recordSize = ChunkDeduplicator::getReferenceRecordSize( chunk );
+            if(( !record.allocate( recordSize ))
+             ||( !ChunkDeduplicator::encodeReferenceRecord( chunk, references[i], record.m_buffer.get(), recordSize ))) {
+               rc = false;
+               break;
+            }
+
+            encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                            , chunk.m_metadata.m_id
+                            , offsets[i]
+                            , recordSize
+                            , crc32c( record.m_buffer.get(), recordSize )
+                            );
+            if( !writer.write( fd, record, offsets[i], callback )) {
+               rc = false;
+            }
+            continue;
+         }
+
+         header.resize( chunk.getHeaderSize());
+         size_t headerSize = chunk.encodeHeader( header.data(), header.size());
+
+         size_t   payloadSize = chunk.m_buffer.getSize();
+         uint32_t checksum    = crc32c( header.data(), headerSize );
+         checksum = crc32c( chunk.m_buffer.m_buffer.get(), payloadSize, checksum );
+
+         encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                         , chunk.m_metadata.m_id
+                         , offsets[i]
+                         , headerSize + payloadSize
+                         , checksum
+                         );
+
+         if( !writer.writeChunk( fd, chunk, offsets[i], callback )) {
+            rc = false;
+         }
+      }
+      m_containerArray.unlockBuffer();
+      writer.wait();
+
+      uint8_t fileHeader[BASECONTAINER_HEADER_SIZE];
+      encodeFileHeader( fileHeader, m_metadata.m_id, count );
+      encodeFooter( index.data(), indexOffset, count );
+
+      bool result = ( rc )
+                 && ( pwriteFully( fd, fileHeader, sizeof(fileHeader), 0 ))
+                 && ( pwriteFully( fd, index.data(), index.size(), indexOffset ));
+
+      if( close( fd ) != 0 ) {
+         result = false;
+      }
+
+      return result;
+   }
+
+   /**
+    * \brief Streams the container file format through a DirectWriter
+    *
+    * \param [in] writer writer opened on an empty file
+    * \param [in] dedup optional deduplicator. Chunks that repeat an earlier payload are written as references
+    * \return true on success, false on failure
+    *
+    * Records are written sequentially, so the writer's staging buffer merges
+    * headers, padding and the index into aligned blocks. The writer is flushed
+    * but not closed. The resulting file is identical to the one written by save.
+    **/
+   bool BaseContainer::save( DirectWriter &writer, ChunkDeduplicator * dedup )
+   {
+      static const uint8_t padding[BASECONTAINER_ALIGNMENT] = {0};
+
+      if(( !writer.isOpen())||( writer.getOffset() != 0 )) {
+         std::cerr << "BaseContainer: writer must be open on an empty file"<<std::endl;
+         return false;
+      }
+
+      size_t      count  = m_containerArray.getSize();
+      BaseChunk * chunks = m_containerArray.lockBuffer();
+
+      std::vector<size_t> references = findReferences( chunks, count, dedup );
+
+      uint8_t fileHeader[BASECONTAINER_HEADER_SIZE];
+      encodeFileHeader( fileHeader, m_metadata.m_id, count );
+      bool rc = writer.write( fileHeader, sizeof(fileHeader));
+
+      std::vector<uint8_t> index( count * BASECONTAINER_INDEX_ENTRY_SIZE + BASECONTAINER_FOOTER_SIZE );
+      std::vector<uint8_t> header;
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         BaseChunk & chunk = chunks[i];
+         if( isReference( references, i )) {
+            header.resize( ChunkDeduplicator::getReferenceRecordSize( chunk ));
+            size_t recordSize = ChunkDeduplicator::encodeReferenceRecord( chunk, references[i], header.data(), header.size());
+            encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                            , chunk.m_metadata.m_id
+                            , writer.getOffset()
+                            , recordSize
+                            , crc32c( header.data(), recordSize )
+                            );
+
+            size_t pad = ( BASECONTAINER_ALIGNMENT - recordSize % BASECONTAINER_ALIGNMENT ) % BASECONTAINER_ALIGNMENT;
+            rc = writer.write( header.data(), recordSize )
+              && writer.write( padding, pad );
+            continue;
+         }
+
+         header.resize( chunk.getHeaderSize());
+         size_t headerSize = chunk.encodeHeader( header.data(), header.size());
+
+         size_t   payloadSize = chunk.m_buffer.getSize();
+         uint64_t recordSize  = headerSize + payloadSize;
+         uint32_t checksum    = crc32c( header.data(), headerSize );
+         checksum = crc32c( chunk.m_buffer.m_buffer.get(), payloadSize, checksum );
+
+         encodeIndexEntry( &index[i * BASECONTAINER_INDEX_ENTRY_SIZE]
+                         , chunk.m_metadata.m_id
+                         , writer.getOffset()
+                         , recordSize
+                         , checksum
+                         );
+
+         size_t pad = ( BASECONTAINER_ALIGNMENT - recordSize % BASECONTAINER_ALIGNMENT ) % BASECONTAINER_ALIGNMENT;
+         rc = writer.write( header.data(), headerSize )
+           && writer.write( chunk.m_buffer.m_buffer.get(), payloadSize )
+           && writer.write( padding, pad );
+      }
+      m_containerArray.unlockBuffer();
+
+      if( rc ) {
+         encodeFooter( index.data(), writer.getOffset(), count );
+         rc = writer.write( index.data(), index.size())&&( writer.flush());
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Replaces the contents of the container with a container file
+    *
+    * \param [in] filename name of the container file
+    * \param [in] pool workers that read and verify the chunks
+    * \return true on success, false on failure. The container is unchanged on failure
+    *
+    * The index is read by ContainerReader. The workers then read every chunk
+    * record with pread into its own buffer and verify its checksum. Reference
+    * records (see ChunkDeduplicator) are resolved afterwards; the chunks share
+    * the buffer of the referenced chunk.
+    **/
+   bool BaseContainer::load( std::string filename, AThreadPool &pool )
+   {
+      ContainerReader reader;
+      if( !reader.open( filename )) {
+         return false;
+      }
+
+      int fd = open( filename.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         std::cerr << "BaseContainer: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      size_t count = reader.getChunkCount();
+      std::vector<ContainerIndexEntry> entries( count );
+      for( size_t i = 0; i < count; i++ ) {
+         reader.getEntry( i, entries[i] );
+      }
+
+      std::vector<BaseChunk> chunks( count );
+      std::vector<uint8_t>   referenceFlags( count, 0 );
+      std::atomic<bool>      rc( true );
+      pool.parallelFor( count, getBlockSize( count, pool ), [&]( size_t begin, size_t end ) {
+         for( size_t i = begin; ( rc )&&( i < end ); i++ ) {
+            ContainerIndexEntry & entry = entries[i];
+            BaseChunk & chunk = chunks[i];
+
+            uint8_t  fixed[BASECHUNK_HEADER_SIZE];
+            uint32_t typeLength = 0;
+            uint64_t dataSize   = 0;
+            uint16_t flags      = 0;
+            if(( !preadFully( fd, fixed, sizeof(fixed), entry.m_offset ))
+             ||( !chunk.decodeHeader( fixed, sizeof(fixed), &typeLength, &dataSize, &flags ))
+             ||( dataSize > entry.m_size )
+             ||( BASECHUNK_HEADER_SIZE + typeLength + dataSize != entry.m_size )) {
+               std::cerr << "BaseContainer: "<<filename<<": invalid chunk record "<<i<<std::endl;
+               rc = false;
+               break;
+            }
+
+            chunk.m_metadata.m_type.resize( typeLength );
+            if(( dataSize > 0 )&&( !chunk.m_buffer.allocate( dataSize ))) {
+               rc = false;
+               break;
+            }
+
+            struct iovec iov[2];
+            iov[0].iov_base = &chunk.m_metadata.m_type[0];
+            iov[0].iov_len  = typeLength;
+            iov[1].iov_base = chunk.m_buffer.m_buffer.get();
+            iov[1].iov_len  = dataSize;
+
+            uint32_t checksum = crc32c( fixed, sizeof(fixed));
+            if( !preadvFully( fd, iov, 2, entry.m_offset + BASECHUNK_HEADER_SIZE )) {
+               rc = false;
+               break;
+            }
+            checksum = crc32c( chunk.m_metadata.m_type.data(), typeLength, checksum );
+            checksum = crc32c( chunk.m_buffer.m_buffer.get(), dataSize, checksum );
+            if( checksum != entry.m_checksum ) {
+               std::cerr << "BaseContainer: "<<filename<<": checksum mismatch in chunk record "<<i<<std::endl;
+               rc = false;
+               break;
+            }
+            referenceFlags[i] = ( flags & BASECHUNK_FLAG_REFERENCE ) ? 1 : 0;
+         }
+      });
+      close( fd );
+
+      //References point backwards, so their targets are resolved before them
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         if( !referenceFlags[i] ) {
+            continue;
+         }
+
+         size_t   reference = 0;
+         uint64_t size      = 0;
+         if(( !ChunkDeduplicator::decodeReference( chunks[i].m_buffer.m_buffer.get(), chunks[i].m_buffer.getSize(), i, &reference, &size ))
+          ||( chunks[reference].m_buffer.getSize() != size )) {
+            std::cerr << "BaseContainer: "<<filename<<": invalid reference in chunk record "<<i<<std::endl;
+            rc = false;
+            break;
+         }
+         chunks[i].m_buffer = chunks[reference].m_buffer;
+      }
+
+      if( !rc ) {
+         return false;
+      }
+
+      std::lock_guard<std::mutex> guard( m_indexMutex );
+      m_containerArray.setSize( 0 );
+      m_metadata.m_id   = reader.getId();
+      m_metadata.m_size = 0;
+      for( size_t i = 0; i < count; i++ ) {
+         m_containerArray.push_back( chunks[i] );
+         m_metadata.m_size += chunks[i].getSize();
+      }
+      m_metadata.m_elementCount = count;
+      m_version++;
+      rebuildIndex();
+
+      return true;
+   }
+
    //Test functions
    bool testBaseContainer() 
    {
@@ -56,6 +1209,361 @@ namespace atl
          return false;
       }
 
+      //Id lookups follow push_back, pop and erase
+      BaseContainer indexed;
+      for( size_t i = 0; i < 1000; i++ ) {
+         BaseChunk item( i * 7 );
+         item.allocate( 4 );
+         item.m_buffer[0] = (uint8_t)i;
+         indexed.push_back( item );
+      }
+
+      BaseChunk found;
+      size_t position = 0;
+      if(( !indexed.find( 700, &found ))||( found.m_buffer[0] != 100 )||( indexed.find( 701, &found ))) {
+         std::cout << "BaseContainer find by id failed"<<std::endl;
+         return false;
+      }
+
+      BaseChunk last = indexed.pop();
+      if(( last.m_metadata.m_id != 999 * 7 )||( indexed.find( 999 * 7, &found ))
+       ||( indexed.getSize() != baseSize + 999 * last.getSize())) {
+         std::cout << "BaseContainer pop failed"<<std::endl;
+         return false;
+      }
+
+      if(( !indexed.erase( 10 ))||( indexed.findIndex( 70, &position ))
+       ||( !indexed.findIndex( 77, &position ))||( position != 10 )
+       ||( !indexed.remove( 77 ))||( !indexed.find( 84, &found ))||( found.m_buffer[0] != 12 )
+       ||( indexed.remove( 77 ))||( indexed.erase( 10000 ))) {
+         std::cout << "BaseContainer erase failed"<<std::endl;
+         return false;
+      }
+
+      //Duplicate ids resolve to the first chunk until it is removed
+      BaseChunk duplicate( 14 );
+      duplicate.allocate( 4 );
+      duplicate.m_buffer[0] = 200;
+      indexed.push_back( duplicate );
+      if(( !indexed.find( 14, &found ))||( found.m_buffer[0] != 2 )
+       ||( !indexed.remove( 14 ))||( !indexed.find( 14, &found ))||( found.m_buffer[0] != 200 )) {
+         std::cout << "BaseContainer duplicate id lookup failed"<<std::endl;
+         return false;
+      }
+
+      //Concurrent removals by id each remove exactly their own chunk
+      BaseContainer shared;
+      for( size_t i = 0; i < 2000; i++ ) {
+         shared.push_back( BaseChunk( i ));
+      }
+      std::atomic<size_t> misses(0);
+      auto removeEvery = [&shared, &misses]( size_t first ) {
+         for( size_t i = first; i < 2000; i += 2 ) {
+            if( !shared.remove( i )) {
+               misses++;
+            }
+         }
+      };
+      std::thread evenThread( removeEvery, 0 );
+      std::thread oddThread( removeEvery, 1 );
+      evenThread.join();
+      oddThread.join();
+      if(( misses != 0 )||( shared.m_containerArray.getSize() != 0 )) {
+         std::cout << "BaseContainer concurrent removal missed "<<misses<<" chunks"<<std::endl;
+         return false;
+      }
+
+      //An arena container must produce the same file as a heap container
+      BaseContainer heap;
+      BaseContainer arena;
+      size_t arenaBytes = 0;
+      for( size_t i = 0; i < 20; i++ ) {
+         arenaBytes += BaseContainer::getRecordSize( i % 3, i * 5 );
+      }
+      if(( !arena.reserveArena( arenaBytes ))||( arena.m_arena.getSize() != arenaBytes )) {
+         std::cout << "BaseContainer failed to reserve arena"<<std::endl;
+         return false;
+      }
+
+      for( size_t i = 0; i < 20; i++ ) {
+         BaseChunk heapChunk( i );
+         BaseChunk arenaChunk( i );
+         heapChunk.m_metadata.m_type.assign( i % 3, 'a' );
+         arenaChunk.m_metadata.m_type.assign( i % 3, 'a' );
+         heapChunk.allocate( i * 5 );
+         if( !arena.allocateChunk( arenaChunk, i * 5 )) {
+            std::cout << "BaseContainer arena allocation "<<i<<" failed"<<std::endl;
+            return false;
+         }
+         for( size_t j = 0; j < i * 5; j++ ) {
+            heapChunk.m_buffer[j]  = (uint8_t)( i * j );
+            arenaChunk.m_buffer[j] = (uint8_t)( i * j );
+         }
+         heap.push_back( heapChunk );
+         arena.push_back( arenaChunk );
+      }
+
+      BaseChunk extra;
+      if( arena.allocateChunk( extra, 1 )) {
+         std::cout << "BaseContainer allocated past the end of the arena"<<std::endl;
+         return false;
+      }
+
+      char heapName[]  = "/tmp/BaseContainerHeapXXXXXX";
+      char arenaName[] = "/tmp/BaseContainerArenaXXXXXX";
+      int heapFd  = mkstemp( heapName );
+      int arenaFd = mkstemp( arenaName );
+      bool rc = ( heapFd >= 0 )&&( arenaFd >= 0 )&&( heap.save( heapName ))&&( arena.save( arenaName ));
+
+      std::vector<uint8_t> heapData( 1 << 16 );
+      std::vector<uint8_t> arenaData( 1 << 16 );
+      ssize_t heapBytes  = rc ? pread( heapFd, heapData.data(), heapData.size(), 0 ) : -1;
+      ssize_t arenaRead  = rc ? pread( arenaFd, arenaData.data(), arenaData.size(), 0 ) : -1;
+      close( heapFd );
+      close( arenaFd );
+      unlink( heapName );
+      unlink( arenaName );
+
+      if(( !rc )||( heapBytes <= 0 )||( heapBytes != arenaRead )
+       ||( memcmp( heapData.data(), arenaData.data(), heapBytes ))) {
+         std::cout << "BaseContainer arena file does not match heap file"<<std::endl;
+         return false;
+      }
+
+      //A parallel save must produce the same file and load it back
+      AThreadPool pool( 3 );
+      char parallelName[] = "/tmp/BaseContainerParallelXXXXXX";
+      int parallelFd = mkstemp( parallelName );
+      std::vector<uint8_t> parallelData( 1 << 16 );
+      ssize_t parallelBytes = -1;
+      heap.m_metadata.m_id = 42;
+      rc = ( parallelFd >= 0 )&&( heap.save( heapName ))&&( heap.save( parallelName, pool ));
+      if( rc ) {
+         parallelBytes = pread( parallelFd, parallelData.data(), parallelData.size(), 0 );
+         heapFd = open( heapName, O_RDONLY );
+         heapBytes = pread( heapFd, heapData.data(), heapData.size(), 0 );
+         close( heapFd );
+      }
+      close( parallelFd );
+
+      BaseContainer loaded;
+      BaseChunk loadedChunk;
+      rc = ( rc )&&( parallelBytes > 0 )&&( parallelBytes == heapBytes )
+        && ( !memcmp( heapData.data(), parallelData.data(), parallelBytes ))
+        && ( loaded.load( parallelName, pool ))
+        && ( loaded.m_containerArray.getSize() == 20 )
+        && ( loaded.getSize() == heap.getSize())
+        && ( loaded.m_metadata.m_id == 42 )
+        && ( loaded.find( 13, &loadedChunk ))
+        && ( loadedChunk.m_buffer.getSize() == 65 )
+        && ( loadedChunk.m_buffer[64] == (uint8_t)( 13 * 64 ))
+        && ( loadedChunk.m_metadata.m_type == "a" );
+      unlink( heapName );
+      unlink( parallelName );
+
+      if( !rc ) {
+         std::cout << "BaseContainer parallel save/load failed"<<std::endl;
+         return false;
+      }
+
+      //Repeated payloads are written once and resolved by every reader
+      BaseContainer repeated;
+      BaseChunk background( 0 );
+      background.allocate( 4096 );
+      memset( background.m_buffer.m_buffer.get(), 0x11, 4096 );
+      for( size_t i = 0; i < 10; i++ ) {
+         BaseChunk frame( 100 + i );
+         frame.m_metadata.m_type = "frame";
+         if( i % 3 == 0 ) {
+            frame.allocate( 4096 );
+            memset( frame.m_buffer.m_buffer.get(), (int)i, 4096 );
+         }
+         else {
+            frame.m_buffer = background.m_buffer;
+         }
+         repeated.push_back( frame );
+      }
+
+      char dedupName[]    = "/tmp/BaseContainerDedupXXXXXX";
+      char parallelDedup[] = "/tmp/BaseContainerDedupParallelXXXXXX";
+      int dedupFd     = mkstemp( dedupName );
+      parallelFd      = mkstemp( parallelDedup );
+      ChunkDeduplicator dedup;
+      ContainerReader   reader;
+      BaseContainer     restored;
+      BaseChunk         resolved;
+      std::vector<uint8_t> dedupData( 1 << 16 );
+      rc = ( dedupFd >= 0 )&&( parallelFd >= 0 )
+        && ( repeated.save( dedupName, &dedup ))
+        && ( repeated.save( parallelDedup, pool, &dedup ));
+      ssize_t dedupBytes = rc ? pread( dedupFd, dedupData.data(), dedupData.size(), 0 ) : -1;
+      parallelBytes      = rc ? pread( parallelFd, parallelData.data(), parallelData.size(), 0 ) : -1;
+      close( dedupFd );
+      close( parallelFd );
+
+      DedupStats stats = dedup.getStats();
+      rc = ( rc )&&( stats.m_chunks == 20 )&&( stats.m_references == 10 )
+        && ( stats.getSavedBytes() == 10 * ( 4096 - BASECHUNK_REFERENCE_SIZE ))
+        && ( dedupBytes > 0 )&&( dedupBytes < 6 * 4096 )&&( dedupBytes == parallelBytes )
+        && ( !memcmp( dedupData.data(), parallelData.data(), dedupBytes ))
+        && ( restored.load( dedupName, pool ))
+        && ( restored.getSize() == repeated.getSize())
+        && ( restored.find( 102, &resolved ))
+        && ( resolved.m_buffer.getSize() == 4096 )&&( resolved.m_buffer[4095] == 0x11 )
+        && ( resolved.m_metadata.m_type == "frame" )
+        && ( restored.find( 103, &resolved ))&&( resolved.m_buffer[0] == 3 )
+        && ( reader.open( dedupName ))
+        && ( reader.getChunkAt( 5, resolved ))
+        && ( resolved.m_metadata.m_id == 105 )
+        && ( resolved.m_buffer.getSize() == 4096 )&&( resolved.m_buffer[100] == 0x11 );
+      reader.close();
+      unlink( dedupName );
+      unlink( parallelDedup );
+
+      if( !rc ) {
+         std::cout << "BaseContainer deduplicated save/load failed"<<std::endl;
+         return false;
+      }
+
+      //Compaction reclaims erased records and keeps the remaining payloads
+      BaseContainer sparse;
+      BaseContainer dense;
+      size_t recordBytes = BaseContainer::getRecordSize( 1, 1000 );
+      sparse.reserveArena( 201 * recordBytes );
+      for( size_t i = 0; i < 200; i++ ) {
+         BaseChunk sparseChunk( i );
+         sparseChunk.m_metadata.m_type = "s";
+         if( !sparse.allocateChunk( sparseChunk, 1000 )) {
+            std::cout << "BaseContainer compaction arena allocation failed"<<std::endl;
+            return false;
+         }
+         memset( sparseChunk.m_buffer.m_buffer.get(), (int)i, 1000 );
+         sparse.push_back( sparseChunk );
+         if( i % 2 == 1 ) {
+            BaseChunk denseChunk( i );
+            denseChunk.m_metadata.m_type = "s";
+            denseChunk.allocate( 1000 );
+            memset( denseChunk.m_buffer.m_buffer.get(), (int)i, 1000 );
+            dense.push_back( denseChunk );
+         }
+      }
+      for( size_t i = 0; i < 100; i++ ) {
+         sparse.erase( i );
+      }
+
+      //A chunk that is allocated but not pushed keeps its place
+      BaseChunk pinned( 1000 );
+      pinned.m_metadata.m_type = "s";
+      if(( sparse.getArenaGarbage() != 100 * recordBytes )
+       ||( !sparse.allocateChunk( pinned, 1000 ))) {
+         std::cout << "BaseContainer arena garbage not reported"<<std::endl;
+         return false;
+      }
+      memset( pinned.m_buffer.m_buffer.get(), 0x77, 1000 );
+      uint8_t * pinnedPayload = pinned.m_buffer.m_buffer.get();
+
+      size_t slices = 1;
+      while( !sparse.compact( 1e-9 )) {
+         slices++;
+      }
+
+      bool intact = ( slices > 1 )&&( sparse.getArenaGarbage() == 100 * recordBytes )
+                 && ( sparse.m_arenaUsed == 201 * recordBytes );
+      for( size_t i = 0; ( intact )&&( i < 100 ); i++ ) {
+         BaseChunk moved = sparse[i];
+         intact = ( moved.m_buffer.getSize() == 1000 )&&( moved.m_buffer[0] == (uint8_t)( 2 * i + 1 ))
+               && ( moved.m_buffer[999] == (uint8_t)( 2 * i + 1 ));
+      }
+      if( !intact ) {
+         std::cout << "BaseContainer incremental compaction failed after "<<slices<<" slices"<<std::endl;
+         return false;
+      }
+
+      //Once pushed and released, the pinned chunk is compacted with the rest
+      BaseChunk denseCopy( 1000 );
+      denseCopy.m_metadata.m_type = "s";
+      denseCopy.allocate( 1000 );
+      memset( denseCopy.m_buffer.m_buffer.get(), 0x77, 1000 );
+      dense.push_back( denseCopy );
+      sparse.push_back( pinned );
+      pinned = BaseChunk();
+      if(( !sparse.compact())||( sparse.getArenaGarbage() != 0 )
+       ||( sparse.m_arenaUsed != 101 * recordBytes )
+       ||( sparse[100].m_buffer.m_buffer.get() == pinnedPayload )
+       ||( sparse[100].m_buffer[999] != 0x77 )) {
+         std::cout << "BaseContainer compaction of the pinned chunk failed"<<std::endl;
+         return false;
+      }
+
+      char sparseName[] = "/tmp/BaseContainerSparseXXXXXX";
+      char denseName[]  = "/tmp/BaseContainerDenseXXXXXX";
+      int sparseFd = mkstemp( sparseName );
+      int denseFd  = mkstemp( denseName );
+      std::vector<uint8_t> sparseData( 1 << 18 );
+      std::vector<uint8_t> denseData( 1 << 18 );
+      rc = ( sparseFd >= 0 )&&( denseFd >= 0 )&&( sparse.save( sparseName ))&&( dense.save( denseName ));
+      ssize_t sparseBytes = rc ? pread( sparseFd, sparseData.data(), sparseData.size(), 0 ) : -1;
+      ssize_t denseBytes  = rc ? pread( denseFd, denseData.data(), denseData.size(), 0 ) : -1;
+      close( sparseFd );
+      close( denseFd );
+      unlink( sparseName );
+      unlink( denseName );
+
+      if(( !rc )||( sparseBytes <= 0 )||( sparseBytes != denseBytes )
+       ||( memcmp( sparseData.data(), denseData.data(), sparseBytes ))) {
+         std::cout << "BaseContainer compacted arena file does not match heap file"<<std::endl;
+         return false;
+      }
+
+      //Chunks held outside the container keep their bytes across compaction
+      BaseContainer held;
+      held.reserveArena( 10 * recordBytes );
+      std::vector<BaseChunk> allocated( 10 );
+      for( size_t i = 0; i < allocated.size(); i++ ) {
+         allocated[i].m_metadata.m_id   = i;
+         allocated[i].m_metadata.m_type = "s";
+         if( !held.allocateChunk( allocated[i], 1000 )) {
+            std::cout << "BaseContainer held arena allocation failed"<<std::endl;
+            return false;
+         }
+         memset( allocated[i].m_buffer.m_buffer.get(), (int)i, 1000 );
+      }
+      for( size_t i = 1; i <= allocated.size(); i++ ) {
+         held.push_back( allocated[i % allocated.size()] );
+      }
+      allocated.clear();
+
+      //The popped chunk is the first record, which the others would move over
+      BaseChunk popped = held.pop();
+      uint8_t * poppedPayload = popped.m_buffer.m_buffer.get();
+      intact = ( popped.m_metadata.m_id == 0 )&&( held.getArenaGarbage() == 0 )
+            && ( held.compact())&&( held.m_arenaUsed == 10 * recordBytes )
+            && ( popped.m_buffer.m_buffer.get() == poppedPayload );
+      for( size_t i = 0; ( intact )&&( i < 1000 ); i++ ) {
+         intact = ( popped.m_buffer[i] == 0 );
+      }
+      if( !intact ) {
+         std::cout << "BaseContainer compaction overwrote a popped chunk"<<std::endl;
+         return false;
+      }
+
+      popped = BaseChunk();
+      BaseChunk copy = held[4];
+      uint8_t * copyPayload = copy.m_buffer.m_buffer.get();
+      intact = ( held.getArenaGarbage() == recordBytes )&&( held.compact())
+            && ( held.m_arenaUsed == 10 * recordBytes )&&( held[4].m_buffer.m_buffer.get() == copyPayload )
+            && ( held[3].m_buffer[999] == 4 )&&( copy.m_buffer[0] == 5 )&&( copy.m_buffer[999] == 5 );
+      copy = BaseChunk();
+      intact = ( intact )&&( held.compact())&&( held.m_arenaUsed == 9 * recordBytes )
+            && ( held.getArenaGarbage() == 0 );
+      for( size_t i = 0; ( intact )&&( i < 9 ); i++ ) {
+         intact = ( held[i].m_buffer[0] == (uint8_t)( i + 1 ))&&( held[i].m_buffer[999] == (uint8_t)( i + 1 ));
+      }
+      if( !intact ) {
+         std::cout << "BaseContainer compaction of copied chunks failed"<<std::endl;
+         return false;
+      }
+
       return true;
    }
 };
@@ -1,13 +1,71 @@
 #pragma once
 #include <memory>
+#include <mutex>
 #include <climits>
+#include <atomic>
+#include <vector>
 #include <stddef.h>
 #include <TSArray.tcc>
 #include <BaseChunk.h>
 #include <BaseContainerMetadata.h>
+#include <ChunkIndex.h>
+#include <ChunkDeduplicator.h>
+#include <AThreadPool.h>
+#include <AsyncWriter.h>
+#include <DirectWriter.h>
+
+#define BASECONTAINER_MAGIC            "AGTC"  //!< Identifies a container file
+#define BASECONTAINER_FOOTER_MAGIC     "AGTX"  //!< Identifies the container footer
+#define BASECONTAINER_VERSION          1       //!< Version of the container file format
+#define BASECONTAINER_HEADER_SIZE      24      //!< Size of the container file header
+#define BASECONTAINER_INDEX_ENTRY_SIZE 32      //!< Size of one index entry
+#define BASECONTAINER_FOOTER_SIZE      32      //!< Size of the container footer
+#define BASECONTAINER_ALIGNMENT        8       //!< Alignment of chunk records in the file
+
+/**
+ * Container file format (all values little-endian):
+ *
+ *   header (24 bytes)
+ *        0     4  magic ("AGTC")
+ *        4     2  version
+ *        6     2  flags
+ *        8     8  container id
+ *       16     8  number of chunks
+ *
+ *   chunk records, each a BaseChunk in the binary chunk format, padded to
+ *   BASECONTAINER_ALIGNMENT bytes. A record may be a reference to the
+ *   payload of an earlier record (BASECHUNK_FLAG_REFERENCE)
+ *
+ *   index (32 bytes per chunk, in container order)
+ *        0     8  chunk id
+ *        8     8  file offset of the chunk record
+ *       16     8  size of the chunk record (header, type and payload)
+ *       24     4  CRC-32C of the chunk record
+ *       28     4  reserved (0)
+ *
+ *   footer (last 32 bytes of the file)
+ *        0     8  file offset of the index
+ *        8     8  number of index entries
+ *       16     4  CRC-32C of the index
+ *       20     2  version
+ *       22     2  flags
+ *       24     4  reserved (0)
+ *       28     4  magic ("AGTX")
+ **/
 
 namespace atl
 {
+   /**
+    * \brief Location of one chunk record in a container file
+    **/
+   struct ContainerIndexEntry
+   {
+      uint64_t m_id       = 0;              //!< ID of the chunk
+      uint64_t m_offset   = 0;              //!< File offset of the chunk record
+      uint64_t m_size     = 0;              //!< Size of the chunk record in bytes
+      uint32_t m_checksum = 0;              //!< CRC-32C of the chunk record
+   };
+
    /**
     * \brief Basic class that contains an array of containers.
     *
@@ -15,21 +73,85 @@ namespace atl
     * with their own metadata and allocated memory. Methods in the class
     * map the embedded containers into a aggregate container object with 
     * a common memory allocation
+    *
+    * In arena mode (reserveArena) chunk buffers are carved sequentially out of
+    * one allocation by allocateChunk. Each chunk is laid out in the arena as a
+    * complete container file record, so a container whose chunks were all
+    * allocated from the arena and pushed in the same order is saved with a
+    * single write of the arena.
+    *
+    * Chunks can be looked up by id in constant time through an open-addressing
+    * hash index that is maintained by push_back, pop and erase. If several
+    * chunks share an id, find returns the first of them.
+    *
+    * Removing arena chunks leaves unused records in the arena. compact slides
+    * the remaining records down so the arena is contiguous again, either in
+    * one call or incrementally in bounded time slices. Every record has its
+    * own use count, and a record that is referenced outside the container
+    * array (a chunk allocated but not yet pushed, a chunk popped or erased
+    * but still held, or a copy handed to a reader or writer) is never moved
+    * or overwritten.
     **/
    class BaseContainer
    {
       private:
-         
+         /**
+          * \brief Location of a record in the arena
+          **/
+         struct ArenaRecord
+         {
+            size_t m_offset   = 0;                    //!< Offset of the record in the arena
+            size_t m_size     = 0;                    //!< Size of the record including padding
+            size_t m_position = SIZE_MAX;             //!< Position of the chunk in the array (SIZE_MAX if pinned)
+            std::weak_ptr<uint8_t> m_payload;         //!< Payload shared by all chunks referring to the record
+         };
+
+         std::mutex m_arenaMutex;                     //!< Protects arena allocation
+         std::mutex m_indexMutex;                     //!< Keeps the index consistent with the array
+         ChunkIndex m_index;                          //!< Chunk id to array position
+         std::atomic<uint64_t> m_version{0};          //!< Incremented by every change of the array or arena
+
+         std::vector<ArenaRecord> m_arenaRecords;     //!< Records handed out by allocateChunk and compact
+         std::vector<ArenaRecord> m_compactPlan;      //!< Records to compact in arena order
+         size_t     m_compactNext    = 0;             //!< Next record of the plan to move
+         size_t     m_compactCursor  = 0;             //!< Arena offset the next record moves to
+         uint64_t   m_compactVersion = 0;             //!< m_version the plan was made for
+         bool       m_compacting     = false;         //!< True while a plan is in progress
+
+         bool isArenaContiguous( BaseChunk * chunks, size_t count );
+         void rebuildIndex();
+         bool eraseLocked( size_t index );
+         bool getArenaRecord( BaseChunk &chunk, ArenaRecord &record );
+         std::shared_ptr<uint8_t> getArenaPointer( uint8_t * payload );
+         bool collectArenaRecords( std::vector<ArenaRecord> &records );
+
       public: 
          BaseContainerMetadata m_metadata;            //!< Metadata about this container
          TSArray<BaseChunk>     m_containerArray;      //!< Array of container objects
+         BaseBuffer             m_arena;               //!< Storage for chunk records in arena mode
+         size_t                 m_arenaUsed = 0;       //!< Number of arena bytes allocated
          
          //Interface functions
 //         BaseContainer::BaseContainer();
          size_t push_back(BaseChunk chunk);
          BaseChunk pop();
+         bool   erase( size_t index );
+         bool   remove( uint64_t id );
+         bool   find( uint64_t id, BaseChunk * chunk );
+         bool   findIndex( uint64_t id, size_t * index );
          BaseChunk operator[] (size_t index) const {return m_containerArray[index];};
          size_t getSize();
+         bool   save( std::string filename, ChunkDeduplicator * dedup = NULL );
+         bool   save( std::string filename, AThreadPool &pool, ChunkDeduplicator * dedup = NULL );
+         bool   save( std::string filename, AsyncWriter &writer, ChunkDeduplicator * dedup = NULL );
+         bool   save( DirectWriter &writer, ChunkDeduplicator * dedup = NULL );
+         bool   load( std::string filename, AThreadPool &pool = getDefaultThreadPool() );
+
+         bool   reserveArena( size_t bytes );
+         bool   allocateChunk( BaseChunk &chunk, size_t bytes );
+         bool   compact( double seconds = 0 );
+         size_t getArenaGarbage();
+         static size_t getRecordSize( size_t typeLength, size_t bytes );
    };
 
    //Test functions
@@ -1,7 +1,8 @@
 #include <iostream>
-#include <sstream>
 #include <string>
+#include <cstring>
 #include <BaseContainerMetadata.h>
+#include <ByteOrder.h>
 
 namespace atl
 {
@@ -15,21 +16,68 @@ namespace atl
     **/
    std::string BaseContainerMetadata::getJsonString( bool brackets ) 
    {
-      std::stringstream ss;
+      char buffer[256];
+      JsonWriter writer( buffer, sizeof(buffer));
+      writeJson( writer, brackets );
+
+      return std::string( writer.getString(), writer.getLength());
+   }
+
+   /**
+    * \brief Appends the json representation of the metadata to a writer
+    * \param [in] writer writer to append to
+    * \param [in] brackets flag to indicate if surrounding brackets are needed (default = true)
+    * \return true on success, false if the writer buffer is too small
+    **/
+   bool BaseContainerMetadata::writeJson( JsonWriter &writer, bool brackets )
+   {
       if( brackets ) {
-         ss << "{";
+         writer.append('{');
       }
 
-      ss << "\"id\":"           << m_id           << ","
-         << "\"elementCount\":" << m_elementCount << ","
-         << "\"size\":"         << m_size;
+      writer.appendKey("id").appendUInt( m_id ).append(',')
+            .appendKey("elementCount").appendUInt( m_elementCount ).append(',')
+            .appendKey("size").appendUInt( m_size );
+
+      if( brackets ) {
+         writer.append('}');
+      }
+
+      return writer.isValid();
+   }
+
+   /**
+    * \brief Fills the metadata from the json representation written by writeJson
+    *
+    * \param [in] text json text (with brackets)
+    * \param [in] length number of characters in the text
+    * \return true on success, false on a syntax error
+    *
+    * Fields may appear in any order. Unknown fields are ignored.
+    **/
+   bool BaseContainerMetadata::parseJson( const char * text, size_t length )
+   {
+      JsonReader   reader( text, length );
+      const char * key;
+      size_t       keyLength;
 
-      if(brackets) {
-         ss << "}";
+      reader.beginObject();
+      while( reader.nextKey( key, keyLength )) {
+         if( JsonReader::keyEquals( key, keyLength, "id" )) {
+            reader.readUInt( m_id );
+         }
+         else if( JsonReader::keyEquals( key, keyLength, "elementCount" )) {
+            reader.readUInt( m_elementCount );
+         }
+         else if( JsonReader::keyEquals( key, keyLength, "size" )) {
+            reader.readUInt( m_size );
+         }
+         else {
+            reader.skipValue();
+         }
       }
 
-      std::string result = ss.str();
-      return result;
+      return reader.isValid() && reader.atEnd();
    }
 
    /**
@@ -43,6 +91,54 @@ namespace atl
     }
 
 
+   /**
+    * \brief Writes the binary representation of the metadata
+    *
+    * \param [in] buffer destination buffer
+    * \param [in] bytes size of the destination buffer
+    * \return number of bytes written (BC_META_SIZE), 0 if the buffer is too small
+    *
+    * Only the metadata is encoded. The contained chunks are stored separately.
+    **/
+   size_t BaseContainerMetadata::encode( uint8_t * buffer, size_t bytes )
+   {
+      if( bytes < BC_META_SIZE ) {
+         std::cerr << "BaseContainerMetadata: encode buffer too small"<<std::endl;
+         return 0;
+      }
+
+      BaseContainerMetadataRecord record;
+      record.m_id           = toLittleEndian64( m_id );
+      record.m_elementCount = toLittleEndian64( m_elementCount );
+      record.m_size         = toLittleEndian64( m_size );
+      memcpy( buffer, &record, sizeof(record));
+
+      return BC_META_SIZE;
+   }
+
+   /**
+    * \brief Reads the binary representation written by encode
+    *
+    * \param [in] buffer encoded metadata
+    * \param [in] bytes size of the buffer
+    * \return true on success, false if the buffer is too small
+    **/
+   bool BaseContainerMetadata::decode( const uint8_t * buffer, size_t bytes )
+   {
+      if( bytes < BC_META_SIZE ) {
+         std::cerr << "BaseContainerMetadata: encoded metadata is truncated"<<std::endl;
+         return false;
+      }
+
+      BaseContainerMetadataRecord record;
+      memcpy( &record, buffer, sizeof(record));
+      m_id           = toLittleEndian64( record.m_id );
+      m_elementCount = toLittleEndian64( record.m_elementCount );
+      m_size         = toLittleEndian64( record.m_size );
+
+      return true;
+   }
+
    //Test functions
    bool testBaseContainerMetadata()
    {
@@ -59,12 +155,30 @@ namespace atl
          return false;
       }
 
+      BaseContainerMetadata parsed;
+      std::string json = "{\"size\":7,\"id\":1,\"elementCount\":2}";
+      if(( !parsed.parseJson( json.data(), json.length()))
+       ||( parsed.m_id != 1 )||( parsed.m_elementCount != 2 )||( parsed.m_size != 7 )) {
+         std::cout << "testBaseContainerMetadata failed to parse "<<json<<std::endl;
+         return false;
+      }
+
       result = meta.getJsonString(false);
       if( result.compare(nobracket)) {
          std::cout << "testBaseContainerMetadata failed with no brackets" <<std::endl;
          return false;
       }
 
+      uint8_t encoded[BC_META_SIZE];
+      BaseContainerMetadata decoded;
+      if(( meta.encode( encoded, sizeof(encoded)) != BC_META_SIZE )
+       ||( readLE64( &encoded[8] ) != 2 )
+       ||( !decoded.decode( encoded, sizeof(encoded)))
+       ||( decoded.m_id != 1 )||( decoded.m_elementCount != 2 )||( decoded.m_size != 0 )) {
+         std::cout << "testBaseContainerMetadata binary round trip failed" <<std::endl;
+         return false;
+      }
+
       size_t expected = BC_META_SIZE;
       size_t sz = meta.getSize();
       if( sz != expected )
@@ -3,10 +3,24 @@
 #include <climits>
 #include <stddef.h>
 #include <string>
+#include <JsonWriter.h>
+#include <JsonReader.h>
 
 namespace atl
 {
    #define BC_META_SIZE 24
+
+   /**
+    * \brief Binary metadata encoding (little-endian)
+    **/
+   struct BaseContainerMetadataRecord
+   {
+      uint64_t m_id;                        //!< ID of the object
+      uint64_t m_elementCount;              //!< Number of containers
+      uint64_t m_size;                      //!< Size of the containers
+   };
+   static_assert( sizeof(BaseContainerMetadataRecord) == BC_META_SIZE, "BaseContainerMetadataRecord does not match BC_META_SIZE" );
+
    /**
     * \brief Low level data structure to associate pointer with a data size
     *
@@ -27,8 +41,12 @@ namespace atl
          uint64_t    m_size = 0;            //!< size of containers (does not include header)
 
          size_t      getSize();             //!< Returns the size of the metadata
+         size_t      encode( uint8_t * buffer, size_t bytes );
+         bool        decode( const uint8_t * buffer, size_t bytes );
 
          std::string getJsonString( bool brackets = true );
+         bool        writeJson( JsonWriter &writer, bool brackets = true );
+         bool        parseJson( const char * text, size_t length );
    };
 
    //Test functions
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <BufferPool.h>
+
+namespace atl
+{
+   /**
+    * \brief Allocates the buffers of the pool
+    *
+    * \param [in] bufferSize size of each buffer. Rounded up to the alignment
+    * \param [in] count number of buffers
+    * \param [in] alignment alignment of each buffer in bytes (default = 4096)
+    * \return true on success, false on failure
+    *
+    * Buffers still held from a previous allocation stay valid.
+    **/
+   bool BufferPool::allocate( size_t bufferSize, size_t count, size_t alignment )
+   {
+      if(( bufferSize == 0 )||( count == 0 )) {
+         std::cerr << "BufferPool: buffer size and count must be non-zero"<<std::endl;
+         return false;
+      }
+
+      std::shared_ptr<State> state( new State );
+      if( !state->m_storage.setAlignment( alignment )) {
+         return false;
+      }
+
+      bufferSize = ( bufferSize + alignment - 1 ) / alignment * alignment;
+      if( !state->m_storage.allocate( bufferSize * count )) {
+         return false;
+      }
+
+      state->m_bufferSize = bufferSize;
+      state->m_count      = count;
+      state->m_free.reserve( count );
+      for( size_t i = count; i > 0; i-- ) {
+         state->m_free.push_back( i - 1 );
+      }
+
+      m_state = state;
+      return true;
+   }
+
+   /**
+    * \brief Takes a buffer from the pool
+    *
+    * \param [out] buffer receives the buffer
+    * \param [in] wait block until a buffer is free (default = true)
+    * \return true on success, false if the pool is empty and wait is false
+    *
+    * The buffer returns to the pool when buffer and all copies of it are released.
+    **/
+   bool BufferPool::acquire( BaseBuffer &buffer, bool wait )
+   {
+      if( m_state == NULL ) {
+         std::cerr << "BufferPool: pool is not allocated"<<std::endl;
+         return false;
+      }
+
+      std::shared_ptr<State> state = m_state;
+      size_t index = 0;
+      {
+         std::unique_lock<std::mutex> lock( state->m_mutex );
+         while( state->m_free.empty()) {
+            if( !wait ) {
+               return false;
+            }
+            state->m_cv.wait( lock );
+         }
+
+         index = state->m_free.back();
+         state->m_free.pop_back();
+      }
+
+      uint8_t * data = state->m_storage.m_buffer.get() + index * state->m_bufferSize;
+      buffer.m_buffer = std::shared_ptr<uint8_t>( data, [state, index]( uint8_t * ) {
+         std::lock_guard<std::mutex> guard( state->m_mutex );
+         state->m_free.push_back( index );
+         state->m_cv.notify_one();
+      });
+      buffer.m_bufferSize = state->m_bufferSize;
+      buffer.m_alignment  = 0;
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the size of each buffer in bytes
+    **/
+   size_t BufferPool::getBufferSize()
+   {
+      return ( m_state == NULL ) ? 0 : m_state->m_bufferSize;
+   }
+
+   /**
+    * \brief Returns the number of buffers in the pool
+    **/
+   size_t BufferPool::getCount()
+   {
+      return ( m_state == NULL ) ? 0 : m_state->m_count;
+   }
+
+   /**
+    * \brief Returns the number of buffers that are not in use
+    **/
+   size_t BufferPool::getFreeCount()
+   {
+      if( m_state == NULL ) {
+         return 0;
+      }
+
+      std::lock_guard<std::mutex> guard( m_state->m_mutex );
+      return m_state->m_free.size();
+   }
+
+   /**
+    * \brief Returns the start of the region holding all buffers
+    **/
+   uint8_t * BufferPool::getStorage()
+   {
+      return ( m_state == NULL ) ? NULL : m_state->m_storage.m_buffer.get();
+   }
+
+   /**
+    * \brief Returns the index of the buffer containing ptr
+    * \return buffer index, or -1 if ptr is not inside the pool
+    **/
+   int BufferPool::getIndex( const void * ptr )
+   {
+      if( m_state == NULL ) {
+         return -1;
+      }
+
+      const uint8_t * base = m_state->m_storage.m_buffer.get();
+      const uint8_t * p    = (const uint8_t *)ptr;
+      if(( p < base )||( p >= base + m_state->m_bufferSize * m_state->m_count )) {
+         return -1;
+      }
+
+      return (int)(( p - base ) / m_state->m_bufferSize );
+   }
+
+   /**
+    * \brief Unit test for the BufferPool class
+    **/
+   bool testBufferPool()
+   {
+      BufferPool pool;
+      BaseBuffer empty;
+      if( pool.acquire( empty, false )) {
+         std::cout << "BufferPool acquired from an unallocated pool"<<std::endl;
+         return false;
+      }
+
+      if(( !pool.allocate( 1000, 4 ))||( pool.getBufferSize() != 4096 )||( pool.getFreeCount() != 4 )) {
+         std::cout << "BufferPool allocation failed"<<std::endl;
+         return false;
+      }
+
+      std::vector<BaseBuffer> buffers( 4 );
+      for( size_t i = 0; i < buffers.size(); i++ ) {
+         if(( !pool.acquire( buffers[i], false ))
+          ||( (uintptr_t)buffers[i].m_buffer.get() % 4096 != 0 )
+          ||( pool.getIndex( buffers[i].m_buffer.get() + 100 ) != (int)i )) {
+            std::cout << "BufferPool acquire "<<i<<" failed"<<std::endl;
+            return false;
+         }
+      }
+
+      BaseBuffer extra;
+      if(( pool.acquire( extra, false ))||( pool.getIndex( &extra ) != -1 )) {
+         std::cout << "BufferPool acquired from an empty pool"<<std::endl;
+         return false;
+      }
+
+      //Buffers return when the last copy is released
+      BaseBuffer copy = buffers[2];
+      buffers[2] = BaseBuffer();
+      if( pool.getFreeCount() != 0 ) {
+         std::cout << "BufferPool released a buffer that is still referenced"<<std::endl;
+         return false;
+      }
+      copy = BaseBuffer();
+      if(( pool.getFreeCount() != 1 )||( !pool.acquire( extra, false ))
+       ||( pool.getIndex( extra.m_buffer.get()) != 2 )) {
+         std::cout << "BufferPool did not reuse a released buffer"<<std::endl;
+         return false;
+      }
+
+      buffers.clear();
+      extra = BaseBuffer();
+      if( pool.getFreeCount() != 4 ) {
+         std::cout << "BufferPool free count = "<<pool.getFreeCount()<<" not 4"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseBuffer.h>
+
+namespace atl
+{
+   /**
+    * \brief Fixed set of equally sized buffers carved from one aligned allocation
+    *
+    * Buffers are handed out as BaseBuffer objects whose storage returns to the
+    * pool when the last reference is released, so a buffer can be passed to
+    * asynchronous writers without explicit bookkeeping. Because all buffers
+    * live in one region they can be registered with the kernel once (see
+    * AsyncWriter) and their slot index recovered from a pointer.
+    *
+    * Copies of a BufferPool share the same buffers. The storage is released
+    * when the pool and all outstanding buffers are gone.
+    **/
+   class BufferPool
+   {
+      private:
+         /**
+          * \brief State shared by the pool and its outstanding buffers
+          **/
+         struct State
+         {
+            std::mutex              m_mutex;               //!< Protects the free list
+            std::condition_variable m_cv;                  //!< Signals released buffers
+            std::vector<size_t>     m_free;                //!< Indices of free buffers
+            BaseBuffer              m_storage;             //!< Storage for all buffers
+            size_t                  m_bufferSize = 0;      //!< Size of each buffer in bytes
+            size_t                  m_count = 0;           //!< Number of buffers
+         };
+
+         std::shared_ptr<State> m_state;                   //!< Shared pool state
+
+      public:
+         bool      allocate( size_t bufferSize, size_t count, size_t alignment = 4096 );
+         bool      acquire( BaseBuffer &buffer, bool wait = true );
+         size_t    getBufferSize();
+         size_t    getCount();
+         size_t    getFreeCount();
+         uint8_t * getStorage();
+         int       getIndex( const void * ptr );
+   };
+
+   //Test functions
+   bool testBufferPool();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <cstring>
+
+/**
+ * \file
+ *
+ * Helpers to store integers in little-endian byte order at arbitrary (possibly
+ * unaligned) addresses. All binary file formats in this library are little-endian.
+ * On little-endian hosts the functions reduce to a single memcpy.
+ **/
+namespace atl
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+   inline uint16_t toLittleEndian16( uint16_t value ) { return __builtin_bswap16( value ); }
+   inline uint32_t toLittleEndian32( uint32_t value ) { return __builtin_bswap32( value ); }
+   inline uint64_t toLittleEndian64( uint64_t value ) { return __builtin_bswap64( value ); }
+#else
+   inline uint16_t toLittleEndian16( uint16_t value ) { return value; }
+   inline uint32_t toLittleEndian32( uint32_t value ) { return value; }
+   inline uint64_t toLittleEndian64( uint64_t value ) { return value; }
+#endif
+
+   /** \brief Writes a 16 bit value in little-endian order **/
+   inline void writeLE16( uint8_t * dest, uint16_t value )
+   {
+      value = toLittleEndian16( value );
+      memcpy( dest, &value, sizeof(value));
+   }
+
+   /** \brief Writes a 32 bit value in little-endian order **/
+   inline void writeLE32( uint8_t * dest, uint32_t value )
+   {
+      value = toLittleEndian32( value );
+      memcpy( dest, &value, sizeof(value));
+   }
+
+   /** \brief Writes a 64 bit value in little-endian order **/
+   inline void writeLE64( uint8_t * dest, uint64_t value )
+   {
+      value = toLittleEndian64( value );
+      memcpy( dest, &value, sizeof(value));
+   }
+
+   /** \brief Reads a 16 bit little-endian value **/
+   inline uint16_t readLE16( const uint8_t * src )
+   {
+      uint16_t value;
+      memcpy( &value, src, sizeof(value));
+      return toLittleEndian16( value );
+   }
+
+   /** \brief Reads a 32 bit little-endian value **/
+   inline uint32_t readLE32( const uint8_t * src )
+   {
+      uint32_t value;
+      memcpy( &value, src, sizeof(value));
+      return toLittleEndian32( value );
+   }
+
+   /** \brief Reads a 64 bit little-endian value **/
+   inline uint64_t readLE64( const uint8_t * src )
+   {
+      uint64_t value;
+      memcpy( &value, src, sizeof(value));
+      return toLittleEndian64( value );
+   }
+}
@@ -0,0 +1,300 @@
+//******************************************************************************
+// CRC-32C (Castagnoli) checksum and 64-bit content hash
+//
+// CRC-32C uses the SSE4.2 crc32 instruction when the CPU supports it and a
+// slicing-by-8 table implementation otherwise. Both produce identical results.
+// hash64 is the XXH64 algorithm, which processes 32 bytes per round in four
+// independent lanes.
+//******************************************************************************
+#include <iostream>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "Checksum.h"
+#include "ByteOrder.h"
+
+namespace atl
+{
+   static const uint32_t CRC32C_POLY = 0x82F63B78;   //!< Reflected Castagnoli polynomial
+
+   /**
+    * \brief Lookup tables for the slicing-by-8 implementation
+    **/
+   struct Crc32cTables
+   {
+      uint32_t m_table[8][256];                        //!< Table for each byte position
+
+      Crc32cTables()
+      {
+         for( uint32_t i = 0; i < 256; i++ ) {
+            uint32_t crc = i;
+            for( int bit = 0; bit < 8; bit++ ) {
+               crc = ( crc & 1 ) ? ( crc >> 1 ) ^ CRC32C_POLY : ( crc >> 1 );
+            }
+            m_table[0][i] = crc;
+         }
+
+         for( uint32_t i = 0; i < 256; i++ ) {
+            for( int t = 1; t < 8; t++ ) {
+               m_table[t][i] = ( m_table[t-1][i] >> 8 ) ^ m_table[0][m_table[t-1][i] & 0xFF];
+            }
+         }
+      }
+   };
+
+   /**
+    * \brief Table based CRC-32C over raw (non-inverted) crc state
+    **/
+   static uint32_t crc32cSoftware( const uint8_t * data, size_t bytes, uint32_t crc )
+   {
+      static const Crc32cTables tables;
+      const uint32_t (*t)[256] = tables.m_table;
+
+      while( bytes >= 8 ) {
+         uint32_t low;
+         uint32_t high;
+         memcpy( &low,  data,     4 );
+         memcpy( &high, data + 4, 4 );
+         low ^= crc;
+
+         crc = t[7][ low         & 0xFF] ^ t[6][( low >> 8 )  & 0xFF]
+             ^ t[5][( low >> 16 ) & 0xFF] ^ t[4][ low >> 24 ]
+             ^ t[3][ high        & 0xFF] ^ t[2][( high >> 8 ) & 0xFF]
+             ^ t[1][( high >> 16 ) & 0xFF] ^ t[0][ high >> 24 ];
+
+         data  += 8;
+         bytes -= 8;
+      }
+
+      while( bytes > 0 ) {
+         crc = ( crc >> 8 ) ^ t[0][( crc ^ *data ) & 0xFF];
+         data++;
+         bytes--;
+      }
+
+      return crc;
+   }
+
+#if defined(__x86_64__)
+   /**
+    * \brief CRC-32C using the SSE4.2 crc32 instruction
+    **/
+   __attribute__((target("sse4.2")))
+   static uint32_t crc32cHardware( const uint8_t * data, size_t bytes, uint32_t crc )
+   {
+      uint64_t crc64 = crc;
+      while( bytes >= 8 ) {
+         uint64_t value;
+         memcpy( &value, data, 8 );
+         crc64 = _mm_crc32_u64( crc64, value );
+         data  += 8;
+         bytes -= 8;
+      }
+
+      crc = (uint32_t)crc64;
+      while( bytes > 0 ) {
+         crc = _mm_crc32_u8( crc, *data );
+         data++;
+         bytes--;
+      }
+
+      return crc;
+   }
+#endif
+
+   typedef uint32_t (*Crc32cFunction)( const uint8_t *, size_t, uint32_t );
+
+   /**
+    * \brief Selects the fastest implementation supported by the CPU
+    **/
+   static Crc32cFunction selectCrc32c()
+   {
+#if defined(__x86_64__)
+      if( __builtin_cpu_supports( "sse4.2" )) {
+         return crc32cHardware;
+      }
+#endif
+      return crc32cSoftware;
+   }
+
+   /**
+    * \brief Computes the CRC-32C checksum of a buffer
+    *
+    * \param [in] buffer data to checksum
+    * \param [in] bytes number of bytes in the buffer
+    * \param [in] crc checksum of the preceding data when checksumming in pieces (default = 0)
+    * \return checksum of the data
+    *
+    * crc32c( b, n2, crc32c( a, n1 )) equals the checksum of a followed by b.
+    **/
+   uint32_t crc32c( const void * buffer, size_t bytes, uint32_t crc )
+   {
+      static const Crc32cFunction function = selectCrc32c();
+      return ~function( (const uint8_t *)buffer, bytes, ~crc );
+   }
+
+   static const uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ULL;
+   static const uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+   static const uint64_t XXH_PRIME3 = 0x165667B19E3779F9ULL;
+   static const uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+   static const uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+   static inline uint64_t rotl64( uint64_t value, int bits )
+   {
+      return ( value << bits ) | ( value >> ( 64 - bits ));
+   }
+
+   static inline uint64_t xxhRound( uint64_t acc, uint64_t input )
+   {
+      acc += input * XXH_PRIME2;
+      acc  = rotl64( acc, 31 );
+      return acc * XXH_PRIME1;
+   }
+
+   static inline uint64_t xxhMerge( uint64_t acc, uint64_t value )
+   {
+      acc ^= xxhRound( 0, value );
+      return acc * XXH_PRIME1 + XXH_PRIME4;
+   }
+
+   /**
+    * \brief Computes a 64-bit hash of a buffer (XXH64)
+    *
+    * \param [in] buffer data to hash
+    * \param [in] bytes number of bytes in the buffer
+    * \param [in] seed hash seed (default = 0)
+    * \return hash of the data
+    *
+    * The hash is not cryptographic. It is intended for content lookups where
+    * a match is confirmed by comparing the data.
+    **/
+   uint64_t hash64( const void * buffer, size_t bytes, uint64_t seed )
+   {
+      const uint8_t * data = (const uint8_t *)buffer;
+      const uint8_t * end  = data + bytes;
+      uint64_t hash;
+
+      if( bytes >= 32 ) {
+         uint64_t v1 = seed + XXH_PRIME1 + XXH_PRIME2;
+         uint64_t v2 = seed + XXH_PRIME2;
+         uint64_t v3 = seed;
+         uint64_t v4 = seed - XXH_PRIME1;
+
+         const uint8_t * limit = end - 32;
+         do {
+            v1 = xxhRound( v1, readLE64( data ));
+            v2 = xxhRound( v2, readLE64( data + 8 ));
+            v3 = xxhRound( v3, readLE64( data + 16 ));
+            v4 = xxhRound( v4, readLE64( data + 24 ));
+            data += 32;
+         } while( data <= limit );
+
+         hash = rotl64( v1, 1 ) + rotl64( v2, 7 ) + rotl64( v3, 12 ) + rotl64( v4, 18 );
+         hash = xxhMerge( hash, v1 );
+         hash = xxhMerge( hash, v2 );
+         hash = xxhMerge( hash, v3 );
+         hash = xxhMerge( hash, v4 );
+      }
+      else {
+         hash = seed + XXH_PRIME5;
+      }
+
+      hash += (uint64_t)bytes;
+
+      while( data + 8 <= end ) {
+         hash ^= xxhRound( 0, readLE64( data ));
+         hash  = rotl64( hash, 27 ) * XXH_PRIME1 + XXH_PRIME4;
+         data += 8;
+      }
+
+      if( data + 4 <= end ) {
+         hash ^= (uint64_t)readLE32( data ) * XXH_PRIME1;
+         hash  = rotl64( hash, 23 ) * XXH_PRIME2 + XXH_PRIME3;
+         data += 4;
+      }
+
+      while( data < end ) {
+         hash ^= (*data) * XXH_PRIME5;
+         hash  = rotl64( hash, 11 ) * XXH_PRIME1;
+         data++;
+      }
+
+      hash ^= hash >> 33;
+      hash *= XXH_PRIME2;
+      hash ^= hash >> 29;
+      hash *= XXH_PRIME3;
+      hash ^= hash >> 32;
+
+      return hash;
+   }
+
+   /**
+    * \brief Test function
+    **/
+   bool testChecksum()
+   {
+      //Standard check value of CRC-32C
+      uint32_t crc = crc32c( "123456789", 9 );
+      if( crc != 0xE3069283 ) {
+         std::cerr << "crc32c check value "<<std::hex<<crc<<" != e3069283"<<std::dec<<std::endl;
+         return false;
+      }
+
+      //Incremental computation and the table implementation must agree
+      uint8_t data[1000];
+      for( size_t i = 0; i < sizeof(data); i++ ) {
+         data[i] = (uint8_t)( i * 31 + 7 );
+      }
+
+      uint32_t whole = crc32c( data, sizeof(data));
+      uint32_t parts = crc32c( data + 333, sizeof(data) - 333, crc32c( data, 333 ));
+      uint32_t table = ~crc32cSoftware( data, sizeof(data), ~0u );
+      if(( whole != parts )||( whole != table )) {
+         std::cerr << "crc32c mismatch "<<whole<<" "<<parts<<" "<<table<<std::endl;
+         return false;
+      }
+
+      //Reference values of XXH64 with seed 0
+      if(( hash64( "", 0 ) != 0xEF46DB3751D8E999ULL )
+       ||( hash64( "a", 1 ) != 0xD24EC4F1A98C6E5BULL )
+       ||( hash64( "abc", 3 ) != 0x44BC2CF5AD770999ULL )) {
+         std::cerr << "hash64 reference value mismatch "<<std::hex<<hash64( "abc", 3 )<<std::dec<<std::endl;
+         return false;
+      }
+
+      //Reference values for inputs that run the 32-byte stripe loop, with and without a seed
+      struct { size_t bytes; uint64_t seed; uint64_t hash; } vectors[] = {
+         { 32,  0,                      0x8D57D6A4671CC43DULL },
+         { 32,  0x9E3779B97F4A7C15ULL,  0x184EBCF3745CD46CULL },
+         { 33,  0,                      0x62C9FD21ED857664ULL },
+         { 33,  0x9E3779B97F4A7C15ULL,  0x52FAC3C981F3CC2EULL },
+         { 100, 0,                      0xEFA0AD2D3E70C151ULL },
+         { 100, 0x9E3779B97F4A7C15ULL,  0xBC7AB33BE7528C18ULL },
+      };
+      for( size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++ ) {
+         uint64_t hash = hash64( data, vectors[i].bytes, vectors[i].seed );
+         if( hash != vectors[i].hash ) {
+            std::cerr << "hash64 of "<<vectors[i].bytes<<" bytes with seed "<<std::hex<<vectors[i].seed
+                      <<" is "<<hash<<" != "<<vectors[i].hash<<std::dec<<std::endl;
+            return false;
+         }
+      }
+      if( hash64( "Nobody inspects the spammish repetition", 39 ) != 0xFBCEA83C8A378BF1ULL ) {
+         std::cerr << "hash64 reference value mismatch for a 39 byte string"<<std::endl;
+         return false;
+      }
+
+      //Every byte must contribute to the hash
+      uint64_t full = hash64( data, sizeof(data));
+      data[517] ^= 1;
+      if(( full == hash64( data, sizeof(data)))||( full == hash64( data, sizeof(data) - 1 ))) {
+         std::cerr << "hash64 does not depend on the whole buffer"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
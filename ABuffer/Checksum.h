@@ -0,0 +1,12 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace atl
+{
+   uint32_t crc32c( const void * buffer, size_t bytes, uint32_t crc = 0 );
+   uint64_t hash64( const void * buffer, size_t bytes, uint64_t seed = 0 );
+
+   //Test functions
+   bool testChecksum();
+}
@@ -0,0 +1,224 @@
+#include <iostream>
+#include <cstring>
+
+#include <ChunkDeduplicator.h>
+#include <Checksum.h>
+#include <ByteOrder.h>
+
+namespace atl
+{
+   /**
+    * \brief Constructor
+    * \param [in] minSize payloads smaller than this many bytes are never deduplicated
+    **/
+   ChunkDeduplicator::ChunkDeduplicator( size_t minSize )
+   {
+      m_minSize = ( minSize > BASECHUNK_REFERENCE_SIZE ) ? minSize : BASECHUNK_REFERENCE_SIZE + 1;
+   }
+
+   /**
+    * \brief Checks whether a chunk repeats the payload of an earlier chunk
+    *
+    * \param [in] chunk chunk that is about to be written
+    * \param [in] position container position of the chunk
+    * \param [out] reference receives the position of the earlier chunk if one is found
+    * \return true if the chunk should be written as a reference, false if its payload is written
+    *
+    * A chunk whose payload is new is added to the index.
+    **/
+   bool ChunkDeduplicator::findReference( BaseChunk &chunk, size_t position, size_t * reference )
+   {
+      size_t bytes = chunk.m_buffer.getSize();
+      m_stats.m_chunks++;
+      m_stats.m_payloadBytes += bytes;
+
+      if( bytes < m_minSize ) {
+         m_stats.m_writtenBytes += bytes;
+         return false;
+      }
+
+      const uint8_t * payload = chunk.m_buffer.m_buffer.get();
+      uint64_t hash = hash64( payload, bytes );
+
+      size_t slot = 0;
+      if( m_index.find( hash, &slot )) {
+         Original & original = m_originals[slot];
+         if(( original.m_payload.getSize() == bytes )
+          &&(( original.m_payload.m_buffer.get() == payload )||( !memcmp( original.m_payload.m_buffer.get(), payload, bytes )))) {
+            *reference = original.m_position;
+            m_stats.m_references++;
+            m_stats.m_writtenBytes += BASECHUNK_REFERENCE_SIZE;
+            return true;
+         }
+
+         //Hash collision with different data. Keep the first payload indexed
+         m_stats.m_writtenBytes += bytes;
+         return false;
+      }
+
+      Original original;
+      original.m_payload  = chunk.m_buffer;
+      original.m_position = position;
+      m_index.insert( hash, m_originals.size());
+      m_originals.push_back( original );
+      m_stats.m_writtenBytes += bytes;
+
+      return false;
+   }
+
+   /**
+    * \brief Empties the index and releases the indexed payloads
+    **/
+   void ChunkDeduplicator::clear()
+   {
+      m_index.clear();
+      m_originals.clear();
+   }
+
+   /**
+    * \brief Returns the statistics since construction or the last resetStats
+    **/
+   DedupStats ChunkDeduplicator::getStats()
+   {
+      return m_stats;
+   }
+
+   /**
+    * \brief Resets the statistics
+    **/
+   void ChunkDeduplicator::resetStats()
+   {
+      m_stats = DedupStats();
+   }
+
+   /**
+    * \brief Returns the size of the reference record of a chunk (header, type and reference)
+    **/
+   size_t ChunkDeduplicator::getReferenceRecordSize( BaseChunk &chunk )
+   {
+      return chunk.getHeaderSize() + BASECHUNK_REFERENCE_SIZE;
+   }
+
+   /**
+    * \brief Encodes a chunk as a reference record
+    *
+    * \param [in] chunk chunk to encode. Its metadata and type are kept
+    * \param [in] reference container position of the chunk that holds the payload
+    * \param [in] buffer destination buffer
+    * \param [in] bytes size of the destination buffer
+    * \return number of bytes written (getReferenceRecordSize), 0 if the buffer is too small
+    **/
+   size_t ChunkDeduplicator::encodeReferenceRecord( BaseChunk &chunk, size_t reference, uint8_t * buffer, size_t bytes )
+   {
+      size_t recordSize = getReferenceRecordSize( chunk );
+      if( bytes < recordSize ) {
+         std::cerr << "ChunkDeduplicator: record buffer too small ("<<bytes<<"<"<<recordSize<<")"<<std::endl;
+         return 0;
+      }
+
+      size_t headerSize = chunk.encodeHeader( buffer, bytes, BASECHUNK_FLAG_REFERENCE );
+      writeLE64( &buffer[48], BASECHUNK_REFERENCE_SIZE );
+      writeLE64( &buffer[headerSize],     reference );
+      writeLE64( &buffer[headerSize + 8], chunk.m_buffer.getSize());
+
+      return recordSize;
+   }
+
+   /**
+    * \brief Decodes the payload of a reference record
+    *
+    * \param [in] payload payload of the reference record
+    * \param [in] bytes payload size from the record header
+    * \param [in] position container position of the reference record
+    * \param [out] reference receives the position of the record with the payload
+    * \param [out] size receives the size of the referenced payload
+    * \return true on success, false if the reference is invalid
+    **/
+   bool ChunkDeduplicator::decodeReference( const uint8_t * payload, uint64_t bytes, size_t position, size_t * reference, uint64_t * size )
+   {
+      if( bytes != BASECHUNK_REFERENCE_SIZE ) {
+         std::cerr << "ChunkDeduplicator: invalid reference size "<<bytes<<std::endl;
+         return false;
+      }
+
+      uint64_t target = readLE64( &payload[0] );
+      if( target >= position ) {
+         std::cerr << "ChunkDeduplicator: record "<<position<<" references record "<<target<<std::endl;
+         return false;
+      }
+
+      *reference = (size_t)target;
+      *size      = readLE64( &payload[8] );
+
+      return true;
+   }
+
+   /**
+    * \brief Unit test for the ChunkDeduplicator class
+    **/
+   bool testChunkDeduplicator()
+   {
+      ChunkDeduplicator dedup( 64 );
+
+      //Chunks 0, 2 and 4 share a payload, chunk 3 is a copy of chunk 1 in another buffer
+      std::vector<BaseChunk> chunks( 6 );
+      for( size_t i = 0; i < chunks.size(); i++ ) {
+         chunks[i].m_metadata.m_id = i;
+      }
+      chunks[0].allocate( 1000 );
+      memset( chunks[0].m_buffer.m_buffer.get(), 7, 1000 );
+      chunks[1].allocate( 1000 );
+      memset( chunks[1].m_buffer.m_buffer.get(), 8, 1000 );
+      chunks[2].m_buffer = chunks[0].m_buffer;
+      chunks[3].allocate( 1000 );
+      memset( chunks[3].m_buffer.m_buffer.get(), 8, 1000 );
+      chunks[4].m_buffer = chunks[0].m_buffer;
+      chunks[5].allocate( 10 );                       //below the minimum size
+
+      size_t expected[] = { SIZE_MAX, SIZE_MAX, 0, 1, 0, SIZE_MAX };
+      for( size_t i = 0; i < chunks.size(); i++ ) {
+         size_t reference = SIZE_MAX;
+         bool found = dedup.findReference( chunks[i], i, &reference );
+         if(( found != ( expected[i] != SIZE_MAX ))||(( found )&&( reference != expected[i] ))) {
+            std::cout << "ChunkDeduplicator chunk "<<i<<" reference "<<reference<<" != "<<expected[i]<<std::endl;
+            return false;
+         }
+      }
+
+      DedupStats stats = dedup.getStats();
+      if(( stats.m_chunks != 6 )||( stats.m_references != 3 )||( stats.m_payloadBytes != 5010 )
+       ||( stats.m_writtenBytes != 2010 + 3 * BASECHUNK_REFERENCE_SIZE )
+       ||( stats.getSavedBytes() != 3000 - 3 * BASECHUNK_REFERENCE_SIZE )) {
+         std::cout << "ChunkDeduplicator statistics do not match"<<std::endl;
+         return false;
+      }
+
+      //Reference records round trip through the chunk header
+      chunks[2].m_metadata.m_type = "ref";
+      std::vector<uint8_t> record( ChunkDeduplicator::getReferenceRecordSize( chunks[2] ));
+      BaseChunk decoded;
+      uint32_t typeLength = 0;
+      uint64_t dataSize   = 0;
+      uint16_t flags      = 0;
+      size_t   reference  = 0;
+      uint64_t size       = 0;
+      if(( ChunkDeduplicator::encodeReferenceRecord( chunks[2], 0, record.data(), record.size()) != record.size())
+       ||( !decoded.decodeHeader( record.data(), record.size(), &typeLength, &dataSize, &flags ))
+       ||( flags != BASECHUNK_FLAG_REFERENCE )||( decoded.m_metadata.m_id != 2 )||( decoded.m_metadata.m_type != "ref" )
+       ||( !ChunkDeduplicator::decodeReference( &record[BASECHUNK_HEADER_SIZE + typeLength], dataSize, 2, &reference, &size ))
+       ||( reference != 0 )||( size != 1000 )
+       ||( ChunkDeduplicator::decodeReference( &record[BASECHUNK_HEADER_SIZE + typeLength], dataSize, 0, &reference, &size ))) {
+         std::cout << "ChunkDeduplicator reference record does not round trip"<<std::endl;
+         return false;
+      }
+
+      //A cleared index starts over but keeps the statistics
+      dedup.clear();
+      if(( dedup.findReference( chunks[2], 0, &reference ))||( dedup.getStats().m_chunks != 7 )) {
+         std::cout << "ChunkDeduplicator clear failed"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
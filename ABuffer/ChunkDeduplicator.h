@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseBuffer.h>
+#include <BaseChunk.h>
+#include <ChunkIndex.h>
+
+#define CHUNKDEDUP_DEFAULT_MIN_SIZE 256     //!< Payloads smaller than this are always written
+
+namespace atl
+{
+   /**
+    * \brief Write statistics of a ChunkDeduplicator
+    **/
+   struct DedupStats
+   {
+      uint64_t m_chunks       = 0;            //!< Number of chunks checked
+      uint64_t m_references   = 0;            //!< Number of chunks written as references
+      uint64_t m_payloadBytes = 0;            //!< Payload bytes of all checked chunks
+      uint64_t m_writtenBytes = 0;            //!< Payload bytes actually written, including references
+
+      uint64_t getSavedBytes() const { return m_payloadBytes - m_writtenBytes; };
+   };
+
+   /**
+    * \brief Content-addressed payload index for container writers
+    *
+    * Container writers pass each chunk to findReference in container order.
+    * The payload is hashed with hash64 and looked up in an index of the
+    * payloads seen so far. A hash match is confirmed by comparing the bytes,
+    * so hash collisions never produce a wrong reference. A duplicate chunk is
+    * written as a reference record (BASECHUNK_FLAG_REFERENCE) that names the
+    * container position of the first chunk with the same payload.
+    *
+    * The index holds a reference to every indexed payload so the comparison
+    * stays valid. Writers clear the index at the start of every file, since
+    * references are positions within one file; the statistics accumulate
+    * until resetStats is called.
+    *
+    * The class is not thread-safe. The owner is responsible for locking.
+    **/
+   class ChunkDeduplicator
+   {
+      private:
+         /**
+          * \brief A payload in the index
+          **/
+         struct Original
+         {
+            BaseBuffer m_payload;                        //!< Payload of the first chunk with this hash
+            size_t     m_position = 0;                   //!< Container position of that chunk
+         };
+
+         ChunkIndex            m_index;                   //!< Payload hash to position in m_originals
+         std::vector<Original> m_originals;               //!< Indexed payloads
+         size_t                m_minSize = CHUNKDEDUP_DEFAULT_MIN_SIZE; //!< Smallest payload that is indexed
+         DedupStats            m_stats;                   //!< Write statistics
+
+      public:
+         ChunkDeduplicator( size_t minSize = CHUNKDEDUP_DEFAULT_MIN_SIZE );
+
+         bool       findReference( BaseChunk &chunk, size_t position, size_t * reference );
+         void       clear();
+         DedupStats getStats();
+         void       resetStats();
+
+         static size_t getReferenceRecordSize( BaseChunk &chunk );
+         static size_t encodeReferenceRecord( BaseChunk &chunk, size_t reference, uint8_t * buffer, size_t bytes );
+         static bool   decodeReference( const uint8_t * payload, uint64_t bytes, size_t position, size_t * reference, uint64_t * size );
+   };
+
+   //Test functions
+   bool testChunkDeduplicator();
+}
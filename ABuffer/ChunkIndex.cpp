@@ -0,0 +1,255 @@
+#include <iostream>
+#include <ChunkIndex.h>
+
+namespace atl
+{
+   /**
+    * \brief Maps an id to its home slot
+    *
+    * Chunk ids are frequently sequential, so the id is mixed (splitmix64
+    * finalizer) before masking to spread neighbouring ids over the table.
+    **/
+   size_t ChunkIndex::getSlot( uint64_t id ) const
+   {
+      id ^= id >> 30;
+      id *= 0xbf58476d1ce4e5b9ULL;
+      id ^= id >> 27;
+      id *= 0x94d049bb133111ebULL;
+      id ^= id >> 31;
+
+      return (size_t)id & ( m_slots.size() - 1 );
+   }
+
+   /**
+    * \brief Rehashes the table into the given number of slots
+    * \param [in] capacity new number of slots (power of two)
+    **/
+   void ChunkIndex::grow( size_t capacity )
+   {
+      std::vector<Slot> slots( capacity );
+      m_slots.swap( slots );
+
+      size_t mask = capacity - 1;
+      for( size_t i = 0; i < slots.size(); i++ ) {
+         if( slots[i].m_position == SIZE_MAX ) {
+            continue;
+         }
+
+         size_t slot = getSlot( slots[i].m_id );
+         while( m_slots[slot].m_position != SIZE_MAX ) {
+            slot = ( slot + 1 ) & mask;
+         }
+         m_slots[slot] = slots[i];
+      }
+   }
+
+   /**
+    * \brief Makes room for the given number of ids without rehashing
+    * \param [in] count number of ids
+    **/
+   void ChunkIndex::reserve( size_t count )
+   {
+      size_t capacity = 16;
+      while( capacity < 2 * count ) {
+         capacity *= 2;
+      }
+
+      if( capacity > m_slots.size()) {
+         grow( capacity );
+      }
+   }
+
+   /**
+    * \brief Adds an id to the index
+    *
+    * \param [in] id chunk id
+    * \param [in] position position of the chunk
+    * \return true on success, false if the id is already in the index
+    **/
+   bool ChunkIndex::insert( uint64_t id, size_t position )
+   {
+      if( 2 * ( m_count + 1 ) > m_slots.size()) {
+         grow( m_slots.size() == 0 ? 16 : 2 * m_slots.size());
+      }
+
+      size_t mask = m_slots.size() - 1;
+      size_t slot = getSlot( id );
+      while( m_slots[slot].m_position != SIZE_MAX ) {
+         if( m_slots[slot].m_id == id ) {
+            return false;
+         }
+         slot = ( slot + 1 ) & mask;
+      }
+
+      m_slots[slot].m_id       = id;
+      m_slots[slot].m_position = position;
+      m_count++;
+
+      return true;
+   }
+
+   /**
+    * \brief Looks up the position of an id
+    *
+    * \param [in] id chunk id
+    * \param [out] position position of the chunk
+    * \return true if the id was found
+    **/
+   bool ChunkIndex::find( uint64_t id, size_t * position ) const
+   {
+      if( m_count == 0 ) {
+         return false;
+      }
+
+      size_t mask = m_slots.size() - 1;
+      size_t slot = getSlot( id );
+      while( m_slots[slot].m_position != SIZE_MAX ) {
+         if( m_slots[slot].m_id == id ) {
+            *position = m_slots[slot].m_position;
+            return true;
+         }
+         slot = ( slot + 1 ) & mask;
+      }
+
+      return false;
+   }
+
+   /**
+    * \brief Changes the position stored for an id
+    *
+    * \param [in] id chunk id
+    * \param [in] position new position of the chunk
+    * \return true on success, false if the id is not in the index
+    **/
+   bool ChunkIndex::update( uint64_t id, size_t position )
+   {
+      if( m_count == 0 ) {
+         return false;
+      }
+
+      size_t mask = m_slots.size() - 1;
+      size_t slot = getSlot( id );
+      while( m_slots[slot].m_position != SIZE_MAX ) {
+         if( m_slots[slot].m_id == id ) {
+            m_slots[slot].m_position = position;
+            return true;
+         }
+         slot = ( slot + 1 ) & mask;
+      }
+
+      return false;
+   }
+
+   /**
+    * \brief Removes an id from the index
+    *
+    * \param [in] id chunk id
+    * \return true on success, false if the id is not in the index
+    *
+    * Entries following the removed slot in the probe sequence are shifted
+    * back so that every entry stays reachable from its home slot.
+    **/
+   bool ChunkIndex::remove( uint64_t id )
+   {
+      if( m_count == 0 ) {
+         return false;
+      }
+
+      size_t mask = m_slots.size() - 1;
+      size_t slot = getSlot( id );
+      while( m_slots[slot].m_id != id ) {
+         if( m_slots[slot].m_position == SIZE_MAX ) {
+            return false;
+         }
+         slot = ( slot + 1 ) & mask;
+      }
+      if( m_slots[slot].m_position == SIZE_MAX ) {
+         return false;
+      }
+
+      //Backward-shift the rest of the cluster into the hole
+      size_t hole = slot;
+      size_t next = ( hole + 1 ) & mask;
+      while( m_slots[next].m_position != SIZE_MAX ) {
+         size_t home = getSlot( m_slots[next].m_id );
+         if((( next - home ) & mask ) >= (( next - hole ) & mask )) {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+         }
+         next = ( next + 1 ) & mask;
+      }
+
+      m_slots[hole] = Slot();
+      m_count--;
+
+      return true;
+   }
+
+   /**
+    * \brief Removes all ids from the index
+    **/
+   void ChunkIndex::clear()
+   {
+      m_slots.clear();
+      m_count = 0;
+   }
+
+   /**
+    * \brief Unit test for the ChunkIndex class
+    **/
+   bool testChunkIndex()
+   {
+      ChunkIndex index;
+      size_t position = 0;
+      if( index.find( 5, &position )) {
+         std::cout << "ChunkIndex found an id in an empty index"<<std::endl;
+         return false;
+      }
+
+      //Sequential and strided ids
+      const size_t count = 10000;
+      for( size_t i = 0; i < count; i++ ) {
+         if( !index.insert( i * 1024, i )) {
+            std::cout << "ChunkIndex failed to insert "<<i * 1024<<std::endl;
+            return false;
+         }
+      }
+      if(( index.insert( 1024, 99 ))||( index.getSize() != count )) {
+         std::cout << "ChunkIndex accepted a duplicate id"<<std::endl;
+         return false;
+      }
+
+      //Remove every third id and verify the rest are still reachable
+      for( size_t i = 0; i < count; i += 3 ) {
+         if( !index.remove( i * 1024 )) {
+            std::cout << "ChunkIndex failed to remove "<<i * 1024<<std::endl;
+            return false;
+         }
+      }
+      if( index.remove( 0 )) {
+         std::cout << "ChunkIndex removed an id twice"<<std::endl;
+         return false;
+      }
+
+      for( size_t i = 0; i < count; i++ ) {
+         bool found = index.find( i * 1024, &position );
+         if(( found != ( i % 3 != 0 ))||(( found )&&( position != i ))) {
+            std::cout << "ChunkIndex lookup of "<<i * 1024<<" returned "<<found<<","<<position<<std::endl;
+            return false;
+         }
+      }
+
+      if(( !index.update( 1024, 7 ))||( !index.find( 1024, &position ))||( position != 7 )) {
+         std::cout << "ChunkIndex update failed"<<std::endl;
+         return false;
+      }
+
+      index.clear();
+      if(( index.getSize() != 0 )||( index.find( 1024, &position ))) {
+         std::cout << "ChunkIndex clear failed"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
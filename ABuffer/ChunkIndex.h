@@ -0,0 +1,45 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace atl
+{
+   /**
+    * \brief Open-addressing hash index from chunk id to array position
+    *
+    * Slots are stored in one flat power-of-two sized table and collisions are
+    * resolved by linear probing. The table is kept at most half full so probe
+    * sequences stay short. Removal uses backward-shift deletion, so there are
+    * no tombstones and lookup cost does not degrade after many erases.
+    *
+    * The class is not thread-safe. The owner is responsible for locking.
+    **/
+   class ChunkIndex
+   {
+      private:
+         struct Slot
+         {
+            uint64_t m_id       = 0;                        //!< Chunk id
+            size_t   m_position = SIZE_MAX;                 //!< Position in the owning array (SIZE_MAX if empty)
+         };
+
+         std::vector<Slot> m_slots;                         //!< Hash table
+         size_t            m_count = 0;                     //!< Number of used slots
+
+         size_t getSlot( uint64_t id ) const;
+         void   grow( size_t capacity );
+
+      public:
+         bool   insert( uint64_t id, size_t position );
+         bool   find( uint64_t id, size_t * position ) const;
+         bool   update( uint64_t id, size_t position );
+         bool   remove( uint64_t id );
+         void   reserve( size_t count );
+         void   clear();
+         size_t getSize() const { return m_count; };
+   };
+
+   //Test functions
+   bool testChunkIndex();
+}
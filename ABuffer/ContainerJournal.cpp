@@ -0,0 +1,618 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include <ContainerJournal.h>
+#include <ByteOrder.h>
+#include <Checksum.h>
+#include <FileIO.h>
+
+namespace atl
+{
+   /**
+    * \brief Flushes the directory entry of a newly created file
+    **/
+   static bool syncDirectory( const std::string &filename )
+   {
+      size_t      slash     = filename.rfind( '/' );
+      std::string directory = ( slash == std::string::npos ) ? "." : filename.substr( 0, slash + 1 );
+
+      int fd = ::open( directory.c_str(), O_RDONLY | O_DIRECTORY );
+      if( fd < 0 ) {
+         return false;
+      }
+
+      bool rc = ( fsync( fd ) == 0 );
+      ::close( fd );
+      return rc;
+   }
+
+   /**
+    * \brief Destructor. Commits queued records and closes the journal
+    **/
+   ContainerJournal::~ContainerJournal()
+   {
+      close();
+   }
+
+   /**
+    * \brief Opens a journal for appending, creating it if needed
+    *
+    * \param [in] filename journal file
+    * \param [in] maxBatchBytes maximum number of bytes written per commit
+    * \param [in] maxDelay maximum time in seconds a commit waits for more records
+    * \return true on success, false on failure
+    *
+    * An existing journal is scanned and truncated after the last valid record.
+    **/
+   bool ContainerJournal::open( std::string filename, size_t maxBatchBytes, double maxDelay )
+   {
+      if( isOpen()) {
+         std::cerr << "ContainerJournal: journal is already open"<<std::endl;
+         return false;
+      }
+
+      int fd = ::open( filename.c_str(), O_RDWR | O_CREAT, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "ContainerJournal: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      struct stat info;
+      if( fstat( fd, &info ) != 0 ) {
+         std::cerr << "ContainerJournal: unable to stat "<<filename<<": "<<strerror(errno)<<std::endl;
+         ::close( fd );
+         return false;
+      }
+
+      uint64_t validEnd = CONTAINERJOURNAL_HEADER_SIZE;
+      uint64_t count    = 0;
+      if( info.st_size == 0 ) {
+         uint8_t header[CONTAINERJOURNAL_HEADER_SIZE] = {0};
+         memcpy( &header[0], CONTAINERJOURNAL_MAGIC, 4 );
+         writeLE16( &header[4], CONTAINERJOURNAL_VERSION );
+
+         if(( !writeFully( fd, header, sizeof(header)))||( fdatasync( fd ) != 0 )) {
+            std::cerr << "ContainerJournal: unable to initialize "<<filename<<": "<<strerror(errno)<<std::endl;
+            ::close( fd );
+            return false;
+         }
+         syncDirectory( filename );
+      }
+      else {
+         if( !scan( fd, info.st_size, &validEnd, &count, NULL )) {
+            std::cerr << "ContainerJournal: "<<filename<<" is not a journal"<<std::endl;
+            ::close( fd );
+            return false;
+         }
+
+         if( validEnd < (uint64_t)info.st_size ) {
+            std::cerr << "ContainerJournal: discarding "<<info.st_size - validEnd
+                      << " bytes after the last valid record in "<<filename<<std::endl;
+            if(( ftruncate( fd, validEnd ) != 0 )||( fdatasync( fd ) != 0 )) {
+               std::cerr << "ContainerJournal: unable to truncate "<<filename<<": "<<strerror(errno)<<std::endl;
+               ::close( fd );
+               return false;
+            }
+         }
+      }
+
+      if( lseek( fd, validEnd, SEEK_SET ) != (off_t)validEnd ) {
+         std::cerr << "ContainerJournal: unable to seek in "<<filename<<": "<<strerror(errno)<<std::endl;
+         ::close( fd );
+         return false;
+      }
+
+      std::lock_guard<std::mutex> guard( m_mutex );
+      m_fd                = fd;
+      m_maxBatchBytes     = maxBatchBytes;
+      m_maxDelay          = maxDelay;
+      m_pendingBytes      = 0;
+      m_nextSequence      = 0;
+      m_committedSequence = 0;
+      m_failedSequence    = UINT64_MAX;
+      m_commitCount       = 0;
+      m_recordCount       = 0;
+      m_largestBatch      = 0;
+      m_recoveredCount    = count;
+      m_running           = true;
+      m_thread = std::thread( &ContainerJournal::commitLoop, this );
+
+      return true;
+   }
+
+   /**
+    * \brief Commits all queued records and closes the journal
+    **/
+   void ContainerJournal::close()
+   {
+      {
+         std::lock_guard<std::mutex> guard( m_mutex );
+         if( !m_running ) {
+            return;
+         }
+         m_running = false;
+      }
+
+      m_pendingCv.notify_one();
+      m_thread.join();
+
+      ::close( m_fd );
+      m_fd = -1;
+   }
+
+   /**
+    * \brief Returns true if the journal is open for appending
+    **/
+   bool ContainerJournal::isOpen()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_running;
+   }
+
+   /**
+    * \brief Appends a chunk and waits until it is durable
+    *
+    * \param [in] chunk chunk to append. The payload is not copied
+    * \return true once the chunk is on stable storage, false on failure
+    *
+    * The record is encoded and checksummed by the calling thread. The payload
+    * must not be modified until this function returns.
+    **/
+   bool ContainerJournal::append( BaseChunk &chunk )
+   {
+      PendingRecord record;
+      record.m_chunk = chunk;
+
+      size_t   headerSize  = chunk.getHeaderSize();
+      uint64_t payloadSize = chunk.m_buffer.getSize();
+      record.m_header.resize( CONTAINERJOURNAL_PREFIX_SIZE + headerSize );
+
+      uint8_t * prefix = record.m_header.data();
+      chunk.encodeHeader( prefix + CONTAINERJOURNAL_PREFIX_SIZE, headerSize );
+
+      uint32_t checksum = crc32c( prefix + CONTAINERJOURNAL_PREFIX_SIZE, headerSize );
+      checksum = crc32c( chunk.m_buffer.m_buffer.get(), payloadSize, checksum );
+      writeLE64( &prefix[0], headerSize + payloadSize );
+      writeLE32( &prefix[8], checksum );
+      writeLE32( &prefix[12], crc32c( prefix, 12 ));
+
+      size_t bytes = record.m_header.size() + payloadSize;
+      record.m_bytes = bytes;
+
+      std::unique_lock<std::mutex> lock( m_mutex );
+      if( !m_running ) {
+         std::cerr << "ContainerJournal: append to a closed journal"<<std::endl;
+         return false;
+      }
+      if( m_failedSequence != UINT64_MAX ) {
+         return false;
+      }
+
+      uint64_t sequence = ++m_nextSequence;
+      record.m_sequence = sequence;
+
+      //The committer only needs waking for the first record or a full batch
+      bool wake = ( m_pending.empty() )||( m_pendingBytes + bytes >= m_maxBatchBytes );
+      m_pendingBytes += bytes;
+      m_pending.push_back( std::move( record ));
+      if( wake ) {
+         m_pendingCv.notify_one();
+      }
+
+      while( m_committedSequence < sequence ) {
+         m_commitCv.wait( lock );
+      }
+
+      return sequence < m_failedSequence;
+   }
+
+   /**
+    * \brief Committer thread. Writes queued records in batches
+    **/
+   void ContainerJournal::commitLoop()
+   {
+      std::vector<PendingRecord>   batch;
+      std::unique_lock<std::mutex> lock( m_mutex );
+
+      while( true ) {
+         while(( m_running )&&( m_pending.empty() )) {
+            m_pendingCv.wait( lock );
+         }
+         if( m_pending.empty()) {
+            break;
+         }
+
+         //Give other producers up to maxDelay to join the batch
+         if( m_maxDelay > 0 ) {
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+               + std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( m_maxDelay ));
+            while(( m_running )&&( m_pendingBytes < m_maxBatchBytes )) {
+               if( m_pendingCv.wait_until( lock, deadline ) == std::cv_status::timeout ) {
+                  break;
+               }
+            }
+         }
+
+         //Take records in order up to the batch limit, but at least one
+         size_t count      = 0;
+         size_t batchBytes = 0;
+         while(( count < m_pending.size() )
+            &&(( count == 0 )||( batchBytes + m_pending[count].m_bytes <= m_maxBatchBytes ))) {
+            batchBytes += m_pending[count].m_bytes;
+            count++;
+         }
+         batch.assign( std::make_move_iterator( m_pending.begin()), std::make_move_iterator( m_pending.begin() + count ));
+         m_pending.erase( m_pending.begin(), m_pending.begin() + count );
+         m_pendingBytes -= batchBytes;
+         if( batchBytes > m_largestBatch ) {
+            m_largestBatch = batchBytes;
+         }
+         bool failed = ( m_failedSequence != UINT64_MAX );
+         lock.unlock();
+
+         bool rc = ( !failed )&&( writeBatch( batch ));
+
+         lock.lock();
+         if(( !rc )&&( !failed )) {
+            m_failedSequence = batch.front().m_sequence;
+         }
+         m_committedSequence = batch.back().m_sequence;
+         m_commitCount++;
+         m_recordCount += batch.size();
+         batch.clear();
+
+         m_commitCv.notify_all();
+      }
+   }
+
+   /**
+    * \brief Writes a batch of records and syncs the file
+    **/
+   bool ContainerJournal::writeBatch( std::vector<PendingRecord> &batch )
+   {
+      std::vector<struct iovec> iov;
+      iov.reserve( 2 * batch.size());
+      for( size_t i = 0; i < batch.size(); i++ ) {
+         struct iovec entry;
+         entry.iov_base = batch[i].m_header.data();
+         entry.iov_len  = batch[i].m_header.size();
+         iov.push_back( entry );
+
+         if( batch[i].m_chunk.m_buffer.getSize() > 0 ) {
+            entry.iov_base = batch[i].m_chunk.m_buffer.m_buffer.get();
+            entry.iov_len  = batch[i].m_chunk.m_buffer.getSize();
+            iov.push_back( entry );
+         }
+      }
+
+      bool rc = true;
+      for( size_t i = 0; ( rc )&&( i < iov.size() ); i += IOV_MAX ) {
+         size_t count = iov.size() - i;
+         if( count > IOV_MAX ) {
+            count = IOV_MAX;
+         }
+         rc = writevFully( m_fd, &iov[i], count );
+      }
+
+      if(( rc )&&( fdatasync( m_fd ) != 0 )) {
+         std::cerr << "ContainerJournal: fdatasync failed: "<<strerror(errno)<<std::endl;
+         rc = false;
+      }
+
+      return rc;
+   }
+
+   /**
+    * \brief Reads records from the start of a journal until the first invalid one
+    *
+    * \param [in] fd journal descriptor
+    * \param [in] fileSize size of the journal file
+    * \param [out] validEnd offset just past the last valid record
+    * \param [out] count number of valid records
+    * \param [in] container receives the chunks if not NULL
+    * \return true if the file has a valid journal header, false otherwise
+    **/
+   bool ContainerJournal::scan( int fd, uint64_t fileSize, uint64_t * validEnd, uint64_t * count, BaseContainer * container )
+   {
+      uint8_t header[CONTAINERJOURNAL_HEADER_SIZE];
+      if(( lseek( fd, 0, SEEK_SET ) != 0 )||( fileSize < sizeof(header))||( !readFully( fd, header, sizeof(header)))) {
+         std::cerr << "ContainerJournal: journal header is truncated"<<std::endl;
+         return false;
+      }
+
+      if( memcmp( header, CONTAINERJOURNAL_MAGIC, 4 ) != 0 ) {
+         std::cerr << "ContainerJournal: invalid journal magic"<<std::endl;
+         return false;
+      }
+
+      uint16_t version = readLE16( &header[4] );
+      if( version != CONTAINERJOURNAL_VERSION ) {
+         std::cerr << "ContainerJournal: unsupported journal version "<<version<<std::endl;
+         return false;
+      }
+
+      uint64_t offset = CONTAINERJOURNAL_HEADER_SIZE;
+      *count = 0;
+      while( offset + CONTAINERJOURNAL_PREFIX_SIZE <= fileSize ) {
+         uint8_t prefix[CONTAINERJOURNAL_PREFIX_SIZE];
+         if(( !readFully( fd, prefix, sizeof(prefix)))||( readLE32( &prefix[12] ) != crc32c( prefix, 12 ))) {
+            break;
+         }
+
+         uint64_t size = readLE64( &prefix[0] );
+         if(( size < BASECHUNK_HEADER_SIZE )||( size > fileSize - offset - CONTAINERJOURNAL_PREFIX_SIZE )) {
+            break;
+         }
+
+         BaseChunk chunk;
+         uint8_t   fixed[BASECHUNK_HEADER_SIZE];
+         uint32_t  typeLength = 0;
+         uint64_t  dataSize   = 0;
+         if(( !readFully( fd, fixed, sizeof(fixed)))
+          ||( !chunk.decodeHeader( fixed, sizeof(fixed), &typeLength, &dataSize ))
+          ||( dataSize > size )
+          ||( BASECHUNK_HEADER_SIZE + typeLength + dataSize != size )) {
+            break;
+         }
+
+         chunk.m_metadata.m_type.resize( typeLength );
+         if(( dataSize > 0 )&&( !chunk.m_buffer.allocate( dataSize ))) {
+            break;
+         }
+
+         struct iovec iov[2];
+         iov[0].iov_base = &chunk.m_metadata.m_type[0];
+         iov[0].iov_len  = typeLength;
+         iov[1].iov_base = chunk.m_buffer.m_buffer.get();
+         iov[1].iov_len  = dataSize;
+         if( !readvFully( fd, iov, 2 )) {
+            break;
+         }
+
+         uint32_t checksum = crc32c( fixed, sizeof(fixed));
+         checksum = crc32c( chunk.m_metadata.m_type.data(), typeLength, checksum );
+         checksum = crc32c( chunk.m_buffer.m_buffer.get(), dataSize, checksum );
+         if( checksum != readLE32( &prefix[8] )) {
+            break;
+         }
+
+         if( container != NULL ) {
+            container->push_back( chunk );
+         }
+
+         offset += CONTAINERJOURNAL_PREFIX_SIZE + size;
+         (*count)++;
+      }
+
+      *validEnd = offset;
+      return true;
+   }
+
+   /**
+    * \brief Reads all valid records of a journal into a container
+    *
+    * \param [in] filename journal file
+    * \param [in] container container the chunks are appended to
+    * \return true on success, false if the file is not a journal
+    *
+    * The file is not modified. Reading stops at the first invalid record.
+    **/
+   bool ContainerJournal::load( std::string filename, BaseContainer &container )
+   {
+      int fd = ::open( filename.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         std::cerr << "ContainerJournal: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      struct stat info;
+      uint64_t validEnd = 0;
+      uint64_t count    = 0;
+      bool rc = ( fstat( fd, &info ) == 0 )&&( scan( fd, info.st_size, &validEnd, &count, &container ));
+      ::close( fd );
+
+      return rc;
+   }
+
+   /**
+    * \brief Returns the number of commits since open
+    **/
+   uint64_t ContainerJournal::getCommitCount()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_commitCount;
+   }
+
+   /**
+    * \brief Returns the number of records committed since open
+    **/
+   uint64_t ContainerJournal::getRecordCount()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_recordCount;
+   }
+
+   /**
+    * \brief Returns the size in bytes of the largest commit since open
+    **/
+   size_t ContainerJournal::getLargestBatch()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_largestBatch;
+   }
+
+   /**
+    * \brief Returns the number of valid records found in the journal on open
+    **/
+   uint64_t ContainerJournal::getRecoveredCount()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_recoveredCount;
+   }
+
+   /**
+    * \brief Unit test for the ContainerJournal class
+    **/
+   bool testContainerJournal()
+   {
+      char filename[] = "/tmp/ContainerJournalXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cout << "ContainerJournal unable to create temporary file"<<std::endl;
+         return false;
+      }
+      ::close( fd );
+
+      //Append from several producers
+      const size_t threadCount = 4;
+      const size_t perThread   = 50;
+      bool rc = true;
+      {
+         ContainerJournal journal;
+         if( !journal.open( filename, 64 * 1024, 0.001 )) {
+            std::cout << "ContainerJournal open failed"<<std::endl;
+            unlink( filename );
+            return false;
+         }
+
+         std::vector<std::thread> threads;
+         std::vector<int>         results( threadCount, 1 );
+         for( size_t t = 0; t < threadCount; t++ ) {
+            threads.push_back( std::thread( [&journal, &results, t, perThread]() {
+               for( size_t i = 0; i < perThread; i++ ) {
+                  BaseChunk chunk( t * 1000 + i );
+                  chunk.m_metadata.m_type = "journal";
+                  chunk.allocate( 100 + i );
+                  memset( chunk.m_buffer.m_buffer.get(), (int)( t + i ), 100 + i );
+                  if( !journal.append( chunk )) {
+                     results[t] = 0;
+                  }
+               }
+            }));
+         }
+         for( size_t t = 0; t < threadCount; t++ ) {
+            threads[t].join();
+            rc = rc && results[t];
+         }
+
+         if(( !rc )||( journal.getRecordCount() != threadCount * perThread )
+          ||( journal.getCommitCount() > threadCount * perThread )) {
+            std::cout << "ContainerJournal append failed"<<std::endl;
+            rc = false;
+         }
+      }
+
+      BaseContainer container;
+      if(( !rc )||( !ContainerJournal::load( filename, container ))
+       ||( container.m_containerArray.getSize() != threadCount * perThread )) {
+         std::cout << "ContainerJournal load did not return all chunks"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      BaseChunk chunk;
+      if(( !container.find( 2 * 1000 + 7, &chunk ))||( chunk.m_buffer.getSize() != 107 )
+       ||( chunk.m_buffer[106] != 9 )||( chunk.m_metadata.m_type != "journal" )) {
+         std::cout << "ContainerJournal chunk contents do not match"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //A torn record at the end is discarded on open
+      struct stat info;
+      stat( filename, &info );
+      off_t validSize = info.st_size;
+      fd = ::open( filename, O_WRONLY | O_APPEND );
+      uint8_t garbage[100];
+      memset( garbage, 0x5A, sizeof(garbage));
+      rc = ( fd >= 0 )&&( writeFully( fd, garbage, sizeof(garbage)));
+      ::close( fd );
+
+      {
+         ContainerJournal journal;
+         BaseChunk extra( 9999 );
+         extra.allocate( 10 );
+         rc = rc && journal.open( filename, 0, 0 );
+         rc = rc && ( journal.getRecoveredCount() == threadCount * perThread );
+         stat( filename, &info );
+         rc = rc && ( info.st_size == validSize );
+         rc = rc && journal.append( extra );
+      }
+      if( !rc ) {
+         std::cout << "ContainerJournal recovery failed"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //A record cut short by a crash is not returned
+      stat( filename, &info );
+      rc = ( truncate( filename, info.st_size - 3 ) == 0 );
+      BaseContainer truncated;
+      rc = rc && ContainerJournal::load( filename, truncated );
+      rc = rc && ( truncated.m_containerArray.getSize() == threadCount * perThread );
+      unlink( filename );
+
+      if( !rc ) {
+         std::cout << "ContainerJournal load returned a truncated record"<<std::endl;
+         return false;
+      }
+
+      //Records queued during a sync are split into batches of at most maxBatchBytes
+      char batchname[] = "/tmp/ContainerJournalXXXXXX";
+      fd = mkstemp( batchname );
+      if( fd < 0 ) {
+         std::cout << "ContainerJournal unable to create temporary file"<<std::endl;
+         return false;
+      }
+      ::close( fd );
+      {
+         const size_t batchBytes = 4096;
+         const size_t payload    = 1000;
+         ContainerJournal journal;
+         std::vector<std::thread> threads;
+         std::vector<int>         results( 2 * threadCount, 1 );
+         rc = journal.open( batchname, batchBytes, 0 );
+         for( size_t t = 0; ( rc )&&( t < results.size() ); t++ ) {
+            threads.push_back( std::thread( [&journal, &results, t, perThread, payload]() {
+               for( size_t i = 0; i < perThread; i++ ) {
+                  BaseChunk chunk( t * 1000 + i );
+                  chunk.m_metadata.m_type = "journal";
+                  chunk.allocate( payload );
+                  memset( chunk.m_buffer.m_buffer.get(), (int)( t + i ), payload );
+                  if( !journal.append( chunk )) {
+                     results[t] = 0;
+                  }
+               }
+            }));
+         }
+         for( size_t t = 0; t < threads.size(); t++ ) {
+            threads[t].join();
+            rc = rc && results[t];
+         }
+
+         size_t recordBytes = CONTAINERJOURNAL_PREFIX_SIZE + BASECHUNK_HEADER_SIZE + 7 + payload;
+         size_t perBatch    = batchBytes / recordBytes;
+         size_t records     = results.size() * perThread;
+         if(( !rc )||( journal.getRecordCount() != records )
+          ||( journal.getLargestBatch() > batchBytes )
+          ||( journal.getCommitCount() < ( records + perBatch - 1 ) / perBatch )) {
+            std::cout << "ContainerJournal batch of "<<journal.getLargestBatch()<<" bytes exceeds "<<batchBytes<<std::endl;
+            rc = false;
+         }
+      }
+      unlink( batchname );
+      if( !rc ) {
+         return false;
+      }
+
+      return true;
+   }
+}
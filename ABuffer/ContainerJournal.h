@@ -0,0 +1,115 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseContainer.h>
+
+#define CONTAINERJOURNAL_MAGIC              "AGTJ"    //!< Identifies a journal file
+#define CONTAINERJOURNAL_VERSION            1         //!< Version of the journal format
+#define CONTAINERJOURNAL_HEADER_SIZE        16        //!< Size of the journal file header
+#define CONTAINERJOURNAL_PREFIX_SIZE        16        //!< Size of the prefix in front of each record
+#define CONTAINERJOURNAL_DEFAULT_BATCH      (4*1024*1024) //!< Default maximum bytes per commit
+#define CONTAINERJOURNAL_DEFAULT_DELAY      0.002     //!< Default maximum commit delay in seconds
+
+/**
+ * Journal file format (all values little-endian):
+ *
+ *   header (16 bytes)
+ *        0     4  magic ("AGTJ")
+ *        4     2  version
+ *        6     2  flags
+ *        8     8  reserved (0)
+ *
+ *   records, each a prefix followed by a BaseChunk in the binary chunk format
+ *        0     8  size of the chunk record (header, type and payload)
+ *        8     4  CRC-32C of the chunk record
+ *       12     4  CRC-32C of prefix bytes 0-11
+ *
+ * The file ends after the last complete record. A record that is truncated or
+ * fails its checksums marks the end of the valid journal.
+ **/
+
+namespace atl
+{
+   /**
+    * \brief Append-only crash-safe journal of chunks
+    *
+    * Producers call append from any number of threads. Records are queued and
+    * a committer thread writes each batch with writev followed by a single
+    * fdatasync (group commit). append returns once the batch containing the
+    * chunk is durable, so the cost of a sync is shared by all chunks in the
+    * batch.
+    *
+    * The batch size is bounded by maxBatchBytes; a single larger record is
+    * committed on its own. Once the committer picks up the first queued record
+    * it waits up to maxDelay seconds for more records before committing. A
+    * maxDelay of 0 commits immediately, which still batches the records queued
+    * while the previous sync was in progress. Records beyond the limit stay
+    * queued for the next commit.
+    *
+    * On open, an existing journal is scanned and truncated after the last
+    * valid record so that a torn write from a crash is discarded.
+    **/
+   class ContainerJournal
+   {
+      private:
+         /**
+          * \brief A chunk waiting to be committed
+          **/
+         struct PendingRecord
+         {
+            uint64_t             m_sequence = 0;       //!< Order of the append
+            BaseChunk            m_chunk;              //!< Chunk (shares the payload)
+            std::vector<uint8_t> m_header;             //!< Record prefix and chunk header
+            size_t               m_bytes = 0;          //!< Size of the record in the journal
+         };
+
+         int                        m_fd = -1;              //!< Journal file descriptor
+         std::thread                m_thread;               //!< Committer thread
+         std::mutex                 m_mutex;                //!< Protects the queue and counters
+         std::condition_variable    m_pendingCv;            //!< Signals queued records to the committer
+         std::condition_variable    m_commitCv;             //!< Signals completed commits to producers
+         std::vector<PendingRecord> m_pending;              //!< Records waiting for the next commit
+         size_t                     m_pendingBytes = 0;     //!< Bytes waiting for the next commit
+         uint64_t                   m_nextSequence = 0;     //!< Sequence of the last queued record
+         uint64_t                   m_committedSequence = 0;//!< Sequence of the last committed record
+         uint64_t                   m_failedSequence = UINT64_MAX; //!< First sequence of a failed commit
+         bool                       m_running = false;      //!< Flag to stop the committer
+         size_t                     m_maxBatchBytes = CONTAINERJOURNAL_DEFAULT_BATCH; //!< Commit size limit
+         double                     m_maxDelay = CONTAINERJOURNAL_DEFAULT_DELAY;      //!< Commit delay limit
+         uint64_t                   m_commitCount = 0;      //!< Number of commits
+         uint64_t                   m_recordCount = 0;      //!< Number of committed records
+         size_t                     m_largestBatch = 0;     //!< Bytes of the largest commit
+         uint64_t                   m_recoveredCount = 0;   //!< Number of records found on open
+
+         void commitLoop();
+         bool writeBatch( std::vector<PendingRecord> &batch );
+         static bool scan( int fd, uint64_t fileSize, uint64_t * validEnd, uint64_t * count, BaseContainer * container );
+
+      public:
+         ContainerJournal() {};
+         ~ContainerJournal();
+
+         bool     open( std::string filename
+                      , size_t maxBatchBytes = CONTAINERJOURNAL_DEFAULT_BATCH
+                      , double maxDelay = CONTAINERJOURNAL_DEFAULT_DELAY
+                      );
+         void     close();
+         bool     isOpen();
+         bool     append( BaseChunk &chunk );
+         uint64_t getCommitCount();
+         uint64_t getRecordCount();
+         size_t   getLargestBatch();
+         uint64_t getRecoveredCount();
+
+         static bool load( std::string filename, BaseContainer &container );
+   };
+
+   //Test functions
+   bool testContainerJournal();
+}
@@ -0,0 +1,404 @@
+#include <iostream>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <ContainerReader.h>
+#include <ByteOrder.h>
+#include <Checksum.h>
+
+namespace atl
+{
+   /**
+    * \brief Maps a container file and loads its index
+    *
+    * \param [in] filename name of the container file
+    * \return true on success, false if the file cannot be mapped or is invalid
+    *
+    * Only the header, footer and index are read. The index checksum is verified.
+    **/
+   bool ContainerReader::open( std::string filename )
+   {
+      close();
+
+      int fd = ::open( filename.c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         std::cerr << "ContainerReader: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      struct stat info;
+      if(( fstat( fd, &info ) != 0 )
+       ||( (size_t)info.st_size < BASECONTAINER_HEADER_SIZE + BASECONTAINER_FOOTER_SIZE )) {
+         std::cerr << "ContainerReader: "<<filename<<" is not a container file"<<std::endl;
+         ::close( fd );
+         return false;
+      }
+
+      size_t bytes = info.st_size;
+      void * map = mmap( NULL, bytes, PROT_READ, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if( map == MAP_FAILED ) {
+         std::cerr << "ContainerReader: unable to map "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      //Chunks are accessed individually so read-ahead only wastes I/O
+      madvise( map, bytes, MADV_RANDOM );
+
+      m_map.reset( (uint8_t *)map, [bytes]( uint8_t * ptr ) { munmap( ptr, bytes ); } );
+      m_mapBytes = bytes;
+
+      const uint8_t * data   = m_map.get();
+      const uint8_t * footer = data + bytes - BASECONTAINER_FOOTER_SIZE;
+      uint64_t indexOffset = readLE64( &footer[0] );
+      uint64_t count       = readLE64( &footer[8] );
+      uint32_t indexCrc    = readLE32( &footer[16] );
+
+      const char * error = NULL;
+      if(( memcmp( data, BASECONTAINER_MAGIC, 4 ) != 0 )
+       ||( memcmp( &footer[28], BASECONTAINER_FOOTER_MAGIC, 4 ) != 0 )) {
+         error = "invalid magic";
+      }
+      else if(( readLE16( &data[4] ) != BASECONTAINER_VERSION )
+            ||( readLE16( &footer[20] ) != BASECONTAINER_VERSION )) {
+         error = "unsupported version";
+      }
+      else if(( indexOffset < BASECONTAINER_HEADER_SIZE )
+            ||( count > ( bytes - BASECONTAINER_FOOTER_SIZE ) / BASECONTAINER_INDEX_ENTRY_SIZE )
+            ||( indexOffset + count * BASECONTAINER_INDEX_ENTRY_SIZE != bytes - BASECONTAINER_FOOTER_SIZE )) {
+         error = "invalid index location";
+      }
+      else if( crc32c( &data[indexOffset], count * BASECONTAINER_INDEX_ENTRY_SIZE ) != indexCrc ) {
+         error = "index checksum mismatch";
+      }
+
+      if( error != NULL ) {
+         std::cerr << "ContainerReader: "<<filename<<": "<<error<<std::endl;
+         close();
+         return false;
+      }
+
+      m_id = readLE64( &data[8] );
+      m_entries.resize( count );
+      m_index.reserve( count );
+      for( size_t i = 0; i < count; i++ ) {
+         const uint8_t * item = &data[indexOffset + i * BASECONTAINER_INDEX_ENTRY_SIZE];
+         ContainerIndexEntry & entry = m_entries[i];
+         entry.m_id       = readLE64( &item[0] );
+         entry.m_offset   = readLE64( &item[8] );
+         entry.m_size     = readLE64( &item[16] );
+         entry.m_checksum = readLE32( &item[24] );
+
+         if(( entry.m_size < BASECHUNK_HEADER_SIZE )
+          ||( entry.m_offset < BASECONTAINER_HEADER_SIZE )
+          ||( entry.m_offset > indexOffset )
+          ||( entry.m_size > indexOffset - entry.m_offset )) {
+            std::cerr << "ContainerReader: "<<filename<<": index entry "<<i<<" out of range"<<std::endl;
+            close();
+            return false;
+         }
+
+         //The first chunk with a given id wins
+         m_index.insert( std::make_pair( entry.m_id, i ));
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Releases the index. The mapping is released once no chunk references it
+    **/
+   void ContainerReader::close()
+   {
+      m_map.reset();
+      m_mapBytes = 0;
+      m_id       = 0;
+      m_entries.clear();
+      m_index.clear();
+   }
+
+   /**
+    * \brief Returns true if a container file is open
+    **/
+   bool ContainerReader::isOpen()
+   {
+      return m_map != NULL;
+   }
+
+   /**
+    * \brief Returns the ID of the container
+    **/
+   uint64_t ContainerReader::getId()
+   {
+      return m_id;
+   }
+
+   /**
+    * \brief Returns the number of chunks in the container
+    **/
+   size_t ContainerReader::getChunkCount()
+   {
+      return m_entries.size();
+   }
+
+   /**
+    * \brief Returns true if the container holds a chunk with the given id
+    **/
+   bool ContainerReader::contains( uint64_t id )
+   {
+      return m_index.find( id ) != m_index.end();
+   }
+
+   /**
+    * \brief Returns the index entry at the given position
+    *
+    * \param [in] position position of the chunk in the container
+    * \param [out] entry index entry
+    * \return true on success, false if the position is out of range
+    **/
+   bool ContainerReader::getEntry( size_t position, ContainerIndexEntry &entry )
+   {
+      if( position >= m_entries.size()) {
+         return false;
+      }
+
+      entry = m_entries[position];
+      return true;
+   }
+
+   /**
+    * \brief Fills a chunk from its record in the mapped file
+    *
+    * The metadata is decoded from the record header. The chunk buffer shares
+    * ownership of the mapping and points at the payload. For a reference
+    * record it points at the payload of the referenced record.
+    **/
+   bool ContainerReader::decodeChunk( size_t position, BaseChunk &chunk )
+   {
+      const ContainerIndexEntry & entry = m_entries[position];
+      const uint8_t * record = m_map.get() + entry.m_offset;
+
+      uint32_t typeLength = 0;
+      uint64_t dataSize   = 0;
+      uint16_t flags      = 0;
+      if(( !chunk.decodeHeader( record, entry.m_size, &typeLength, &dataSize, &flags ))
+       ||( typeLength > entry.m_size - BASECHUNK_HEADER_SIZE )
+       ||( dataSize != entry.m_size - BASECHUNK_HEADER_SIZE - typeLength )) {
+         std::cerr << "ContainerReader: invalid record for chunk "<<entry.m_id<<std::endl;
+         return false;
+      }
+
+      uint8_t * payload = (uint8_t *)record + BASECHUNK_HEADER_SIZE + typeLength;
+      if( flags & BASECHUNK_FLAG_REFERENCE ) {
+         size_t   reference = 0;
+         uint64_t size      = 0;
+         BaseChunk original;
+         if(( !ChunkDeduplicator::decodeReference( payload, dataSize, position, &reference, &size ))
+          ||( !decodeChunk( reference, original ))
+          ||( original.m_buffer.getSize() != size )) {
+            std::cerr << "ContainerReader: invalid reference in chunk "<<entry.m_id<<std::endl;
+            return false;
+         }
+
+         chunk.m_buffer = original.m_buffer;
+         return true;
+      }
+
+      chunk.m_buffer.m_buffer     = std::shared_ptr<uint8_t>( m_map, payload );
+      chunk.m_buffer.m_bufferSize = dataSize;
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the chunk with the given id without copying its payload
+    *
+    * \param [in] id ID of the chunk
+    * \param [out] chunk chunk to fill. Its buffer references the mapped file and must not be written
+    * \return true on success, false if the chunk does not exist or its record is invalid
+    *
+    * The lookup is a hash table access and only the page with the record header
+    * is touched. The checksum is not verified (see verifyChunk).
+    **/
+   bool ContainerReader::getChunk( uint64_t id, BaseChunk &chunk )
+   {
+      std::unordered_map<uint64_t, size_t>::const_iterator it = m_index.find( id );
+      if( it == m_index.end()) {
+         return false;
+      }
+
+      return decodeChunk( it->second, chunk );
+   }
+
+   /**
+    * \brief Returns the chunk at the given position in the container
+    *
+    * \param [in] position position of the chunk in the container
+    * \param [out] chunk chunk to fill. Its buffer references the mapped file and must not be written
+    * \return true on success, false on failure
+    **/
+   bool ContainerReader::getChunkAt( size_t position, BaseChunk &chunk )
+   {
+      if( position >= m_entries.size()) {
+         return false;
+      }
+
+      return decodeChunk( position, chunk );
+   }
+
+   /**
+    * \brief Verifies the checksum of the record of the given chunk
+    *
+    * \param [in] id ID of the chunk
+    * \return true if the chunk exists and its checksum matches, false otherwise
+    *
+    * This reads the complete record from the file.
+    **/
+   bool ContainerReader::verifyChunk( uint64_t id )
+   {
+      std::unordered_map<uint64_t, size_t>::const_iterator it = m_index.find( id );
+      if( it == m_index.end()) {
+         return false;
+      }
+
+      const ContainerIndexEntry & entry = m_entries[it->second];
+      return crc32c( m_map.get() + entry.m_offset, entry.m_size ) == entry.m_checksum;
+   }
+
+   /**
+    * \brief Test function
+    **/
+   bool testContainerReader()
+   {
+      const size_t count = 500;
+
+      BaseContainer container;
+      container.m_metadata.m_id = 42;
+      for( size_t i = 0; i < count; i++ ) {
+         BaseChunk chunk( 1000 + i );
+         chunk.m_metadata.m_type.assign( i % 7, 't' );
+         chunk.m_metadata.m_elementCount = i;
+         if( i % 10 ) {
+            chunk.allocate( i * 3 );
+            for( size_t j = 0; j < i * 3; j++ ) {
+               chunk.m_buffer[j] = (uint8_t)( i + j );
+            }
+         }
+         container.push_back( chunk );
+      }
+
+      char filename[] = "/tmp/ContainerReaderXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cerr << "testContainerReader unable to create temporary file"<<std::endl;
+         return false;
+      }
+      ::close( fd );
+
+      if( !container.save( filename )) {
+         unlink( filename );
+         return false;
+      }
+
+      ContainerReader reader;
+      if(( !reader.open( filename ))||( reader.getId() != 42 )||( reader.getChunkCount() != count )) {
+         std::cerr << "testContainerReader failed to open the container"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //Random access in reverse order
+      bool rc = true;
+      for( size_t n = count; ( rc )&&( n > 0 ); n-- ) {
+         size_t i = n - 1;
+         BaseChunk chunk;
+         if(( !reader.getChunk( 1000 + i, chunk ))
+          ||( chunk.m_metadata.m_id != 1000 + i )
+          ||( chunk.m_metadata.m_elementCount != i )
+          ||( chunk.m_metadata.m_type.length() != i % 7 )
+          ||( chunk.m_buffer.getSize() != (( i % 10 ) ? i * 3 : 0 ))
+          ||( !reader.verifyChunk( 1000 + i ))) {
+            std::cerr << "testContainerReader chunk "<<i<<" metadata mismatch"<<std::endl;
+            rc = false;
+            break;
+         }
+
+         for( size_t j = 0; j < chunk.m_buffer.getSize(); j++ ) {
+            if( chunk.m_buffer[j] != (uint8_t)( i + j )) {
+               std::cerr << "testContainerReader chunk "<<i<<" payload mismatch"<<std::endl;
+               rc = false;
+               break;
+            }
+         }
+      }
+
+      BaseChunk missing;
+      if(( reader.contains( 5 ))||( reader.getChunk( 5, missing ))) {
+         std::cerr << "testContainerReader found a chunk that does not exist"<<std::endl;
+         rc = false;
+      }
+
+      //Chunks keep the mapping alive after the reader is closed
+      BaseChunk kept;
+      reader.getChunk( 1001, kept );
+      reader.close();
+      if(( kept.m_buffer.getSize() != 3 )||( kept.m_buffer[2] != 3 )) {
+         std::cerr << "testContainerReader chunk did not outlive the reader"<<std::endl;
+         rc = false;
+      }
+
+      //Damaged payloads fail verification, a damaged index fails to open
+      ContainerIndexEntry entry;
+      reader.open( filename );
+      reader.getEntry( 11, entry );
+      reader.close();
+
+      fd = ::open( filename, O_WRONLY );
+      uint8_t value = 0xFF;
+      if( pwrite( fd, &value, 1, entry.m_offset + entry.m_size - 1 ) != 1 ) {
+         rc = false;
+      }
+      reader.open( filename );
+      if( reader.verifyChunk( 1011 )) {
+         std::cerr << "testContainerReader checksum did not detect a damaged payload"<<std::endl;
+         rc = false;
+      }
+      reader.close();
+
+      //A type length that wraps the record size must not move the payload outside the record
+      reader.open( filename );
+      reader.getEntry( 12, entry );
+      reader.close();
+
+      uint8_t length[4];
+      writeLE32( length, (uint32_t)( 12 % 7 - BASECHUNK_HEADER_SIZE ));
+      if( pwrite( fd, length, sizeof(length), entry.m_offset + 8 ) != sizeof(length)) {
+         rc = false;
+      }
+      BaseChunk wrapped;
+      reader.open( filename );
+      if( reader.getChunk( 1012, wrapped )) {
+         std::cerr << "testContainerReader accepted a record with an overflowing type length"<<std::endl;
+         rc = false;
+      }
+      reader.close();
+
+      struct stat info;
+      fstat( fd, &info );
+      if( pwrite( fd, &value, 1, info.st_size - BASECONTAINER_FOOTER_SIZE - 1 ) != 1 ) {
+         rc = false;
+      }
+      ::close( fd );
+      if( reader.open( filename )) {
+         std::cerr << "testContainerReader opened a container with a damaged index"<<std::endl;
+         rc = false;
+      }
+
+      unlink( filename );
+      return rc;
+   }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseContainer.h>
+
+namespace atl
+{
+   /**
+    * \brief Random access reader for indexed container files
+    *
+    * The file written by BaseContainer::save is memory mapped and the index is
+    * loaded into a hash table on open. getChunk returns chunks whose buffers
+    * reference the mapped file directly, so looking up a chunk does not read
+    * or copy its payload; only the pages that are accessed are loaded. The
+    * mapping stays valid as long as the reader or any returned chunk exists.
+    *
+    * After open the reader is not modified and may be used by multiple threads.
+    **/
+   class ContainerReader
+   {
+      private:
+         std::shared_ptr<uint8_t>             m_map;            //!< Mapped file
+         size_t                               m_mapBytes = 0;   //!< Size of the mapping
+         uint64_t                             m_id = 0;         //!< ID of the container
+         std::vector<ContainerIndexEntry>     m_entries;        //!< Index in container order
+         std::unordered_map<uint64_t, size_t> m_index;          //!< Chunk id to entry position
+
+         bool decodeChunk( size_t position, BaseChunk &chunk );
+
+      public:
+         bool     open( std::string filename );
+         void     close();
+         bool     isOpen();
+         uint64_t getId();
+         size_t   getChunkCount();
+         bool     contains( uint64_t id );
+         bool     getEntry( size_t position, ContainerIndexEntry &entry );
+         bool     getChunk( uint64_t id, BaseChunk &chunk );
+         bool     getChunkAt( size_t position, BaseChunk &chunk );
+         bool     verifyChunk( uint64_t id );
+   };
+
+   //Test functions
+   bool testContainerReader();
+}
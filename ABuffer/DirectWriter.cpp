@@ -0,0 +1,333 @@
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <DirectWriter.h>
+#include <BaseContainer.h>
+
+namespace atl
+{
+   /**
+    * \brief Destructor. Flushes and closes the file
+    **/
+   DirectWriter::~DirectWriter()
+   {
+      close();
+   }
+
+   /**
+    * \brief Creates or truncates a file for writing
+    *
+    * \param [in] filename file to write
+    * \param [in] mode BUFFERED or DIRECT (default = DIRECT)
+    * \param [in] stagingBytes size of the staging buffer. Rounded up to DIRECTWRITER_ALIGNMENT
+    * \return true on success, false on failure
+    **/
+   bool DirectWriter::open( std::string filename, Mode mode, size_t stagingBytes )
+   {
+      if( !close()) {
+         return false;
+      }
+
+      int flags = O_WRONLY | O_CREAT | O_TRUNC;
+      m_direct  = ( mode == DIRECT );
+      m_fd      = ::open( filename.c_str(), flags | ( m_direct ? O_DIRECT : 0 ), 0644 );
+      if(( m_fd < 0 )&&( m_direct )&&( errno == EINVAL )) {
+         std::cerr << "DirectWriter: O_DIRECT not supported for "<<filename<<", using buffered I/O"<<std::endl;
+         m_direct = false;
+         m_fd     = ::open( filename.c_str(), flags, 0644 );
+      }
+      if( m_fd < 0 ) {
+         std::cerr << "DirectWriter: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      stagingBytes = ( stagingBytes + DIRECTWRITER_ALIGNMENT - 1 ) / DIRECTWRITER_ALIGNMENT * DIRECTWRITER_ALIGNMENT;
+      if( stagingBytes == 0 ) {
+         stagingBytes = DIRECTWRITER_ALIGNMENT;
+      }
+
+      if( m_staging.getSize() != stagingBytes ) {
+         m_staging.deallocate();
+         m_staging.setAlignment( DIRECTWRITER_ALIGNMENT );
+         if( !m_staging.allocate( stagingBytes )) {
+            ::close( m_fd );
+            m_fd = -1;
+            return false;
+         }
+      }
+
+      m_used     = 0;
+      m_offset   = 0;
+      m_fileSize = 0;
+
+      return true;
+   }
+
+   /**
+    * \brief Writes whole blocks at the given offset
+    *
+    * Falls back to buffered I/O if the kernel rejects the direct write.
+    **/
+   bool DirectWriter::writeBlocks( const uint8_t * data, size_t bytes, uint64_t offset )
+   {
+      size_t written = 0;
+      while( written < bytes ) {
+         ssize_t rc = pwrite( m_fd, data + written, bytes - written, offset + written );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            if(( errno == EINVAL )&&( m_direct )) {
+               std::cerr << "DirectWriter: direct write rejected, using buffered I/O"<<std::endl;
+               fcntl( m_fd, F_SETFL, fcntl( m_fd, F_GETFL ) & ~O_DIRECT );
+               m_direct = false;
+               continue;
+            }
+            std::cerr << "DirectWriter: write failed: "<<strerror(errno)<<std::endl;
+            return false;
+         }
+         if( rc == 0 ) {
+            std::cerr << "DirectWriter: write made no progress"<<std::endl;
+            errno = EIO;
+            return false;
+         }
+         written += rc;
+      }
+
+      if( offset + bytes > m_fileSize ) {
+         m_fileSize = offset + bytes;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Appends data to the file
+    *
+    * \param [in] data data to write
+    * \param [in] bytes number of bytes
+    * \return true on success, false on failure
+    **/
+   bool DirectWriter::write( const void * data, size_t bytes )
+   {
+      if( m_fd < 0 ) {
+         std::cerr << "DirectWriter: file is not open"<<std::endl;
+         return false;
+      }
+
+      const uint8_t * src     = (const uint8_t *)data;
+      size_t          staging = m_staging.getSize();
+      while( bytes > 0 ) {
+         //Large writes bypass the staging buffer when the memory allows it
+         if(( m_used == 0 )&&( bytes >= staging )
+          &&(( !m_direct )||( (uintptr_t)src % DIRECTWRITER_ALIGNMENT == 0 ))) {
+            size_t direct = bytes / DIRECTWRITER_ALIGNMENT * DIRECTWRITER_ALIGNMENT;
+            if( !writeBlocks( src, direct, m_offset )) {
+               return false;
+            }
+            m_offset += direct;
+            src      += direct;
+            bytes    -= direct;
+            continue;
+         }
+
+         size_t copy = staging - m_used;
+         if( copy > bytes ) {
+            copy = bytes;
+         }
+         memcpy( m_staging.m_buffer.get() + m_used, src, copy );
+         m_used += copy;
+         src    += copy;
+         bytes  -= copy;
+
+         if( m_used == staging ) {
+            if( !writeBlocks( m_staging.m_buffer.get(), staging, m_offset )) {
+               return false;
+            }
+            m_offset += staging;
+            m_used    = 0;
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Appends a chunk in the binary chunk format
+    **/
+   bool DirectWriter::writeChunk( BaseChunk &chunk )
+   {
+      std::vector<uint8_t> header( chunk.getHeaderSize());
+      chunk.encodeHeader( header.data(), header.size());
+
+      return write( header.data(), header.size())
+          && write( chunk.m_buffer.m_buffer.get(), chunk.m_buffer.getSize());
+   }
+
+   /**
+    * \brief Writes the staged data and sets the file to its logical size
+    * \return true on success, false on failure
+    *
+    * In direct mode the tail is padded to a whole block, written, and removed
+    * again by truncating the file.
+    **/
+   bool DirectWriter::flush()
+   {
+      if( m_fd < 0 ) {
+         return true;
+      }
+
+      if( m_used > 0 ) {
+         size_t padded = m_used;
+         if( m_direct ) {
+            padded = ( m_used + DIRECTWRITER_ALIGNMENT - 1 ) / DIRECTWRITER_ALIGNMENT * DIRECTWRITER_ALIGNMENT;
+            memset( m_staging.m_buffer.get() + m_used, 0, padded - m_used );
+         }
+
+         if( !writeBlocks( m_staging.m_buffer.get(), padded, m_offset )) {
+            return false;
+         }
+      }
+
+      uint64_t size = m_offset + m_used;
+      if( m_fileSize != size ) {
+         if( ftruncate( m_fd, size ) != 0 ) {
+            std::cerr << "DirectWriter: unable to truncate: "<<strerror(errno)<<std::endl;
+            return false;
+         }
+         m_fileSize = size;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Flushes and closes the file
+    * \return true on success, false if the final flush failed
+    **/
+   bool DirectWriter::close()
+   {
+      if( m_fd < 0 ) {
+         return true;
+      }
+
+      bool rc = flush();
+      if( ::close( m_fd ) != 0 ) {
+         rc = false;
+      }
+      m_fd = -1;
+
+      return rc;
+   }
+
+   /**
+    * \brief Returns true if a file is open
+    **/
+   bool DirectWriter::isOpen()
+   {
+      return m_fd >= 0;
+   }
+
+   /**
+    * \brief Returns true if O_DIRECT is in effect
+    **/
+   bool DirectWriter::isDirect()
+   {
+      return m_direct;
+   }
+
+   /**
+    * \brief Returns the logical size of the file written so far
+    **/
+   uint64_t DirectWriter::getOffset()
+   {
+      return m_offset + m_used;
+   }
+
+   /**
+    * \brief Writes unaligned data through one mode and checks the file
+    **/
+   static bool testMode( DirectWriter::Mode mode )
+   {
+      //Use the working directory since /tmp is often tmpfs, which rejects O_DIRECT
+      char filename[] = "DirectWriterXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cout << "DirectWriter unable to create temporary file"<<std::endl;
+         return false;
+      }
+      close( fd );
+
+      std::vector<uint8_t> data( 3 * DIRECTWRITER_ALIGNMENT + 123 );
+      for( size_t i = 0; i < data.size(); i++ ) {
+         data[i] = (uint8_t)( i * 7 );
+      }
+
+      //Staging smaller than the data, unaligned source, a flush between writes
+      DirectWriter writer;
+      bool rc = writer.open( filename, mode, DIRECTWRITER_ALIGNMENT )
+             && writer.write( &data[1], 1000 )
+             && writer.flush()
+             && writer.write( &data[1001], data.size() - 1001 )
+             && ( writer.getOffset() == data.size() - 1 )
+             && writer.close();
+
+      std::vector<uint8_t> result( data.size());
+      fd = ::open( filename, O_RDONLY );
+      ssize_t bytes = read( fd, result.data(), result.size());
+      close( fd );
+
+      if(( !rc )||( bytes != (ssize_t)data.size() - 1 )||( memcmp( result.data(), &data[1], bytes ))) {
+         std::cout << "DirectWriter mode "<<mode<<" wrote "<<bytes<<" incorrect bytes"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //A container streamed through the writer matches the serial file
+      BaseContainer container;
+      for( size_t i = 0; i < 10; i++ ) {
+         BaseChunk item( i );
+         item.m_metadata.m_type.assign( i, 'd' );
+         item.allocate( i * 1000 + 1 );
+         memset( item.m_buffer.m_buffer.get(), (int)i, i * 1000 + 1 );
+         container.push_back( item );
+      }
+
+      std::string serialName = std::string( filename ) + ".serial";
+      rc = container.save( serialName )
+        && writer.open( filename, mode, 2 * DIRECTWRITER_ALIGNMENT )
+        && container.save( writer )
+        && writer.close();
+
+      std::vector<uint8_t> expected( 1 << 16 );
+      std::vector<uint8_t> actual( 1 << 16 );
+      int serialFd = ::open( serialName.c_str(), O_RDONLY );
+      fd = ::open( filename, O_RDONLY );
+      ssize_t expectedBytes = read( serialFd, expected.data(), expected.size());
+      ssize_t actualBytes   = read( fd, actual.data(), actual.size());
+      close( serialFd );
+      close( fd );
+      unlink( serialName.c_str());
+      unlink( filename );
+
+      if(( !rc )||( expectedBytes <= 0 )||( expectedBytes != actualBytes )
+       ||( memcmp( expected.data(), actual.data(), expectedBytes ))) {
+         std::cout << "DirectWriter mode "<<mode<<" container file does not match"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Unit test for the DirectWriter class
+    **/
+   bool testDirectWriter()
+   {
+      return testMode( DirectWriter::BUFFERED )&&( testMode( DirectWriter::DIRECT ));
+   }
+}
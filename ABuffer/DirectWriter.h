@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseBuffer.h>
+#include <BaseChunk.h>
+
+#define DIRECTWRITER_ALIGNMENT       4096               //!< Offset, size and memory alignment for O_DIRECT
+#define DIRECTWRITER_DEFAULT_STAGING (4*1024*1024)      //!< Default staging buffer size
+
+namespace atl
+{
+   /**
+    * \brief Sequential file writer with a per-stream choice of buffered or direct I/O
+    *
+    * In DIRECT mode the file is opened with O_DIRECT so streamed data bypasses
+    * the page cache. Data is collected in an aligned staging buffer and written
+    * in aligned blocks. Large writes from aligned memory skip the staging
+    * buffer. The unaligned tail is written zero padded by flush and the file is
+    * truncated back to its logical size; the tail stays staged so later writes
+    * continue in the same block.
+    *
+    * If the filesystem does not support O_DIRECT (open or write fails with
+    * EINVAL) the writer falls back to buffered I/O. isDirect reports the mode
+    * in effect. BUFFERED mode uses the same staging, which batches small
+    * writes such as chunk headers and record padding.
+    **/
+   class DirectWriter
+   {
+      public:
+         enum Mode
+         {
+            BUFFERED,                                      //!< Write through the page cache
+            DIRECT                                         //!< Bypass the page cache with O_DIRECT
+         };
+
+      private:
+         int        m_fd = -1;                             //!< File descriptor
+         bool       m_direct = false;                      //!< True while O_DIRECT is in effect
+         BaseBuffer m_staging;                             //!< Aligned staging buffer
+         size_t     m_used = 0;                            //!< Bytes in the staging buffer
+         uint64_t   m_offset = 0;                          //!< File offset of the staging buffer
+         uint64_t   m_fileSize = 0;                        //!< Bytes written to the file including padding
+
+         bool writeBlocks( const uint8_t * data, size_t bytes, uint64_t offset );
+
+      public:
+         ~DirectWriter();
+
+         bool     open( std::string filename, Mode mode = DIRECT, size_t stagingBytes = DIRECTWRITER_DEFAULT_STAGING );
+         bool     write( const void * data, size_t bytes );
+         bool     writeChunk( BaseChunk &chunk );
+         bool     flush();
+         bool     close();
+         bool     isOpen();
+         bool     isDirect();
+         uint64_t getOffset();
+   };
+
+   //Test functions
+   bool testDirectWriter();
+}
@@ -0,0 +1,238 @@
+#include <iostream>
+#include <cstring>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "FileIO.h"
+
+namespace atl
+{
+   /**
+    * \brief Advances an iovec array past the given number of transferred bytes
+    *
+    * \param [in,out] iov pointer to the first pending entry
+    * \param [in,out] count number of pending entries
+    * \param [in] bytes number of bytes that were transferred
+    **/
+   static void advance( struct iovec *& iov, int & count, size_t bytes )
+   {
+      while(( count > 0 )&&( bytes >= iov->iov_len )) {
+         bytes -= iov->iov_len;
+         iov++;
+         count--;
+      }
+
+      if( count > 0 ) {
+         iov->iov_base = (uint8_t *)iov->iov_base + bytes;
+         iov->iov_len -= bytes;
+      }
+   }
+
+   /**
+    * \brief Writes all entries of an iovec array
+    *
+    * \param [in] fd descriptor to write to
+    * \param [in] iov array of buffers. The entries are modified on partial writes
+    * \param [in] count number of entries
+    * \return true on success, false on failure
+    *
+    * All buffers are passed to a single writev call. Additional calls are only
+    * made if the kernel accepts part of the data.
+    **/
+   bool writevFully( int fd, struct iovec * iov, int count )
+   {
+      //Skip empty entries so that a zero return means no progress
+      advance( iov, count, 0 );
+      while( count > 0 ) {
+         ssize_t rc = writev( fd, iov, count );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            int error = errno;
+            std::cerr << "writevFully failed: "<<strerror(error)<<std::endl;
+            errno = error;
+            return false;
+         }
+         if( rc == 0 ) {
+            std::cerr << "writevFully made no progress"<<std::endl;
+            errno = EIO;
+            return false;
+         }
+         advance( iov, count, rc );
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Writes the whole buffer
+    *
+    * \param [in] fd descriptor to write to
+    * \param [in] buffer data to write
+    * \param [in] bytes number of bytes to write
+    * \return true on success, false on failure
+    **/
+   bool writeFully( int fd, const void * buffer, size_t bytes )
+   {
+      struct iovec iov;
+      iov.iov_base = (void *)buffer;
+      iov.iov_len  = bytes;
+
+      return writevFully( fd, &iov, 1 );
+   }
+
+   /**
+    * \brief Fills all entries of an iovec array
+    *
+    * \param [in] fd descriptor to read from
+    * \param [in] iov array of buffers. The entries are modified on partial reads
+    * \param [in] count number of entries
+    * \return true on success, false on failure or end of file
+    **/
+   bool readvFully( int fd, struct iovec * iov, int count )
+   {
+      advance( iov, count, 0 );
+      while( count > 0 ) {
+         ssize_t rc = readv( fd, iov, count );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            int error = errno;
+            std::cerr << "readvFully failed: "<<strerror(error)<<std::endl;
+            errno = error;
+            return false;
+         }
+         if( rc == 0 ) {
+            return false;
+         }
+         advance( iov, count, rc );
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Reads the requested number of bytes
+    *
+    * \param [in] fd descriptor to read from
+    * \param [in] buffer destination
+    * \param [in] bytes number of bytes to read
+    * \return true on success, false on failure or end of file
+    **/
+   bool readFully( int fd, void * buffer, size_t bytes )
+   {
+      struct iovec iov;
+      iov.iov_base = buffer;
+      iov.iov_len  = bytes;
+
+      return readvFully( fd, &iov, 1 );
+   }
+
+   /**
+    * \brief Writes all entries of an iovec array at the given file offset
+    *
+    * \param [in] fd descriptor to write to
+    * \param [in] iov array of buffers. The entries are modified on partial writes
+    * \param [in] count number of entries
+    * \param [in] offset file offset of the first byte
+    * \return true on success, false on failure
+    **/
+   bool pwritevFully( int fd, struct iovec * iov, int count, uint64_t offset )
+   {
+      advance( iov, count, 0 );
+      while( count > 0 ) {
+         ssize_t rc = pwritev( fd, iov, count, offset );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            int error = errno;
+            std::cerr << "pwritevFully failed: "<<strerror(error)<<std::endl;
+            errno = error;
+            return false;
+         }
+         if( rc == 0 ) {
+            std::cerr << "pwritevFully made no progress"<<std::endl;
+            errno = EIO;
+            return false;
+         }
+         advance( iov, count, rc );
+         offset += rc;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Writes the whole buffer at the given file offset
+    *
+    * \param [in] fd descriptor to write to
+    * \param [in] buffer data to write
+    * \param [in] bytes number of bytes to write
+    * \param [in] offset file offset of the first byte
+    * \return true on success, false on failure
+    **/
+   bool pwriteFully( int fd, const void * buffer, size_t bytes, uint64_t offset )
+   {
+      struct iovec iov;
+      iov.iov_base = (void *)buffer;
+      iov.iov_len  = bytes;
+
+      return pwritevFully( fd, &iov, 1, offset );
+   }
+
+   /**
+    * \brief Fills all entries of an iovec array from the given file offset
+    *
+    * \param [in] fd descriptor to read from
+    * \param [in] iov array of buffers. The entries are modified on partial reads
+    * \param [in] count number of entries
+    * \param [in] offset file offset of the first byte
+    * \return true on success, false on failure or end of file
+    **/
+   bool preadvFully( int fd, struct iovec * iov, int count, uint64_t offset )
+   {
+      advance( iov, count, 0 );
+      while( count > 0 ) {
+         ssize_t rc = preadv( fd, iov, count, offset );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            int error = errno;
+            std::cerr << "preadvFully failed: "<<strerror(error)<<std::endl;
+            errno = error;
+            return false;
+         }
+         if( rc == 0 ) {
+            return false;
+         }
+         advance( iov, count, rc );
+         offset += rc;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Reads the requested number of bytes from the given file offset
+    *
+    * \param [in] fd descriptor to read from
+    * \param [in] buffer destination
+    * \param [in] bytes number of bytes to read
+    * \param [in] offset file offset of the first byte
+    * \return true on success, false on failure or end of file
+    **/
+   bool preadFully( int fd, void * buffer, size_t bytes, uint64_t offset )
+   {
+      struct iovec iov;
+      iov.iov_base = buffer;
+      iov.iov_len  = bytes;
+
+      return preadvFully( fd, &iov, 1, offset );
+   }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+/**
+ * \file
+ *
+ * Descriptor I/O helpers that complete partial transfers and retry on EINTR.
+ * They are used by the binary chunk and container formats. The p* variants
+ * transfer at an explicit file offset and do not move the file position, so
+ * several threads can use the same descriptor concurrently. On failure
+ * errno holds the error of the failed transfer, or EIO if a write made no
+ * progress.
+ **/
+namespace atl
+{
+   bool writeFully( int fd, const void * buffer, size_t bytes );
+   bool writevFully( int fd, struct iovec * iov, int count );
+   bool readFully( int fd, void * buffer, size_t bytes );
+   bool readvFully( int fd, struct iovec * iov, int count );
+   bool pwritevFully( int fd, struct iovec * iov, int count, uint64_t offset );
+   bool pwriteFully( int fd, const void * buffer, size_t bytes, uint64_t offset );
+   bool preadvFully( int fd, struct iovec * iov, int count, uint64_t offset );
+   bool preadFully( int fd, void * buffer, size_t bytes, uint64_t offset );
+}
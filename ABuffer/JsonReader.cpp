@@ -0,0 +1,290 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#include "JsonReader.h"
+
+namespace atl
+{
+   /**
+    * \brief Constructor
+    *
+    * \param [in] text JSON text. It does not need to be NUL terminated
+    * \param [in] length number of characters in the text
+    **/
+   JsonReader::JsonReader( const char * text, size_t length )
+   {
+      m_text = text;
+      m_end  = text + length;
+   }
+
+   /**
+    * \brief Returns false if a syntax error has been found
+    **/
+   bool JsonReader::isValid()
+   {
+      return !m_error;
+   }
+
+   /**
+    * \brief Flags a syntax error
+    * \return false
+    **/
+   bool JsonReader::fail()
+   {
+      m_error = true;
+      m_text  = m_end;
+      return false;
+   }
+
+   /**
+    * \brief Advances past spaces, tabs and line breaks
+    **/
+   void JsonReader::skipWhitespace()
+   {
+      while(( m_text < m_end )
+          &&(( *m_text == ' ' )||( *m_text == '\t' )||( *m_text == '\n' )||( *m_text == '\r' ))) {
+         m_text++;
+      }
+   }
+
+   /**
+    * \brief Returns true if only whitespace remains
+    **/
+   bool JsonReader::atEnd()
+   {
+      skipWhitespace();
+      return m_text == m_end;
+   }
+
+   /**
+    * \brief Consumes the opening bracket of an object
+    * \return true on success, false on a syntax error
+    **/
+   bool JsonReader::beginObject()
+   {
+      skipWhitespace();
+      if(( m_text == m_end )||( *m_text != '{' )) {
+         return fail();
+      }
+
+      m_text++;
+      m_first = true;
+      return true;
+   }
+
+   /**
+    * \brief Advances past a quoted string. The reader must be at the opening quote
+    **/
+   bool JsonReader::skipString()
+   {
+      m_text++;
+      while( m_text < m_end ) {
+         if( *m_text == '\\' ) {
+            m_text += 2;
+            continue;
+         }
+         if( *m_text == '"' ) {
+            m_text++;
+            return true;
+         }
+         m_text++;
+      }
+
+      return fail();
+   }
+
+   /**
+    * \brief Reads the next key of the current object and the following colon
+    *
+    * \param [out] key pointer to the first character of the key
+    * \param [out] length number of characters in the key
+    * \return true if a key was read, false at the end of the object or on error
+    *
+    * At the end of the object the closing bracket is consumed.
+    **/
+   bool JsonReader::nextKey( const char *& key, size_t &length )
+   {
+      if( m_error ) {
+         return false;
+      }
+
+      skipWhitespace();
+      if( m_text == m_end ) {
+         return fail();
+      }
+
+      if( *m_text == '}' ) {
+         m_text++;
+         m_first = false;
+         return false;
+      }
+
+      if( !m_first ) {
+         if( *m_text != ',' ) {
+            return fail();
+         }
+         m_text++;
+         skipWhitespace();
+      }
+      m_first = false;
+
+      if(( m_text == m_end )||( *m_text != '"' )) {
+         return fail();
+      }
+
+      const char * start = m_text + 1;
+      if( !skipString()) {
+         return false;
+      }
+      key    = start;
+      length = m_text - 1 - start;
+
+      skipWhitespace();
+      if(( m_text == m_end )||( *m_text != ':' )) {
+         return fail();
+      }
+      m_text++;
+      skipWhitespace();
+
+      return true;
+   }
+
+   /**
+    * \brief Reads an unsigned integer value
+    *
+    * \param [out] value parsed value
+    * \return true on success, false if the value is not an unsigned integer or overflows
+    **/
+   bool JsonReader::readUInt( uint64_t &value )
+   {
+      skipWhitespace();
+      if(( m_text == m_end )||( *m_text < '0' )||( *m_text > '9' )) {
+         return fail();
+      }
+
+      uint64_t result = 0;
+      while(( m_text < m_end )&&( *m_text >= '0' )&&( *m_text <= '9' )) {
+         uint64_t digit = *m_text - '0';
+         if( result > ( UINT64_MAX - digit ) / 10 ) {
+            return fail();
+         }
+         result = result * 10 + digit;
+         m_text++;
+      }
+
+      value = result;
+      return true;
+   }
+
+   /**
+    * \brief Skips a value of any type, including nested objects and arrays
+    * \return true on success, false on a syntax error
+    **/
+   bool JsonReader::skipValue()
+   {
+      skipWhitespace();
+      if( m_text == m_end ) {
+         return fail();
+      }
+
+      if( *m_text == '"' ) {
+         return skipString();
+      }
+
+      if(( *m_text == '{' )||( *m_text == '[' )) {
+         size_t depth = 0;
+         while( m_text < m_end ) {
+            char c = *m_text;
+            if( c == '"' ) {
+               if( !skipString()) {
+                  return false;
+               }
+               continue;
+            }
+            if(( c == '{' )||( c == '[' )) {
+               depth++;
+            }
+            else if(( c == '}' )||( c == ']' )) {
+               depth--;
+            }
+            m_text++;
+            if( depth == 0 ) {
+               return true;
+            }
+         }
+         return fail();
+      }
+
+      //Numbers and literals end at the next delimiter
+      const char * start = m_text;
+      while(( m_text < m_end )&&( *m_text != ',' )&&( *m_text != '}' )&&( *m_text != ']' )
+          &&( *m_text != ' ' )&&( *m_text != '\t' )&&( *m_text != '\n' )&&( *m_text != '\r' )) {
+         m_text++;
+      }
+
+      if( m_text == start ) {
+         return fail();
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Compares a key returned by nextKey with a NUL terminated name
+    **/
+   bool JsonReader::keyEquals( const char * key, size_t length, const char * name )
+   {
+      return ( strncmp( key, name, length ) == 0 )&&( name[length] == 0 );
+   }
+
+   /**
+    * \brief Test function
+    **/
+   bool testJsonReader()
+   {
+      std::string text = " { \"b\" : 7 , \"skip\":{\"x\":[1,{\"y\":\"}\"}],\"z\":\"a\\\"b\"}, \"a\":18446744073709551615,\"t\":true } ";
+      JsonReader reader( text.data(), text.length());
+
+      uint64_t a = 0;
+      uint64_t b = 0;
+      const char * key;
+      size_t length;
+      size_t count = 0;
+
+      reader.beginObject();
+      while( reader.nextKey( key, length )) {
+         count++;
+         if( JsonReader::keyEquals( key, length, "a" )) {
+            reader.readUInt( a );
+         }
+         else if( JsonReader::keyEquals( key, length, "b" )) {
+            reader.readUInt( b );
+         }
+         else {
+            reader.skipValue();
+         }
+      }
+
+      if(( !reader.isValid())||( !reader.atEnd())||( count != 4 )||( a != 18446744073709551615ULL )||( b != 7 )) {
+         std::cerr << "testJsonReader failed to parse "<<text<<std::endl;
+         return false;
+      }
+
+      //Malformed input must be rejected
+      const char * invalid[] = { "{\"a\" 1}", "{\"a\":1 \"b\":2}", "{\"a\":18446744073709551616}", "{\"a\":-1}", "{\"a\":1" };
+      for( size_t i = 0; i < sizeof(invalid)/sizeof(invalid[0]); i++ ) {
+         JsonReader bad( invalid[i], strlen( invalid[i] ));
+         bad.beginObject();
+         while( bad.nextKey( key, length )) {
+            bad.readUInt( a );
+         }
+         if( bad.isValid()) {
+            std::cerr << "testJsonReader accepted "<<invalid[i]<<std::endl;
+            return false;
+         }
+      }
+
+      return true;
+   }
+}
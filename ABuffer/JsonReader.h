@@ -0,0 +1,51 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace atl
+{
+   /**
+    * \brief Streaming parser for the JSON objects written by JsonWriter
+    *
+    * The reader walks the text in place and never allocates. Keys are returned
+    * as pointers into the text (escape sequences are not decoded, which is
+    * sufficient for the plain ASCII keys used by the metadata classes).
+    * Unknown values can be skipped with skipValue.
+    *
+    * Typical use:
+    *
+    *    reader.beginObject();
+    *    while( reader.nextKey( key, length )) {
+    *       if( JsonReader::keyEquals( key, length, "id" )) reader.readUInt( id );
+    *       else reader.skipValue();
+    *    }
+    *    if( !reader.isValid()) ...
+    **/
+   class JsonReader
+   {
+      private:
+         const char * m_text;                    //!< Current position
+         const char * m_end;                     //!< End of the text
+         bool         m_error = false;           //!< Flag set on a syntax error
+         bool         m_first = true;            //!< No member read yet in the current object
+
+         void skipWhitespace();
+         bool fail();
+         bool skipString();
+
+      public:
+         JsonReader( const char * text, size_t length );
+
+         bool isValid();
+         bool beginObject();
+         bool nextKey( const char *& key, size_t &length );
+         bool readUInt( uint64_t &value );
+         bool skipValue();
+         bool atEnd();
+
+         static bool keyEquals( const char * key, size_t length, const char * name );
+   };
+
+   //Test functions
+   bool testJsonReader();
+}
@@ -0,0 +1,292 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#include "JsonWriter.h"
+
+namespace atl
+{
+   /**
+    * \brief Two character decimal representation of 0..99
+    **/
+   static const char DIGIT_PAIRS[201] =
+      "00010203040506070809"
+      "10111213141516171819"
+      "20212223242526272829"
+      "30313233343536373839"
+      "40414243444546474849"
+      "50515253545556575859"
+      "60616263646566676869"
+      "70717273747576777879"
+      "80818283848586878889"
+      "90919293949596979899";
+
+   /**
+    * \brief Writes the decimal representation of a value
+    *
+    * \param [in] dest destination. Must hold at least 20 characters
+    * \param [in] value value to convert
+    * \return number of characters written (not NUL terminated)
+    *
+    * Digits are produced two at a time from a lookup table.
+    **/
+   size_t uintToChars( char * dest, uint64_t value )
+   {
+      char   digits[20];
+      size_t pos = sizeof(digits);
+
+      while( value >= 100 ) {
+         size_t pair = ( value % 100 ) * 2;
+         value /= 100;
+         digits[--pos] = DIGIT_PAIRS[pair + 1];
+         digits[--pos] = DIGIT_PAIRS[pair];
+      }
+
+      if( value >= 10 ) {
+         digits[--pos] = DIGIT_PAIRS[value * 2 + 1];
+         digits[--pos] = DIGIT_PAIRS[value * 2];
+      }
+      else {
+         digits[--pos] = (char)( '0' + value );
+      }
+
+      size_t length = sizeof(digits) - pos;
+      memcpy( dest, &digits[pos], length );
+      return length;
+   }
+
+   /**
+    * \brief Constructor
+    *
+    * \param [in] buffer destination buffer
+    * \param [in] capacity size of the buffer including the terminating NUL
+    **/
+   JsonWriter::JsonWriter( char * buffer, size_t capacity )
+   {
+      m_buffer   = buffer;
+      m_capacity = capacity;
+      terminate();
+   }
+
+   /**
+    * \brief NUL terminates the output
+    **/
+   void JsonWriter::terminate()
+   {
+      if( m_capacity > 0 ) {
+         m_buffer[m_length] = 0;
+      }
+   }
+
+   /**
+    * \brief Discards the output so the buffer can be reused
+    **/
+   void JsonWriter::reset()
+   {
+      m_length   = 0;
+      m_overflow = false;
+      terminate();
+   }
+
+   /**
+    * \brief Returns the NUL terminated output
+    **/
+   const char * JsonWriter::getString()
+   {
+      return m_buffer;
+   }
+
+   /**
+    * \brief Returns the number of characters written
+    **/
+   size_t JsonWriter::getLength()
+   {
+      return m_length;
+   }
+
+   /**
+    * \brief Returns false if the output did not fit in the buffer
+    **/
+   bool JsonWriter::isValid()
+   {
+      return !m_overflow;
+   }
+
+   /**
+    * \brief Appends raw text
+    *
+    * \param [in] text characters to append
+    * \param [in] length number of characters
+    * \return reference to the writer
+    **/
+   JsonWriter & JsonWriter::append( const char * text, size_t length )
+   {
+      if(( m_overflow )||( m_length + length >= m_capacity )) {
+         m_overflow = true;
+         return *this;
+      }
+
+      memcpy( &m_buffer[m_length], text, length );
+      m_length += length;
+      terminate();
+
+      return *this;
+   }
+
+   /**
+    * \brief Appends a single character
+    **/
+   JsonWriter & JsonWriter::append( char c )
+   {
+      return append( &c, 1 );
+   }
+
+   /**
+    * \brief Appends a NUL terminated string without escaping
+    **/
+   JsonWriter & JsonWriter::append( const char * text )
+   {
+      return append( text, strlen( text ));
+   }
+
+   /**
+    * \brief Appends an unsigned integer
+    **/
+   JsonWriter & JsonWriter::appendUInt( uint64_t value )
+   {
+      char digits[20];
+      return append( digits, uintToChars( digits, value ));
+   }
+
+   /**
+    * \brief Appends a signed integer
+    **/
+   JsonWriter & JsonWriter::appendInt( int64_t value )
+   {
+      char   digits[21];
+      size_t length = 0;
+      uint64_t magnitude = value;
+      if( value < 0 ) {
+         digits[length++] = '-';
+         magnitude = 0 - magnitude;
+      }
+
+      length += uintToChars( &digits[length], magnitude );
+      return append( digits, length );
+   }
+
+   /**
+    * \brief Appends a quoted string, escaping characters as required by JSON
+    *
+    * \param [in] text characters of the string
+    * \param [in] length number of characters
+    * \return reference to the writer
+    **/
+   JsonWriter & JsonWriter::appendString( const char * text, size_t length )
+   {
+      static const char HEX[] = "0123456789abcdef";
+
+      append( '"' );
+
+      size_t start = 0;
+      for( size_t i = 0; i < length; i++ ) {
+         unsigned char c = text[i];
+         if(( c >= 0x20 )&&( c != '"' )&&( c != '\\' )) {
+            continue;
+         }
+
+         append( &text[start], i - start );
+         start = i + 1;
+
+         char escape[6] = { '\\', (char)c, 0, 0, 0, 0 };
+         switch( c ) {
+            case '"':
+            case '\\':
+               append( escape, 2 );
+               break;
+            case '\n':
+               append( "\\n", 2 );
+               break;
+            case '\t':
+               append( "\\t", 2 );
+               break;
+            case '\r':
+               append( "\\r", 2 );
+               break;
+            default:
+               escape[1] = 'u';
+               escape[2] = '0';
+               escape[3] = '0';
+               escape[4] = HEX[c >> 4];
+               escape[5] = HEX[c & 0xF];
+               append( escape, 6 );
+               break;
+         }
+      }
+
+      append( &text[start], length - start );
+      return append( '"' );
+   }
+
+   /**
+    * \brief Appends an object key followed by a colon
+    *
+    * \param [in] key NUL terminated key. It is not escaped
+    * \return reference to the writer
+    **/
+   JsonWriter & JsonWriter::appendKey( const char * key )
+   {
+      append( '"' );
+      append( key );
+      return append( "\":", 2 );
+   }
+
+   /**
+    * \brief Test function
+    **/
+   bool testJsonWriter()
+   {
+      char buffer[128];
+      JsonWriter writer( buffer, sizeof(buffer));
+
+      writer.append('{')
+            .appendKey("a").appendUInt(0).append(',')
+            .appendKey("b").appendUInt(18446744073709551615ULL).append(',')
+            .appendKey("c").appendInt(-9223372036854775807LL - 1).append(',')
+            .appendKey("d").appendString("x\"y\\z\n\x01", 7)
+            .append('}');
+
+      std::string expected = "{\"a\":0,\"b\":18446744073709551615,\"c\":-9223372036854775808,\"d\":\"x\\\"y\\\\z\\n\\u0001\"}";
+      if(( !writer.isValid())||( expected.compare( writer.getString()))||( writer.getLength() != expected.length())) {
+         std::cerr << "testJsonWriter: "<<writer.getString()<<" != "<<expected<<std::endl;
+         return false;
+      }
+
+      //Every value must convert like the standard library
+      for( uint64_t value = 1; value < 1000000000000000000ULL; value = value * 7 + 3 ) {
+         char digits[20];
+         size_t length = uintToChars( digits, value );
+         if( std::string( digits, length ) != std::to_string( (unsigned long long)value )) {
+            std::cerr << "testJsonWriter: conversion of "<<value<<" failed"<<std::endl;
+            return false;
+         }
+      }
+
+      //Output that does not fit is reported and stays terminated
+      char small[8];
+      JsonWriter overflow( small, sizeof(small));
+      overflow.append("{\"id\":").appendUInt(123456);
+      if(( overflow.isValid())||( strlen( small ) != overflow.getLength())) {
+         std::cerr << "testJsonWriter: overflow not detected"<<std::endl;
+         return false;
+      }
+
+      writer.reset();
+      if(( writer.getLength() != 0 )||( buffer[0] != 0 )) {
+         std::cerr << "testJsonWriter: reset failed"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace atl
+{
+   /**
+    * \brief Appends JSON text to a caller-provided character buffer
+    *
+    * The writer never allocates memory and does not use locales or streams.
+    * The caller owns the buffer and can reuse it by calling reset. If the
+    * buffer is too small the output is truncated and isValid returns false.
+    * The text is always NUL terminated when the buffer is not empty.
+    **/
+   class JsonWriter
+   {
+      private:
+         char * m_buffer   = NULL;               //!< Destination buffer
+         size_t m_capacity = 0;                  //!< Size of the destination buffer
+         size_t m_length   = 0;                  //!< Number of characters written
+         bool   m_overflow = false;              //!< Flag set when output was truncated
+
+         void terminate();
+
+      public:
+         JsonWriter( char * buffer, size_t capacity );
+
+         void         reset();
+         const char * getString();
+         size_t       getLength();
+         bool         isValid();
+
+         JsonWriter & append( char c );
+         JsonWriter & append( const char * text, size_t length );
+         JsonWriter & append( const char * text );
+         JsonWriter & appendUInt( uint64_t value );
+         JsonWriter & appendInt( int64_t value );
+         JsonWriter & appendString( const char * text, size_t length );
+         JsonWriter & appendKey( const char * key );
+   };
+
+   size_t uintToChars( char * dest, uint64_t value );
+
+   //Test functions
+   bool testJsonWriter();
+}
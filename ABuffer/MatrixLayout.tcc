@@ -0,0 +1,266 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * \file
+ *
+ * Layout policies for the TSMatrix class. A layout maps an N-dimensional
+ * coordinate onto an offset into the linear storage of the underlying TSArray.
+ * Every policy provides the same interface:
+ *
+ * - setDimensions( dims ) computes the internal tables for the given dimensions
+ * - getStorageSize() returns the number of elements that must be allocated
+ * - calculateOffset( coords ) returns the storage offset of a coordinate
+ *
+ * The storage size may be larger than the product of the dimensions for layouts
+ * that pad the data (tiled and Morton). Each policy also has a unique layoutId
+ * that is recorded in memory-mapped matrix files.
+ **/
+namespace atl
+{
+   /**
+    * \brief Classic row-major layout. The last dimension is contiguous in memory.
+    **/
+   class RowMajorLayout
+   {
+      private:
+         std::vector<size_t> m_strides;          //!< Element stride for each dimension
+         size_t              m_storageSize = 0;  //!< Number of elements in storage
+
+      public:
+         static const bool     isRowMajor = true;    //!< Last dimension is contiguous
+         static const uint32_t layoutId   = 1;       //!< Identifier stored in mapped files
+
+         bool   setDimensions( const std::vector<size_t> &dims );
+         size_t getStorageSize() const { return m_storageSize; };
+
+         /** \brief Returns the storage offset of the given coordinate array **/
+         size_t calculateOffset( const size_t * coords ) const
+         {
+            size_t offset = 0;
+            for( size_t i = 0; i < m_strides.size(); i++ ) {
+               offset += coords[i]*m_strides[i];
+            }
+            return offset;
+         };
+   };
+
+   /**
+    * \brief Blocked layout that stores the data as row-major tiles of Edge^N elements
+    *
+    * Tiles are stored in row-major order and the elements within a tile are also
+    * row-major. Dimensions smaller than Edge are not padded. Edge must be a power of 2
+    **/
+   template <size_t Edge = 32>
+   class TiledLayout
+   {
+      private:
+         static_assert(( Edge > 0 )&&(( Edge & (Edge-1)) == 0 ), "TiledLayout edge must be a power of 2");
+
+         std::vector<size_t> m_tileStrides;      //!< Element stride between tiles for each dimension
+         std::vector<size_t> m_innerStrides;     //!< Element stride within a tile for each dimension
+         size_t              m_storageSize = 0;  //!< Number of elements in storage
+         size_t              m_shift = 0;        //!< log2(Edge)
+
+      public:
+         static const bool     isRowMajor = false;   //!< Last dimension is not contiguous
+         static const uint32_t layoutId   = 2 | ( Edge << 8 ); //!< Identifier stored in mapped files
+
+         bool   setDimensions( const std::vector<size_t> &dims );
+         size_t getStorageSize() const { return m_storageSize; };
+
+         /** \brief Returns the storage offset of the given coordinate array **/
+         size_t calculateOffset( const size_t * coords ) const
+         {
+            size_t offset = 0;
+            for( size_t i = 0; i < m_tileStrides.size(); i++ ) {
+               offset += (coords[i] >> m_shift)      * m_tileStrides[i]
+                       + (coords[i] & (Edge-1))      * m_innerStrides[i];
+            }
+            return offset;
+         };
+   };
+
+   /**
+    * \brief Morton (Z-order) layout that interleaves the bits of all coordinates
+    *
+    * Each dimension is padded to the next power of two. Bits are interleaved from
+    * the least significant bit up with the last dimension varying fastest. Once a
+    * dimension runs out of bits the remaining dimensions continue to interleave,
+    * so non-square grids are not padded to the largest dimension.
+    *
+    * Offsets are computed with a 256 entry lookup table per coordinate byte.
+    **/
+   class MortonLayout
+   {
+      private:
+         std::vector<std::vector<size_t> > m_tables;   //!< Per-dimension spread tables (256 entries per byte)
+         std::vector<size_t>               m_bytes;    //!< Number of coordinate bytes for each dimension
+         size_t                            m_storageSize = 0;  //!< Number of elements in storage
+
+      public:
+         static const bool     isRowMajor = false;   //!< Last dimension is not contiguous
+         static const uint32_t layoutId   = 3;       //!< Identifier stored in mapped files
+
+         bool   setDimensions( const std::vector<size_t> &dims );
+         size_t getStorageSize() const { return m_storageSize; };
+
+         /** \brief Returns the storage offset of the given coordinate array **/
+         size_t calculateOffset( const size_t * coords ) const
+         {
+            size_t offset = 0;
+            for( size_t i = 0; i < m_bytes.size(); i++ ) {
+               const size_t * table = m_tables[i].data();
+               size_t value = coords[i];
+               for( size_t b = 0; b < m_bytes[i]; b++ ) {
+                  offset |= table[256*b + (value & 0xFF)];
+                  value >>= 8;
+               }
+            }
+            return offset;
+         };
+   };
+
+   /**
+    * \brief Computes the row-major strides for the given dimensions
+    *
+    * \param [in] dims vector of the dimensions of the matrix
+    * \return true on success, false on failure
+    **/
+   inline bool RowMajorLayout::setDimensions( const std::vector<size_t> &dims )
+   {
+      if( dims.size() == 0 ) {
+         std::cerr << "RowMajorLayout::setDimensions no dimensions specified"<<std::endl;
+         return false;
+      }
+
+      m_strides.resize( dims.size() );
+
+      size_t totalSize = 1;
+      for( size_t i = dims.size(); i > 0; i-- ) {
+         m_strides[i-1] = totalSize;
+         totalSize *= dims[i-1];
+      }
+
+      m_storageSize = totalSize;
+      return true;
+   }
+
+   /**
+    * \brief Computes the tile and inner strides for the given dimensions
+    *
+    * \param [in] dims vector of the dimensions of the matrix
+    * \return true on success, false on failure
+    **/
+   template <size_t Edge>
+   bool TiledLayout<Edge>::setDimensions( const std::vector<size_t> &dims )
+   {
+      if( dims.size() == 0 ) {
+         std::cerr << "TiledLayout::setDimensions no dimensions specified"<<std::endl;
+         return false;
+      }
+
+      m_shift = 0;
+      while(( (size_t)1 << m_shift ) < Edge ) {
+         m_shift++;
+      }
+
+      //Dimensions smaller than a tile use the dimension as the tile edge
+      std::vector<size_t> edges( dims.size() );
+      std::vector<size_t> tiles( dims.size() );
+      for( size_t i = 0; i < dims.size(); i++ ) {
+         edges[i] = ( dims[i] < Edge ) ? dims[i] : Edge;
+         tiles[i] = ( dims[i] + Edge - 1 ) / Edge;
+      }
+
+      //Inner strides are row-major within a tile
+      m_innerStrides.resize( dims.size() );
+      size_t tileVolume = 1;
+      for( size_t i = dims.size(); i > 0; i-- ) {
+         m_innerStrides[i-1] = tileVolume;
+         tileVolume *= edges[i-1];
+      }
+
+      //Tile strides are row-major across the grid of tiles
+      m_tileStrides.resize( dims.size() );
+      size_t tileCount = 1;
+      for( size_t i = dims.size(); i > 0; i-- ) {
+         m_tileStrides[i-1] = tileCount * tileVolume;
+         tileCount *= tiles[i-1];
+      }
+
+      m_storageSize = tileCount * tileVolume;
+      return true;
+   }
+
+   /**
+    * \brief Builds the bit-interleaving tables for the given dimensions
+    *
+    * \param [in] dims vector of the dimensions of the matrix
+    * \return true on success, false on failure
+    **/
+   inline bool MortonLayout::setDimensions( const std::vector<size_t> &dims )
+   {
+      if( dims.size() == 0 ) {
+         std::cerr << "MortonLayout::setDimensions no dimensions specified"<<std::endl;
+         return false;
+      }
+
+      //Determine the number of bits needed for each dimension
+      std::vector<size_t> bits( dims.size(), 0 );
+      size_t maxBits   = 0;
+      size_t totalBits = 0;
+      for( size_t i = 0; i < dims.size(); i++ ) {
+         while(( (size_t)1 << bits[i] ) < dims[i] ) {
+            bits[i]++;
+         }
+         if( bits[i] > maxBits ) {
+            maxBits = bits[i];
+         }
+         totalBits += bits[i];
+      }
+
+      if( totalBits >= sizeof(size_t)*8 ) {
+         std::cerr << "MortonLayout::setDimensions dimensions exceed addressable range"<<std::endl;
+         return false;
+      }
+
+      //Assign destination bits, lowest first, last dimension varying fastest
+      std::vector<std::vector<size_t> > destination( dims.size() );
+      size_t position = 0;
+      for( size_t b = 0; b < maxBits; b++ ) {
+         for( size_t i = dims.size(); i > 0; i-- ) {
+            if( b < bits[i-1] ) {
+               destination[i-1].push_back( position++ );
+            }
+         }
+      }
+
+      //Build a spread table for each byte of each coordinate
+      m_bytes.assign( dims.size(), 0 );
+      m_tables.assign( dims.size(), std::vector<size_t>() );
+      for( size_t i = 0; i < dims.size(); i++ ) {
+         m_bytes[i] = ( bits[i] + 7 ) / 8;
+         m_tables[i].assign( 256*m_bytes[i], 0 );
+
+         for( size_t byte = 0; byte < m_bytes[i]; byte++ ) {
+            for( size_t value = 0; value < 256; value++ ) {
+               size_t spread = 0;
+               for( size_t bit = 0; bit < 8; bit++ ) {
+                  size_t srcBit = byte*8 + bit;
+                  if(( srcBit < bits[i] )&&( value & ((size_t)1 << bit) )) {
+                     spread |= (size_t)1 << destination[i][srcBit];
+                  }
+               }
+               m_tables[i][256*byte + value] = spread;
+            }
+         }
+      }
+
+      m_storageSize = (size_t)1 << totalBits;
+      return true;
+   }
+}
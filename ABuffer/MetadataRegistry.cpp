@@ -0,0 +1,113 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+
+#include <MetadataRegistry.tcc>
+#include <ImageMetadata.h>
+#include <BaseChunk.h>
+
+namespace atl
+{
+   /**
+    * \brief Records the fixed size of the dispatched type
+    **/
+   struct FixedSizeVisitor
+   {
+      size_t m_size = 0;
+
+      template <typename T>
+      bool operator()( MetadataTag<T> )
+      {
+         m_size = MetadataTraits<T>::fixedSize;
+         return true;
+      }
+   };
+
+   /**
+    * \brief Records the fields of the decoded metadata
+    **/
+   struct DecodeVisitor
+   {
+      uint64_t m_id    = 0;
+      uint16_t m_width = 0;
+      bool     m_image = false;
+
+      bool operator()( BaseChunkMetadata &metadata )
+      {
+         m_id = metadata.m_id;
+         return true;
+      }
+
+      bool operator()( ImageMetadata &metadata )
+      {
+         m_id    = metadata.m_id;
+         m_width = metadata.m_width;
+         m_image = true;
+         return true;
+      }
+   };
+
+   /**
+    * \brief Unit test for the MetadataRegistry class
+    **/
+   bool testMetadataRegistry()
+   {
+      if(( MetadataTypes::count != 2 )
+       ||( strcmp( MetadataTypes::getName( METADATA_TYPE_BASE ), "base" ))
+       ||( strcmp( MetadataTypes::getName( METADATA_TYPE_IMAGE ), "image" ))
+       ||( strcmp( MetadataTypes::getName( 7 ), "unknown" ))
+       ||( MetadataTypes::getFixedSize( METADATA_TYPE_BASE ) != BASECONTAINERMETA_SIZE )
+       ||( MetadataTypes::getEncodedSize( METADATA_TYPE_IMAGE, 5 ) != BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE + 5 )
+       ||( MetadataTypes::getEncodedSize( 7, 5 ) != 0 )) {
+         std::cout << "MetadataRegistry type table does not match"<<std::endl;
+         return false;
+      }
+
+      //The registered sizes agree with the classes
+      ImageMetadata     image;
+      BaseChunkMetadata base;
+      image.m_type = "bayer";
+      base.m_type  = "raw";
+      if(( image.m_typeId != METADATA_TYPE_IMAGE )||( base.m_typeId != METADATA_TYPE_BASE )
+       ||( MetadataTypes::getEncodedSize( image.m_typeId, 5 ) != image.getSize())
+       ||( MetadataTypes::getEncodedSize( base.m_typeId, 3 ) != base.getSize())) {
+         std::cout << "MetadataRegistry sizes do not match the metadata classes"<<std::endl;
+         return false;
+      }
+
+      FixedSizeVisitor sizeVisitor;
+      if(( !MetadataTypes::dispatch( METADATA_TYPE_IMAGE, sizeVisitor ))
+       ||( sizeVisitor.m_size != BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE )
+       ||( MetadataTypes::dispatch( 7, sizeVisitor ))) {
+         std::cout << "MetadataRegistry dispatch failed"<<std::endl;
+         return false;
+      }
+
+      //Decoding by id produces an object of the registered class
+      uint8_t encoded[64];
+      image.m_id    = 99;
+      image.m_width = 640;
+      size_t bytes = image.encode( encoded, sizeof(encoded));
+      DecodeVisitor decoded;
+      if(( !MetadataTypes::decode( METADATA_TYPE_IMAGE, encoded, bytes, decoded ))
+       ||( !decoded.m_image )||( decoded.m_id != 99 )||( decoded.m_width != 640 )
+       ||( MetadataTypes::decode( METADATA_TYPE_IMAGE, encoded, 8, decoded ))) {
+         std::cout << "MetadataRegistry decode failed"<<std::endl;
+         return false;
+      }
+
+      //Chunk headers carry the type id
+      BaseChunk chunk( 5 );
+      chunk.m_metadata.m_typeId = METADATA_TYPE_IMAGE;
+      uint8_t header[BASECHUNK_HEADER_SIZE];
+      BaseChunk restored;
+      if(( !chunk.encodeHeader( header, sizeof(header)))
+       ||( !restored.decodeHeader( header, sizeof(header)))
+       ||( restored.m_metadata.m_typeId != METADATA_TYPE_IMAGE )) {
+         std::cout << "MetadataRegistry type id lost in the chunk header"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+}
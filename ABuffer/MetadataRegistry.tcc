@@ -0,0 +1,147 @@
+#pragma once
+#include <iostream>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseChunkMetadata.h>
+
+namespace atl
+{
+   /**
+    * \brief Identifies a metadata class in a dispatch call
+    **/
+   template <typename T> struct MetadataTag { typedef T Type; };
+
+   /**
+    * \brief Checks at compile time that every type id equals its registry position
+    **/
+   template <size_t Index, typename... Types> struct MetadataIdsMatch
+   {
+      static const bool value = true;
+   };
+
+   template <size_t Index, typename T, typename... Types> struct MetadataIdsMatch<Index, T, Types...>
+   {
+      static const bool value = ( MetadataTraits<T>::id == Index )&&( MetadataIdsMatch<Index + 1, Types...>::value );
+   };
+
+   /**
+    * \brief Compile-time registry of metadata classes
+    *
+    * The registry is instantiated with the metadata classes in type id order
+    * (see MetadataTypes in ImageMetadata.h). Names, fixed sizes and the
+    * dispatch tables are generated from MetadataTraits at compile time, so a
+    * lookup by type id is a single indexed load and dispatch is one indirect
+    * call through a constant table. No strings are compared and the metadata
+    * classes need no virtual functions.
+    *
+    * Visitors are function objects with a template call operator. dispatch
+    * calls visitor( MetadataTag<T>()) and decode calls visitor( T &metadata )
+    * for the class registered under the id. Both return the visitor's result.
+    **/
+   template <typename... Types>
+   class MetadataRegistry
+   {
+      static_assert( sizeof...(Types) > 0, "MetadataRegistry needs at least one type" );
+      static_assert( MetadataIdsMatch<0, Types...>::value, "Metadata type ids must match their registry positions" );
+
+      private:
+         template <typename T, typename Visitor>
+         static bool callVisitor( Visitor &visitor )
+         {
+            return visitor( MetadataTag<T>());
+         }
+
+         template <typename T, typename Visitor>
+         static bool decodeAs( const uint8_t * buffer, size_t bytes, Visitor &visitor )
+         {
+            T metadata;
+            if( !metadata.decode( buffer, bytes )) {
+               return false;
+            }
+
+            return visitor( metadata );
+         }
+
+      public:
+         static const size_t count = sizeof...(Types);       //!< Number of registered types
+
+         /**
+          * \brief Returns true if a class is registered under the id
+          **/
+         static bool isRegistered( uint16_t id )
+         {
+            return id < count;
+         }
+
+         /**
+          * \brief Returns the display name of a type, "unknown" if it is not registered
+          **/
+         static const char * getName( uint16_t id )
+         {
+            static constexpr const char * names[] = { MetadataTraits<Types>::getName()... };
+            return isRegistered( id ) ? names[id] : "unknown";
+         }
+
+         /**
+          * \brief Returns the size of the fixed binary fields of a type, 0 if it is not registered
+          **/
+         static size_t getFixedSize( uint16_t id )
+         {
+            static constexpr size_t sizes[] = { MetadataTraits<Types>::fixedSize... };
+            return isRegistered( id ) ? sizes[id] : 0;
+         }
+
+         /**
+          * \brief Returns the size of the binary encoding of a type with the given type string length
+          **/
+         static size_t getEncodedSize( uint16_t id, size_t typeLength )
+         {
+            return isRegistered( id ) ? getFixedSize( id ) + typeLength : 0;
+         }
+
+         /**
+          * \brief Calls the visitor with the tag of the class registered under the id
+          * \return result of the visitor, false if the id is not registered
+          **/
+         template <typename Visitor>
+         static bool dispatch( uint16_t id, Visitor &visitor )
+         {
+            typedef bool (*Function)( Visitor & );
+            static constexpr Function table[] = { &callVisitor<Types, Visitor>... };
+
+            if( !isRegistered( id )) {
+               std::cerr << "MetadataRegistry: unknown metadata type "<<id<<std::endl;
+               return false;
+            }
+
+            return table[id]( visitor );
+         }
+
+         /**
+          * \brief Decodes binary metadata of the given type and passes it to the visitor
+          *
+          * \param [in] id type id of the encoded metadata
+          * \param [in] buffer encoded metadata (see the encode function of the class)
+          * \param [in] bytes size of the encoded metadata
+          * \param [in] visitor called with the decoded metadata object
+          * \return result of the visitor, false if the id is unknown or decoding fails
+          **/
+         template <typename Visitor>
+         static bool decode( uint16_t id, const uint8_t * buffer, size_t bytes, Visitor &visitor )
+         {
+            typedef bool (*Function)( const uint8_t *, size_t, Visitor & );
+            static constexpr Function table[] = { &decodeAs<Types, Visitor>... };
+
+            if( !isRegistered( id )) {
+               std::cerr << "MetadataRegistry: unknown metadata type "<<id<<std::endl;
+               return false;
+            }
+
+            return table[id]( buffer, bytes, visitor );
+         }
+   };
+
+   //Test functions
+   bool testMetadataRegistry();
+}
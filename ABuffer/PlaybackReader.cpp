@@ -0,0 +1,397 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <PlaybackReader.h>
+#include <ContainerReader.h>
+#include <Checksum.h>
+#include <FileIO.h>
+
+namespace atl
+{
+   /**
+    * \brief Destructor. Stops the prefetch thread and closes the file
+    **/
+   PlaybackReader::~PlaybackReader()
+   {
+      close();
+   }
+
+   /**
+    * \brief Opens a container file and starts prefetching from the first chunk
+    *
+    * \param [in] filename container file written by BaseContainer::save
+    * \param [in] lookahead number of chunks to keep read ahead (at least 1)
+    * \return true on success, false on failure
+    **/
+   bool PlaybackReader::open( std::string filename, size_t lookahead )
+   {
+      close();
+
+      ContainerReader reader;
+      if( !reader.open( filename )) {
+         return false;
+      }
+
+      m_id = reader.getId();
+      m_entries.resize( reader.getChunkCount());
+      uint64_t maxRecord = 0;
+      for( size_t i = 0; i < m_entries.size(); i++ ) {
+         reader.getEntry( i, m_entries[i] );
+         if( m_entries[i].m_size > maxRecord ) {
+            maxRecord = m_entries[i].m_size;
+         }
+      }
+      reader.close();
+
+      m_fd = ::open( filename.c_str(), O_RDONLY );
+      if( m_fd < 0 ) {
+         std::cerr << "PlaybackReader: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      m_lookahead = ( lookahead > 0 ) ? lookahead : 1;
+      m_pool      = BufferPool();
+      if(( maxRecord > 0 )&&( !m_pool.allocate( maxRecord, m_lookahead + 2, 64 ))) {
+         ::close( m_fd );
+         m_fd = -1;
+         return false;
+      }
+
+      posix_fadvise( m_fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+      for( size_t i = 0; ( i < 2 * m_lookahead )&&( i < m_entries.size() ); i++ ) {
+         advise( i );
+      }
+
+      std::lock_guard<std::mutex> guard( m_mutex );
+      m_ready.clear();
+      m_nextFetch  = 0;
+      m_nextPlay   = 0;
+      m_generation = 0;
+      m_stats      = PlaybackStats();
+      m_running    = true;
+      m_thread     = std::thread( &PlaybackReader::prefetchLoop, this );
+
+      return true;
+   }
+
+   /**
+    * \brief Stops prefetching and closes the file
+    **/
+   void PlaybackReader::close()
+   {
+      {
+         std::lock_guard<std::mutex> guard( m_mutex );
+         if( !m_running ) {
+            return;
+         }
+         m_running = false;
+      }
+
+      m_fetchCv.notify_all();
+      m_readyCv.notify_all();
+      m_thread.join();
+
+      std::lock_guard<std::mutex> guard( m_mutex );
+      ::close( m_fd );
+      m_fd = -1;
+      m_ready.clear();
+      m_entries.clear();
+   }
+
+   /**
+    * \brief Asks the kernel to start reading the record at the given position
+    **/
+   void PlaybackReader::advise( size_t position )
+   {
+      if( position < m_entries.size()) {
+         posix_fadvise( m_fd, m_entries[position].m_offset, m_entries[position].m_size, POSIX_FADV_WILLNEED );
+      }
+   }
+
+   /**
+    * \brief Reads and verifies the record at the given position
+    *
+    * A reference record is resolved by reading the referenced record.
+    **/
+   bool PlaybackReader::readChunk( size_t position, BaseChunk &chunk )
+   {
+      const ContainerIndexEntry & entry = m_entries[position];
+
+      BaseBuffer record;
+      if(( entry.m_size > m_pool.getBufferSize())||( !m_pool.acquire( record, false ))) {
+         record = BaseBuffer();
+         if( !record.allocate( entry.m_size )) {
+            return false;
+         }
+      }
+
+      uint8_t * data = record.m_buffer.get();
+      if( !preadFully( m_fd, data, entry.m_size, entry.m_offset )) {
+         std::cerr << "PlaybackReader: unable to read chunk "<<entry.m_id<<std::endl;
+         return false;
+      }
+
+      if( crc32c( data, entry.m_size ) != entry.m_checksum ) {
+         std::cerr << "PlaybackReader: checksum mismatch in chunk "<<entry.m_id<<std::endl;
+         return false;
+      }
+
+      uint32_t typeLength = 0;
+      uint64_t dataSize   = 0;
+      uint16_t flags      = 0;
+      if(( !chunk.decodeHeader( data, entry.m_size, &typeLength, &dataSize, &flags ))
+       ||( typeLength > entry.m_size - BASECHUNK_HEADER_SIZE )
+       ||( dataSize != entry.m_size - BASECHUNK_HEADER_SIZE - typeLength )) {
+         std::cerr << "PlaybackReader: invalid record for chunk "<<entry.m_id<<std::endl;
+         return false;
+      }
+
+      if( flags & BASECHUNK_FLAG_REFERENCE ) {
+         size_t   reference = 0;
+         uint64_t size      = 0;
+         BaseChunk original;
+         if(( !ChunkDeduplicator::decodeReference( data + BASECHUNK_HEADER_SIZE + typeLength, dataSize, position, &reference, &size ))
+          ||( !readChunk( reference, original ))
+          ||( original.m_buffer.getSize() != size )) {
+            std::cerr << "PlaybackReader: invalid reference in chunk "<<entry.m_id<<std::endl;
+            return false;
+         }
+
+         chunk.m_buffer = original.m_buffer;
+         return true;
+      }
+
+      chunk.m_buffer.m_buffer     = std::shared_ptr<uint8_t>( record.m_buffer, data + BASECHUNK_HEADER_SIZE + typeLength );
+      chunk.m_buffer.m_bufferSize = dataSize;
+
+      return true;
+   }
+
+   /**
+    * \brief Prefetch thread. Keeps up to lookahead chunks ready ahead of the consumer
+    **/
+   void PlaybackReader::prefetchLoop()
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      while( m_running ) {
+         if(( m_nextFetch >= m_entries.size())||( m_ready.size() >= m_lookahead )) {
+            m_fetchCv.wait( lock );
+            continue;
+         }
+
+         ReadyChunk ready;
+         ready.m_position = m_nextFetch++;
+         uint64_t generation = m_generation;
+         lock.unlock();
+
+         advise( ready.m_position + m_lookahead );
+         ready.m_valid = readChunk( ready.m_position, ready.m_chunk );
+
+         lock.lock();
+         if( generation == m_generation ) {
+            m_ready.push_back( ready );
+            m_readyCv.notify_all();
+         }
+      }
+   }
+
+   /**
+    * \brief Returns the next chunk in container order
+    *
+    * \param [out] chunk receives the chunk. Its buffer must not be written
+    * \param [out] waitTime time in seconds spent waiting for the chunk (optional)
+    * \return true on success, false at the end of the container, if the record is invalid or the reader was closed
+    **/
+   bool PlaybackReader::next( BaseChunk &chunk, double * waitTime )
+   {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+      std::unique_lock<std::mutex> lock( m_mutex );
+      if(( !m_running )||( m_nextPlay >= m_entries.size())) {
+         return false;
+      }
+
+      while(( m_running )&&( m_ready.empty())) {
+         m_readyCv.wait( lock );
+      }
+      if( !m_running ) {
+         return false;
+      }
+
+      ReadyChunk ready = m_ready.front();
+      m_ready.pop_front();
+      m_nextPlay++;
+      m_fetchCv.notify_all();
+
+      double wait = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+      m_stats.m_chunks++;
+      m_stats.m_totalWait += wait;
+      if( wait > m_stats.m_maxWait ) {
+         m_stats.m_maxWait = wait;
+      }
+      if( wait > PLAYBACKREADER_STALL_TIME ) {
+         m_stats.m_stalls++;
+      }
+      lock.unlock();
+
+      if( waitTime != NULL ) {
+         *waitTime = wait;
+      }
+
+      chunk = ready.m_chunk;
+      return ready.m_valid;
+   }
+
+   /**
+    * \brief Moves playback to the given position and restarts the read-ahead there
+    * \return true on success, false if the position is out of range
+    **/
+   bool PlaybackReader::seek( size_t position )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if(( !m_running )||( position > m_entries.size())) {
+         return false;
+      }
+
+      m_generation++;
+      m_ready.clear();
+      m_nextFetch = position;
+      m_nextPlay  = position;
+      for( size_t i = position; ( i < position + 2 * m_lookahead )&&( i < m_entries.size() ); i++ ) {
+         advise( i );
+      }
+      m_fetchCv.notify_all();
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the position of the chunk the next call to next returns
+    **/
+   size_t PlaybackReader::getPosition()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_nextPlay;
+   }
+
+   /**
+    * \brief Returns the number of chunks in the container
+    **/
+   size_t PlaybackReader::getChunkCount()
+   {
+      return m_entries.size();
+   }
+
+   /**
+    * \brief Returns the ID of the container
+    **/
+   uint64_t PlaybackReader::getId()
+   {
+      return m_id;
+   }
+
+   /**
+    * \brief Returns the wait statistics since open
+    **/
+   PlaybackStats PlaybackReader::getStats()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_stats;
+   }
+
+   /**
+    * \brief Unit test for the PlaybackReader class
+    **/
+   bool testPlaybackReader()
+   {
+      char filename[] = "/tmp/PlaybackReaderXXXXXX";
+      int fd = mkstemp( filename );
+      if( fd < 0 ) {
+         std::cout << "PlaybackReader unable to create temporary file"<<std::endl;
+         return false;
+      }
+      ::close( fd );
+
+      const size_t count = 50;
+      BaseContainer container;
+      container.m_metadata.m_id = 9;
+      for( size_t i = 0; i < count; i++ ) {
+         BaseChunk chunk( 100 + i );
+         chunk.m_metadata.m_type = "frame";
+         chunk.allocate( 1000 + i * 10 );
+         memset( chunk.m_buffer.m_buffer.get(), (int)i, chunk.m_buffer.getSize());
+         container.push_back( chunk );
+      }
+
+      PlaybackReader reader;
+      if(( !container.save( filename ))||( !reader.open( filename, 4 ))
+       ||( reader.getChunkCount() != count )||( reader.getId() != 9 )) {
+         std::cout << "PlaybackReader open failed"<<std::endl;
+         unlink( filename );
+         return false;
+      }
+
+      //Hold every chunk so the pool runs dry and heap buffers are used
+      std::vector<BaseChunk> chunks( count );
+      bool rc = true;
+      for( size_t i = 0; ( rc )&&( i < count ); i++ ) {
+         double wait = -1;
+         if(( !reader.next( chunks[i], &wait ))||( wait < 0 )
+          ||( chunks[i].m_metadata.m_id != 100 + i )
+          ||( chunks[i].m_buffer.getSize() != 1000 + i * 10 )
+          ||( chunks[i].m_buffer[999] != (uint8_t)i )) {
+            std::cout << "PlaybackReader chunk "<<i<<" does not match"<<std::endl;
+            rc = false;
+         }
+      }
+
+      BaseChunk chunk;
+      if(( rc )&&( reader.next( chunk ))) {
+         std::cout << "PlaybackReader returned a chunk past the end"<<std::endl;
+         rc = false;
+      }
+
+      PlaybackStats stats = reader.getStats();
+      if(( rc )&&( stats.m_chunks != count )) {
+         std::cout << "PlaybackReader counted "<<stats.m_chunks<<" chunks"<<std::endl;
+         rc = false;
+      }
+
+      if(( rc )&&(( !reader.seek( 17 ))||( !reader.next( chunk ))||( chunk.m_metadata.m_id != 117 )
+                ||( reader.getPosition() != 18 )||( reader.seek( count + 1 )))) {
+         std::cout << "PlaybackReader seek failed"<<std::endl;
+         rc = false;
+      }
+
+      reader.close();
+
+      //Closing the reader releases a consumer waiting for the next chunk
+      for( int i = 0; ( rc )&&( i < 5 ); i++ ) {
+         PlaybackReader playback;
+         playback.open( filename, 1 );
+         std::thread consumer( [&playback]() {
+            BaseChunk frame;
+            while(( playback.next( frame ))||( playback.seek( 0 ))) {
+            }
+         });
+         std::this_thread::sleep_for( std::chrono::milliseconds( 5 ));
+         playback.close();
+         consumer.join();
+      }
+
+      unlink( filename );
+
+      //Chunks stay valid after the reader is closed
+      if(( rc )&&( chunks[3].m_buffer[0] != 3 )) {
+         std::cout << "PlaybackReader chunk released with the reader"<<std::endl;
+         rc = false;
+      }
+
+      return rc;
+   }
+}
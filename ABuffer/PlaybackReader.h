@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <BaseContainer.h>
+#include <BufferPool.h>
+
+#define PLAYBACKREADER_DEFAULT_LOOKAHEAD 8        //!< Default number of chunks read ahead
+#define PLAYBACKREADER_STALL_TIME        0.001    //!< Waits longer than this (seconds) count as stalls
+
+namespace atl
+{
+   /**
+    * \brief Wait statistics of a PlaybackReader
+    **/
+   struct PlaybackStats
+   {
+      uint64_t m_chunks    = 0;                    //!< Number of chunks returned by next
+      uint64_t m_stalls    = 0;                    //!< Number of waits longer than PLAYBACKREADER_STALL_TIME
+      double   m_totalWait = 0;                    //!< Total time spent waiting in seconds
+      double   m_maxWait   = 0;                    //!< Longest single wait in seconds
+   };
+
+   /**
+    * \brief Sequential reader for container files with asynchronous read-ahead
+    *
+    * Chunks are returned in container order by next. A prefetch thread reads
+    * the following lookahead chunks into memory ahead of the consumer and
+    * issues POSIX_FADV_WILLNEED for the lookahead chunks beyond those, so the
+    * kernel starts fetching them from the device early. Each record is read
+    * with a single pread into a pooled buffer and its checksum is verified.
+    * The returned chunk buffers reference the pooled buffer directly.
+    *
+    * The pool holds enough buffers for the read-ahead window plus a few held
+    * by the consumer. When the consumer holds more, buffers are allocated
+    * from the heap instead.
+    *
+    * next reports how long each call waited for its chunk; a playback loop
+    * that keeps up with the device never waits.
+    **/
+   class PlaybackReader
+   {
+      private:
+         /**
+          * \brief A prefetched chunk
+          **/
+         struct ReadyChunk
+         {
+            size_t    m_position = 0;                //!< Position in the container
+            bool      m_valid = false;               //!< False if the record could not be read
+            BaseChunk m_chunk;                       //!< The chunk
+         };
+
+         int                              m_fd = -1;           //!< Container file
+         uint64_t                         m_id = 0;            //!< ID of the container
+         std::vector<ContainerIndexEntry> m_entries;           //!< Container index
+         size_t                           m_lookahead = PLAYBACKREADER_DEFAULT_LOOKAHEAD; //!< Read-ahead depth
+         BufferPool                       m_pool;              //!< Record buffers
+         std::thread                      m_thread;            //!< Prefetch thread
+         std::mutex                       m_mutex;             //!< Protects the state below
+         std::condition_variable          m_fetchCv;           //!< Signals the prefetch thread
+         std::condition_variable          m_readyCv;           //!< Signals prefetched chunks
+         std::deque<ReadyChunk>           m_ready;             //!< Prefetched chunks in order
+         size_t                           m_nextFetch = 0;     //!< Next position to prefetch
+         size_t                           m_nextPlay = 0;      //!< Next position returned by next
+         uint64_t                         m_generation = 0;    //!< Incremented by seek
+         bool                             m_running = false;   //!< Flag to stop the prefetch thread
+         PlaybackStats                    m_stats;             //!< Wait statistics
+
+         void prefetchLoop();
+         bool readChunk( size_t position, BaseChunk &chunk );
+         void advise( size_t position );
+
+      public:
+         ~PlaybackReader();
+
+         bool          open( std::string filename, size_t lookahead = PLAYBACKREADER_DEFAULT_LOOKAHEAD );
+         void          close();
+         bool          next( BaseChunk &chunk, double * waitTime = NULL );
+         bool          seek( size_t position );
+         size_t        getPosition();
+         size_t        getChunkCount();
+         uint64_t      getId();
+         PlaybackStats getStats();
+   };
+
+   //Test functions
+   bool testPlaybackReader();
+}
@@ -79,8 +79,26 @@ bool testTSArray()
       std::cout<<"TSArray failed to push item. Unexpected value:"<<sz2<<"!="<<44<<std::endl;
       return false;
    }
-   
 
-   
+   //Erase the first element and pop the last one
+   sz = tsa.getSize();
+   tsa.setItem( 11, 0 );
+   tsa.setItem( 22, 1 );
+   if(( !tsa.erase( 0 ))||( tsa.getSize() != sz-1 )||( tsa[0] != 22 )||( tsa.erase( sz ))) {
+      std::cout<<"TSArray erase failed"<<std::endl;
+      return false;
+   }
+
+   if(( !tsa.pop_back( &result ))||( result != 44 )||( tsa.getSize() != sz-2 )) {
+      std::cout<<"TSArray pop_back failed. Unexpected value:"<<result<<"!="<<44<<std::endl;
+      return false;
+   }
+
+   TSArray<double> empty;
+   if( empty.pop_back( &result )) {
+      std::cout<<"TSArray popped an item from an empty array"<<std::endl;
+      return false;
+   }
+
    return true;
 }
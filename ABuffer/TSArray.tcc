@@ -27,6 +27,10 @@ namespace atl
          bool   setItem( T item, size_t index, double waitTime = 0 );
          bool   getItem( T* itemPtr, size_t index, double waitTime = 0);
          size_t push_back( T item );
+         bool   pop_back( T* itemPtr );
+         bool   erase( size_t index );
+         T *    lockBuffer();
+         void   unlockBuffer();
 
          T   operator [](size_t index) const {return m_array.at(index);};
          T & operator [](size_t index)       {return m_array.at(index);};
@@ -46,6 +50,71 @@ namespace atl
        return m_array.size();
     }
 
+   /**
+    * \brief removes the last item from the array
+    * \param [out] itemPtr pointer to an element to receive the removed item
+    * \return true on success, false if the array is empty
+    **/
+   template <typename T>
+   bool TSArray<T>::pop_back( T * itemPtr )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( m_array.size() == 0 ) {
+         return false;
+      }
+
+      *itemPtr = m_array.back();
+      m_array.pop_back();
+      return true;
+   }
+
+   /**
+    * \brief removes the item at the specified index
+    * \param [in] index array index of the item to remove
+    * \return true on success, false if the index is out of range
+    *
+    * Items after the index are moved down by one position.
+    **/
+   template <typename T>
+   bool TSArray<T>::erase( size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( index >= m_array.size()) {
+         return false;
+      }
+
+      m_array.erase( m_array.begin() + index );
+      return true;
+   }
+
+   /**
+    * \brief Locks the array and returns a pointer to the contiguous storage
+    * \return pointer to the first element (NULL if the array is empty)
+    *
+    * This function is used for bulk operations that need to access many elements
+    * under a single lock. The array remains locked until unlockBuffer is called
+    * and must not be resized or accessed through the other member functions
+    * by the same thread in the meantime.
+    **/
+   template <typename T>
+   T * TSArray<T>::lockBuffer()
+   {
+      m_mutex.lock();
+      if( m_array.size() == 0 ) {
+         return NULL;
+      }
+      return &m_array[0];
+   }
+
+   /**
+    * \brief Releases the lock acquired by lockBuffer
+    **/
+   template <typename T>
+   void TSArray<T>::unlockBuffer()
+   {
+      m_mutex.unlock();
+   }
+
    /**
     * \brief Returns the number of allocated elements in the array
     * \return size of the array
@@ -106,7 +175,7 @@ namespace atl
    bool TSArray<T>::getItem( T * itemPtr, size_t index, double waitTime)
    {
       //Check array size to see if we have the specified value
-      if( index > m_array.size()) {
+      if( index >= m_array.size()) {
          cerr << "TSArray index size exceeds array size"<<endl;
          return false;
       }
@@ -0,0 +1,103 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "TSMatrix.tcc"
+
+using namespace std;
+using namespace atl;
+
+/**
+ * \brief Unit test for the TSMappedArray class and file-backed TSMatrix
+ **/
+bool testTSMappedArray()
+{
+   //Anonymous storage keeps its contents when resized
+   TSMappedArray<int32_t> array;
+   array.setSize( 10 );
+   array.setItem( 7, 9 );
+   array.setSize( 100 );
+   int32_t value = 0;
+   if(( !array.getItem( &value, 9 ))||( value != 7 )||( array.isMapped())) {
+      cout << "TSMappedArray anonymous value = "<<value<<" not 7"<<endl;
+      return false;
+   }
+
+   char filename[] = "/tmp/TSMappedArrayXXXXXX";
+   int fd = mkstemp( filename );
+   if( fd < 0 ) {
+      cout << "TSMappedArray unable to create temporary file"<<endl;
+      return false;
+   }
+   close( fd );
+
+   std::vector<size_t> dims = {37, 53, 5};
+   bool rc = true;
+
+   //Create a file-backed matrix and fill it
+   {
+      TSMatrix<float, TiledLayout<8>, TSMappedArray<float> > matrix;
+      if( !matrix.createMapped( filename, dims )) {
+         cout << "TSMappedArray createMapped failed"<<endl;
+         unlink( filename );
+         return false;
+      }
+
+      for( size_t i = 0; i < dims[0]; i++ ) {
+         for( size_t j = 0; j < dims[1]; j++ ) {
+            for( size_t k = 0; k < dims[2]; k++ ) {
+               matrix.setItem( (float)( i*10000 + j*10 + k ), {i,j,k} );
+            }
+         }
+      }
+
+      if( matrix.setSize( 10 )) {
+         cout << "TSMappedArray resized a file-backed array"<<endl;
+         rc = false;
+      }
+      matrix.sync();
+   }
+
+   //Reopen and verify the dimensions and contents
+   {
+      TSMatrix<float, TiledLayout<8>, TSMappedArray<float> > matrix;
+      if( !matrix.openMapped( filename )) {
+         cout << "TSMappedArray openMapped failed"<<endl;
+         rc = false;
+      }
+      else if( matrix.getDimensions() != dims ) {
+         cout << "TSMappedArray dimensions not restored"<<endl;
+         rc = false;
+      }
+
+      for( size_t i = 0; ( rc )&&( i < dims[0] ); i++ ) {
+         for( size_t j = 0; ( rc )&&( j < dims[1] ); j++ ) {
+            for( size_t k = 0; k < dims[2]; k++ ) {
+               float result = -1;
+               matrix.getItem( result, {i,j,k} );
+               if( result != (float)( i*10000 + j*10 + k )) {
+                  cout << "TSMappedArray value = "<<result<<" at "<<i<<","<<j<<","<<k<<endl;
+                  rc = false;
+                  break;
+               }
+            }
+         }
+      }
+   }
+
+   //A different layout or element type must be rejected
+   TSMatrix<float, RowMajorLayout, TSMappedArray<float> > rowMajor;
+   if( rowMajor.openMapped( filename )) {
+      cout << "TSMappedArray opened a file with a different layout"<<endl;
+      rc = false;
+   }
+
+   TSMappedArray<double> wrongType;
+   if( wrongType.openMapped( filename )) {
+      cout << "TSMappedArray opened a file with a different element type"<<endl;
+      rc = false;
+   }
+
+   unlink( filename );
+   return rc;
+}
@@ -0,0 +1,448 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <type_traits>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TSMAPPED_MAGIC           "ATLM"   //!< Identifies a mapped array file
+#define TSMAPPED_VERSION         1        //!< Version of the file header
+#define TSMAPPED_HEADER_SIZE     4096     //!< Offset of the data in the file (one page)
+#define TSMAPPED_MAX_DIMENSIONS  16       //!< Maximum number of shape dimensions in the header
+
+namespace atl
+{
+   /**
+    * \brief Maps an element type to the type code stored in mapped files
+    *
+    * Types without a specialization use code 0 and are only checked by size.
+    **/
+   template <typename T> struct MappedTypeCode { static const uint32_t value = 0; };
+   template <> struct MappedTypeCode<int8_t>   { static const uint32_t value = 1; };
+   template <> struct MappedTypeCode<uint8_t>  { static const uint32_t value = 2; };
+   template <> struct MappedTypeCode<int16_t>  { static const uint32_t value = 3; };
+   template <> struct MappedTypeCode<uint16_t> { static const uint32_t value = 4; };
+   template <> struct MappedTypeCode<int32_t>  { static const uint32_t value = 5; };
+   template <> struct MappedTypeCode<uint32_t> { static const uint32_t value = 6; };
+   template <> struct MappedTypeCode<int64_t>  { static const uint32_t value = 7; };
+   template <> struct MappedTypeCode<uint64_t> { static const uint32_t value = 8; };
+   template <> struct MappedTypeCode<float>    { static const uint32_t value = 9; };
+   template <> struct MappedTypeCode<double>   { static const uint32_t value = 10; };
+
+   /**
+    * \brief Header at the start of a mapped array file
+    *
+    * Values are stored in host byte order. The data starts at TSMAPPED_HEADER_SIZE
+    * so that it is page aligned.
+    **/
+   struct TSMappedHeader
+   {
+      char     m_magic[4];                                //!< TSMAPPED_MAGIC
+      uint32_t m_version;                                 //!< TSMAPPED_VERSION
+      uint32_t m_elementSize;                             //!< sizeof(T)
+      uint32_t m_typeCode;                                //!< MappedTypeCode<T>::value
+      uint32_t m_layoutId;                                //!< Layout of the data (see MatrixLayout.tcc)
+      uint32_t m_dimensionCount;                          //!< Number of valid entries in m_dimensions
+      uint64_t m_elementCount;                            //!< Number of elements in the data
+      uint64_t m_dimensions[TSMAPPED_MAX_DIMENSIONS];     //!< Shape of the data
+   };
+   static_assert( sizeof(TSMappedHeader) <= TSMAPPED_HEADER_SIZE, "TSMappedHeader exceeds header size" );
+
+   /**
+    * !\brief Thread-safe array of POD elements stored in memory-mapped pages
+    *
+    * The array is either backed by a file (createMapped/openMapped) or, when
+    * setSize is called on an unmapped array, by anonymous memory. File-backed
+    * arrays are mapped shared so that changes are written back to the file and
+    * pages are only read from disk when they are first accessed. Opening an
+    * existing file therefore takes constant time regardless of its size.
+    *
+    * The file header records the element type and a shape with a layout
+    * identifier so that TSMatrix can restore its dimensions.
+    **/
+   template <typename T>
+   class TSMappedArray
+   {
+      static_assert( std::is_pod<T>::value, "TSMappedArray requires a POD element type" );
+
+      private:
+         std::mutex m_mutex;                     //!< mutex to ensure thread-safe operation
+         uint8_t *  m_map      = NULL;           //!< Start of the mapping
+         size_t     m_mapBytes = 0;              //!< Size of the mapping in bytes
+         T *        m_data     = NULL;           //!< First element
+         size_t     m_size     = 0;              //!< Number of elements
+         int        m_fd       = -1;             //!< Descriptor of the mapped file (-1 if anonymous)
+
+         void unmap();
+
+      public:
+         ~TSMappedArray();
+
+         bool   createMapped( std::string filename
+                            , size_t size
+                            , const std::vector<size_t> &shape = std::vector<size_t>()
+                            , uint32_t layoutId = 0
+                            );
+         bool   openMapped( std::string filename
+                          , std::vector<size_t> * shape = NULL
+                          , uint32_t * layoutId = NULL
+                          );
+         void   closeMapped();
+         bool   isMapped();
+         bool   sync();
+
+         bool   setSize( size_t size );
+         size_t getSize();
+         bool   setItem( T item, size_t index );
+         bool   getItem( T* itemPtr, size_t index );
+         T *    lockBuffer();
+         void   unlockBuffer();
+   };
+
+   /**
+    * \brief Destructor. Unmaps the data. File contents are written back by the kernel
+    **/
+   template <typename T>
+   TSMappedArray<T>::~TSMappedArray()
+   {
+      unmap();
+   }
+
+   /**
+    * \brief Releases the mapping and closes the file. Must be called with the mutex held
+    **/
+   template <typename T>
+   void TSMappedArray<T>::unmap()
+   {
+      if( m_map != NULL ) {
+         munmap( m_map, m_mapBytes );
+      }
+      if( m_fd >= 0 ) {
+         close( m_fd );
+      }
+
+      m_map      = NULL;
+      m_mapBytes = 0;
+      m_data     = NULL;
+      m_size     = 0;
+      m_fd       = -1;
+   }
+
+   /**
+    * \brief Creates a file of the given size and maps it
+    *
+    * \param [in] filename name of the file to create. An existing file is replaced
+    * \param [in] size number of elements
+    * \param [in] shape dimensions to record in the header
+    * \param [in] layoutId layout identifier to record in the header
+    * \return true on success, false on failure
+    *
+    * The elements are initialized to zero. The file is extended without writing
+    * the data, so file systems that support it create a sparse file.
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::createMapped( std::string filename
+                                      , size_t size
+                                      , const std::vector<size_t> &shape
+                                      , uint32_t layoutId
+                                      )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+
+      if( shape.size() > TSMAPPED_MAX_DIMENSIONS ) {
+         std::cerr << "TSMappedArray: too many dimensions ("<<shape.size()<<")"<<std::endl;
+         return false;
+      }
+
+      unmap();
+
+      int fd = open( filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         std::cerr << "TSMappedArray: unable to create "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      size_t bytes = TSMAPPED_HEADER_SIZE + size * sizeof(T);
+      if( ftruncate( fd, bytes ) != 0 ) {
+         std::cerr << "TSMappedArray: unable to size "<<filename<<": "<<strerror(errno)<<std::endl;
+         close( fd );
+         return false;
+      }
+
+      void * map = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      if( map == MAP_FAILED ) {
+         std::cerr << "TSMappedArray: unable to map "<<filename<<": "<<strerror(errno)<<std::endl;
+         close( fd );
+         return false;
+      }
+
+      TSMappedHeader * header = (TSMappedHeader *)map;
+      memcpy( header->m_magic, TSMAPPED_MAGIC, sizeof(header->m_magic));
+      header->m_version        = TSMAPPED_VERSION;
+      header->m_elementSize    = sizeof(T);
+      header->m_typeCode       = MappedTypeCode<T>::value;
+      header->m_layoutId       = layoutId;
+      header->m_dimensionCount = shape.size();
+      header->m_elementCount   = size;
+      for( size_t i = 0; i < shape.size(); i++ ) {
+         header->m_dimensions[i] = shape[i];
+      }
+
+      m_fd       = fd;
+      m_map      = (uint8_t *)map;
+      m_mapBytes = bytes;
+      m_data     = (T *)( m_map + TSMAPPED_HEADER_SIZE );
+      m_size     = size;
+
+      return true;
+   }
+
+   /**
+    * \brief Maps an existing file created by createMapped
+    *
+    * \param [in] filename name of the file to map
+    * \param [out] shape optional pointer that receives the dimensions in the header
+    * \param [out] layoutId optional pointer that receives the layout identifier
+    * \return true on success, false if the file is missing, invalid or has a different element type
+    *
+    * No data is read. Pages are loaded from the file on first access.
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::openMapped( std::string filename
+                                    , std::vector<size_t> * shape
+                                    , uint32_t * layoutId
+                                    )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      unmap();
+
+      int fd = open( filename.c_str(), O_RDWR );
+      if( fd < 0 ) {
+         std::cerr << "TSMappedArray: unable to open "<<filename<<": "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      struct stat info;
+      if(( fstat( fd, &info ) != 0 )||( (size_t)info.st_size < TSMAPPED_HEADER_SIZE )) {
+         std::cerr << "TSMappedArray: "<<filename<<" is not a mapped array file"<<std::endl;
+         close( fd );
+         return false;
+      }
+
+      size_t bytes = info.st_size;
+      void * map = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+      if( map == MAP_FAILED ) {
+         std::cerr << "TSMappedArray: unable to map "<<filename<<": "<<strerror(errno)<<std::endl;
+         close( fd );
+         return false;
+      }
+
+      //Validate the header before using any of the data
+      const TSMappedHeader * header = (const TSMappedHeader *)map;
+      const char * error = NULL;
+      if( memcmp( header->m_magic, TSMAPPED_MAGIC, sizeof(header->m_magic)) != 0 ) {
+         error = "invalid magic";
+      }
+      else if( header->m_version != TSMAPPED_VERSION ) {
+         error = "unsupported version";
+      }
+      else if(( header->m_elementSize != sizeof(T))||( header->m_typeCode != MappedTypeCode<T>::value )) {
+         error = "element type mismatch";
+      }
+      else if( header->m_dimensionCount > TSMAPPED_MAX_DIMENSIONS ) {
+         error = "invalid dimension count";
+      }
+      else if( header->m_elementCount > ( bytes - TSMAPPED_HEADER_SIZE ) / sizeof(T)) {
+         error = "file is truncated";
+      }
+
+      if( error != NULL ) {
+         std::cerr << "TSMappedArray: "<<filename<<": "<<error<<std::endl;
+         munmap( map, bytes );
+         close( fd );
+         return false;
+      }
+
+      if( shape != NULL ) {
+         shape->assign( header->m_dimensions, header->m_dimensions + header->m_dimensionCount );
+      }
+      if( layoutId != NULL ) {
+         *layoutId = header->m_layoutId;
+      }
+
+      m_fd       = fd;
+      m_map      = (uint8_t *)map;
+      m_mapBytes = bytes;
+      m_data     = (T *)( m_map + TSMAPPED_HEADER_SIZE );
+      m_size     = header->m_elementCount;
+
+      return true;
+   }
+
+   /**
+    * \brief Unmaps the data and closes the file. The array is empty afterwards
+    **/
+   template <typename T>
+   void TSMappedArray<T>::closeMapped()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      unmap();
+   }
+
+   /**
+    * \brief Returns true if the array is backed by a file
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::isMapped()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_fd >= 0;
+   }
+
+   /**
+    * \brief Writes modified pages back to the file and waits for completion
+    * \return true on success (or for anonymous memory), false on failure
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::sync()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if(( m_fd < 0 )||( m_map == NULL )) {
+         return true;
+      }
+
+      if( msync( m_map, m_mapBytes, MS_SYNC ) != 0 ) {
+         std::cerr << "TSMappedArray: sync failed: "<<strerror(errno)<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Sets the number of elements in the array
+    *
+    * \param [in] size new number of elements
+    * \return true on success, false on failure
+    *
+    * The size of a file-backed array cannot be changed. Unmapped arrays are
+    * allocated from anonymous memory and keep their contents when resized.
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::setSize( size_t size )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( size == m_size ) {
+         return true;
+      }
+
+      if( m_fd >= 0 ) {
+         std::cerr << "TSMappedArray: cannot resize a file-backed array"<<std::endl;
+         return false;
+      }
+
+      uint8_t * map   = NULL;
+      size_t    bytes = size * sizeof(T);
+      if( bytes > 0 ) {
+         void * memory = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+         if( memory == MAP_FAILED ) {
+            std::cerr << "TSMappedArray: unable to allocate "<<bytes<<" bytes"<<std::endl;
+            return false;
+         }
+         map = (uint8_t *)memory;
+         memcpy( map, m_data, (( size < m_size ) ? size : m_size ) * sizeof(T));
+      }
+
+      unmap();
+
+      m_map      = map;
+      m_mapBytes = bytes;
+      m_data     = (T *)map;
+      m_size     = size;
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the number of elements in the array
+    **/
+   template <typename T>
+   size_t TSMappedArray<T>::getSize()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_size;
+   }
+
+   /**
+    * \brief sets the item at the specified index
+    *
+    * \param [in] item item to assign
+    * \param [in] index array index to set
+    * \return true on success, false on failure
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::setItem( T item, size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( index >= m_size ) {
+         std::cerr << "TSMappedArray index exceeds array size"<<std::endl;
+         return false;
+      }
+
+      m_data[index] = item;
+      return true;
+   }
+
+   /**
+    * \brief gets the item at the specified index
+    *
+    * \param [in] itemPtr pointer to an element to set
+    * \param [in] index array index to get data element from
+    * \return true on success, false on failure
+    **/
+   template <typename T>
+   bool TSMappedArray<T>::getItem( T * itemPtr, size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( index >= m_size ) {
+         std::cerr << "TSMappedArray index exceeds array size"<<std::endl;
+         return false;
+      }
+
+      *itemPtr = m_data[index];
+      return true;
+   }
+
+   /**
+    * \brief Locks the array and returns a pointer to the contiguous storage
+    * \return pointer to the first element (NULL if the array is empty)
+    **/
+   template <typename T>
+   T * TSMappedArray<T>::lockBuffer()
+   {
+      m_mutex.lock();
+      if( m_size == 0 ) {
+         return NULL;
+      }
+      return m_data;
+   }
+
+   /**
+    * \brief Releases the lock acquired by lockBuffer
+    **/
+   template <typename T>
+   void TSMappedArray<T>::unlockBuffer()
+   {
+      m_mutex.unlock();
+   }
+}
+
+//Test functionality
+bool testTSMappedArray();
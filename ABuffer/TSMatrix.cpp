@@ -4,24 +4,97 @@
 
 using namespace std;
 using namespace atl;
- 
+
 size_t TSMTestSize = 100;
 const size_t TSMThreadCount  = 100;
 
 TSMatrix<double> tsm;
 
-void TSMconsumerThread( double id) 
+void TSMconsumerThread( double id)
 {
    for( size_t i = 0; i < TSMTestSize; i++ ) {
       tsm.setItem( id, {i%10, i%10, i%10});
       double value;
-      tsm.getItem( &value, {i%10, i%10, i%10});
+      tsm.getItem( value, {i%10, i%10, i%10});
+   }
+}
+
+/**
+ * \brief Verifies that a layout maps every coordinate to a unique offset
+ *
+ * \param [in] dims dimensions of the matrix to test
+ * \param [in] name name of the layout for error reporting
+ * \return true on success, false on failure
+ **/
+template <typename Layout>
+bool testTSMatrixLayout( std::vector<size_t> dims, std::string name )
+{
+   TSMatrix<size_t, Layout> matrix;
+   if( !matrix.setDimensions( dims )) {
+      cout << "TSMatrix<"<<name<<"> failed to set dimensions"<<endl;
+      return false;
+   }
+
+   size_t count = 1;
+   for( size_t i = 0; i < dims.size(); i++ ) {
+      count *= dims[i];
+   }
+
+   if( matrix.getSize() < count ) {
+      cout << "TSMatrix<"<<name<<"> storage "<<matrix.getSize()<<" smaller than "<<count<<endl;
+      return false;
+   }
+
+   //Write a unique value to every coordinate
+   std::vector<bool> used( matrix.getSize(), false );
+   std::vector<size_t> coords( dims.size(), 0 );
+   for( size_t value = 0; value < count; value++ ) {
+      size_t offset = matrix.calculateOffset( coords );
+      if(( offset >= used.size())||( used[offset] )) {
+         cout << "TSMatrix<"<<name<<"> invalid or duplicate offset "<<offset<<endl;
+         return false;
+      }
+      used[offset] = true;
+      matrix.setItem( value, coords );
+
+      for( size_t d = dims.size(); d > 0; d-- ) {
+         if( ++coords[d-1] < dims[d-1] ) {
+            break;
+         }
+         coords[d-1] = 0;
+      }
+   }
+
+   //Read everything back
+   coords.assign( dims.size(), 0 );
+   for( size_t value = 0; value < count; value++ ) {
+      size_t result = 0;
+      if(( !matrix.getItem( result, coords ))||( result != value )) {
+         cout << "TSMatrix<"<<name<<"> value = "<<result<<" not "<<value<<endl;
+         return false;
+      }
+
+      for( size_t d = dims.size(); d > 0; d-- ) {
+         if( ++coords[d-1] < dims[d-1] ) {
+            break;
+         }
+         coords[d-1] = 0;
+      }
    }
+
+   //Out of range coordinates must be rejected
+   coords = dims;
+   if( matrix.setItem( 0, coords )) {
+      cout << "TSMatrix<"<<name<<"> accepted out of range coordinates"<<endl;
+      return false;
+   }
+
+   return true;
 }
 
-   
+
 /**
- * \brief Unit test fuction for the ExtendedBuffer class
+ * \brief Unit test fuction for the TSMatrix class
  **/
 bool testTSMatrix()
 {
@@ -47,13 +120,13 @@ bool testTSMatrix()
            << endl;
       return false;
    }
-    
+
    std::vector<size_t> target = {5,5,5};
    double value = 2.2;
    tsm.setItem( value, target );
    double result;
 
-   tsm.getItem( &result, target );
+   tsm.getItem( result, target );
    if( result != value ) {
       cout << "TSMatrix value = "<<result<<" not "<<value<<endl;
       return false;
@@ -72,5 +145,21 @@ bool testTSMatrix()
    for( uint16_t i = 0; i < TSMThreadCount; i++ ) {
       t[i].join();
    }
+
+   //Verify each layout with non-square and non power of 2 dimensions
+   std::vector<size_t> layoutDims = {5,37,70};
+   if( !testTSMatrixLayout<RowMajorLayout>( layoutDims, "RowMajor" )) {
+      return false;
+   }
+   if( !testTSMatrixLayout<TiledLayout<8> >( layoutDims, "Tiled" )) {
+      return false;
+   }
+   if( !testTSMatrixLayout<MortonLayout>( layoutDims, "Morton" )) {
+      return false;
+   }
+   if( !testTSMatrixLayout<MortonLayout>( {300,3}, "Morton" )) {
+      return false;
+   }
+
    return true;
 }
@@ -1,39 +1,58 @@
 #pragma once
+#include <string>
 #include "TSArray.tcc"
+#include "TSMappedArray.tcc"
+#include "MatrixLayout.tcc"
 
 namespace atl
 {
    /**
     * !\brief Templated class for representing arrays of arbitrary data
     *
-    * This class handle continuous arrays of arbitrary data types
+    * This class handle continuous arrays of arbitrary data types. The Layout
+    * policy determines how coordinates are mapped into memory (see MatrixLayout.tcc).
+    * RowMajorLayout is the default. TiledLayout and MortonLayout keep neighboring
+    * elements in all dimensions close together for column and stencil access.
+    *
+    * The Array parameter selects the storage. TSMappedArray<T> allows the matrix
+    * to be stored in a memory-mapped file with createMapped and reopened in
+    * constant time with openMapped.
     **/
-   template <typename T>
-   class TSMatrix : public TSArray<T>
+   template <typename T, typename Layout = RowMajorLayout, typename Array = TSArray<T> >
+   class TSMatrix : public Array
    {
       private:
          std::vector<size_t> m_dimensions;       //!< Array of the dimensions of the data
-         std::vector<size_t> m_dimScalar;        //!< Array of the scalars for each dimension
+         Layout              m_layout;           //!< Maps coordinates to storage offsets
+
+         bool   checkCoordinates( const std::vector<size_t> &coords);
 
-         size_t calculateOffset( std::vector<size_t> coords);
-         
       public:
+         typedef T      value_type;              //!< Element type of the matrix
+         typedef Layout layout_type;             //!< Layout policy of the matrix
+         typedef Array  array_type;              //!< Storage of the matrix
+
          bool setDimensions( std::vector<size_t> dims);
+         bool createMapped( std::string filename, std::vector<size_t> dims );
+         bool openMapped( std::string filename );
          std::vector<size_t> getDimensions();
-         bool getItem( T &item, std::vector<size_t> coords);
-         bool setItem( T &item, std::vector<size_t> coords );
+         size_t calculateOffset( const std::vector<size_t> &coords);
+         /** \brief Returns the storage offset of a coordinate array (no bounds checking) **/
+         size_t calculateOffset( const size_t * coords) { return m_layout.calculateOffset( coords ); };
+         bool getItem( T &item, const std::vector<size_t> &coords);
+         bool setItem( const T &item, const std::vector<size_t> &coords );
    };
 
-   
+
    /**
     * \brief Specifies the dimensions of the array and allocates the buffers as needed
     * \return size of the array
     *
     * This function allows external processes to get the size of the array
     **/
-   template <typename T>
-   std::vector<size_t> TSMatrix<T>::getDimensions()
-   { 
+   template <typename T, typename Layout, typename Array>
+   std::vector<size_t> TSMatrix<T, Layout, Array>::getDimensions()
+   {
       return m_dimensions;
    }
 
@@ -43,41 +62,94 @@ namespace atl
     * \param [in] dims vector of the dimensions of the object
     * \return true on success, false on failure
     *
-    * This function allows external processes to get the size of the array
+    * The allocated size is determined by the layout and may exceed the
+    * product of the dimensions for padded layouts.
     **/
-   template <typename T>
-   bool TSMatrix<T>::setDimensions( std::vector<size_t>dims)
-   { 
-      bool rc = true;
-
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::setDimensions( std::vector<size_t>dims)
+   {
       //Make sure we are not reallocating
       if(( m_dimensions.size() != 0 )||(dims.size() == 0 )) {
          std::cerr << "TSMatrix::setDimensions array already defined."<<std::endl;
-         rc = false;
-      } 
-      else {
-         m_dimensions = dims;
-         m_dimScalar = dims;
-         m_dimScalar[dims.size()-1] = 0;
-
-         //Loop to calculate the total size
-         size_t totalSize = 1;
-         for( size_t i = m_dimensions.size()-1; i > 0; i-- ) {
-            if( i == m_dimensions.size()-1) {
-               m_dimScalar[i] = totalSize;
-            }
-            else {
-               m_dimScalar[i] = totalSize;
-            }
-
-            //Calculate total size
-            totalSize *= m_dimensions[i];
-         }
+         return false;
+      }
 
-         TSArray<T>::setSize(totalSize);
-         rc = true;
+      if( !m_layout.setDimensions( dims )) {
+         std::cerr << "TSMatrix::setDimensions unable to compute layout."<<std::endl;
+         return false;
       }
-      return rc;
+
+      m_dimensions = dims;
+      return Array::setSize( m_layout.getStorageSize());
+   }
+
+   /**
+    * \brief Creates a file-backed matrix with the given dimensions
+    *
+    * \param [in] filename name of the file to create. An existing file is replaced
+    * \param [in] dims vector of the dimensions of the object
+    * \return true on success, false on failure
+    *
+    * The dimensions and layout are stored in the file header. Requires an Array
+    * that supports mapping, such as TSMappedArray.
+    **/
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::createMapped( std::string filename, std::vector<size_t> dims )
+   {
+      if(( m_dimensions.size() != 0 )||(dims.size() == 0 )) {
+         std::cerr << "TSMatrix::createMapped array already defined."<<std::endl;
+         return false;
+      }
+
+      if( !m_layout.setDimensions( dims )) {
+         std::cerr << "TSMatrix::createMapped unable to compute layout."<<std::endl;
+         return false;
+      }
+
+      if( !Array::createMapped( filename, m_layout.getStorageSize(), dims, Layout::layoutId )) {
+         return false;
+      }
+
+      m_dimensions = dims;
+      return true;
+   }
+
+   /**
+    * \brief Maps an existing matrix file created by createMapped
+    *
+    * \param [in] filename name of the file to map
+    * \return true on success, false on failure
+    *
+    * The dimensions are restored from the file header. The layout recorded in
+    * the file must match the Layout of this matrix. No data is read; pages are
+    * loaded on first access.
+    **/
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::openMapped( std::string filename )
+   {
+      if( m_dimensions.size() != 0 ) {
+         std::cerr << "TSMatrix::openMapped array already defined."<<std::endl;
+         return false;
+      }
+
+      std::vector<size_t> dims;
+      uint32_t            layoutId = 0;
+      if( !Array::openMapped( filename, &dims, &layoutId )) {
+         return false;
+      }
+
+      if(( layoutId != Layout::layoutId )
+       ||( dims.size() == 0 )
+       ||( !m_layout.setDimensions( dims ))
+       ||( m_layout.getStorageSize() != Array::getSize())) {
+         std::cerr << "TSMatrix::openMapped "<<filename<<" does not match the matrix layout."<<std::endl;
+         Array::closeMapped();
+         m_layout = Layout();
+         return false;
+      }
+
+      m_dimensions = dims;
+      return true;
    }
 
    /**
@@ -85,18 +157,36 @@ namespace atl
     *
     * \param [in] coords vector of coordinate values
     **/
-   template <typename T>
-   size_t TSMatrix<T>::calculateOffset( std::vector<size_t> coords)
+   template <typename T, typename Layout, typename Array>
+   size_t TSMatrix<T, Layout, Array>::calculateOffset( const std::vector<size_t> &coords)
+   {
+      return m_layout.calculateOffset( coords.data() );
+   }
+
+   /**
+    * \brief Verifies that the coordinates are inside of the matrix
+    *
+    * \param [in] coords vector of coordinate values
+    * \return true if valid, false otherwise
+    **/
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::checkCoordinates( const std::vector<size_t> &coords)
    {
-      //Find a total offset into the array
-      size_t offset = 0;
-      for( size_t i = 0; i < m_dimScalar.size(); i++ ) {
-         offset += coords[i]*m_dimScalar[i];
+      if( coords.size() != m_dimensions.size()) {
+         std::cerr << "TSMatrix: requested coordinates do not match dimensions"<<std::endl;
+         return false;
+      }
+
+      for( size_t i = 0; i < coords.size(); i++ ) {
+         if( coords[i] >= m_dimensions[i] ) {
+            std::cerr << "TSMatrix: coordinate "<<i<<" out of range"<<std::endl;
+            return false;
+         }
       }
 
-      return offset;
+      return true;
    }
-   
+
    /**
     * \brief Gets the item at the specified coordinates
     *
@@ -104,31 +194,31 @@ namespace atl
     * \param [in] coords vector of coordinates of the item.
     * \return true on success, false on failure
     **/
-   template <typename T>
-   bool TSMatrix<T>::getItem( T &item, std::vector<size_t> coords)
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::getItem( T &item, const std::vector<size_t> &coords)
    {
-      if( coords.size() != m_dimensions.size()) {
-         std::cerr << "TSArray getItem: requested coordinates do not match"<<std::endl;
+      if( !checkCoordinates( coords )) {
          return false;
       }
 
-      size_t offset = calculateOffset( coords);
-
-      return TSArray<T>::getItem( item, offset );
+      return Array::getItem( &item, calculateOffset( coords ));
    }
-   
+
    /**
     * \brief Sets the array at the specified index to the given item
     *
     * \param [in] item value to set
-    * \param [in] index index to set value at
-    * \param [in] waitTime amount of time to wait (before giving up)a
+    * \param [in] coords vector of coordinates of the item.
     * \return true on success, false on failure
     **/
-   template <typename T>
-   bool TSMatrix<T>::setItem( T &item, std::vector<size_t> coords)
+   template <typename T, typename Layout, typename Array>
+   bool TSMatrix<T, Layout, Array>::setItem( const T &item, const std::vector<size_t> &coords)
    {
-      return TSArray<T>::setItem( item, calculateOffset(coords));
+      if( !checkCoordinates( coords )) {
+         return false;
+      }
+
+      return Array::setItem( item, calculateOffset(coords));
    }
 }
 
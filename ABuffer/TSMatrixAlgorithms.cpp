@@ -0,0 +1,99 @@
+#include <iostream>
+#include "TSMatrixAlgorithms.tcc"
+
+using namespace std;
+using namespace atl;
+
+/**
+ * \brief Unit test function for the parallel TSMatrix algorithms
+ **/
+bool testTSMatrixAlgorithms()
+{
+   AThreadPool pool(4);
+
+   //Row-major matrix with values 0..N-1 and a tiled copy
+   const size_t rows = 300;
+   const size_t cols = 257;
+   TSMatrix<int32_t> matrix;
+   matrix.setDimensions( {rows, cols} );
+   TSMatrixView<TSMatrix<int32_t> > view( matrix );
+
+   TSMatrix<float, TiledLayout<16> > tiled;
+   tiled.setDimensions( {rows, cols} );
+   TSMatrixView<TSMatrix<float, TiledLayout<16> > > tiledView( tiled );
+
+   size_t count = rows*cols;
+   std::vector<int32_t> values( count );
+   for( size_t i = 0; i < count; i++ ) {
+      values[i] = (int32_t)i;
+   }
+   view.copyIn( values.data(), count );
+
+   //Transform into the tiled matrix
+   if( !transform( view, tiledView, []( int32_t v ) { return (float)v * 0.5f; }, pool )) {
+      cout << "transform failed"<<endl;
+      return false;
+   }
+   float item = 0;
+   tiled.getItem( item, {123, 45} );
+   if( item != (float)(123*cols+45) * 0.5f ) {
+      cout << "transform result "<<item<<" not "<<(123*cols+45)*0.5f<<endl;
+      return false;
+   }
+
+   //In-place forEach
+   parallelForEach( matrix, []( int32_t &v ) { v *= 2; }, pool );
+
+   int64_t expected = (int64_t)count * (int64_t)(count-1);
+   int64_t sum = parallelSum( view, pool );
+   if( sum != expected ) {
+      cout << "parallelSum = "<<sum<<" not "<<expected<<endl;
+      return false;
+   }
+
+   //Sum over a strided region
+   TSMatrixView<TSMatrix<int32_t> > region( matrix, {10,3}, {50,40}, {2,3} );
+   int64_t regionExpected = 0;
+   for( size_t r = 0; r < 50; r++ ) {
+      for( size_t c = 0; c < 40; c++ ) {
+         regionExpected += 2*(int64_t)((10+2*r)*cols + 3+3*c);
+      }
+   }
+   if( parallelSum( region, pool ) != regionExpected ) {
+      cout << "parallelSum over region does not match "<<regionExpected<<endl;
+      return false;
+   }
+
+   int32_t minValue = 0;
+   int32_t maxValue = 0;
+   parallelMin( region, minValue, pool );
+   parallelMax( region, maxValue, pool );
+   if(( minValue != 2*(int32_t)(10*cols+3) )||( maxValue != 2*(int32_t)(108*cols+120) )) {
+      cout << "parallelMin/Max = "<<minValue<<"/"<<maxValue<<endl;
+      return false;
+   }
+
+   //Sum and min over the tiled matrix
+   double tiledSum = parallelSum( tiledView, pool );
+   if( tiledSum != (double)expected / 4.0 ) {
+      cout << "parallelSum(tiled) = "<<tiledSum<<" not "<<(double)expected/4.0<<endl;
+      return false;
+   }
+
+   //Histogram of the values 0..2(N-1) in 10 bins
+   std::vector<uint64_t> histogram = parallelHistogram( view, 10, 0, 2.0*count, pool );
+   uint64_t total = 0;
+   for( size_t i = 0; i < histogram.size(); i++ ) {
+      if( histogram[i] != count / 10 ) {
+         cout << "parallelHistogram bin "<<i<<" = "<<histogram[i]<<" not "<<count/10<<endl;
+         return false;
+      }
+      total += histogram[i];
+   }
+   if( total != count ) {
+      cout << "parallelHistogram total "<<total<<" not "<<count<<endl;
+      return false;
+   }
+
+   return true;
+}
@@ -0,0 +1,421 @@
+#pragma once
+#include <limits>
+#include <type_traits>
+#include <mutex>
+#include <vector>
+
+#include "TSMatrixView.tcc"
+#include "AThreadPool.h"
+
+/**
+ * \file
+ *
+ * Parallel algorithms over TSMatrix objects and TSMatrixView regions.
+ *
+ * Each algorithm locks the matrix once, splits the view into blocks of about
+ * TSMATRIX_BLOCK_BYTES (rounded to whole rows for row-major matrices) and
+ * processes the blocks on an AThreadPool. The inner loops operate on raw
+ * contiguous runs so that they can be vectorized by the compiler for
+ * arithmetic types.
+ *
+ * The functions passed to the algorithms are called concurrently from several
+ * threads and must not access the matrix through its locking interface.
+ **/
+#define TSMATRIX_BLOCK_BYTES 65536
+
+namespace atl
+{
+   /**
+    * \brief Accumulator type used by parallelSum
+    **/
+   template <typename T>
+   struct SumType
+   {
+      typedef typename std::conditional< std::is_floating_point<T>::value
+                                       , double
+                                       , typename std::conditional< std::is_signed<T>::value
+                                                                  , int64_t
+                                                                  , uint64_t
+                                                                  >::type
+                                       >::type type;
+   };
+
+   /**
+    * \brief Returns the number of view elements to process per block
+    **/
+   template <typename Matrix>
+   size_t getBlockElements( const TSMatrixView<Matrix> &view )
+   {
+      size_t run  = view.getRunLength();
+      size_t runs = TSMATRIX_BLOCK_BYTES / ( sizeof(typename Matrix::value_type) * run );
+      if( runs == 0 ) {
+         runs = 1;
+      }
+      return runs * run;
+   }
+
+   /**
+    * \brief Calls fn( element ) for every element of the view in parallel
+    *
+    * \param [in] view region to process
+    * \param [in] fn function taking a reference to an element
+    * \param [in] pool worker pool to use
+    * \return true on success, false if the view is invalid
+    **/
+   template <typename Matrix, typename F>
+   bool parallelForEach( TSMatrixView<Matrix> &view
+                       , F fn
+                       , AThreadPool &pool = getDefaultThreadPool()
+                       )
+   {
+      typedef typename Matrix::value_type T;
+
+      if( !view.isValid() ) {
+         std::cerr << "parallelForEach: invalid view"<<std::endl;
+         return false;
+      }
+
+      T * data = view.getMatrix()->lockBuffer();
+      pool.parallelFor( view.getElementCount(), getBlockElements( view ), [&]( size_t begin, size_t end ) {
+         view.forEachRun( data, [&fn]( T * first, size_t n, size_t step, size_t ) {
+            if( step == 1 ) {
+               for( size_t i = 0; i < n; i++ ) {
+                  fn( first[i] );
+               }
+            }
+            else {
+               for( size_t i = 0; i < n; i++ ) {
+                  fn( first[i*step] );
+               }
+            }
+         }, begin, end );
+      });
+      view.getMatrix()->unlockBuffer();
+
+      return true;
+   }
+
+   /**
+    * \brief Calls fn( element ) for every element of the matrix in parallel
+    **/
+   template <typename T, typename Layout, typename Array, typename F>
+   bool parallelForEach( TSMatrix<T, Layout, Array> &matrix
+                       , F fn
+                       , AThreadPool &pool = getDefaultThreadPool()
+                       )
+   {
+      TSMatrixView<TSMatrix<T, Layout, Array> > view( matrix );
+      return parallelForEach( view, fn, pool );
+   }
+
+   /**
+    * \brief Sets each element of dst to fn( element of src ) in parallel
+    *
+    * \param [in] src source region
+    * \param [in] dst destination region with the same extents as src
+    * \param [in] fn function mapping a source element to a destination element
+    * \param [in] pool worker pool to use
+    * \return true on success, false if the views are invalid or do not match
+    *
+    * Each block of the source is gathered into a cache-resident buffer before
+    * being written to the destination, so the source and destination may use
+    * different layouts. They may reference the same matrix if the regions are
+    * identical (in-place) or do not overlap.
+    **/
+   template <typename SrcMatrix, typename DstMatrix, typename F>
+   bool transform( TSMatrixView<SrcMatrix> &src
+                 , TSMatrixView<DstMatrix> &dst
+                 , F fn
+                 , AThreadPool &pool = getDefaultThreadPool()
+                 )
+   {
+      typedef typename SrcMatrix::value_type S;
+      typedef typename DstMatrix::value_type D;
+
+      if(( !src.isValid() )||( !dst.isValid() )||( src.getDimensions() != dst.getDimensions() )) {
+         std::cerr << "transform: invalid or mismatched views"<<std::endl;
+         return false;
+      }
+
+      //Blocks must be whole runs of both views. Runs are either single elements
+      //or full rows, so rounding up to the source run length is sufficient
+      size_t blockSize = getBlockElements( dst );
+      size_t srcRun = src.getRunLength();
+      if( blockSize % srcRun != 0 ) {
+         blockSize = srcRun * (( blockSize + srcRun - 1 ) / srcRun );
+      }
+
+      bool sameMatrix = ( (void *)src.getMatrix() == (void *)dst.getMatrix() );
+      S * srcData = src.getMatrix()->lockBuffer();
+      D * dstData = sameMatrix ? (D *)srcData : dst.getMatrix()->lockBuffer();
+
+      pool.parallelFor( dst.getElementCount(), blockSize, [&]( size_t begin, size_t end ) {
+         std::vector<S> buffer( end - begin );
+         S * block = buffer.data();
+
+         src.forEachRun( srcData, [block, begin]( S * first, size_t n, size_t step, size_t index ) {
+            S * out = &block[index - begin];
+            if( step == 1 ) {
+               for( size_t i = 0; i < n; i++ ) {
+                  out[i] = first[i];
+               }
+            }
+            else {
+               for( size_t i = 0; i < n; i++ ) {
+                  out[i] = first[i*step];
+               }
+            }
+         }, begin, end );
+
+         dst.forEachRun( dstData, [&fn, block, begin]( D * first, size_t n, size_t step, size_t index ) {
+            const S * in = &block[index - begin];
+            if( step == 1 ) {
+               for( size_t i = 0; i < n; i++ ) {
+                  first[i] = fn( in[i] );
+               }
+            }
+            else {
+               for( size_t i = 0; i < n; i++ ) {
+                  first[i*step] = fn( in[i] );
+               }
+            }
+         }, begin, end );
+      });
+
+      if( !sameMatrix ) {
+         dst.getMatrix()->unlockBuffer();
+      }
+      src.getMatrix()->unlockBuffer();
+
+      return true;
+   }
+
+   /**
+    * \brief Sets each element of dst to fn( element of src ) in parallel
+    **/
+   template <typename S, typename SLayout, typename SArray, typename D, typename DLayout, typename DArray, typename F>
+   bool transform( TSMatrix<S, SLayout, SArray> &src
+                 , TSMatrix<D, DLayout, DArray> &dst
+                 , F fn
+                 , AThreadPool &pool = getDefaultThreadPool()
+                 )
+   {
+      TSMatrixView<TSMatrix<S, SLayout, SArray> > srcView( src );
+      TSMatrixView<TSMatrix<D, DLayout, DArray> > dstView( dst );
+      return transform( srcView, dstView, fn, pool );
+   }
+
+   /**
+    * \brief Generic parallel reduction over the elements of a view
+    *
+    * \param [in] view region to reduce
+    * \param [in] identity initial value of each block accumulator
+    * \param [in] runFn function called as runFn( first, count, step, acc ) for each run
+    * \param [in] combine function called as combine( result, acc ) to merge block results
+    * \param [in] pool worker pool to use
+    * \return reduced value (identity if the view is invalid)
+    **/
+   template <typename Matrix, typename Acc, typename RunFn, typename CombineFn>
+   Acc parallelReduce( TSMatrixView<Matrix> &view
+                     , const Acc &identity
+                     , RunFn runFn
+                     , CombineFn combine
+                     , AThreadPool &pool = getDefaultThreadPool()
+                     )
+   {
+      typedef typename Matrix::value_type T;
+      Acc result = identity;
+
+      if( !view.isValid() ) {
+         std::cerr << "parallelReduce: invalid view"<<std::endl;
+         return result;
+      }
+
+      std::mutex resultMutex;
+      T * data = view.getMatrix()->lockBuffer();
+      pool.parallelFor( view.getElementCount(), getBlockElements( view ), [&]( size_t begin, size_t end ) {
+         Acc acc = identity;
+         view.forEachRun( data, [&runFn, &acc]( T * first, size_t n, size_t step, size_t ) {
+            runFn( (const T *)first, n, step, acc );
+         }, begin, end );
+
+         std::lock_guard<std::mutex> guard( resultMutex );
+         combine( result, acc );
+      });
+      view.getMatrix()->unlockBuffer();
+
+      return result;
+   }
+
+   /**
+    * \brief Returns the sum of all elements in the view
+    **/
+   template <typename Matrix>
+   typename SumType<typename Matrix::value_type>::type
+   parallelSum( TSMatrixView<Matrix> &view, AThreadPool &pool = getDefaultThreadPool() )
+   {
+      typedef typename Matrix::value_type T;
+      typedef typename SumType<T>::type   A;
+
+      return parallelReduce( view, (A)0, []( const T * p, size_t n, size_t step, A &acc ) {
+         if( step == 1 ) {
+            //Independent accumulators allow the loop to be vectorized
+            A lanes[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+            size_t i = 0;
+            for( ; i + 8 <= n; i += 8 ) {
+               for( size_t k = 0; k < 8; k++ ) {
+                  lanes[k] += p[i+k];
+               }
+            }
+            for( ; i < n; i++ ) {
+               lanes[0] += p[i];
+            }
+            for( size_t k = 0; k < 8; k++ ) {
+               acc += lanes[k];
+            }
+         }
+         else {
+            for( size_t i = 0; i < n; i++ ) {
+               acc += p[i*step];
+            }
+         }
+      }, []( A &result, const A &acc ) { result += acc; }, pool );
+   }
+
+   /**
+    * \brief Finds the minimum (or maximum) element of the view
+    *
+    * \param [in] view region to search
+    * \param [out] result extreme value
+    * \param [in] findMax true to find the maximum, false for the minimum
+    * \param [in] pool worker pool to use
+    * \return true on success, false if the view is invalid
+    **/
+   template <typename Matrix>
+   bool parallelExtreme( TSMatrixView<Matrix> &view
+                       , typename Matrix::value_type &result
+                       , bool findMax
+                       , AThreadPool &pool = getDefaultThreadPool()
+                       )
+   {
+      typedef typename Matrix::value_type T;
+
+      if( !view.isValid() ) {
+         return false;
+      }
+
+      //Every block starts from the first element so no sentinel value is needed
+      T first = T();
+      std::vector<size_t> origin( view.getDimensions().size(), 0 );
+      view.getItem( first, origin );
+
+      if( findMax ) {
+         result = parallelReduce( view, first, []( const T * p, size_t n, size_t step, T &acc ) {
+            T value = acc;
+            if( step == 1 ) {
+               for( size_t i = 0; i < n; i++ ) {
+                  value = ( p[i] > value ) ? p[i] : value;
+               }
+            }
+            else {
+               for( size_t i = 0; i < n; i++ ) {
+                  value = ( p[i*step] > value ) ? p[i*step] : value;
+               }
+            }
+            acc = value;
+         }, []( T &res, const T &acc ) { if( acc > res ) { res = acc; } }, pool );
+      }
+      else {
+         result = parallelReduce( view, first, []( const T * p, size_t n, size_t step, T &acc ) {
+            T value = acc;
+            if( step == 1 ) {
+               for( size_t i = 0; i < n; i++ ) {
+                  value = ( p[i] < value ) ? p[i] : value;
+               }
+            }
+            else {
+               for( size_t i = 0; i < n; i++ ) {
+                  value = ( p[i*step] < value ) ? p[i*step] : value;
+               }
+            }
+            acc = value;
+         }, []( T &res, const T &acc ) { if( acc < res ) { res = acc; } }, pool );
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Finds the minimum element of the view
+    **/
+   template <typename Matrix>
+   bool parallelMin( TSMatrixView<Matrix> &view
+                   , typename Matrix::value_type &result
+                   , AThreadPool &pool = getDefaultThreadPool()
+                   )
+   {
+      return parallelExtreme( view, result, false, pool );
+   }
+
+   /**
+    * \brief Finds the maximum element of the view
+    **/
+   template <typename Matrix>
+   bool parallelMax( TSMatrixView<Matrix> &view
+                   , typename Matrix::value_type &result
+                   , AThreadPool &pool = getDefaultThreadPool()
+                   )
+   {
+      return parallelExtreme( view, result, true, pool );
+   }
+
+   /**
+    * \brief Computes a histogram of the elements in the view
+    *
+    * \param [in] view region to process
+    * \param [in] bins number of bins
+    * \param [in] minValue lower bound of the first bin
+    * \param [in] maxValue upper bound of the last bin
+    * \param [in] pool worker pool to use
+    * \return vector of bin counts. Values outside [minValue, maxValue) are not counted
+    **/
+   template <typename Matrix>
+   std::vector<uint64_t> parallelHistogram( TSMatrixView<Matrix> &view
+                                          , size_t bins
+                                          , double minValue
+                                          , double maxValue
+                                          , AThreadPool &pool = getDefaultThreadPool()
+                                          )
+   {
+      typedef typename Matrix::value_type T;
+      std::vector<uint64_t> identity( bins, 0 );
+
+      if(( bins == 0 )||( maxValue <= minValue )) {
+         std::cerr << "parallelHistogram: invalid range"<<std::endl;
+         return identity;
+      }
+
+      const double scale = (double)bins / ( maxValue - minValue );
+
+      return parallelReduce( view, identity, [=]( const T * p, size_t n, size_t step, std::vector<uint64_t> &acc ) {
+         uint64_t * counts = acc.data();
+         for( size_t i = 0; i < n; i++ ) {
+            double value = (double)p[i*step];
+            if(( value >= minValue )&&( value < maxValue )) {
+               size_t bin = (size_t)(( value - minValue ) * scale );
+               if( bin >= bins ) {
+                  bin = bins - 1;
+               }
+               counts[bin]++;
+            }
+         }
+      }, []( std::vector<uint64_t> &result, const std::vector<uint64_t> &acc ) {
+         for( size_t i = 0; i < result.size(); i++ ) {
+            result[i] += acc[i];
+         }
+      }, pool );
+   }
+}
+
+//Test functionality
+bool testTSMatrixAlgorithms();
@@ -0,0 +1,107 @@
+#include <iostream>
+#include "TSMatrixView.tcc"
+
+using namespace std;
+using namespace atl;
+
+/**
+ * \brief Checks views on a 6x8 matrix where each element is row*8+column
+ *
+ * \param [in] name name of the layout for error reporting
+ * \return true on success, false on failure
+ **/
+template <typename Layout>
+bool testTSMatrixViewLayout( std::string name )
+{
+   typedef TSMatrix<int, Layout> Matrix;
+   Matrix matrix;
+   matrix.setDimensions( {6, 8} );
+   for( size_t r = 0; r < 6; r++ ) {
+      for( size_t c = 0; c < 8; c++ ) {
+         matrix.setItem( (int)(r*8+c), {r, c} );
+      }
+   }
+
+   //Contiguous region
+   TSMatrixView<Matrix> view( matrix, {1,2}, {3,4} );
+   if( !view.isValid() || view.getElementCount() != 12 ) {
+      cout << "TSMatrixView<"<<name<<"> failed to create region view"<<endl;
+      return false;
+   }
+
+   int values[12];
+   if( view.copyOut( values, 12 ) != 12 ) {
+      cout << "TSMatrixView<"<<name<<"> copyOut failed"<<endl;
+      return false;
+   }
+   for( size_t i = 0; i < 12; i++ ) {
+      int expected = (int)((1 + i/4)*8 + 2 + i%4);
+      if( values[i] != expected ) {
+         cout << "TSMatrixView<"<<name<<"> copyOut["<<i<<"] = "<<values[i]<<" not "<<expected<<endl;
+         return false;
+      }
+   }
+
+   //Iteration must visit the same elements in the same order
+   size_t index = 0;
+   for( typename TSMatrixView<Matrix>::Iterator it = view.begin(); it != view.end(); ++it ) {
+      if( *it != values[index++] ) {
+         cout << "TSMatrixView<"<<name<<"> iterator mismatch at "<<index-1<<endl;
+         return false;
+      }
+   }
+   if( index != 12 ) {
+      cout << "TSMatrixView<"<<name<<"> iterator visited "<<index<<" elements"<<endl;
+      return false;
+   }
+
+   //Strided view of every other row and column, sliced again
+   TSMatrixView<Matrix> strided( matrix, {0,1}, {3,4}, {2,2} );
+   TSMatrixView<Matrix> sliced = strided.slice( {1,1}, {2,2}, {1,2} );
+   int item = 0;
+   if(( !sliced.getItem( item, {1,0} ))||( item != 4*8 + 3 )) {
+      cout << "TSMatrixView<"<<name<<"> slice getItem = "<<item<<" not "<<4*8+3<<endl;
+      return false;
+   }
+   sliced.getItem( item, {0,1} );
+   if( item != 2*8 + 7 ) {
+      cout << "TSMatrixView<"<<name<<"> slice getItem = "<<item<<" not "<<2*8+7<<endl;
+      return false;
+   }
+
+   //Copy into a strided view and read back through the matrix
+   int ones[4] = { -1, -2, -3, -4 };
+   sliced.copyIn( ones, 4 );
+   matrix.getItem( item, {4,7} );
+   if( item != -4 ) {
+      cout << "TSMatrixView<"<<name<<"> copyIn wrote "<<item<<" not -4"<<endl;
+      return false;
+   }
+
+   //Regions outside of the matrix are invalid
+   TSMatrixView<Matrix> bad( matrix, {4,0}, {3,1} );
+   if( bad.isValid() ) {
+      cout << "TSMatrixView<"<<name<<"> accepted invalid region"<<endl;
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * \brief Unit test function for the TSMatrixView class
+ **/
+bool testTSMatrixView()
+{
+   if( !testTSMatrixViewLayout<RowMajorLayout>( "RowMajor" )) {
+      return false;
+   }
+   if( !testTSMatrixViewLayout<TiledLayout<4> >( "Tiled" )) {
+      return false;
+   }
+   if( !testTSMatrixViewLayout<MortonLayout>( "Morton" )) {
+      return false;
+   }
+
+   return true;
+}
@@ -0,0 +1,466 @@
+#pragma once
+#include <algorithm>
+#include <stdint.h>
+#include <iterator>
+#include "TSMatrix.tcc"
+
+namespace atl
+{
+   /**
+    * !\brief Lightweight view of a hyper-rectangular region of a TSMatrix
+    *
+    * A view references the storage of an existing TSMatrix and describes a region
+    * with an offset, an extent and a stride for each dimension. No data is copied
+    * when a view is created or sliced. The referenced matrix must outlive the view.
+    *
+    * View coordinates run from 0 to extent-1 in each dimension and map onto the
+    * matrix coordinate offset + coord*stride. Elements are visited in row-major
+    * order of the view by the iterator and the bulk copy functions.
+    **/
+   template <typename Matrix>
+   class TSMatrixView
+   {
+      public:
+         typedef typename Matrix::value_type  value_type;   //!< Element type of the view
+         typedef typename Matrix::layout_type layout_type;  //!< Layout of the referenced matrix
+
+         class Iterator;
+
+      private:
+         Matrix *            m_matrix = NULL;    //!< Referenced matrix
+         std::vector<size_t> m_offsets;          //!< First matrix coordinate of the view
+         std::vector<size_t> m_extents;          //!< Number of elements in each dimension
+         std::vector<size_t> m_strides;          //!< Matrix step between view elements
+         size_t              m_count = 0;        //!< Total number of elements in the view
+
+      public:
+         TSMatrixView() {};
+         TSMatrixView( Matrix &matrix );
+         TSMatrixView( Matrix &matrix
+                     , const std::vector<size_t> &offsets
+                     , const std::vector<size_t> &extents
+                     , const std::vector<size_t> &strides = std::vector<size_t>()
+                     );
+
+         bool   setRegion( Matrix &matrix
+                         , const std::vector<size_t> &offsets
+                         , const std::vector<size_t> &extents
+                         , const std::vector<size_t> &strides = std::vector<size_t>()
+                         );
+         bool   isValid() const { return m_matrix != NULL; };
+         std::vector<size_t> getDimensions() const { return m_extents; };
+         std::vector<size_t> getOffsets() const    { return m_offsets; };
+         std::vector<size_t> getStrides() const    { return m_strides; };
+         size_t getElementCount() const            { return m_count; };
+         Matrix * getMatrix() const                { return m_matrix; };
+
+         TSMatrixView<Matrix> slice( const std::vector<size_t> &offsets
+                                   , const std::vector<size_t> &extents
+                                   , const std::vector<size_t> &strides = std::vector<size_t>()
+                                   ) const;
+
+         bool   getItem( value_type &item, const std::vector<size_t> &coords );
+         bool   setItem( const value_type &item, const std::vector<size_t> &coords );
+         size_t copyOut( value_type * array, size_t count );
+         size_t copyIn( const value_type * array, size_t count );
+
+         size_t getRunLength() const;
+
+         template <typename F>
+         void   forEachRun( value_type * data, F fn, size_t begin = 0, size_t end = SIZE_MAX ) const;
+
+         Iterator begin();
+         Iterator end();
+   };
+
+   /**
+    * \brief Forward iterator over the elements of a view in row-major order
+    *
+    * Dereferencing returns a copy of the element. Each access locks the matrix,
+    * use copyOut for bulk access.
+    **/
+   template <typename Matrix>
+   class TSMatrixView<Matrix>::Iterator : public std::iterator<std::forward_iterator_tag, typename Matrix::value_type>
+   {
+      private:
+         TSMatrixView<Matrix> * m_view = NULL;   //!< View being iterated
+         std::vector<size_t>    m_coords;        //!< Current view coordinates
+         size_t                 m_index = 0;     //!< Linear index into the view
+
+      public:
+         Iterator( TSMatrixView<Matrix> * view, size_t index )
+            : m_view(view)
+            , m_coords(view->m_extents.size(), 0)
+            , m_index(index)
+         {};
+
+         /** \brief Returns the view coordinates of the current element **/
+         const std::vector<size_t> & getCoordinates() const { return m_coords; };
+
+         /** \brief Returns a copy of the current element **/
+         value_type operator *()
+         {
+            value_type item = value_type();
+            m_view->getItem( item, m_coords );
+            return item;
+         };
+
+         /** \brief Advances to the next element **/
+         Iterator & operator ++()
+         {
+            m_index++;
+            for( size_t d = m_coords.size(); d > 0; d-- ) {
+               if( ++m_coords[d-1] < m_view->m_extents[d-1] ) {
+                  break;
+               }
+               m_coords[d-1] = 0;
+            }
+            return *this;
+         };
+
+         bool operator ==( const Iterator &other ) const { return m_index == other.m_index; };
+         bool operator !=( const Iterator &other ) const { return m_index != other.m_index; };
+   };
+
+   /**
+    * \brief Creates a view of the entire matrix
+    *
+    * \param [in] matrix matrix to reference
+    **/
+   template <typename Matrix>
+   TSMatrixView<Matrix>::TSMatrixView( Matrix &matrix )
+   {
+      std::vector<size_t> dims = matrix.getDimensions();
+      setRegion( matrix, std::vector<size_t>( dims.size(), 0 ), dims );
+   }
+
+   /**
+    * \brief Creates a view of a region of the matrix
+    *
+    * \param [in] matrix matrix to reference
+    * \param [in] offsets first coordinate of the region
+    * \param [in] extents number of elements in each dimension
+    * \param [in] strides step between elements in each dimension (default=1)
+    **/
+   template <typename Matrix>
+   TSMatrixView<Matrix>::TSMatrixView( Matrix &matrix
+                                     , const std::vector<size_t> &offsets
+                                     , const std::vector<size_t> &extents
+                                     , const std::vector<size_t> &strides
+                                     )
+   {
+      setRegion( matrix, offsets, extents, strides );
+   }
+
+   /**
+    * \brief Sets the region of the matrix referenced by the view
+    *
+    * \param [in] matrix matrix to reference
+    * \param [in] offsets first coordinate of the region
+    * \param [in] extents number of elements in each dimension
+    * \param [in] strides step between elements in each dimension (default=1)
+    * \return true on success, false if the region does not fit in the matrix
+    *
+    * On failure the view is left invalid.
+    **/
+   template <typename Matrix>
+   bool TSMatrixView<Matrix>::setRegion( Matrix &matrix
+                                       , const std::vector<size_t> &offsets
+                                       , const std::vector<size_t> &extents
+                                       , const std::vector<size_t> &strides
+                                       )
+   {
+      m_matrix = NULL;
+      m_count  = 0;
+
+      std::vector<size_t> dims = matrix.getDimensions();
+      std::vector<size_t> steps = strides;
+      if( steps.size() == 0 ) {
+         steps.assign( dims.size(), 1 );
+      }
+
+      if(( dims.size() == 0 )
+       ||( offsets.size() != dims.size())
+       ||( extents.size() != dims.size())
+       ||( steps.size() != dims.size())) {
+         std::cerr << "TSMatrixView: region does not match matrix dimensions"<<std::endl;
+         return false;
+      }
+
+      size_t count = 1;
+      for( size_t i = 0; i < dims.size(); i++ ) {
+         if(( extents[i] == 0 )||( steps[i] == 0 )
+          ||( offsets[i] + (extents[i]-1)*steps[i] >= dims[i] )) {
+            std::cerr << "TSMatrixView: region exceeds matrix dimension "<<i<<std::endl;
+            return false;
+         }
+         count *= extents[i];
+      }
+
+      m_offsets = offsets;
+      m_extents = extents;
+      m_strides = steps;
+      m_count   = count;
+      m_matrix  = &matrix;
+
+      return true;
+   }
+
+   /**
+    * \brief Creates a view of a region of this view
+    *
+    * \param [in] offsets first view coordinate of the region
+    * \param [in] extents number of elements in each dimension
+    * \param [in] strides step between view elements in each dimension (default=1)
+    * \return new view. The view is invalid if the region does not fit
+    **/
+   template <typename Matrix>
+   TSMatrixView<Matrix> TSMatrixView<Matrix>::slice( const std::vector<size_t> &offsets
+                                                   , const std::vector<size_t> &extents
+                                                   , const std::vector<size_t> &strides
+                                                   ) const
+   {
+      TSMatrixView<Matrix> view;
+
+      std::vector<size_t> steps = strides;
+      if( steps.size() == 0 ) {
+         steps.assign( m_extents.size(), 1 );
+      }
+
+      if(( !isValid() )
+       ||( offsets.size() != m_extents.size())
+       ||( extents.size() != m_extents.size())
+       ||( steps.size() != m_extents.size())) {
+         std::cerr << "TSMatrixView::slice region does not match view dimensions"<<std::endl;
+         return view;
+      }
+
+      std::vector<size_t> matrixOffsets( m_extents.size() );
+      std::vector<size_t> matrixStrides( m_extents.size() );
+      for( size_t i = 0; i < m_extents.size(); i++ ) {
+         if(( extents[i] == 0 )||( steps[i] == 0 )
+          ||( offsets[i] + (extents[i]-1)*steps[i] >= m_extents[i] )) {
+            std::cerr << "TSMatrixView::slice region exceeds view dimension "<<i<<std::endl;
+            return view;
+         }
+         matrixOffsets[i] = m_offsets[i] + offsets[i]*m_strides[i];
+         matrixStrides[i] = m_strides[i]*steps[i];
+      }
+
+      view.setRegion( *m_matrix, matrixOffsets, extents, matrixStrides );
+      return view;
+   }
+
+   /**
+    * \brief Gets the item at the specified view coordinates
+    *
+    * \param [out] item reference to the element to fill
+    * \param [in] coords view coordinates of the item
+    * \return true on success, false on failure
+    **/
+   template <typename Matrix>
+   bool TSMatrixView<Matrix>::getItem( value_type &item, const std::vector<size_t> &coords )
+   {
+      if(( !isValid() )||( coords.size() != m_extents.size())) {
+         return false;
+      }
+
+      std::vector<size_t> matrixCoords( coords.size() );
+      for( size_t i = 0; i < coords.size(); i++ ) {
+         if( coords[i] >= m_extents[i] ) {
+            return false;
+         }
+         matrixCoords[i] = m_offsets[i] + coords[i]*m_strides[i];
+      }
+
+      return m_matrix->getItem( item, matrixCoords );
+   }
+
+   /**
+    * \brief Sets the item at the specified view coordinates
+    *
+    * \param [in] item value to set
+    * \param [in] coords view coordinates of the item
+    * \return true on success, false on failure
+    **/
+   template <typename Matrix>
+   bool TSMatrixView<Matrix>::setItem( const value_type &item, const std::vector<size_t> &coords )
+   {
+      if(( !isValid() )||( coords.size() != m_extents.size())) {
+         return false;
+      }
+
+      std::vector<size_t> matrixCoords( coords.size() );
+      for( size_t i = 0; i < coords.size(); i++ ) {
+         if( coords[i] >= m_extents[i] ) {
+            return false;
+         }
+         matrixCoords[i] = m_offsets[i] + coords[i]*m_strides[i];
+      }
+
+      return m_matrix->setItem( item, matrixCoords );
+   }
+
+   /**
+    * \brief Returns the number of elements visited per call by forEachRun
+    *
+    * Row-major matrices are visited one view row at a time, other layouts
+    * one element at a time.
+    **/
+   template <typename Matrix>
+   size_t TSMatrixView<Matrix>::getRunLength() const
+   {
+      if(( !isValid() )||( !layout_type::isRowMajor )) {
+         return 1;
+      }
+      return m_extents[m_extents.size()-1];
+   }
+
+   /**
+    * \brief Calls a function for each run of elements along the last view dimension
+    *
+    * \param [in] data pointer to the matrix storage (from Matrix::lockBuffer)
+    * \param [in] fn function called as fn( first, count, step, index )
+    * \param [in] begin linear view index to start from (multiple of getRunLength)
+    * \param [in] end linear view index to stop at (default = all elements)
+    *
+    * For row-major matrices each call covers a full row of the view, where
+    * first points to the first element, count is the number of elements, step is
+    * the storage distance between them and index is the linear view index of the
+    * first element. Other layouts are visited one element at a time.
+    *
+    * The caller is responsible for holding the matrix lock.
+    **/
+   template <typename Matrix>
+   template <typename F>
+   void TSMatrixView<Matrix>::forEachRun( value_type * data, F fn, size_t begin, size_t end ) const
+   {
+      if(( !isValid() )||( data == NULL )) {
+         return;
+      }
+
+      const size_t dims  = m_extents.size();
+      const size_t last  = dims-1;
+      const bool rowRuns = layout_type::isRowMajor;
+      const size_t runLength = getRunLength();
+
+      if( end > m_count ) {
+         end = m_count;
+      }
+
+      //Convert the starting index into view and matrix coordinates
+      std::vector<size_t> coords( dims, 0 );
+      std::vector<size_t> matrixCoords( dims, 0 );
+      size_t remainder = begin;
+      for( size_t d = dims; d > 0; d-- ) {
+         coords[d-1] = remainder % m_extents[d-1];
+         remainder  /= m_extents[d-1];
+         matrixCoords[d-1] = m_offsets[d-1] + coords[d-1]*m_strides[d-1];
+      }
+
+      for( size_t index = begin; index < end; index += runLength ) {
+         fn( &data[m_matrix->calculateOffset( matrixCoords.data() )]
+           , runLength
+           , m_strides[last]
+           , index
+           );
+
+         //Advance to the next run
+         for( size_t d = rowRuns ? last : dims; d > 0; d-- ) {
+            if( ++coords[d-1] < m_extents[d-1] ) {
+               matrixCoords[d-1] = m_offsets[d-1] + coords[d-1]*m_strides[d-1];
+               break;
+            }
+            coords[d-1] = 0;
+            matrixCoords[d-1] = m_offsets[d-1];
+         }
+      }
+   }
+
+   /**
+    * \brief Copies the elements of the view into an array
+    *
+    * \param [out] array destination array
+    * \param [in] count number of elements available in the destination array
+    * \return number of elements copied (0 if count is smaller than the view)
+    *
+    * Elements are written in row-major view order under a single matrix lock.
+    **/
+   template <typename Matrix>
+   size_t TSMatrixView<Matrix>::copyOut( value_type * array, size_t count )
+   {
+      if(( !isValid() )||( array == NULL )||( count < m_count )) {
+         std::cerr << "TSMatrixView::copyOut invalid view or destination too small"<<std::endl;
+         return 0;
+      }
+
+      value_type * data = m_matrix->lockBuffer();
+      forEachRun( data, [array]( value_type * first, size_t n, size_t step, size_t index ) {
+         value_type * dest = &array[index];
+         if( step == 1 ) {
+            std::copy( first, first+n, dest );
+         }
+         else {
+            for( size_t i = 0; i < n; i++ ) {
+               dest[i] = first[i*step];
+            }
+         }
+      });
+      m_matrix->unlockBuffer();
+
+      return m_count;
+   }
+
+   /**
+    * \brief Copies an array into the elements of the view
+    *
+    * \param [in] array source array in row-major view order
+    * \param [in] count number of elements in the source array
+    * \return number of elements copied (0 if count is smaller than the view)
+    **/
+   template <typename Matrix>
+   size_t TSMatrixView<Matrix>::copyIn( const value_type * array, size_t count )
+   {
+      if(( !isValid() )||( array == NULL )||( count < m_count )) {
+         std::cerr << "TSMatrixView::copyIn invalid view or source too small"<<std::endl;
+         return 0;
+      }
+
+      value_type * data = m_matrix->lockBuffer();
+      forEachRun( data, [array]( value_type * first, size_t n, size_t step, size_t index ) {
+         const value_type * src = &array[index];
+         if( step == 1 ) {
+            std::copy( src, src+n, first );
+         }
+         else {
+            for( size_t i = 0; i < n; i++ ) {
+               first[i*step] = src[i];
+            }
+         }
+      });
+      m_matrix->unlockBuffer();
+
+      return m_count;
+   }
+
+   /**
+    * \brief Returns an iterator to the first element of the view
+    **/
+   template <typename Matrix>
+   typename TSMatrixView<Matrix>::Iterator TSMatrixView<Matrix>::begin()
+   {
+      return Iterator( this, 0 );
+   }
+
+   /**
+    * \brief Returns an iterator past the last element of the view
+    **/
+   template <typename Matrix>
+   typename TSMatrixView<Matrix>::Iterator TSMatrixView<Matrix>::end()
+   {
+      return Iterator( this, m_count );
+   }
+}
+
+//Test functionality
+bool testTSMatrixView();
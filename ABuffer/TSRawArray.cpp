@@ -0,0 +1,117 @@
+#include <iostream>
+#include <thread>
+#include <cstdio>
+#include <stdint.h>
+#include <unistd.h>
+#include "TSRawArray.tcc"
+
+using namespace std;
+using namespace atl;
+
+/**
+ * \brief Unit test for the TSRawArray class
+ **/
+bool testTSRawArray()
+{
+   TSRawArray<float> array;
+   if( array.getSize() != 0 ) {
+      cout << "TSRawArray size = "<<array.getSize()<<" not 0!"<<endl;
+      return false;
+   }
+
+   //Grow by push_back and verify the contents survive reallocation
+   const size_t count = 1000;
+   for( size_t i = 0; i < count; i++ ) {
+      if( array.push_back( (float)i ) != i+1 ) {
+         cout << "TSRawArray push_back failed at "<<i<<endl;
+         return false;
+      }
+   }
+
+   float value = 0;
+   if(( !array.getItem( &value, 999 ))||( value != 999.0f )) {
+      cout << "TSRawArray value = "<<value<<" not 999"<<endl;
+      return false;
+   }
+   if( array.getItem( &value, count )) {
+      cout << "TSRawArray getItem past the end did not fail"<<endl;
+      return false;
+   }
+
+   //Bulk processing through a span on aligned storage
+   {
+      TSRawArray<float>::Span span = array.getSpan();
+      if( (uintptr_t)span.data() % TSRAWARRAY_ALIGNMENT != 0 ) {
+         cout << "TSRawArray storage is not aligned"<<endl;
+         return false;
+      }
+      if( span.size() != count ) {
+         cout << "TSRawArray span size = "<<span.size()<<" not "<<count<<endl;
+         return false;
+      }
+      for( float * it = span.begin(); it != span.end(); it++ ) {
+         *it *= 2.0f;
+      }
+   }
+
+   //The span released the lock, so another thread can access the array
+   std::thread t( [&array]() { array.setItem( -1.0f, 0 ); } );
+   t.join();
+
+   array.getItem( &value, 10 );
+   if( value != 20.0f ) {
+      cout << "TSRawArray span update value = "<<value<<" not 20"<<endl;
+      return false;
+   }
+
+   //Growing with setSize zero initializes the new elements
+   array.setSize( count + 10 );
+   array.getItem( &value, count + 5 );
+   if( value != 0.0f ) {
+      cout << "TSRawArray setSize did not clear new elements"<<endl;
+      return false;
+   }
+
+   //The buffer shares the storage with the array
+   BaseBuffer buffer = array.getBuffer();
+   if(( buffer.getSize() != ( count + 10 ) * sizeof(float))
+    ||( ((float *)buffer.m_buffer.get())[0] != -1.0f )) {
+      cout << "TSRawArray getBuffer returned wrong data"<<endl;
+      return false;
+   }
+
+   //Round trip through a file descriptor
+   FILE * fptr = tmpfile();
+   if( fptr == NULL ) {
+      cout << "TSRawArray unable to create temporary file"<<endl;
+      return false;
+   }
+   int fd = fileno( fptr );
+
+   if( !array.write( fd )) {
+      fclose( fptr );
+      return false;
+   }
+
+   TSRawArray<float> copy;
+   lseek( fd, 0, SEEK_SET );
+   bool rc = copy.read( fd, count + 10 );
+   fclose( fptr );
+   if(( !rc )||( copy.getSize() != count + 10 )) {
+      cout << "TSRawArray read failed"<<endl;
+      return false;
+   }
+
+   for( size_t i = 0; i < count + 10; i++ ) {
+      float a = 0;
+      float b = 0;
+      array.getItem( &a, i );
+      copy.getItem( &b, i );
+      if( a != b ) {
+         cout << "TSRawArray read value "<<b<<" != "<<a<<" at "<<i<<endl;
+         return false;
+      }
+   }
+
+   return true;
+}
@@ -0,0 +1,345 @@
+#pragma once
+#include <iostream>
+#include <mutex>
+#include <type_traits>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+
+#include "ExtendedBuffer.tcc"
+
+#define TSRAWARRAY_ALIGNMENT 64           //!< Default alignment of the storage (one cache line)
+
+namespace atl
+{
+   /**
+    * !\brief Thread-safe contiguous array of POD elements in raw aligned storage
+    *
+    * This class provides the TSArray interface for plain-old-data types, but
+    * stores the elements in an aligned ExtendedBuffer instead of a std::vector.
+    * The storage can be processed in bulk through a Span, which holds the array
+    * lock for its lifetime, and can be written to or read from a file or socket
+    * descriptor without per-element copies.
+    **/
+   template <typename T>
+   class TSRawArray
+   {
+      static_assert( std::is_pod<T>::value, "TSRawArray requires a POD element type" );
+
+      private:
+         std::mutex        m_mutex;              //!< mutex to ensure thread-safe operation
+         ExtendedBuffer<T> m_buffer;             //!< Raw element storage
+         size_t            m_size = 0;           //!< Number of elements in use
+
+         bool reserve( size_t size );
+
+      public:
+         /**
+          * !\brief Lock-protected view of the contiguous storage
+          *
+          * The array is locked while the span exists. The span must not outlive
+          * the array and the array must not be accessed through its other member
+          * functions by the same thread while the span exists.
+          **/
+         class Span
+         {
+            private:
+               std::unique_lock<std::mutex> m_lock;   //!< Lock on the array
+               T *                          m_data;   //!< First element
+               size_t                       m_size;   //!< Number of elements
+
+            public:
+               /** \brief Constructor. Locks the array **/
+               Span( TSRawArray<T> & array )
+                  : m_lock( array.m_mutex )
+                  , m_data( (T *)array.m_buffer.m_buffer.get() )
+                  , m_size( array.m_size ) {};
+               /** \brief Move constructor. Transfers the lock **/
+               Span( Span && span )
+                  : m_lock( std::move( span.m_lock )), m_data( span.m_data ), m_size( span.m_size ) {};
+
+               T *    data()  { return m_data; };
+               size_t size()  { return m_size; };
+               T *    begin() { return m_data; };
+               T *    end()   { return m_data + m_size; };
+
+               T   operator [](size_t index) const { return m_data[index]; };
+               T & operator [](size_t index)       { return m_data[index]; };
+         };
+
+         TSRawArray( size_t alignment = TSRAWARRAY_ALIGNMENT );
+
+         bool   setSize( size_t size );
+         size_t getSize();
+         bool   setItem( T item, size_t index );
+         bool   getItem( T* itemPtr, size_t index );
+         size_t push_back( T item );
+         T *    lockBuffer();
+         void   unlockBuffer();
+         Span   getSpan();
+
+         BaseBuffer getBuffer();
+         bool       write( int fd );
+         bool       read( int fd, size_t count );
+   };
+
+   /**
+    * \brief Constructor
+    *
+    * \param [in] alignment alignment of the storage in bytes
+    **/
+   template <typename T>
+   TSRawArray<T>::TSRawArray( size_t alignment )
+   {
+      m_buffer.setAlignment( alignment );
+   }
+
+   /**
+    * \brief Makes sure the storage holds at least size elements
+    *
+    * Must be called with the mutex held. Capacity grows geometrically so that
+    * repeated push_back calls are amortized.
+    **/
+   template <typename T>
+   bool TSRawArray<T>::reserve( size_t size )
+   {
+      size_t capacity = m_buffer.getCapacity();
+      if( size <= capacity ) {
+         return true;
+      }
+
+      if( size < 2 * capacity ) {
+         size = 2 * capacity;
+      }
+
+      return m_buffer.allocate( size, true );
+   }
+
+   /**
+    * \brief Sets the number of elements in the array
+    *
+    * \param [in] size new number of elements
+    * \return true on success, false on failure
+    *
+    * Elements added by growing the array are zero initialized.
+    **/
+   template <typename T>
+   bool TSRawArray<T>::setSize( size_t size )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+
+      if( !reserve( size )) {
+         return false;
+      }
+
+      if( size > m_size ) {
+         T * data = (T *)m_buffer.m_buffer.get();
+         memset( data + m_size, 0, ( size - m_size ) * sizeof(T));
+      }
+
+      m_size = size;
+      return true;
+   }
+
+   /**
+    * \brief Returns the number of elements in the array
+    **/
+   template <typename T>
+   size_t TSRawArray<T>::getSize()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      return m_size;
+   }
+
+   /**
+    * \brief sets the item at the specified index
+    *
+    * \param [in] item item to assign
+    * \param [in] index array index to set
+    * \return true on success, false on failure
+    **/
+   template <typename T>
+   bool TSRawArray<T>::setItem( T item, size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( index >= m_size ) {
+         std::cerr << "TSRawArray index exceeds array size"<<std::endl;
+         return false;
+      }
+
+      m_buffer[index] = item;
+      return true;
+   }
+
+   /**
+    * \brief gets the item at the specified index
+    *
+    * \param [in] itemPtr pointer to an element to set
+    * \param [in] index array index to get data element from
+    * \return true on success, false on failure
+    **/
+   template <typename T>
+   bool TSRawArray<T>::getItem( T * itemPtr, size_t index )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( index >= m_size ) {
+         std::cerr << "TSRawArray index exceeds array size"<<std::endl;
+         return false;
+      }
+
+      *itemPtr = m_buffer[index];
+      return true;
+   }
+
+   /**
+    * \brief appends the specified item to the end of the array
+    * \param [in] item new item to push onto the array
+    * \return number of elements in the array, 0 on failure
+    **/
+   template <typename T>
+   size_t TSRawArray<T>::push_back( T item )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( !reserve( m_size + 1 )) {
+         return 0;
+      }
+
+      m_buffer[m_size] = item;
+      m_size++;
+
+      return m_size;
+   }
+
+   /**
+    * \brief Locks the array and returns a pointer to the contiguous storage
+    * \return pointer to the first element (NULL if the array is empty)
+    *
+    * The array remains locked until unlockBuffer is called. getSpan provides the
+    * same access with the lock released automatically.
+    **/
+   template <typename T>
+   T * TSRawArray<T>::lockBuffer()
+   {
+      m_mutex.lock();
+      if( m_size == 0 ) {
+         return NULL;
+      }
+      return (T *)m_buffer.m_buffer.get();
+   }
+
+   /**
+    * \brief Releases the lock acquired by lockBuffer
+    **/
+   template <typename T>
+   void TSRawArray<T>::unlockBuffer()
+   {
+      m_mutex.unlock();
+   }
+
+   /**
+    * \brief Returns a locked span over the elements of the array
+    *
+    * The storage is aligned to the alignment given to the constructor, which
+    * allows aligned vector loads and stores over the span.
+    **/
+   template <typename T>
+   typename TSRawArray<T>::Span TSRawArray<T>::getSpan()
+   {
+      return Span( *this );
+   }
+
+   /**
+    * \brief Returns a BaseBuffer that references the elements of the array
+    *
+    * The returned buffer shares the storage with the array (no copy is made)
+    * and can be passed to the socket interfaces. The contents are only stable
+    * while the array is not modified.
+    **/
+   template <typename T>
+   BaseBuffer TSRawArray<T>::getBuffer()
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+
+      BaseBuffer buffer;
+      buffer.m_buffer     = m_buffer.m_buffer;
+      buffer.m_bufferSize = m_size * sizeof(T);
+
+      return buffer;
+   }
+
+   /**
+    * \brief Writes the raw elements to a file or socket descriptor
+    *
+    * \param [in] fd descriptor to write to
+    * \return true on success, false on failure
+    *
+    * The elements are written in host byte order directly from the storage.
+    **/
+   template <typename T>
+   bool TSRawArray<T>::write( int fd )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+
+      const uint8_t * data  = m_buffer.m_buffer.get();
+      size_t          bytes = m_size * sizeof(T);
+      while( bytes > 0 ) {
+         ssize_t rc = ::write( fd, data, bytes );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            std::cerr << "TSRawArray write failed: "<<strerror(errno)<<std::endl;
+            return false;
+         }
+         data  += rc;
+         bytes -= rc;
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Replaces the contents with raw elements read from a descriptor
+    *
+    * \param [in] fd descriptor to read from
+    * \param [in] count number of elements to read
+    * \return true on success, false on failure or end of file
+    *
+    * The data is read directly into the storage.
+    **/
+   template <typename T>
+   bool TSRawArray<T>::read( int fd, size_t count )
+   {
+      std::lock_guard<std::mutex> guard( m_mutex );
+      if( !reserve( count )) {
+         return false;
+      }
+
+      uint8_t * data  = m_buffer.m_buffer.get();
+      size_t    bytes = count * sizeof(T);
+      while( bytes > 0 ) {
+         ssize_t rc = ::read( fd, data, bytes );
+         if( rc < 0 ) {
+            if( errno == EINTR ) {
+               continue;
+            }
+            std::cerr << "TSRawArray read failed: "<<strerror(errno)<<std::endl;
+            m_size = 0;
+            return false;
+         }
+         if( rc == 0 ) {
+            std::cerr << "TSRawArray read reached end of file"<<std::endl;
+            m_size = 0;
+            return false;
+         }
+         data  += rc;
+         bytes -= rc;
+      }
+
+      m_size = count;
+      return true;
+   }
+}
+
+//Test functionality
+bool testTSRawArray();
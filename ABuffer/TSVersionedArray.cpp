@@ -0,0 +1,107 @@
+#include <iostream>
+#include <thread>
+#include "TSVersionedArray.tcc"
+
+using namespace std;
+using namespace atl;
+
+const size_t TSVAReaderCount = 8;
+const size_t TSVAVersions    = 200;
+const size_t TSVASize        = 64;
+
+/**
+ * \brief Reader thread that verifies every snapshot is internally consistent
+ **/
+void TSVAReaderThread( TSVersionedArray<uint64_t> * array, std::atomic<bool> * running, std::atomic<bool> * failed )
+{
+   uint64_t lastVersion = 0;
+   while( *running ) {
+      uint64_t version = 0;
+      TSVersionedArray<uint64_t>::Snapshot snapshot = array->getSnapshot( &version );
+
+      //Versions never go backwards and all elements of a version hold its number
+      if( version < lastVersion ) {
+         *failed = true;
+      }
+      lastVersion = version;
+      for( size_t i = 0; i < snapshot->size(); i++ ) {
+         if( (*snapshot)[i] != version ) {
+            *failed = true;
+         }
+      }
+   }
+}
+
+/**
+ * \brief Unit test function for the TSVersionedArray class
+ **/
+bool testTSVersionedArray()
+{
+   TSVersionedArray<uint64_t> array;
+   if(( array.getVersion() != 0 )||( array.getSize() != 0 )) {
+      cout << "TSVersionedArray initial version/size not 0"<<endl;
+      return false;
+   }
+
+   uint64_t version = array.publish( std::vector<uint64_t>( TSVASize, 1 ));
+   if( version != 1 ) {
+      cout << "TSVersionedArray publish returned version "<<version<<" not 1"<<endl;
+      return false;
+   }
+
+   //A snapshot must not change when a new version is published
+   TSVersionedArray<uint64_t>::Snapshot snapshot = array.getSnapshot();
+   std::weak_ptr<const std::vector<uint64_t> > weak = snapshot;
+   array.update( []( std::vector<uint64_t> &values ) {
+      for( size_t i = 0; i < values.size(); i++ ) {
+         values[i] = 2;
+      }
+   });
+
+   uint64_t item = 0;
+   array.getItem( &item, 10 );
+   if(( (*snapshot)[10] != 1 )||( item != 2 )) {
+      cout << "TSVersionedArray snapshot "<<(*snapshot)[10]<<" current "<<item<<endl;
+      return false;
+   }
+
+   //The old version is reclaimed once the last reader lets go
+   if( weak.expired() ) {
+      cout << "TSVersionedArray released a version still in use"<<endl;
+      return false;
+   }
+   snapshot.reset();
+   if( !weak.expired() ) {
+      cout << "TSVersionedArray did not reclaim an unused version"<<endl;
+      return false;
+   }
+
+   //Concurrent readers while versions are published
+   std::atomic<bool> running( true );
+   std::atomic<bool> failed( false );
+   std::thread readers[TSVAReaderCount];
+   for( size_t i = 0; i < TSVAReaderCount; i++ ) {
+      readers[i] = std::thread( TSVAReaderThread, &array, &running, &failed );
+   }
+
+   for( size_t v = 3; v < TSVAVersions; v++ ) {
+      array.publish( std::vector<uint64_t>( TSVASize, v ));
+   }
+
+   running = false;
+   for( size_t i = 0; i < TSVAReaderCount; i++ ) {
+      readers[i].join();
+   }
+
+   if( failed ) {
+      cout << "TSVersionedArray reader saw an inconsistent snapshot"<<endl;
+      return false;
+   }
+
+   if( array.getVersion() != TSVAVersions - 1 ) {
+      cout << "TSVersionedArray final version "<<array.getVersion()<<" not "<<TSVAVersions-1<<endl;
+      return false;
+   }
+
+   return true;
+}
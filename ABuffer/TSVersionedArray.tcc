@@ -0,0 +1,251 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+
+namespace atl
+{
+   /**
+    * !\brief Versioned array with lock-free snapshot reads (RCU-style)
+    *
+    * This class is intended for tables that are read very frequently and replaced
+    * wholesale only occasionally. Writers build a complete new array and publish it
+    * as a new immutable version. Readers obtain a shared_ptr snapshot of the
+    * current version without taking a lock; the snapshot remains valid and
+    * unchanged for as long as the reader holds it. A version is freed when the
+    * last snapshot referencing it is released.
+    *
+    * The read path only uses atomic counters. Publishing waits for a grace period
+    * (all readers that may have seen the previous version have finished copying
+    * their snapshot) before dropping the reference to the previous version.
+    **/
+   template <typename T>
+   class TSVersionedArray
+   {
+      public:
+         typedef std::shared_ptr<const std::vector<T> > Snapshot;   //!< Immutable view of one version
+
+      private:
+         /** \brief One published version of the array **/
+         struct Version
+         {
+            uint64_t       m_version;            //!< Version number
+            std::vector<T> m_array;              //!< Array contents
+         };
+         typedef std::shared_ptr<const Version> VersionPtr;
+
+         /** \brief Reader counter padded to its own cache line **/
+         struct ReaderCount
+         {
+            std::atomic<size_t> m_count;         //!< Number of readers in the critical section
+            char                m_pad[64 - sizeof(std::atomic<size_t>)];  //!< Padding
+         };
+
+         std::mutex                m_writeMutex; //!< Serializes writers
+         std::atomic<VersionPtr *> m_current;    //!< Owner of the current version
+         std::atomic<size_t>       m_epoch;      //!< Selects the reader counter to use
+         mutable ReaderCount       m_readers[2]; //!< Reader counters for each epoch
+
+         VersionPtr acquire() const;
+         void       synchronize();
+         uint64_t   install( std::shared_ptr<Version> version );
+
+      public:
+         TSVersionedArray();
+         ~TSVersionedArray();
+
+         Snapshot getSnapshot( uint64_t * version = NULL ) const;
+         uint64_t getVersion() const;
+         size_t   getSize() const;
+         bool     getItem( T * itemPtr, size_t index ) const;
+
+         uint64_t publish( std::vector<T> array );
+         template <typename F>
+         uint64_t update( F fn );
+   };
+
+   /**
+    * \brief Constructor. Publishes an empty array as version 0
+    **/
+   template <typename T>
+   TSVersionedArray<T>::TSVersionedArray()
+   {
+      std::shared_ptr<Version> version = std::make_shared<Version>();
+      version->m_version = 0;
+
+      m_current.store( new VersionPtr( version ));
+      m_epoch.store( 0 );
+      m_readers[0].m_count.store( 0 );
+      m_readers[1].m_count.store( 0 );
+   }
+
+   /**
+    * \brief Destructor. Outstanding snapshots remain valid.
+    **/
+   template <typename T>
+   TSVersionedArray<T>::~TSVersionedArray()
+   {
+      delete m_current.load();
+   }
+
+   /**
+    * \brief Obtains a reference to the current version
+    *
+    * The reader registers in the counter of the current epoch while it copies the
+    * owning shared_ptr so that the writer does not release it in the meantime.
+    **/
+   template <typename T>
+   typename TSVersionedArray<T>::VersionPtr TSVersionedArray<T>::acquire() const
+   {
+      ReaderCount & readers = m_readers[m_epoch.load() & 1];
+
+      readers.m_count.fetch_add( 1 );
+      VersionPtr version = *m_current.load();
+      readers.m_count.fetch_sub( 1 );
+
+      return version;
+   }
+
+   /**
+    * \brief Waits until no reader can still be copying a previous version
+    *
+    * Two epoch flips are required since a reader may have sampled the epoch just
+    * before the first flip and registered in the other counter.
+    **/
+   template <typename T>
+   void TSVersionedArray<T>::synchronize()
+   {
+      for( int phase = 0; phase < 2; phase++ ) {
+         size_t previous = m_epoch.fetch_add( 1 ) & 1;
+         while( m_readers[previous].m_count.load() != 0 ) {
+            std::this_thread::yield();
+         }
+      }
+   }
+
+   /**
+    * \brief Makes a new version current and releases the previous one
+    *
+    * \param [in] version new version. The version number is assigned here
+    * \return version number of the new version
+    *
+    * Must be called with the write mutex held.
+    **/
+   template <typename T>
+   uint64_t TSVersionedArray<T>::install( std::shared_ptr<Version> version )
+   {
+      VersionPtr * previous = m_current.load();
+      version->m_version = (*previous)->m_version + 1;
+
+      m_current.store( new VersionPtr( version ));
+      synchronize();
+      delete previous;
+
+      return version->m_version;
+   }
+
+   /**
+    * \brief Returns a snapshot of the current version
+    *
+    * \param [out] version optional pointer that receives the snapshot version number
+    * \return shared pointer to the immutable array
+    **/
+   template <typename T>
+   typename TSVersionedArray<T>::Snapshot TSVersionedArray<T>::getSnapshot( uint64_t * version ) const
+   {
+      VersionPtr current = acquire();
+      if( version != NULL ) {
+         *version = current->m_version;
+      }
+
+      //Alias the array so the caller holds a reference to the whole version
+      return Snapshot( current, &current->m_array );
+   }
+
+   /**
+    * \brief Returns the current version number
+    **/
+   template <typename T>
+   uint64_t TSVersionedArray<T>::getVersion() const
+   {
+      return acquire()->m_version;
+   }
+
+   /**
+    * \brief Returns the number of elements in the current version
+    **/
+   template <typename T>
+   size_t TSVersionedArray<T>::getSize() const
+   {
+      return acquire()->m_array.size();
+   }
+
+   /**
+    * \brief gets the item at the specified index of the current version
+    *
+    * \param [in] itemPtr pointer to an element to set
+    * \param [in] index array index to get data element from
+    * \return true on success, false on failure
+    **/
+   template <typename T>
+   bool TSVersionedArray<T>::getItem( T * itemPtr, size_t index ) const
+   {
+      VersionPtr current = acquire();
+      if( index >= current->m_array.size() ) {
+         std::cerr << "TSVersionedArray index size exceeds array size"<<std::endl;
+         return false;
+      }
+
+      *itemPtr = current->m_array[index];
+      return true;
+   }
+
+   /**
+    * \brief Publishes a new version of the array
+    *
+    * \param [in] array contents of the new version
+    * \return version number of the published array
+    *
+    * The previous version is released once all readers that may have obtained it
+    * have finished copying their snapshot. It is freed when the last snapshot is
+    * released.
+    **/
+   template <typename T>
+   uint64_t TSVersionedArray<T>::publish( std::vector<T> array )
+   {
+      std::lock_guard<std::mutex> guard( m_writeMutex );
+
+      std::shared_ptr<Version> version = std::make_shared<Version>();
+      version->m_array.swap( array );
+
+      return install( version );
+   }
+
+   /**
+    * \brief Copies the current version, modifies it and publishes the result
+    *
+    * \param [in] fn function called as fn( std::vector<T> & ) on the copy
+    * \return version number of the published array
+    *
+    * Concurrent calls to update are serialized so no modification is lost.
+    **/
+   template <typename T>
+   template <typename F>
+   uint64_t TSVersionedArray<T>::update( F fn )
+   {
+      std::lock_guard<std::mutex> guard( m_writeMutex );
+
+      std::shared_ptr<Version> version = std::make_shared<Version>();
+      version->m_array = (*m_current.load())->m_array;
+      fn( version->m_array );
+
+      return install( version );
+   }
+}
+
+//Test functionality
+bool testTSVersionedArray();
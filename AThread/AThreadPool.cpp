@@ -0,0 +1,253 @@
+//******************************************************************************
+// A fixed-size pool of worker threads
+//
+//******************************************************************************
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "AThreadPool.h"
+
+using namespace std;
+namespace atl
+{
+   /**
+    * \brief Constructor
+    *
+    * \param [in] threadCount number of workers to create (0 = one per hardware thread)
+    **/
+   AThreadPool::AThreadPool( size_t threadCount )
+   {
+      if( threadCount == 0 ) {
+         threadCount = std::thread::hardware_concurrency();
+      }
+      if( threadCount == 0 ) {
+         threadCount = 1;
+      }
+
+      for( size_t i = 0; i < threadCount; i++ ) {
+         m_threads.push_back( std::thread( &AThreadPool::workerLoop, this ));
+      }
+   }
+
+   /**
+    * \brief Destructor
+    *
+    * Finishes all queued tasks and joins the workers
+    **/
+   AThreadPool::~AThreadPool()
+   {
+      {
+         std::lock_guard<std::mutex> guard( m_mutex );
+         m_running = false;
+      }
+      m_taskCv.notify_all();
+
+      for( size_t i = 0; i < m_threads.size(); i++ ) {
+         m_threads[i].join();
+      }
+   }
+
+   /**
+    * \brief Worker thread processing loop
+    **/
+   void AThreadPool::workerLoop()
+   {
+      while( true ) {
+         std::function<void()> task;
+         {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            while( m_running && m_tasks.empty() ) {
+               m_taskCv.wait( lock );
+            }
+
+            if( m_tasks.empty() ) {
+               return;
+            }
+
+            task = std::move( m_tasks.front() );
+            m_tasks.pop_front();
+         }
+
+         task();
+
+         {
+            std::lock_guard<std::mutex> guard( m_mutex );
+            m_active--;
+         }
+         m_doneCv.notify_all();
+      }
+   }
+
+   /**
+    * \brief Returns the number of worker threads
+    **/
+   size_t AThreadPool::getThreadCount()
+   {
+      return m_threads.size();
+   }
+
+   /**
+    * \brief Queues a task for execution
+    *
+    * \param [in] task function to execute
+    * \return true on success, false if the pool is shutting down
+    **/
+   bool AThreadPool::submit( std::function<void()> task )
+   {
+      {
+         std::lock_guard<std::mutex> guard( m_mutex );
+         if( !m_running ) {
+            return false;
+         }
+         m_tasks.push_back( std::move( task ));
+         m_active++;
+      }
+      m_taskCv.notify_one();
+      return true;
+   }
+
+   /**
+    * \brief Waits until all submitted tasks have completed
+    **/
+   void AThreadPool::wait()
+   {
+      std::unique_lock<std::mutex> lock( m_mutex );
+      while( m_active > 0 ) {
+         m_doneCv.wait( lock );
+      }
+   }
+
+   /**
+    * \brief Processes the range [0, count) in blocks across the workers
+    *
+    * \param [in] count number of items to process
+    * \param [in] blockSize number of items per block (0 = split evenly over the workers)
+    * \param [in] fn function called as fn( begin, end ) for each block
+    *
+    * This function returns once all blocks have been processed. Ranges that fit
+    * in a single block, or pools with a single worker, are processed block by
+    * block on the calling thread. So are blocks that cannot be submitted
+    * because the pool is shutting down.
+    **/
+   void AThreadPool::parallelFor( size_t count
+                                , size_t blockSize
+                                , std::function<void(size_t begin, size_t end)> fn
+                                )
+   {
+      if( count == 0 ) {
+         return;
+      }
+
+      if( blockSize == 0 ) {
+         blockSize = ( count + m_threads.size() - 1 ) / m_threads.size();
+      }
+
+      size_t blocks = ( count + blockSize - 1 ) / blockSize;
+
+      //Nothing to gain from the workers, process the blocks in order
+      if(( blocks == 1 )||( m_threads.size() == 1 )) {
+         for( size_t begin = 0; begin < count; begin += blockSize ) {
+            size_t end = begin + blockSize;
+            fn( begin, ( end > count ) ? count : end );
+         }
+         return;
+      }
+
+      std::mutex              doneMutex;
+      std::condition_variable doneCv;
+      size_t                  remaining = blocks;
+
+      for( size_t b = 0; b < blocks; b++ ) {
+         size_t begin = b * blockSize;
+         size_t end   = begin + blockSize;
+         if( end > count ) {
+            end = count;
+         }
+
+         std::function<void()> block = [&, begin, end]() {
+            fn( begin, end );
+
+            std::lock_guard<std::mutex> guard( doneMutex );
+            if( --remaining == 0 ) {
+               doneCv.notify_all();
+            }
+         };
+         if( !submit( block )) {
+            block();
+         }
+      }
+
+      std::unique_lock<std::mutex> lock( doneMutex );
+      while( remaining > 0 ) {
+         doneCv.wait( lock );
+      }
+   }
+
+   /**
+    * \brief Returns a process-wide pool with one worker per hardware thread
+    **/
+   AThreadPool & getDefaultThreadPool()
+   {
+      static AThreadPool pool;
+      return pool;
+   }
+
+   /**
+    * \brief Test function
+    **/
+   bool testAThreadPool()
+   {
+      AThreadPool pool(4);
+      if( pool.getThreadCount() != 4 ) {
+         cout << "AThreadPool thread count "<<pool.getThreadCount()<<" != 4"<<endl;
+         return false;
+      }
+
+      //Submit individual tasks
+      std::atomic<size_t> counter(0);
+      for( size_t i = 0; i < 100; i++ ) {
+         pool.submit( [&counter]() { counter++; } );
+      }
+      pool.wait();
+      if( counter != 100 ) {
+         cout << "AThreadPool executed "<<counter<<" tasks, not 100"<<endl;
+         return false;
+      }
+
+      //Every index must be visited exactly once
+      std::vector<int> visited( 1000, 0 );
+      pool.parallelFor( visited.size(), 7, [&visited]( size_t begin, size_t end ) {
+         for( size_t i = begin; i < end; i++ ) {
+            visited[i]++;
+         }
+      });
+
+      for( size_t i = 0; i < visited.size(); i++ ) {
+         if( visited[i] != 1 ) {
+            cout << "AThreadPool parallelFor visited "<<i<<" "<<visited[i]<<" times"<<endl;
+            return false;
+         }
+      }
+
+      //A task still running while the pool shuts down can use parallelFor
+      std::atomic<size_t> late(0);
+      {
+         AThreadPool closing(2);
+         closing.submit( [&closing, &late]() {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 20 ));
+            closing.parallelFor( 100, 10, [&late]( size_t begin, size_t end ) {
+               late += end - begin;
+            });
+         });
+      }
+      if( late != 100 ) {
+         cout << "AThreadPool parallelFor during shutdown processed "<<late<<" of 100 items"<<endl;
+         return false;
+      }
+
+      return true;
+   }
+}
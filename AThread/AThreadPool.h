@@ -0,0 +1,53 @@
+//==============================================================================
+// A fixed-size pool of worker threads
+//
+// Tasks are submitted as std::function objects and executed in FIFO order by
+// the first available worker. parallelFor splits an index range into blocks
+// and waits until all of them have been processed.
+//==============================================================================
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+namespace atl
+{
+   /**
+    *!\brief Fixed-size pool of worker threads
+    *
+    * parallelFor and wait must not be called from a task running in the same
+    * pool since the calling worker would block waiting on itself.
+    **/
+   class AThreadPool
+   {
+      private:
+         std::vector<std::thread>           m_threads;       //!< Worker threads
+         std::deque<std::function<void()> > m_tasks;         //!< Pending tasks
+         std::mutex                         m_mutex;         //!< Protects the task queue
+         std::condition_variable            m_taskCv;        //!< Signals new tasks
+         std::condition_variable            m_doneCv;        //!< Signals task completion
+         size_t                             m_active = 0;    //!< Number of queued or running tasks
+         bool                               m_running = true;//!< Flag to stop the workers
+
+         void workerLoop();
+
+      public:
+         AThreadPool( size_t threadCount = 0 );
+         ~AThreadPool();
+
+         size_t getThreadCount();
+         bool   submit( std::function<void()> task );
+         void   wait();
+         void   parallelFor( size_t count
+                           , size_t blockSize
+                           , std::function<void(size_t begin, size_t end)> fn
+                           );
+   };
+
+   AThreadPool & getDefaultThreadPool();
+
+   bool testAThreadPool();
+}
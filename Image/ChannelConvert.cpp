@@ -0,0 +1,525 @@
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <tmmintrin.h>
+#endif
+
+#include <ChannelConvert.h>
+#include <ImageContainer.h>
+
+namespace atl
+{
+   /**
+    * \brief Reordering of the channels of one pixel format into another
+    **/
+   struct ChannelPlan
+   {
+      size_t  m_sourceChannels = 0;         //!< Channels per source pixel
+      size_t  m_destChannels   = 0;         //!< Channels per destination pixel
+      int     m_channel[4];                 //!< Source channel of each destination channel, -1 for alpha
+      size_t  m_elementSize    = 1;         //!< Bytes per channel
+      size_t  m_step           = 0;         //!< Pixels per 16-byte shuffle
+      uint8_t m_shuffle[16];                //!< Byte shuffle of m_step pixels
+      uint8_t m_alpha[16];                  //!< Bytes set after the shuffle
+   };
+
+   /**
+    * \brief Work item of a batch
+    **/
+   struct ChannelTask
+   {
+      const uint8_t * m_source;             //!< First source pixel
+      uint8_t       * m_destination;        //!< First destination pixel
+      size_t          m_pixels;             //!< Number of pixels
+      bool            m_backward;           //!< Convert from the last pixel to the first
+   };
+
+   /**
+    * \brief Returns the number of channels of a pixel mode, 0 if channel conversion does not support it
+    **/
+   size_t getChannelCount( uint16_t mode )
+   {
+      switch( mode ) {
+         case APL_MODE_RGB:  return 3;
+         case APL_MODE_BGR:  return 3;
+         case APL_MODE_BGRA: return 4;
+         default:            return 0;
+      }
+   }
+
+   /**
+    * \brief Returns the position of red, green and blue in a pixel mode
+    **/
+   static void getChannelOrder( uint16_t mode, int order[3] )
+   {
+      bool rgb = ( mode == APL_MODE_RGB );
+      order[0] = rgb ? 0 : 2;
+      order[1] = 1;
+      order[2] = rgb ? 2 : 0;
+   }
+
+   /**
+    * \brief Builds the channel mapping and shuffle masks of a conversion
+    **/
+   static bool makeChannelPlan( uint16_t sourceMode, uint16_t destMode, size_t elementSize, ChannelPlan &plan )
+   {
+      plan.m_sourceChannels = getChannelCount( sourceMode );
+      plan.m_destChannels   = getChannelCount( destMode );
+      plan.m_elementSize    = elementSize;
+      if(( plan.m_sourceChannels == 0 )||( plan.m_destChannels == 0 )) {
+         std::cerr << "convertChannels: unsupported conversion from mode "<<sourceMode<<" to "<<destMode<<std::endl;
+         return false;
+      }
+
+      int sourceOrder[3];
+      int destOrder[3];
+      getChannelOrder( sourceMode, sourceOrder );
+      getChannelOrder( destMode, destOrder );
+      plan.m_channel[3] = -1;
+      for( size_t color = 0; color < 3; color++ ) {
+         plan.m_channel[destOrder[color]] = sourceOrder[color];
+      }
+      if(( plan.m_sourceChannels == 4 )&&( plan.m_destChannels == 4 )) {
+         plan.m_channel[3] = 3;
+      }
+
+      size_t sourceBytes = plan.m_sourceChannels * elementSize;
+      size_t destBytes   = plan.m_destChannels * elementSize;
+      plan.m_step = 16 / ( sourceBytes > destBytes ? sourceBytes : destBytes );
+      for( size_t i = 0; i < 16; i++ ) {
+         //Bytes past the converted pixels keep their value if the pixel size does not change
+         plan.m_shuffle[i] = ( sourceBytes == destBytes ) ? i : 0x80;
+         plan.m_alpha[i]   = 0;
+      }
+      for( size_t pixel = 0; pixel < plan.m_step; pixel++ ) {
+         for( size_t channel = 0; channel < plan.m_destChannels; channel++ ) {
+            for( size_t byte = 0; byte < elementSize; byte++ ) {
+               size_t index = pixel * destBytes + channel * elementSize + byte;
+               if( plan.m_channel[channel] < 0 ) {
+                  plan.m_shuffle[index] = 0x80;
+                  plan.m_alpha[index]   = 0xFF;
+               }
+               else {
+                  plan.m_shuffle[index] = pixel * sourceBytes + plan.m_channel[channel] * elementSize + byte;
+               }
+            }
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Converts a single pixel. The source is read completely before the destination is written
+    **/
+   template <typename T>
+   static inline void convertPixel( const ChannelPlan &plan, const T * source, T * destination )
+   {
+      T pixel[4];
+      for( size_t channel = 0; channel < plan.m_sourceChannels; channel++ ) {
+         pixel[channel] = source[channel];
+      }
+      for( size_t channel = 0; channel < plan.m_destChannels; channel++ ) {
+         int index = plan.m_channel[channel];
+         destination[channel] = ( index < 0 ) ? std::numeric_limits<T>::max() : pixel[index];
+      }
+   }
+
+   /**
+    * \brief Scalar conversion of a range of pixels
+    **/
+   template <typename T>
+   static void convertScalar( const ChannelPlan &plan, const ChannelTask &task, size_t begin, size_t end )
+   {
+      const T * source      = (const T *)task.m_source;
+      T       * destination = (T *)task.m_destination;
+      if( task.m_backward ) {
+         for( size_t i = end; i > begin; i-- ) {
+            convertPixel( plan, source + ( i - 1 ) * plan.m_sourceChannels, destination + ( i - 1 ) * plan.m_destChannels );
+         }
+      }
+      else {
+         for( size_t i = begin; i < end; i++ ) {
+            convertPixel( plan, source + i * plan.m_sourceChannels, destination + i * plan.m_destChannels );
+         }
+      }
+   }
+
+   /**
+    * \brief Scalar conversion of a work item
+    **/
+   static void convertTaskScalar( const ChannelPlan &plan, const ChannelTask &task )
+   {
+      if( plan.m_elementSize == 1 ) {
+         convertScalar<uint8_t>( plan, task, 0, task.m_pixels );
+      }
+      else {
+         convertScalar<uint16_t>( plan, task, 0, task.m_pixels );
+      }
+   }
+
+   /**
+    * \brief Scalar conversion of part of a work item
+    **/
+   static void convertRangeScalar( const ChannelPlan &plan, const ChannelTask &task, size_t begin, size_t end )
+   {
+      if( plan.m_elementSize == 1 ) {
+         convertScalar<uint8_t>( plan, task, begin, end );
+      }
+      else {
+         convertScalar<uint16_t>( plan, task, begin, end );
+      }
+   }
+
+#if defined(__x86_64__)
+   /**
+    * \brief Conversion of a work item with the SSSE3 byte shuffle
+    *
+    * Every shuffle loads 16 source bytes and stores 16 destination bytes, of
+    * which the first m_step pixels are valid. Forward, the extra bytes are
+    * rewritten by the next store (or keep their value if the pixel size does
+    * not change); the loop stops while 16 bytes still fit in both ranges.
+    * Backward (in place to a larger pixel), every store is exactly m_step
+    * pixels and the last pixels are converted first by the scalar loop.
+    **/
+   __attribute__((target("ssse3")))
+   static void convertTaskShuffle( const ChannelPlan &plan, const ChannelTask &task )
+   {
+      const __m128i shuffle = _mm_loadu_si128( (const __m128i *)plan.m_shuffle );
+      const __m128i alpha   = _mm_loadu_si128( (const __m128i *)plan.m_alpha );
+      const size_t  sourceBytes = plan.m_sourceChannels * plan.m_elementSize;
+      const size_t  destBytes   = plan.m_destChannels * plan.m_elementSize;
+      const size_t  step        = plan.m_step;
+
+      if( task.m_backward ) {
+         size_t groups = 0;
+         if( task.m_pixels * sourceBytes >= 16 ) {
+            groups = ( task.m_pixels * sourceBytes - 16 ) / ( step * sourceBytes ) + 1;
+         }
+         convertRangeScalar( plan, task, groups * step, task.m_pixels );
+         for( size_t group = groups; group > 0; group-- ) {
+            size_t pixel = ( group - 1 ) * step;
+            __m128i value = _mm_loadu_si128( (const __m128i *)( task.m_source + pixel * sourceBytes ));
+            value = _mm_or_si128( _mm_shuffle_epi8( value, shuffle ), alpha );
+            _mm_storeu_si128( (__m128i *)( task.m_destination + pixel * destBytes ), value );
+         }
+         return;
+      }
+
+      //The next pixels are loaded before the store, which in place may overlap them
+      size_t pixels = 0;
+      while(( ( task.m_pixels - pixels ) * sourceBytes >= 16 )&&(( task.m_pixels - pixels ) * destBytes >= 16 )) {
+         pixels += step;
+      }
+
+      __m128i next = _mm_setzero_si128();
+      if( pixels > 0 ) {
+         next = _mm_loadu_si128( (const __m128i *)task.m_source );
+      }
+      for( size_t pixel = 0; pixel < pixels; pixel += step ) {
+         __m128i value = next;
+         if( pixel + step < pixels ) {
+            next = _mm_loadu_si128( (const __m128i *)( task.m_source + ( pixel + step ) * sourceBytes ));
+         }
+         value = _mm_or_si128( _mm_shuffle_epi8( value, shuffle ), alpha );
+         _mm_storeu_si128( (__m128i *)( task.m_destination + pixel * destBytes ), value );
+      }
+      convertRangeScalar( plan, task, pixels, task.m_pixels );
+   }
+#endif
+
+   typedef void (*ChannelFunction)( const ChannelPlan &, const ChannelTask & );
+
+   /**
+    * \brief Selects the fastest implementation supported by the CPU
+    **/
+   static ChannelFunction selectChannelFunction()
+   {
+#if defined(__x86_64__)
+      if( __builtin_cpu_supports( "ssse3" )) {
+         return convertTaskShuffle;
+      }
+#endif
+      return convertTaskScalar;
+   }
+
+   /**
+    * \brief Returns the implementation selected for this CPU
+    **/
+   static ChannelFunction getChannelFunction()
+   {
+      static const ChannelFunction function = selectChannelFunction();
+      return function;
+   }
+
+   /**
+    * \brief Splits one image of a batch into work items
+    *
+    * In-place conversions that change the pixel size must run in one pass
+    * (backward when the pixels grow), all others are split into blocks.
+    **/
+   template <typename T>
+   static bool planConversion( ChannelConversion<T> &conversion, const ChannelPlan &plan, std::vector<ChannelTask> &tasks )
+   {
+      if(( conversion.m_source == NULL )||( conversion.m_destination == NULL )||( conversion.m_metadata == NULL )) {
+         std::cerr << "convertChannels: incomplete batch entry"<<std::endl;
+         return false;
+      }
+
+      ImageMetadata & metadata = *conversion.m_metadata;
+      size_t pixels = (size_t)metadata.m_width * metadata.m_height;
+      if( conversion.m_source->getCapacity() < pixels * plan.m_sourceChannels ) {
+         std::cerr << "convertChannels: source holds "<<conversion.m_source->getCapacity()<<" of "<<pixels * plan.m_sourceChannels<<" samples"<<std::endl;
+         return false;
+      }
+
+      bool inPlace = ( conversion.m_source->m_buffer.get() == conversion.m_destination->m_buffer.get());
+      if( conversion.m_destination->getCapacity() < pixels * plan.m_destChannels ) {
+         if( inPlace ) {
+            std::cerr << "convertChannels: buffer too small to convert in place"<<std::endl;
+            return false;
+         }
+         conversion.m_destination->deallocate();
+         if( !conversion.m_destination->allocate( pixels * plan.m_destChannels )) {
+            return false;
+         }
+      }
+
+      ChannelTask task;
+      task.m_source      = conversion.m_source->m_buffer.get();
+      task.m_destination = conversion.m_destination->m_buffer.get();
+      task.m_backward    = ( inPlace )&&( plan.m_destChannels > plan.m_sourceChannels );
+      if(( inPlace )&&( plan.m_destChannels != plan.m_sourceChannels )) {
+         task.m_pixels = pixels;
+         tasks.push_back( task );
+         return true;
+      }
+
+      for( size_t begin = 0; begin < pixels; begin += CHANNELCONVERT_BLOCK_PIXELS ) {
+         ChannelTask block = task;
+         block.m_source      += begin * plan.m_sourceChannels * sizeof(T);
+         block.m_destination += begin * plan.m_destChannels * sizeof(T);
+         block.m_pixels       = ( pixels - begin < CHANNELCONVERT_BLOCK_PIXELS ) ? pixels - begin : CHANNELCONVERT_BLOCK_PIXELS;
+         tasks.push_back( block );
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Converts a batch of images of any sample type
+    **/
+   template <typename T>
+   static bool convertBatch( std::vector<ChannelConversion<T> > &batch, uint16_t mode, AThreadPool &pool )
+   {
+      ChannelFunction function = getChannelFunction();
+
+      //Images with different source modes have different plans
+      std::vector<ChannelPlan> plans( batch.size());
+      std::vector<ChannelTask> tasks;
+      std::vector<size_t>      taskPlans;
+      for( size_t i = 0; i < batch.size(); i++ ) {
+         if(( batch[i].m_metadata == NULL )
+          ||( !makeChannelPlan( batch[i].m_metadata->m_mode, mode, sizeof(T), plans[i] ))
+          ||( !planConversion( batch[i], plans[i], tasks ))) {
+            return false;
+         }
+         taskPlans.resize( tasks.size(), i );
+      }
+
+      size_t blocks    = 4 * pool.getThreadCount();
+      size_t blockSize = ( tasks.size() + blocks - 1 ) / blocks;
+      if( tasks.size() > 0 ) {
+         pool.parallelFor( tasks.size(), blockSize, [&]( size_t begin, size_t end ) {
+            for( size_t i = begin; i < end; i++ ) {
+               function( plans[taskPlans[i]], tasks[i] );
+            }
+         });
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Converts the channel order of a batch of 8-bit images
+    *
+    * \param [in] batch images to convert. The source modes may differ
+    * \param [in] mode destination mode: APL_MODE_RGB, APL_MODE_BGR or APL_MODE_BGRA
+    * \param [in] pool workers that convert blocks of pixels
+    * \return true on success, false if an entry is not supported or does not fit its buffers
+    *
+    * All blocks of all images are distributed over the pool at once, so small
+    * images do not leave workers idle. Alpha is set to the maximum sample
+    * value. Nothing is converted if any entry is invalid.
+    **/
+   bool convertChannels( std::vector<ChannelConversion<uint8_t> > &batch, uint16_t mode, AThreadPool &pool )
+   {
+      return convertBatch( batch, mode, pool );
+   }
+
+   /**
+    * \brief Converts the channel order of a batch of 16-bit images
+    *
+    * See the 8-bit version.
+    **/
+   bool convertChannels( std::vector<ChannelConversion<uint16_t> > &batch, uint16_t mode, AThreadPool &pool )
+   {
+      return convertBatch( batch, mode, pool );
+   }
+
+   /**
+    * \brief Converts the channel order of a run of pixels in the calling thread
+    *
+    * \param [in] source source pixels
+    * \param [in] sourceMode mode of the source pixels
+    * \param [out] destination destination pixels. Must not overlap the source
+    * \param [in] mode mode of the destination pixels
+    * \param [in] pixels number of pixels
+    * \param [in] elementSize bytes per channel (1 or 2)
+    * \return true on success, false if a mode is not supported
+    *
+    * This is the kernel used by convertChannels, for code that converts rows
+    * as part of its own processing.
+    **/
+   bool convertPixels( const void * source, uint16_t sourceMode, void * destination, uint16_t mode, size_t pixels, size_t elementSize )
+   {
+      ChannelPlan plan;
+      if(( elementSize < 1 )||( elementSize > 2 )||( !makeChannelPlan( sourceMode, mode, elementSize, plan ))) {
+         return false;
+      }
+
+      ChannelTask task;
+      task.m_source      = (const uint8_t *)source;
+      task.m_destination = (uint8_t *)destination;
+      task.m_pixels      = pixels;
+      task.m_backward    = false;
+      getChannelFunction()( plan, task );
+
+      return true;
+   }
+
+   /**
+    * \brief Fills an image with a pattern that differs in every channel
+    **/
+   template <typename T>
+   static void fillPattern( ExtendedBuffer<T> &buffer, size_t samples )
+   {
+      for( size_t i = 0; i < samples; i++ ) {
+         buffer[i] = (T)( i * 7 + 3 );
+      }
+   }
+
+   /**
+    * \brief Checks every conversion against the scalar pixel conversion, out of place and in place
+    **/
+   template <typename T>
+   static bool testConversions( AThreadPool &pool )
+   {
+      const uint16_t modes[] = { APL_MODE_RGB, APL_MODE_BGR, APL_MODE_BGRA };
+      const size_t   sizes[][2] = { { 1, 1 }, { 37, 5 }, { 300, 301 } };
+
+      for( size_t s = 0; s < 3; s++ ) {
+         for( size_t from = 0; from < 3; from++ ) {
+            for( size_t to = 0; to < 3; to++ ) {
+               ImageMetadata metadata;
+               metadata.m_mode   = modes[from];
+               metadata.m_width  = sizes[s][0];
+               metadata.m_height = sizes[s][1];
+               size_t pixels = sizes[s][0] * sizes[s][1];
+
+               ChannelPlan plan;
+               makeChannelPlan( modes[from], modes[to], sizeof(T), plan );
+               ExtendedBuffer<T> source( pixels * plan.m_sourceChannels );
+               std::vector<T>    expected( pixels * plan.m_destChannels );
+               fillPattern( source, pixels * plan.m_sourceChannels );
+               for( size_t i = 0; i < pixels; i++ ) {
+                  convertPixel( plan, (T *)source.m_buffer.get() + i * plan.m_sourceChannels, &expected[i * plan.m_destChannels] );
+               }
+
+               ExtendedBuffer<T> destination;
+               ExtendedBuffer<T> inPlace( pixels * 4 );
+               fillPattern( inPlace, pixels * plan.m_sourceChannels );
+               if(( !convertChannels( source, metadata, destination, modes[to], pool ))
+                ||( memcmp( destination.m_buffer.get(), expected.data(), expected.size() * sizeof(T)))
+                ||( !convertChannels( inPlace, metadata, inPlace, modes[to], pool ))
+                ||( memcmp( inPlace.m_buffer.get(), expected.data(), expected.size() * sizeof(T)))) {
+                  std::cout << "Channel conversion of "<<8 * sizeof(T)<<"-bit "<<pixels<<" pixels from mode "<<modes[from]<<" to "<<modes[to]<<" failed"<<std::endl;
+                  return false;
+               }
+            }
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Unit test for channel conversion
+    **/
+   bool testChannelConvert()
+   {
+      AThreadPool pool( 3 );
+      if(( !testConversions<uint8_t>( pool ))||( !testConversions<uint16_t>( pool ))) {
+         return false;
+      }
+
+      //Growing in place needs room in the buffer
+      ImageMetadata metadata;
+      metadata.m_mode   = APL_MODE_RGB;
+      metadata.m_width  = 4;
+      metadata.m_height = 4;
+      ExtendedBuffer<uint8_t> small( 48 );
+      if( convertChannels( small, metadata, small, APL_MODE_BGRA, pool )) {
+         std::cout << "Channel conversion grew a buffer in place beyond its capacity"<<std::endl;
+         return false;
+      }
+
+      metadata.m_mode = APL_MODE_YUV_422;
+      ExtendedBuffer<uint8_t> destination;
+      if( convertChannels( small, metadata, destination, APL_MODE_RGB, pool )) {
+         std::cout << "Channel conversion accepted an unsupported mode"<<std::endl;
+         return false;
+      }
+
+      //The container interface converts in place, reallocating when the image grows
+      ImageContainer<uint8_t> first;
+      ImageContainer<uint8_t> second;
+      first.m_metadata.m_mode   = APL_MODE_RGB;
+      first.m_metadata.m_width  = 2;
+      first.m_metadata.m_height = 1;
+      first.m_metadata.m_bpp    = 24;
+      first.m_data.allocate( 6 );
+      for( size_t i = 0; i < 6; i++ ) {
+         first.m_data[i] = i + 1;
+      }
+      second.m_metadata = first.m_metadata;
+      second.m_metadata.m_mode = APL_MODE_BGR;
+      second.m_data.allocate( 6 );
+      second.m_data[0] = 30;
+
+      std::vector<ImageContainer<uint8_t> *> images;
+      images.push_back( &first );
+      images.push_back( &second );
+      const uint8_t expected[] = { 3, 2, 1, 255, 6, 5, 4, 255 };
+      if(( !ImageContainer<uint8_t>::convert( images, APL_MODE_BGRA, pool ))
+       ||( first.m_metadata.m_mode != APL_MODE_BGRA )||( first.m_metadata.m_bpp != 32 )
+       ||( memcmp( first.m_data.m_buffer.get(), expected, sizeof(expected)))
+       ||( second.m_data[0] != 30 )||( second.m_data[3] != 255 )) {
+         std::cout << "ImageContainer batch channel conversion failed"<<std::endl;
+         return false;
+      }
+
+      ImageContainer<uint8_t> rgb;
+      if(( !first.convert( rgb, APL_MODE_RGB, pool ))||( rgb.m_metadata.m_mode != APL_MODE_RGB )
+       ||( rgb.m_metadata.m_bpp != 24 )||( rgb.m_data[0] != 1 )||( rgb.m_data[5] != 6 )
+       ||( !first.convert( APL_MODE_BGR, pool ))||( first.m_data[0] != 3 )||( first.m_data[5] != 4 )) {
+         std::cout << "ImageContainer channel conversion failed"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+};
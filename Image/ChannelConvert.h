@@ -0,0 +1,70 @@
+//==============================================================================
+// Channel order conversion between APL_MODE_RGB, APL_MODE_BGR and APL_MODE_BGRA
+//
+// Each conversion is described by the source channel that feeds every
+// destination channel. On x86-64 CPUs with SSSE3 the pixels are reordered
+// with one byte shuffle per 16 bytes; other CPUs use a scalar loop. Both
+// produce identical results.
+//==============================================================================
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include <ExtendedBuffer.tcc>
+#include <ImageMetadata.h>
+#include <AThreadPool.h>
+
+#define CHANNELCONVERT_BLOCK_PIXELS 65536     //!< Pixels per parallel work item
+
+namespace atl
+{
+   /**
+    * \brief One image of a channel conversion batch
+    *
+    * m_source and m_destination may be the same buffer to convert in place.
+    * Conversions to BGRA need a buffer with room for the larger image.
+    **/
+   template <typename T>
+   struct ChannelConversion
+   {
+      ExtendedBuffer<T> * m_source      = NULL;   //!< Source pixels
+      ExtendedBuffer<T> * m_destination = NULL;   //!< Destination pixels, allocated if too small
+      ImageMetadata     * m_metadata    = NULL;   //!< Description of the source image
+   };
+
+   size_t getChannelCount( uint16_t mode );
+   bool   convertPixels( const void * source, uint16_t sourceMode, void * destination, uint16_t mode, size_t pixels, size_t elementSize = 1 );
+
+   bool convertChannels( std::vector<ChannelConversion<uint8_t> > &batch, uint16_t mode, AThreadPool &pool = getDefaultThreadPool());
+   bool convertChannels( std::vector<ChannelConversion<uint16_t> > &batch, uint16_t mode, AThreadPool &pool = getDefaultThreadPool());
+
+   /**
+    * \brief Converts the channel order of a single image
+    *
+    * \param [in] source source pixels
+    * \param [in] metadata description of the source image
+    * \param [out] destination destination pixels. May be the source buffer
+    * \param [in] mode APL_MODE_RGB, APL_MODE_BGR or APL_MODE_BGRA
+    * \param [in] pool workers that convert blocks of pixels
+    * \return true on success, false if a mode is not supported or the buffers do not fit
+    **/
+   template <typename T>
+   bool convertChannels( ExtendedBuffer<T> &source
+                       , ImageMetadata &metadata
+                       , ExtendedBuffer<T> &destination
+                       , uint16_t mode
+                       , AThreadPool &pool = getDefaultThreadPool()
+                       )
+   {
+      std::vector<ChannelConversion<T> > batch( 1 );
+      batch[0].m_source      = &source;
+      batch[0].m_destination = &destination;
+      batch[0].m_metadata    = &metadata;
+
+      return convertChannels( batch, mode, pool );
+   }
+
+   //Test functions
+   bool testChannelConvert();
+};
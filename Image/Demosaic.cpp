@@ -0,0 +1,676 @@
+#include <iostream>
+#include <vector>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include <Demosaic.h>
+#include <ImageContainer.h>
+
+namespace atl
+{
+   /**
+    * \brief Returns true if the mode is a single-color Bayer mode
+    **/
+   bool isBayerMode( uint16_t mode )
+   {
+      return ( mode == APL_MODE_GRBG )||( mode == APL_MODE_BGGR )||( mode == APL_MODE_RGGB );
+   }
+
+   /**
+    * \brief Position of the red sample in the 2x2 Bayer cell
+    **/
+   static bool getRedPosition( uint16_t mode, size_t &redX, size_t &redY )
+   {
+      switch( mode ) {
+         case APL_MODE_RGGB: redX = 0; redY = 0; return true;
+         case APL_MODE_GRBG: redX = 1; redY = 0; return true;
+         case APL_MODE_BGGR: redX = 1; redY = 1; return true;
+         default:            return false;
+      }
+   }
+
+   /**
+    * \brief Mirrors a coordinate at the image border without repeating the edge sample
+    *
+    * Mirroring by one sample keeps the Bayer parity of the neighbours.
+    **/
+   static inline size_t mirror( long position, size_t size )
+   {
+      if( position < 0 ) {
+         return -position;
+      }
+      if( position >= (long)size ) {
+         return 2 * size - 2 - position;
+      }
+      return position;
+   }
+
+   /**
+    * \brief Geometry of the image being converted
+    **/
+   template <typename T>
+   struct BayerImage
+   {
+      const T * m_source;                    //!< Bayer samples
+      T       * m_green;                     //!< Interpolated green plane (edge-aware method only)
+      size_t    m_width;                     //!< Width in pixels
+      size_t    m_height;                    //!< Height in pixels
+      size_t    m_redX;                      //!< Column of the red sample in the 2x2 cell
+      size_t    m_redY;                      //!< Row of the red sample in the 2x2 cell
+
+      /** \brief Sample at an offset from a pixel, mirrored at the borders **/
+      int at( size_t x, size_t y, long dx, long dy ) const
+      {
+         return m_source[mirror( (long)y + dy, m_height ) * m_width + mirror( (long)x + dx, m_width )];
+      }
+
+      /** \brief True if the row holds red samples **/
+      bool isRedRow( size_t y ) const
+      {
+         return ( y & 1 ) == m_redY;
+      }
+
+      /** \brief True if the pixel holds a red or blue sample **/
+      bool isColorSite( size_t x, size_t y ) const
+      {
+         return (( x ^ y ) & 1 ) == (( m_redX ^ m_redY ) & 1 );
+      }
+   };
+
+   /**
+    * \brief Bilinear interpolation of a single pixel with mirrored borders
+    **/
+   template <typename T>
+   static void bilinearPixel( const BayerImage<T> &image, size_t x, size_t y, T &red, T &green, T &blue )
+   {
+      int own   = 0;
+      int other = 0;
+      int g     = 0;
+      if( image.isColorSite( x, y )) {
+         own   = image.at( x, y, 0, 0 );
+         g     = ( image.at( x, y, -1, 0 ) + image.at( x, y, 1, 0 ) + image.at( x, y, 0, -1 ) + image.at( x, y, 0, 1 ) + 2 ) >> 2;
+         other = ( image.at( x, y, -1, -1 ) + image.at( x, y, 1, -1 ) + image.at( x, y, -1, 1 ) + image.at( x, y, 1, 1 ) + 2 ) >> 2;
+      }
+      else {
+         g     = image.at( x, y, 0, 0 );
+         own   = ( image.at( x, y, -1, 0 ) + image.at( x, y, 1, 0 ) + 1 ) >> 1;
+         other = ( image.at( x, y, 0, -1 ) + image.at( x, y, 0, 1 ) + 1 ) >> 1;
+      }
+
+      //On a red row the color sites and the horizontal neighbours of green are red
+      green = g;
+      red   = image.isRedRow( y ) ? own : other;
+      blue  = image.isRedRow( y ) ? other : own;
+   }
+
+   /**
+    * \brief Edge-aware green at a pixel with mirrored borders
+    **/
+   template <typename T>
+   static int edgeAwareGreen( const BayerImage<T> &image, size_t x, size_t y )
+   {
+      if( !image.isColorSite( x, y )) {
+         return image.at( x, y, 0, 0 );
+      }
+
+      int left  = image.at( x, y, -1, 0 );
+      int right = image.at( x, y, 1, 0 );
+      int up    = image.at( x, y, 0, -1 );
+      int down  = image.at( x, y, 0, 1 );
+      int dh    = std::abs( left - right );
+      int dv    = std::abs( up - down );
+      if( dh < dv ) {
+         return ( left + right + 1 ) >> 1;
+      }
+      if( dv < dh ) {
+         return ( up + down + 1 ) >> 1;
+      }
+      return ( left + right + up + down + 2 ) >> 2;
+   }
+
+   /**
+    * \brief Clamps an interpolated value to the range of the sample type
+    **/
+   template <typename T>
+   static inline T clampSample( int value )
+   {
+      const int maxValue = std::numeric_limits<T>::max();
+      return (T)( value < 0 ? 0 : ( value > maxValue ? maxValue : value ));
+   }
+
+   /**
+    * \brief Interleaves planar rows into an RGB row
+    **/
+   template <typename T>
+   static void interleaveRow( const T * red, const T * green, const T * blue, T * rgb, size_t width )
+   {
+      for( size_t x = 0; x < width; x++ ) {
+         rgb[3 * x]     = red[x];
+         rgb[3 * x + 1] = green[x];
+         rgb[3 * x + 2] = blue[x];
+      }
+   }
+
+   /**
+    * \brief Bilinear interpolation of an interior row into planar rows
+    *
+    * \param [in] image image geometry
+    * \param [in] y row index, 1 <= y < height - 1
+    * \param [out] own row of the color sampled on this row (red on a red row)
+    * \param [out] green green row
+    * \param [out] other row of the color sampled on the neighbouring rows
+    * \param [in] first first column pair to interpolate
+    * \return first column that was not interpolated
+    *
+    * Columns are processed as pairs of a color site and a green site, starting
+    * at column 1. The caller fills the border columns and an unpaired last
+    * interior column.
+    **/
+   template <typename T>
+   static size_t bilinearRow( const BayerImage<T> &image, size_t y, T * __restrict own, T * __restrict green, T * __restrict other, size_t first = 0 )
+   {
+      const size_t width = image.m_width;
+      const T * __restrict up   = image.m_source + ( y - 1 ) * width;
+      const T * __restrict cur  = image.m_source + y * width;
+      const T * __restrict down = image.m_source + ( y + 1 ) * width;
+
+      size_t color = image.isColorSite( 1, y ) ? 1 : 2;
+      size_t gsite = 3 - color;
+      size_t pairs = ( width - 2 ) / 2;
+      for( size_t i = first; i < pairs; i++ ) {
+         size_t c = color + 2 * i;
+         size_t g = gsite + 2 * i;
+
+         own[c]   = cur[c];
+         green[c] = ( cur[c - 1] + cur[c + 1] + up[c] + down[c] + 2 ) >> 2;
+         other[c] = ( up[c - 1] + up[c + 1] + down[c - 1] + down[c + 1] + 2 ) >> 2;
+
+         own[g]   = ( cur[g - 1] + cur[g + 1] + 1 ) >> 1;
+         green[g] = cur[g];
+         other[g] = ( up[g] + down[g] + 1 ) >> 1;
+      }
+
+      return 1 + 2 * pairs;
+   }
+
+#if defined(__x86_64__)
+   /**
+    * \brief Rounded mean of four rows of 16 samples, (a + b + c + d + 2) >> 2
+    **/
+   static inline __m128i average4( __m128i a, __m128i b, __m128i c, __m128i d )
+   {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i two  = _mm_set1_epi16( 2 );
+      __m128i low  = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ))
+                                  , _mm_add_epi16( _mm_unpacklo_epi8( c, zero ), _mm_unpacklo_epi8( d, zero )));
+      __m128i high = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ))
+                                  , _mm_add_epi16( _mm_unpackhi_epi8( c, zero ), _mm_unpackhi_epi8( d, zero )));
+      low  = _mm_srli_epi16( _mm_add_epi16( low, two ), 2 );
+      high = _mm_srli_epi16( _mm_add_epi16( high, two ), 2 );
+      return _mm_packus_epi16( low, high );
+   }
+
+   /**
+    * \brief Selects a where the mask is set and b elsewhere
+    **/
+   static inline __m128i select( __m128i mask, __m128i a, __m128i b )
+   {
+      return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ));
+   }
+
+   /**
+    * \brief Bilinear interpolation of an interior 8-bit row with SSE2
+    *
+    * The vectorized generic loop is slower than scalar code for 8-bit
+    * samples, because it widens every sample to 32 bits. This version
+    * computes both the color-site and the green-site formula for 16 columns
+    * in 8 or 16-bit lanes and selects the result by column parity. The two
+    * sample means are exact with _mm_avg_epu8. SSE2 is part of x86-64, so no
+    * runtime check is needed. The remaining pairs use the generic loop.
+    **/
+   static size_t bilinearRow( const BayerImage<uint8_t> &image, size_t y, uint8_t * __restrict own, uint8_t * __restrict green, uint8_t * __restrict other )
+   {
+      const size_t width = image.m_width;
+      const uint8_t * up   = image.m_source + ( y - 1 ) * width;
+      const uint8_t * cur  = image.m_source + y * width;
+      const uint8_t * down = image.m_source + ( y + 1 ) * width;
+
+      //Column 1 is in the first lane, so color sites are the even or the odd lanes
+      const __m128i colorSites = image.isColorSite( 1, y ) ? _mm_set1_epi16( 0x00FF ) : _mm_set1_epi16( (short)0xFF00 );
+      size_t end = 1 + 2 * (( width - 2 ) / 2 );
+      size_t x   = 1;
+      for( ; x + 16 <= end; x += 16 ) {
+         __m128i left      = _mm_loadu_si128( (const __m128i *)( cur + x - 1 ));
+         __m128i center    = _mm_loadu_si128( (const __m128i *)( cur + x ));
+         __m128i right     = _mm_loadu_si128( (const __m128i *)( cur + x + 1 ));
+         __m128i upper     = _mm_loadu_si128( (const __m128i *)( up + x ));
+         __m128i lower     = _mm_loadu_si128( (const __m128i *)( down + x ));
+         __m128i diagonals = average4( _mm_loadu_si128( (const __m128i *)( up + x - 1 ))
+                                     , _mm_loadu_si128( (const __m128i *)( up + x + 1 ))
+                                     , _mm_loadu_si128( (const __m128i *)( down + x - 1 ))
+                                     , _mm_loadu_si128( (const __m128i *)( down + x + 1 )));
+
+         _mm_storeu_si128( (__m128i *)( own + x ), select( colorSites, center, _mm_avg_epu8( left, right )));
+         _mm_storeu_si128( (__m128i *)( green + x ), select( colorSites, average4( left, right, upper, lower ), center ));
+         _mm_storeu_si128( (__m128i *)( other + x ), select( colorSites, diagonals, _mm_avg_epu8( upper, lower )));
+      }
+
+      return bilinearRow<uint8_t>( image, y, own, green, other, ( x - 1 ) / 2 );
+   }
+#endif
+
+   /**
+    * \brief Edge-aware green of an interior row
+    *
+    * Color sites take the mean of the horizontal or vertical neighbours,
+    * whichever differ less, so green is not averaged across an edge.
+    **/
+   template <typename T>
+   static size_t edgeAwareGreenRow( const BayerImage<T> &image, size_t y, T * __restrict green )
+   {
+      const size_t width = image.m_width;
+      const T * __restrict up   = image.m_source + ( y - 1 ) * width;
+      const T * __restrict cur  = image.m_source + y * width;
+      const T * __restrict down = image.m_source + ( y + 1 ) * width;
+
+      size_t color = image.isColorSite( 1, y ) ? 1 : 2;
+      size_t gsite = 3 - color;
+      size_t pairs = ( width - 2 ) / 2;
+      for( size_t i = 0; i < pairs; i++ ) {
+         size_t c = color + 2 * i;
+         size_t g = gsite + 2 * i;
+
+         int left  = cur[c - 1];
+         int right = cur[c + 1];
+         int above = up[c];
+         int below = down[c];
+         int dh    = left > right ? left - right : right - left;
+         int dv    = above > below ? above - below : below - above;
+         int h     = ( left + right + 1 ) >> 1;
+         int v     = ( above + below + 1 ) >> 1;
+         int both  = ( left + right + above + below + 2 ) >> 2;
+
+         green[c] = dh < dv ? h : ( dv < dh ? v : both );
+         green[g] = cur[g];
+      }
+
+      return 1 + 2 * pairs;
+   }
+
+   /**
+    * \brief Red and blue of an interior row from the color differences to green
+    *
+    * The missing color is green plus the mean difference between the color and
+    * green at the nearest samples of that color. The green plane must be complete.
+    **/
+   template <typename T>
+   static size_t edgeAwareColorRow( const BayerImage<T> &image, size_t y, T * __restrict own, T * __restrict other )
+   {
+      const size_t width = image.m_width;
+      const T * __restrict up    = image.m_source + ( y - 1 ) * width;
+      const T * __restrict cur   = image.m_source + y * width;
+      const T * __restrict down  = image.m_source + ( y + 1 ) * width;
+      const T * __restrict gUp   = image.m_green + ( y - 1 ) * width;
+      const T * __restrict gCur  = image.m_green + y * width;
+      const T * __restrict gDown = image.m_green + ( y + 1 ) * width;
+
+      size_t color = image.isColorSite( 1, y ) ? 1 : 2;
+      size_t gsite = 3 - color;
+      size_t pairs = ( width - 2 ) / 2;
+      for( size_t i = 0; i < pairs; i++ ) {
+         size_t c = color + 2 * i;
+         size_t g = gsite + 2 * i;
+
+         int diagonal = ( up[c - 1] - gUp[c - 1] ) + ( up[c + 1] - gUp[c + 1] )
+                      + ( down[c - 1] - gDown[c - 1] ) + ( down[c + 1] - gDown[c + 1] );
+         own[c]   = cur[c];
+         other[c] = clampSample<T>( gCur[c] + (( diagonal + 2 ) >> 2 ));
+
+         int horizontal = ( cur[g - 1] - gCur[g - 1] ) + ( cur[g + 1] - gCur[g + 1] );
+         int vertical   = ( up[g] - gUp[g] ) + ( down[g] - gDown[g] );
+         own[g]   = clampSample<T>( gCur[g] + (( horizontal + 1 ) >> 1 ));
+         other[g] = clampSample<T>( gCur[g] + (( vertical + 1 ) >> 1 ));
+      }
+
+      return 1 + 2 * pairs;
+   }
+
+   /**
+    * \brief Demosaics a band of rows
+    *
+    * Border rows, border columns and an unpaired last column are interpolated
+    * bilinearly with mirrored neighbours.
+    **/
+   template <typename T>
+   static void demosaicRows( const BayerImage<T> &image, uint16_t method, T * rgb, size_t begin, size_t end )
+   {
+      const size_t width = image.m_width;
+      std::vector<T> rows( 3 * width );
+      T * red   = &rows[0];
+      T * green = &rows[width];
+      T * blue  = &rows[2 * width];
+
+      for( size_t y = begin; y < end; y++ ) {
+         size_t done = 0;
+         if(( y > 0 )&&( y + 1 < image.m_height )) {
+            T * own   = image.isRedRow( y ) ? red : blue;
+            T * other = image.isRedRow( y ) ? blue : red;
+            if( method == DEMOSAIC_EDGE_AWARE ) {
+               memcpy( green, image.m_green + y * width, width * sizeof(T));
+               done = edgeAwareColorRow( image, y, own, other );
+            }
+            else {
+               done = bilinearRow( image, y, own, green, other );
+            }
+         }
+
+         //The remaining columns, with the first column visited last
+         for( size_t x = ( done > 0 ) ? done : 1; x <= width; x++ ) {
+            size_t column = ( x == width ) ? 0 : x;
+            bilinearPixel( image, column, y, red[column], green[column], blue[column] );
+            if( method == DEMOSAIC_EDGE_AWARE ) {
+               green[column] = image.m_green[y * width + column];
+            }
+         }
+
+         interleaveRow( red, green, blue, rgb + 3 * y * width, width );
+      }
+   }
+
+   /**
+    * \brief Demosaics an image of any sample type
+    **/
+   template <typename T>
+   static bool demosaicImage( ExtendedBuffer<T> &source
+                            , ImageMetadata &metadata
+                            , ExtendedBuffer<T> &destination
+                            , uint16_t method
+                            , AThreadPool &pool
+                            )
+   {
+      BayerImage<T> image;
+      image.m_width  = metadata.m_width;
+      image.m_height = metadata.m_height;
+      image.m_green  = NULL;
+      if( !getRedPosition( metadata.m_mode, image.m_redX, image.m_redY )) {
+         std::cerr << "demosaic: mode "<<metadata.m_mode<<" is not a Bayer mode"<<std::endl;
+         return false;
+      }
+      if(( method != DEMOSAIC_BILINEAR )&&( method != DEMOSAIC_EDGE_AWARE )) {
+         std::cerr << "demosaic: unknown method "<<method<<std::endl;
+         return false;
+      }
+      if(( image.m_width < 2 )||( image.m_height < 2 )) {
+         std::cerr << "demosaic: image of "<<image.m_width<<"x"<<image.m_height<<" is too small"<<std::endl;
+         return false;
+      }
+
+      size_t pixels = image.m_width * image.m_height;
+      if( source.getCapacity() < pixels ) {
+         std::cerr << "demosaic: source holds "<<source.getCapacity()<<" of "<<pixels<<" samples"<<std::endl;
+         return false;
+      }
+      if( source.m_buffer.get() == destination.m_buffer.get()) {
+         std::cerr << "demosaic: source and destination must be different buffers"<<std::endl;
+         return false;
+      }
+      if( destination.getCapacity() < 3 * pixels ) {
+         destination.deallocate();
+         if( !destination.allocate( 3 * pixels )) {
+            return false;
+         }
+      }
+      image.m_source = (const T *)source.m_buffer.get();
+      T * rgb = (T *)destination.m_buffer.get();
+
+      size_t blocks    = 4 * pool.getThreadCount();
+      size_t blockRows = ( image.m_height + blocks - 1 ) / blocks;
+
+      //Color differences need the green of the neighbouring rows, so green is completed first
+      std::vector<T> green;
+      if( method == DEMOSAIC_EDGE_AWARE ) {
+         green.resize( pixels );
+         image.m_green = green.data();
+         pool.parallelFor( image.m_height, blockRows, [&]( size_t begin, size_t end ) {
+            for( size_t y = begin; y < end; y++ ) {
+               T * row = image.m_green + y * image.m_width;
+               size_t done = 0;
+               if(( y > 0 )&&( y + 1 < image.m_height )) {
+                  done = edgeAwareGreenRow( image, y, row );
+               }
+               for( size_t x = ( done > 0 ) ? done : 1; x <= image.m_width; x++ ) {
+                  size_t column = ( x == image.m_width ) ? 0 : x;
+                  row[column] = edgeAwareGreen( image, column, y );
+               }
+            }
+         });
+      }
+
+      pool.parallelFor( image.m_height, blockRows, [&]( size_t begin, size_t end ) {
+         demosaicRows( image, method, rgb, begin, end );
+      });
+
+      return true;
+   }
+
+   /**
+    * \brief Converts an 8-bit Bayer image to RGB
+    *
+    * \param [in] source Bayer samples, one per pixel in row-major order
+    * \param [in] metadata image description. m_mode selects the Bayer pattern
+    * \param [out] destination receives R,G,B per pixel. It is reallocated if it is too small
+    * \param [in] method DEMOSAIC_BILINEAR or DEMOSAIC_EDGE_AWARE
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if the mode is not a Bayer mode or the buffers do not fit the image
+    **/
+   bool demosaic( ExtendedBuffer<uint8_t> &source
+                , ImageMetadata &metadata
+                , ExtendedBuffer<uint8_t> &destination
+                , uint16_t method
+                , AThreadPool &pool
+                )
+   {
+      return demosaicImage( source, metadata, destination, method, pool );
+   }
+
+   /**
+    * \brief Converts a 16-bit Bayer image to RGB
+    *
+    * See the 8-bit version. Samples of any bit depth up to 16 bits are supported.
+    **/
+   bool demosaic( ExtendedBuffer<uint16_t> &source
+                , ImageMetadata &metadata
+                , ExtendedBuffer<uint16_t> &destination
+                , uint16_t method
+                , AThreadPool &pool
+                )
+   {
+      return demosaicImage( source, metadata, destination, method, pool );
+   }
+
+   /**
+    * \brief Builds a Bayer mosaic of an RGB image
+    **/
+   template <typename T>
+   static void mosaic( const std::vector<T> &rgb, size_t width, size_t height, uint16_t mode, ExtendedBuffer<T> &bayer )
+   {
+      size_t redX = 0;
+      size_t redY = 0;
+      getRedPosition( mode, redX, redY );
+
+      bayer.allocate( width * height );
+      for( size_t y = 0; y < height; y++ ) {
+         for( size_t x = 0; x < width; x++ ) {
+            size_t channel = 1;
+            if((( x & 1 ) == redX )&&(( y & 1 ) == redY )) {
+               channel = 0;
+            }
+            else if((( x & 1 ) != redX )&&(( y & 1 ) != redY )) {
+               channel = 2;
+            }
+            bayer[y * width + x] = rgb[3 * ( y * width + x ) + channel];
+         }
+      }
+   }
+
+   /**
+    * \brief Checks that a uniform color is reproduced exactly for every pattern and method
+    **/
+   template <typename T>
+   static bool testUniform( T red, T green, T blue, AThreadPool &pool )
+   {
+      const size_t width  = 37;
+      const size_t height = 21;
+      const uint16_t modes[] = { APL_MODE_GRBG, APL_MODE_BGGR, APL_MODE_RGGB };
+
+      std::vector<T> rgb( 3 * width * height );
+      for( size_t i = 0; i < width * height; i++ ) {
+         rgb[3 * i]     = red;
+         rgb[3 * i + 1] = green;
+         rgb[3 * i + 2] = blue;
+      }
+
+      for( size_t m = 0; m < 3; m++ ) {
+         for( uint16_t method = DEMOSAIC_BILINEAR; method <= DEMOSAIC_EDGE_AWARE; method++ ) {
+            ImageMetadata metadata;
+            metadata.m_mode   = modes[m];
+            metadata.m_width  = width;
+            metadata.m_height = height;
+
+            ExtendedBuffer<T> bayer;
+            ExtendedBuffer<T> result;
+            mosaic( rgb, width, height, modes[m], bayer );
+            if(( !demosaic( bayer, metadata, result, method, pool ))
+             ||( memcmp( result.m_buffer.get(), rgb.data(), rgb.size() * sizeof(T)))) {
+               std::cout << "Demosaic of a uniform "<<8 * sizeof(T)<<"-bit image failed for mode "<<modes[m]<<" method "<<method<<std::endl;
+               return false;
+            }
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Unit test for Bayer demosaicing
+    **/
+   bool testDemosaic()
+   {
+      AThreadPool pool( 3 );
+      if(( !testUniform<uint8_t>( 200, 100, 50, pool ))||( !testUniform<uint16_t>( 4000, 2000, 1000, pool ))) {
+         return false;
+      }
+
+      //A gray image with a vertical edge
+      const size_t width  = 64;
+      const size_t height = 48;
+      std::vector<uint8_t> gray( 3 * width * height );
+      for( size_t y = 0; y < height; y++ ) {
+         for( size_t x = 0; x < width; x++ ) {
+            uint8_t value = ( x < 29 ) ? 20 : 220;
+            memset( &gray[3 * ( y * width + x )], value, 3 );
+         }
+      }
+
+      ImageMetadata metadata;
+      metadata.m_mode   = APL_MODE_GRBG;
+      metadata.m_width  = width;
+      metadata.m_height = height;
+
+      ExtendedBuffer<uint8_t> bayer;
+      ExtendedBuffer<uint8_t> bilinear;
+      ExtendedBuffer<uint8_t> edgeAware;
+      ExtendedBuffer<uint8_t> serial;
+      AThreadPool single( 1 );
+      mosaic( gray, width, height, APL_MODE_GRBG, bayer );
+      if(( !demosaic( bayer, metadata, bilinear, DEMOSAIC_BILINEAR, pool ))
+       ||( !demosaic( bayer, metadata, edgeAware, DEMOSAIC_EDGE_AWARE, pool ))
+       ||( !demosaic( bayer, metadata, serial, DEMOSAIC_EDGE_AWARE, single ))) {
+         std::cout << "Demosaic of the edge image failed"<<std::endl;
+         return false;
+      }
+
+      //Interpolating green along the edge removes the error bilinear makes across it
+      size_t bilinearError = 0;
+      size_t edgeError     = 0;
+      for( size_t i = 0; i < width * height; i++ ) {
+         bilinearError += std::abs( bilinear[3 * i + 1] - gray[3 * i + 1] );
+         edgeError     += std::abs( edgeAware[3 * i + 1] - gray[3 * i + 1] );
+      }
+      if(( edgeError != 0 )||( bilinearError == 0 )) {
+         std::cout << "Edge-aware demosaic green error "<<edgeError<<", bilinear "<<bilinearError<<std::endl;
+         return false;
+      }
+
+      if( memcmp( serial.m_buffer.get(), edgeAware.m_buffer.get(), 3 * width * height )) {
+         std::cout << "Demosaic result depends on the number of workers"<<std::endl;
+         return false;
+      }
+
+      //The row kernels match the per-pixel interpolation on noise, for both row phases
+      ImageMetadata noiseMetadata;
+      noiseMetadata.m_mode   = APL_MODE_RGGB;
+      noiseMetadata.m_width  = 53;
+      noiseMetadata.m_height = 6;
+      ExtendedBuffer<uint8_t> noise( 53 * 6 );
+      ExtendedBuffer<uint8_t> noiseColor;
+      srand( 5 );
+      for( size_t i = 0; i < 53 * 6; i++ ) {
+         noise[i] = (uint8_t)rand();
+      }
+      if( !demosaic( noise, noiseMetadata, noiseColor, DEMOSAIC_BILINEAR, pool )) {
+         std::cout << "Demosaic of the noise image failed"<<std::endl;
+         return false;
+      }
+      BayerImage<uint8_t> noiseImage;
+      noiseImage.m_source = noise.m_buffer.get();
+      noiseImage.m_green  = NULL;
+      noiseImage.m_width  = 53;
+      noiseImage.m_height = 6;
+      getRedPosition( APL_MODE_RGGB, noiseImage.m_redX, noiseImage.m_redY );
+      for( size_t i = 0; i < 53 * 6; i++ ) {
+         uint8_t expected[3];
+         bilinearPixel( noiseImage, i % 53, i / 53, expected[0], expected[1], expected[2] );
+         if( memcmp( expected, &noiseColor[3 * i], 3 )) {
+            std::cout << "Bilinear row of the noise image differs at pixel "<<i<<std::endl;
+            return false;
+         }
+      }
+
+      //The container interface converts the mode
+      ImageContainer<uint8_t> image;
+      ImageContainer<uint8_t> color;
+      image.m_metadata = metadata;
+      image.m_metadata.m_bpp = 8;
+      image.m_data = bayer;
+      if(( !image.demosaic( color, DEMOSAIC_BILINEAR, pool ))
+       ||( color.m_metadata.m_mode != APL_MODE_RGB )||( color.m_metadata.m_bpp != 24 )
+       ||( color.m_metadata.m_width != width )||( color.m_metadata.m_height != height )
+       ||( memcmp( color.m_data.m_buffer.get(), bilinear.m_buffer.get(), 3 * width * height ))) {
+         std::cout << "ImageContainer demosaic failed"<<std::endl;
+         return false;
+      }
+
+      //The output cannot overwrite its own Bayer source
+      std::vector<uint8_t> original( bayer.m_buffer.get(), bayer.m_buffer.get() + width * height );
+      if(( demosaic( bayer, metadata, bayer, DEMOSAIC_BILINEAR, pool ))
+       ||( bayer.getCapacity() != width * height )
+       ||( memcmp( bayer.m_buffer.get(), original.data(), width * height ))) {
+         std::cout << "Demosaic accepted the source as destination"<<std::endl;
+         return false;
+      }
+
+      metadata.m_mode = APL_MODE_RGB;
+      if( demosaic( bayer, metadata, bilinear )) {
+         std::cout << "Demosaic accepted a non-Bayer image"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+};
@@ -0,0 +1,44 @@
+//==============================================================================
+// Bayer demosaicing
+//
+// Converts single-color Bayer images (APL_MODE_GRBG, APL_MODE_BGGR and
+// APL_MODE_RGGB) into interleaved APL_MODE_RGB images. The image is split
+// into bands of rows that are processed by a thread pool. Each row is first
+// interpolated into separate red, green and blue rows by loops that handle
+// one 2x2 Bayer column pair per iteration, so the compiler can vectorize
+// them (the build enables vectorization for this file at -O2 as well), and
+// then interleaved into the output. 8-bit bilinear rows use SSE2 on x86-64.
+//==============================================================================
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ExtendedBuffer.tcc>
+#include <ImageMetadata.h>
+#include <AThreadPool.h>
+
+namespace atl
+{
+   // Demosaic methods
+   const uint16_t DEMOSAIC_BILINEAR   = 0;   //!< Average of the nearest samples of each color
+   const uint16_t DEMOSAIC_EDGE_AWARE = 1;   //!< Green along the smoother direction, red and blue from color differences
+
+   bool isBayerMode( uint16_t mode );
+
+   bool demosaic( ExtendedBuffer<uint8_t> &source
+                , ImageMetadata &metadata
+                , ExtendedBuffer<uint8_t> &destination
+                , uint16_t method = DEMOSAIC_BILINEAR
+                , AThreadPool &pool = getDefaultThreadPool()
+                );
+
+   bool demosaic( ExtendedBuffer<uint16_t> &source
+                , ImageMetadata &metadata
+                , ExtendedBuffer<uint16_t> &destination
+                , uint16_t method = DEMOSAIC_BILINEAR
+                , AThreadPool &pool = getDefaultThreadPool()
+                );
+
+   //Test functions
+   bool testDemosaic();
+};
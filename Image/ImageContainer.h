@@ -5,9 +5,15 @@
 #include <sstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <ImageMetadata.h>
 #include <ExtendedBuffer.tcc>
+#include <BaseContainer.h>
+#include <Demosaic.h>
+#include <ChannelConvert.h>
+#include <YuvConvert.h>
+#include <ImagePyramid.h>
 
 namespace atl
 {
@@ -31,13 +37,193 @@ namespace atl
    class ImageContainer : public BaseContainer
    {
       private:
+         static uint16_t getConvertedBpp( ImageMetadata &metadata, uint16_t mode );
+
       protected:
 
       public: 
          ExtendedBuffer<T> m_data;
          ImageMetadata m_metadata;            //!<Image metadata structure
+
+         bool demosaic( ImageContainer<T> &rgb, uint16_t method = DEMOSAIC_BILINEAR, AThreadPool &pool = getDefaultThreadPool());
+         bool convert( uint16_t mode, AThreadPool &pool = getDefaultThreadPool());
+         bool convert( ImageContainer<T> &destination, uint16_t mode, AThreadPool &pool = getDefaultThreadPool());
+         static bool convert( std::vector<ImageContainer<T> *> &images, uint16_t mode, AThreadPool &pool = getDefaultThreadPool());
+         bool buildPyramid( BaseContainer &pyramid, uint16_t filter = PYRAMID_BOX, AThreadPool &pool = getDefaultThreadPool());
+         bool updatePyramid( BaseContainer &pyramid, size_t x, size_t y, size_t width, size_t height, AThreadPool &pool = getDefaultThreadPool());
    };
 
+   /**
+    * \brief Converts a Bayer image into an RGB image
+    *
+    * \param [out] rgb receives the APL_MODE_RGB image
+    * \param [in] method DEMOSAIC_BILINEAR or DEMOSAIC_EDGE_AWARE
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if this is not a Bayer image
+    **/
+   template<typename T>
+   bool ImageContainer<T>::demosaic( ImageContainer<T> &rgb, uint16_t method, AThreadPool &pool )
+   {
+      if( !atl::demosaic( m_data, m_metadata, rgb.m_data, method, pool )) {
+         return false;
+      }
+
+      rgb.m_metadata.m_mode   = APL_MODE_RGB;
+      rgb.m_metadata.m_width  = m_metadata.m_width;
+      rgb.m_metadata.m_height = m_metadata.m_height;
+      rgb.m_metadata.m_bpp    = 3 * ( m_metadata.m_bpp ? m_metadata.m_bpp : 8 * sizeof(T));
+
+      return true;
+   }
+
+   /**
+    * \brief Returns the bits per pixel of an image after a mode conversion
+    **/
+   template<typename T>
+   uint16_t ImageContainer<T>::getConvertedBpp( ImageMetadata &metadata, uint16_t mode )
+   {
+      if( isYuvMode( mode )) {
+         return 16;
+      }
+      if(( isYuvMode( metadata.m_mode ))||( metadata.m_bpp == 0 )) {
+         return 8 * sizeof(T) * getChannelCount( mode );
+      }
+
+      //Keeps the sample depth of images stored in wider types
+      return metadata.m_bpp / getChannelCount( metadata.m_mode ) * getChannelCount( mode );
+   }
+
+   /**
+    * \brief Converts the image to another mode in place
+    *
+    * \param [in] mode destination mode: APL_MODE_RGB, APL_MODE_BGR, APL_MODE_BGRA or a YUV 4:2:2 mode
+    * \param [in] pool workers that convert the pixels
+    * \return true on success, false if the conversion is not supported
+    *
+    * Channel reordering converts the pixels in the image buffer unless the
+    * image grows beyond its capacity. YUV conversions always produce a new
+    * buffer.
+    **/
+   template<typename T>
+   bool ImageContainer<T>::convert( uint16_t mode, AThreadPool &pool )
+   {
+      std::vector<ImageContainer<T> *> images( 1, this );
+      return convert( images, mode, pool );
+   }
+
+   /**
+    * \brief Converts the image to another mode into a second image
+    *
+    * \param [out] destination receives the converted image
+    * \param [in] mode destination mode: APL_MODE_RGB, APL_MODE_BGR, APL_MODE_BGRA or a YUV 4:2:2 mode
+    * \param [in] pool workers that convert the pixels
+    * \return true on success, false if the conversion is not supported
+    *
+    * Conversions to or from YUV 4:2:2 use convertYuv, all others convertChannels.
+    **/
+   template<typename T>
+   bool ImageContainer<T>::convert( ImageContainer<T> &destination, uint16_t mode, AThreadPool &pool )
+   {
+      bool yuv = ( isYuvMode( m_metadata.m_mode ))||( isYuvMode( mode ));
+      bool rc  = yuv ? convertYuv( m_data, m_metadata, destination.m_data, mode, pool )
+                     : convertChannels( m_data, m_metadata, destination.m_data, mode, pool );
+      if( !rc ) {
+         return false;
+      }
+
+      destination.m_metadata.m_mode   = mode;
+      destination.m_metadata.m_width  = m_metadata.m_width;
+      destination.m_metadata.m_height = m_metadata.m_height;
+      destination.m_metadata.m_bpp    = getConvertedBpp( m_metadata, mode );
+
+      return true;
+   }
+
+   /**
+    * \brief Converts a batch of images to another mode in place
+    *
+    * \param [in] images images to convert. Their modes may differ
+    * \param [in] mode destination mode: APL_MODE_RGB, APL_MODE_BGR, APL_MODE_BGRA or a YUV 4:2:2 mode
+    * \param [in] pool workers that convert the pixels
+    * \return true on success, false if any conversion is not supported. No image is changed on failure
+    *
+    * The blocks of all channel reorderings are converted in one parallel
+    * pass. YUV conversions run one image at a time into new buffers, which
+    * replace the image buffers once every conversion has succeeded.
+    **/
+   template<typename T>
+   bool ImageContainer<T>::convert( std::vector<ImageContainer<T> *> &images, uint16_t mode, AThreadPool &pool )
+   {
+      std::vector<ChannelConversion<T> > batch;
+      std::vector<ExtendedBuffer<T> >    converted( images.size());
+      std::vector<bool>                  replace( images.size(), false );
+      for( size_t i = 0; i < images.size(); i++ ) {
+         ImageContainer<T> & image = *images[i];
+         if(( isYuvMode( image.m_metadata.m_mode ))||( isYuvMode( mode ))) {
+            if( !convertYuv( image.m_data, image.m_metadata, converted[i], mode, pool )) {
+               return false;
+            }
+            replace[i] = true;
+            continue;
+         }
+
+         size_t pixels = (size_t)image.m_metadata.m_width * image.m_metadata.m_height;
+         replace[i] = ( image.m_data.getCapacity() < pixels * getChannelCount( mode ));
+
+         ChannelConversion<T> conversion;
+         conversion.m_source      = &image.m_data;
+         conversion.m_destination = replace[i] ? &converted[i] : &image.m_data;
+         conversion.m_metadata    = &image.m_metadata;
+         batch.push_back( conversion );
+      }
+
+      if(( !batch.empty())&&( !convertChannels( batch, mode, pool ))) {
+         return false;
+      }
+
+      for( size_t i = 0; i < images.size(); i++ ) {
+         ImageMetadata & metadata = images[i]->m_metadata;
+         metadata.m_bpp  = getConvertedBpp( metadata, mode );
+         metadata.m_mode = mode;
+         if( replace[i] ) {
+            images[i]->m_data = converted[i];
+         }
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Builds the multi-resolution pyramid of the image
+    *
+    * \param [out] pyramid receives one chunk per level, level 0 sharing the image buffer
+    * \param [in] filter PYRAMID_BOX or PYRAMID_GAUSSIAN
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if the mode or filter is not supported
+    **/
+   template<typename T>
+   bool ImageContainer<T>::buildPyramid( BaseContainer &pyramid, uint16_t filter, AThreadPool &pool )
+   {
+      return atl::buildPyramid( m_data, m_metadata, pyramid, filter, pool );
+   }
+
+   /**
+    * \brief Updates the pyramid of the image after a region of the image changed
+    *
+    * \param [in,out] pyramid pyramid built by buildPyramid
+    * \param [in] x first changed column
+    * \param [in] y first changed row
+    * \param [in] width number of changed columns
+    * \param [in] height number of changed rows
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if the region or the pyramid does not match the image
+    **/
+   template<typename T>
+   bool ImageContainer<T>::updatePyramid( BaseContainer &pyramid, size_t x, size_t y, size_t width, size_t height, AThreadPool &pool )
+   {
+      return atl::updatePyramid( m_data, m_metadata, pyramid, x, y, width, height, pool );
+   }
+
    bool testImageContainer();
 };
 
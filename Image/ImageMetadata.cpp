@@ -1,11 +1,21 @@
 #include <iostream>
-#include <sstream>
 #include <string>
 
+#include <cstring>
+
 #include "ImageMetadata.h"
+#include "ByteOrder.h"
 
 namespace atl
 {
+   /**
+    * \brief Constructor. Sets the image metadata type id
+    **/
+   ImageMetadata::ImageMetadata()
+   {
+      m_typeId = METADATA_TYPE_IMAGE;
+   }
+
    /**
     * \brief Generates a jsonString based on the contained metadata
     * \param [in] brackets flag to indicate if the output includes enclosing bracketss
@@ -14,27 +24,179 @@ namespace atl
     **/
    std::string ImageMetadata::getJsonString(bool brackets )
    {
-      std::stringstream ss;
+      char buffer[384];
+      JsonWriter writer( buffer, sizeof(buffer));
+      writeJson( writer, brackets );
+
+      return std::string( writer.getString(), writer.getLength());
+   }
 
+   /**
+    * \brief Appends the json representation of the metadata to a writer
+    * \param [in] writer writer to append to
+    * \param [in] brackets flag to indicate if the output includes enclosing brackets
+    * \return true on success, false if the writer buffer is too small
+    *
+    * The base metadata is written directly into the same writer.
+    **/
+   bool ImageMetadata::writeJson( JsonWriter &writer, bool brackets )
+   {
       if(brackets) {
-         ss << "{";
+         writer.append('{');
       }
 
-      std::string baseString = BaseChunkMetadata::getJsonString(false);
-      ss << baseString << ","
-         << "\"image\":{"
-            << "\"mode\":"   << m_mode    << ","
-            << "\"width\":"  << m_width   << ","
-            << "\"height\":" << m_height  << ","
-            << "\"bpp\":"  << m_bpp     
-         << "}";
+      BaseChunkMetadata::writeJson( writer, false );
+      writer.append(',')
+            .appendKey("image").append('{')
+               .appendKey("mode").appendUInt( m_mode ).append(',')
+               .appendKey("width").appendUInt( m_width ).append(',')
+               .appendKey("height").appendUInt( m_height ).append(',')
+               .appendKey("bpp").appendUInt( m_bpp )
+            .append('}');
 
       if(brackets) {
-         ss << "}";
+         writer.append('}');
+      }
+
+      return writer.isValid();
+   }
+
+   /**
+    * \brief Returns the size of the binary representation
+    **/
+   size_t ImageMetadata::getSize()
+   {
+      return BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE + m_type.length();
+   }
+
+   /**
+    * \brief Writes the binary representation of the metadata
+    *
+    * \param [in] buffer destination buffer
+    * \param [in] bytes size of the destination buffer
+    * \return number of bytes written (getSize), 0 if the buffer is too small
+    *
+    * The layout is the BaseChunkMetadataRecord, the ImageMetadataRecord and the type string.
+    **/
+   size_t ImageMetadata::encode( uint8_t * buffer, size_t bytes )
+   {
+      size_t size = getSize();
+      if( bytes < size ) {
+         std::cerr << "ImageMetadata: encode buffer too small ("<<bytes<<"<"<<size<<")"<<std::endl;
+         return 0;
+      }
+
+      encodeRecord( buffer );
+
+      ImageMetadataRecord record;
+      record.m_mode   = toLittleEndian16( m_mode );
+      record.m_width  = toLittleEndian16( m_width );
+      record.m_height = toLittleEndian16( m_height );
+      record.m_bpp    = toLittleEndian16( m_bpp );
+      memcpy( &buffer[BASECONTAINERMETA_SIZE], &record, sizeof(record));
+      memcpy( &buffer[BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE], m_type.data(), m_type.length());
+
+      return size;
+   }
+
+   /**
+    * \brief Reads the binary representation written by encode
+    *
+    * \param [in] buffer encoded metadata
+    * \param [in] bytes size of the encoded metadata. Bytes past the fixed fields are the type
+    * \return true on success, false if the buffer is too small
+    **/
+   bool ImageMetadata::decode( const uint8_t * buffer, size_t bytes )
+   {
+      if( bytes < BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE ) {
+         std::cerr << "ImageMetadata: encoded metadata is truncated"<<std::endl;
+         return false;
+      }
+
+      decodeRecord( buffer );
+
+      ImageMetadataRecord record;
+      memcpy( &record, &buffer[BASECONTAINERMETA_SIZE], sizeof(record));
+      m_mode   = toLittleEndian16( record.m_mode );
+      m_width  = toLittleEndian16( record.m_width );
+      m_height = toLittleEndian16( record.m_height );
+      m_bpp    = toLittleEndian16( record.m_bpp );
+
+      size_t fixed = BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE;
+      m_type.assign( (const char *)&buffer[fixed], bytes - fixed );
+
+      return true;
+   }
+
+   /**
+    * \brief Reads a 16 bit unsigned field
+    * \return false if the value is invalid or exceeds 16 bits
+    **/
+   static bool readUInt16( JsonReader &reader, uint16_t &value )
+   {
+      uint64_t result = 0;
+      if( !reader.readUInt( result )) {
+         return false;
+      }
+
+      if( result > 0xFFFF ) {
+         std::cerr << "ImageMetadata: value "<<result<<" exceeds 16 bits"<<std::endl;
+         return false;
+      }
+
+      value = result;
+      return true;
+   }
+
+   /**
+    * \brief Fills the metadata from the json representation written by writeJson
+    *
+    * \param [in] text json text (with brackets)
+    * \param [in] length number of characters in the text
+    * \return true on success, false on a syntax error
+    *
+    * Fields may appear in any order, both at the top level and in the image
+    * object. Unknown fields are ignored.
+    **/
+   bool ImageMetadata::parseJson( const char * text, size_t length )
+   {
+      JsonReader   reader( text, length );
+      const char * key;
+      size_t       keyLength;
+      bool         rc = true;
+
+      reader.beginObject();
+      while( reader.nextKey( key, keyLength )) {
+         if( BaseChunkMetadata::readJsonField( reader, key, keyLength )) {
+            continue;
+         }
+
+         if( !JsonReader::keyEquals( key, keyLength, "image" )) {
+            reader.skipValue();
+            continue;
+         }
+
+         reader.beginObject();
+         while( reader.nextKey( key, keyLength )) {
+            if( JsonReader::keyEquals( key, keyLength, "mode" )) {
+               rc &= readUInt16( reader, m_mode );
+            }
+            else if( JsonReader::keyEquals( key, keyLength, "width" )) {
+               rc &= readUInt16( reader, m_width );
+            }
+            else if( JsonReader::keyEquals( key, keyLength, "height" )) {
+               rc &= readUInt16( reader, m_height );
+            }
+            else if( JsonReader::keyEquals( key, keyLength, "bpp" )) {
+               rc &= readUInt16( reader, m_bpp );
+            }
+            else {
+               reader.skipValue();
+            }
+         }
       }
-      std::string result = ss.str();
 
-      return result;
+      return rc && reader.isValid() && reader.atEnd();
    }
 
    /**
@@ -54,6 +216,48 @@ namespace atl
       std::string expected("{\"id\":1234,\"offset\":1235,\"elementSize\":1,\"image\":{\"mode\":1,\"width\":2,\"height\":3,\"bpp\":4}}");
       std::string result = metadata.getJsonString();
 
+      //The writer appends into a reused buffer and reports truncation
+      char buffer[256];
+      JsonWriter writer( buffer, sizeof(buffer));
+      for( int i = 0; i < 2; i++ ) {
+         writer.reset();
+         if(( !metadata.writeJson( writer ))||( expected.compare( writer.getString()))) {
+            std::cout << "testImageMetadata writeJson failed: "<<writer.getString()<<std::endl;
+            return false;
+         }
+      }
+
+      //Round trip through the parser with the image fields first
+      ImageMetadata parsed;
+      std::string json = "{\"image\":{\"bpp\":4,\"height\":3,\"width\":2,\"mode\":1},\"elementSize\":1,\"offset\":1235,\"id\":1234}";
+      if(( !parsed.parseJson( json.data(), json.length()))
+       ||( parsed.getJsonString() != expected )) {
+         std::cout << "testImageMetadata failed to parse "<<json<<std::endl;
+         return false;
+      }
+
+      //Binary round trip
+      metadata.m_type = "bayer";
+      uint8_t encoded[64];
+      ImageMetadata decoded;
+      size_t encodedSize = metadata.encode( encoded, sizeof(encoded));
+      if(( encodedSize != BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE + 5 )
+       ||( encodedSize != metadata.getSize())
+       ||( readLE16( &encoded[BASECONTAINERMETA_SIZE + 2] ) != 2 )
+       ||( !decoded.decode( encoded, encodedSize ))
+       ||( decoded.m_type != "bayer" )
+       ||( decoded.getJsonString() != expected )) {
+         std::cout << "testImageMetadata binary round trip failed"<<std::endl;
+         return false;
+      }
+      metadata.m_type.clear();
+
+      JsonWriter small( buffer, 32 );
+      if( metadata.writeJson( small )) {
+         std::cout << "testImageMetadata writeJson did not detect truncation"<<std::endl;
+         return false;
+      }
+
       if( !expected.compare(result)) {
          return true;
       }
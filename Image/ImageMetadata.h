@@ -3,9 +3,26 @@
 #include <climits>
 #include <stddef.h>
 #include <BaseChunkMetadata.h>
+#include <MetadataRegistry.tcc>
 
 namespace atl
 {
+#define IMAGEMETA_SIZE 8                      //!< Size of the binary image fields
+
+   /**
+    * \brief Binary encoding of the image fields (little-endian)
+    *
+    * The image fields follow the BaseChunkMetadataRecord and precede the type string.
+    **/
+   struct ImageMetadataRecord
+   {
+      uint16_t m_mode;                        //!< Image mode
+      uint16_t m_width;                       //!< Width of image
+      uint16_t m_height;                      //!< Height of image
+      uint16_t m_bpp;                         //!< Bits per pixel
+   };
+   static_assert( sizeof(ImageMetadataRecord) == IMAGEMETA_SIZE, "ImageMetadataRecord does not match IMAGEMETA_SIZE" );
+
    /**
     * \brief Low level data structure to associate pointer with a data size
     *
@@ -24,10 +41,28 @@ namespace atl
          uint16_t m_height = 0;               //!< Height of image
          uint16_t m_bpp    = 0;               //!< Bits per pixel
 
+         ImageMetadata();
 
+         size_t      getSize();
+         size_t      encode( uint8_t * buffer, size_t bytes );
+         bool        decode( const uint8_t * buffer, size_t bytes );
          std::string getJsonString( bool brackets = true );
+         bool        writeJson( JsonWriter &writer, bool brackets = true );
+         bool        parseJson( const char * text, size_t length );
    };
 
+   template <> struct MetadataTraits<ImageMetadata>
+   {
+      static const uint16_t id        = METADATA_TYPE_IMAGE;
+      static const size_t   fixedSize = BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE;
+      static constexpr const char * getName() { return "image"; }
+   };
+
+   /**
+    * \brief Registry of all metadata classes. New classes are appended in type id order
+    **/
+   typedef MetadataRegistry<BaseChunkMetadata, ImageMetadata> MetadataTypes;
+
 
    //Test functions
    bool testImageMetadata();
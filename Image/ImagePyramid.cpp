@@ -0,0 +1,685 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+
+#include <ImagePyramid.h>
+#include <ImageContainer.h>
+
+namespace atl
+{
+   /**
+    * \brief Type that holds the filter sums of a sample type without overflow
+    **/
+   template <typename T> struct PyramidSum;
+   template <> struct PyramidSum<uint8_t>  { typedef uint16_t Type; };
+   template <> struct PyramidSum<uint16_t> { typedef uint32_t Type; };
+
+   /**
+    * \brief A level of the pyramid and the level it is reduced from
+    **/
+   template <typename T>
+   struct PyramidLevel
+   {
+      const T * m_source;                     //!< Samples of the larger level
+      size_t    m_sourceWidth;                //!< Width of the larger level
+      size_t    m_sourceHeight;               //!< Height of the larger level
+      T       * m_destination;                //!< Samples of the reduced level
+      size_t    m_width;                      //!< Width of the reduced level
+      size_t    m_height;                     //!< Height of the reduced level
+   };
+
+   /**
+    * \brief Returns the number of interleaved samples per pixel, 0 if the mode is not supported
+    **/
+   static size_t getPyramidChannels( uint16_t mode )
+   {
+      return ( mode == APL_MODE_GRAY ) ? 1 : getChannelCount( mode );
+   }
+
+   /**
+    * \brief Returns the chunk type that records the filter of a pyramid
+    **/
+   static const char * getPyramidType( uint16_t filter )
+   {
+      return ( filter == PYRAMID_GAUSSIAN ) ? "pyramid gaussian" : "pyramid box";
+   }
+
+   /**
+    * \brief Returns the number of levels of the pyramid of an image, including the image
+    *
+    * \param [in] metadata description of the image
+    * \return number of levels down to a single pixel, 0 for an empty image
+    **/
+   size_t getPyramidLevels( ImageMetadata &metadata )
+   {
+      size_t width  = metadata.m_width;
+      size_t height = metadata.m_height;
+      if(( width == 0 )||( height == 0 )) {
+         return 0;
+      }
+
+      size_t levels = 1;
+      while(( width > 1 )||( height > 1 )) {
+         width  = ( width + 1 ) / 2;
+         height = ( height + 1 ) / 2;
+         levels++;
+      }
+      return levels;
+   }
+
+   /**
+    * \brief Describes one level of the pyramid of an image
+    *
+    * \param [in] metadata description of the image
+    * \param [in] level pyramid level, 0 for the image itself
+    * \param [out] levelMetadata receives the mode, size and bits per pixel of the level
+    * \return true on success, false if the level does not exist
+    *
+    * Each level is half the size of the level above, rounded up.
+    **/
+   bool getPyramidLevel( ImageMetadata &metadata, size_t level, ImageMetadata &levelMetadata )
+   {
+      if( level >= getPyramidLevels( metadata )) {
+         return false;
+      }
+
+      size_t width  = metadata.m_width;
+      size_t height = metadata.m_height;
+      for( size_t i = 0; i < level; i++ ) {
+         width  = ( width + 1 ) / 2;
+         height = ( height + 1 ) / 2;
+      }
+
+      levelMetadata.m_id     = level;
+      levelMetadata.m_mode   = metadata.m_mode;
+      levelMetadata.m_width  = width;
+      levelMetadata.m_height = height;
+      levelMetadata.m_bpp    = metadata.m_bpp;
+      return true;
+   }
+
+   /**
+    * \brief Reduces columns [begin,end) of rows [rowBegin,rowEnd) of a level
+    *
+    * The vertical pass sums the source rows of each output row into a row of
+    * source pixels from 2*begin-1 to 2*end, with the samples beyond the image
+    * repeating the edge. The horizontal pass combines pairs (box) or four
+    * (Gaussian) of these sums per output sample.
+    **/
+   template <typename T, size_t CHANNELS>
+   static void reduceRows( const PyramidLevel<T> &level
+                         , uint16_t filter
+                         , size_t rowBegin
+                         , size_t rowEnd
+                         , size_t begin
+                         , size_t end
+                         )
+   {
+      typedef typename PyramidSum<T>::Type Sum;
+
+      size_t count = end - begin;
+      std::vector<Sum> sums(( 2 * count + 2 ) * CHANNELS );
+
+      //Source columns [first,last) lie inside the image, the rest are edge copies
+      long   origin = 2 * (long)begin - 1;
+      size_t first  = ( begin > 0 ) ? origin : 0;
+      size_t last   = std::min( 2 * end + 1, level.m_sourceWidth );
+      size_t left   = first - origin;
+      size_t right  = left + last - first;
+      size_t samples = ( last - first ) * CHANNELS;
+      size_t stride  = level.m_sourceWidth * CHANNELS;
+
+      for( size_t y = rowBegin; y < rowEnd; y++ ) {
+         size_t bottom = level.m_sourceHeight - 1;
+         size_t row1 = std::min( 2 * y, bottom );
+         size_t row2 = std::min( 2 * y + 1, bottom );
+         const T * r1 = level.m_source + row1 * stride + first * CHANNELS;
+         const T * r2 = level.m_source + row2 * stride + first * CHANNELS;
+         Sum * vertical = sums.data() + left * CHANNELS;
+
+         if( filter == PYRAMID_BOX ) {
+            for( size_t i = 0; i < samples; i++ ) {
+               vertical[i] = (Sum)r1[i] + r2[i];
+            }
+         }
+         else {
+            size_t row0 = ( y > 0 ) ? 2 * y - 1 : 0;
+            size_t row3 = std::min( 2 * y + 2, bottom );
+            const T * r0 = level.m_source + row0 * stride + first * CHANNELS;
+            const T * r3 = level.m_source + row3 * stride + first * CHANNELS;
+            for( size_t i = 0; i < samples; i++ ) {
+               vertical[i] = (Sum)r0[i] + r3[i] + 3 * ((Sum)r1[i] + r2[i] );
+            }
+         }
+
+         for( size_t p = 0; p < left; p++ ) {
+            memcpy( &sums[p * CHANNELS], &sums[left * CHANNELS], CHANNELS * sizeof(Sum));
+         }
+         for( size_t p = right; p < 2 * count + 2; p++ ) {
+            memcpy( &sums[p * CHANNELS], &sums[( right - 1 ) * CHANNELS], CHANNELS * sizeof(Sum));
+         }
+
+         const Sum * s = sums.data();
+         T * out = level.m_destination + ( y * level.m_width + begin ) * CHANNELS;
+         if( filter == PYRAMID_BOX ) {
+            for( size_t k = 0; k < count; k++ ) {
+               for( size_t c = 0; c < CHANNELS; c++ ) {
+                  out[k * CHANNELS + c] = (T)(( s[( 2 * k + 1 ) * CHANNELS + c] + s[( 2 * k + 2 ) * CHANNELS + c] + 2 ) >> 2 );
+               }
+            }
+         }
+         else {
+            for( size_t k = 0; k < count; k++ ) {
+               for( size_t c = 0; c < CHANNELS; c++ ) {
+                  Sum outer = s[2 * k * CHANNELS + c] + s[( 2 * k + 3 ) * CHANNELS + c];
+                  Sum inner = s[( 2 * k + 1 ) * CHANNELS + c] + s[( 2 * k + 2 ) * CHANNELS + c];
+                  out[k * CHANNELS + c] = (T)(( outer + 3 * inner + 32 ) >> 6 );
+               }
+            }
+         }
+      }
+   }
+
+   /**
+    * \brief Reduces the region [x0,x1)x[y0,y1) of a level in bands of rows
+    **/
+   template <typename T>
+   static void reduceRegion( const PyramidLevel<T> &level
+                           , size_t channels
+                           , uint16_t filter
+                           , size_t x0
+                           , size_t y0
+                           , size_t x1
+                           , size_t y1
+                           , AThreadPool &pool
+                           )
+   {
+      size_t rows      = y1 - y0;
+      size_t blocks    = 4 * pool.getThreadCount();
+      size_t blockRows = ( rows + blocks - 1 ) / blocks;
+      size_t minRows   = ( PYRAMID_BLOCK_PIXELS + ( x1 - x0 ) - 1 ) / ( x1 - x0 );
+      blockRows = std::max( blockRows, minRows );
+
+      pool.parallelFor( rows, blockRows, [&]( size_t begin, size_t end ) {
+         switch( channels ) {
+            case 1:  reduceRows<T, 1>( level, filter, y0 + begin, y0 + end, x0, x1 ); break;
+            case 3:  reduceRows<T, 3>( level, filter, y0 + begin, y0 + end, x0, x1 ); break;
+            default: reduceRows<T, 4>( level, filter, y0 + begin, y0 + end, x0, x1 ); break;
+         }
+      });
+   }
+
+   /**
+    * \brief Returns the range of a reduced level that depends on a range of the level above
+    *
+    * \param [in,out] begin first changed position, replaced by the first affected one
+    * \param [in,out] end position after the last changed one, replaced by the one after the last affected
+    * \param [in] size size of the reduced level
+    **/
+   static void reduceRange( uint16_t filter, size_t &begin, size_t &end, size_t size )
+   {
+      //Output i reads 2i,2i+1 (box) or 2i-1 to 2i+2 (Gaussian)
+      if( filter == PYRAMID_BOX ) {
+         begin = begin / 2;
+         end   = ( end + 1 ) / 2;
+      }
+      else {
+         begin = ( begin > 0 ) ? ( begin - 1 ) / 2 : 0;
+         end   = end / 2 + 1;
+      }
+      end = std::min( end, size );
+   }
+
+   /**
+    * \brief Checks an image and returns its number of channels
+    **/
+   template <typename T>
+   static size_t checkPyramidImage( const char * caller, ExtendedBuffer<T> &source, ImageMetadata &metadata )
+   {
+      size_t channels = getPyramidChannels( metadata.m_mode );
+      if( channels == 0 ) {
+         std::cerr << caller <<": mode "<<metadata.m_mode<<" is not supported"<<std::endl;
+         return 0;
+      }
+      if(( metadata.m_width == 0 )||( metadata.m_height == 0 )) {
+         std::cerr << caller <<": the image is empty"<<std::endl;
+         return 0;
+      }
+
+      size_t samples = (size_t)metadata.m_width * metadata.m_height * channels;
+      if( source.getCapacity() < samples ) {
+         std::cerr << caller <<": source holds "<<source.getCapacity()<<" of "<<samples<<" samples"<<std::endl;
+         return 0;
+      }
+      return channels;
+   }
+
+   /**
+    * \brief Recomputes the pixels of every level below 0 that depend on a region of level 0
+    **/
+   template <typename T>
+   static void reducePyramid( BaseContainer &pyramid
+                            , ImageMetadata &metadata
+                            , size_t channels
+                            , uint16_t filter
+                            , size_t x0
+                            , size_t y0
+                            , size_t x1
+                            , size_t y1
+                            , AThreadPool &pool
+                            )
+   {
+      ImageMetadata above;
+      ImageMetadata below;
+      getPyramidLevel( metadata, 0, above );
+      for( size_t i = 1; i < pyramid.m_containerArray.getSize(); i++ ) {
+         getPyramidLevel( metadata, i, below );
+         reduceRange( filter, x0, x1, below.m_width );
+         reduceRange( filter, y0, y1, below.m_height );
+
+         PyramidLevel<T> level;
+         level.m_source       = (const T *)pyramid[i - 1].m_buffer.m_buffer.get();
+         level.m_sourceWidth  = above.m_width;
+         level.m_sourceHeight = above.m_height;
+         level.m_destination  = (T *)pyramid[i].m_buffer.m_buffer.get();
+         level.m_width        = below.m_width;
+         level.m_height       = below.m_height;
+         reduceRegion( level, channels, filter, x0, y0, x1, y1, pool );
+
+         above = below;
+      }
+   }
+
+   /**
+    * \brief Builds the pyramid of an image of any sample type
+    **/
+   template <typename T>
+   static bool buildImagePyramid( ExtendedBuffer<T> &source
+                                , ImageMetadata &metadata
+                                , BaseContainer &pyramid
+                                , uint16_t filter
+                                , AThreadPool &pool
+                                )
+   {
+      if(( filter != PYRAMID_BOX )&&( filter != PYRAMID_GAUSSIAN )) {
+         std::cerr << "buildPyramid: unknown filter "<<filter<<std::endl;
+         return false;
+      }
+      size_t channels = checkPyramidImage( "buildPyramid", source, metadata );
+      if( channels == 0 ) {
+         return false;
+      }
+
+      while( pyramid.m_containerArray.getSize()) {
+         pyramid.pop();
+      }
+
+      size_t levels = getPyramidLevels( metadata );
+      for( size_t i = 0; i < levels; i++ ) {
+         ImageMetadata levelMetadata;
+         getPyramidLevel( metadata, i, levelMetadata );
+
+         BaseChunk chunk( i );
+         chunk.m_metadata.m_elementSize  = sizeof(T);
+         chunk.m_metadata.m_elementCount = (size_t)levelMetadata.m_width * levelMetadata.m_height * channels;
+         chunk.m_metadata.m_type         = getPyramidType( filter );
+
+         size_t bytes = chunk.m_metadata.m_elementCount * sizeof(T);
+         if( i == 0 ) {
+            chunk.m_buffer.m_buffer     = source.m_buffer;
+            chunk.m_buffer.m_bufferSize = bytes;
+         }
+         else if( !chunk.allocate( bytes )) {
+            return false;
+         }
+         pyramid.push_back( chunk );
+      }
+
+      reducePyramid<T>( pyramid, metadata, channels, filter, 0, 0, metadata.m_width, metadata.m_height, pool );
+      return true;
+   }
+
+   /**
+    * \brief Updates the pyramid of an image of any sample type
+    **/
+   template <typename T>
+   static bool updateImagePyramid( ExtendedBuffer<T> &source
+                                 , ImageMetadata &metadata
+                                 , BaseContainer &pyramid
+                                 , size_t x
+                                 , size_t y
+                                 , size_t width
+                                 , size_t height
+                                 , AThreadPool &pool
+                                 )
+   {
+      size_t channels = checkPyramidImage( "updatePyramid", source, metadata );
+      if( channels == 0 ) {
+         return false;
+      }
+      if(( x + width > metadata.m_width )||( y + height > metadata.m_height )) {
+         std::cerr << "updatePyramid: region "<<width<<"x"<<height<<" at "<<x<<","<<y<<" exceeds the image"<<std::endl;
+         return false;
+      }
+
+      //The chunks must match the image, and record the filter they were built with
+      size_t levels = getPyramidLevels( metadata );
+      bool   valid  = ( pyramid.m_containerArray.getSize() == levels );
+      for( size_t i = 0; ( valid )&&( i < levels ); i++ ) {
+         ImageMetadata levelMetadata;
+         getPyramidLevel( metadata, i, levelMetadata );
+         BaseChunk chunk = pyramid[i];
+         valid = ( chunk.m_metadata.m_elementSize == sizeof(T) )
+              && ( chunk.m_metadata.m_elementCount == (size_t)levelMetadata.m_width * levelMetadata.m_height * channels )
+              && ( chunk.m_buffer.m_bufferSize >= chunk.m_metadata.m_elementCount * sizeof(T) )
+              && ( chunk.m_metadata.m_type == pyramid[0].m_metadata.m_type );
+      }
+      uint16_t filter = PYRAMID_BOX;
+      if(( valid )&&( pyramid[0].m_metadata.m_type != getPyramidType( PYRAMID_BOX ))) {
+         filter = PYRAMID_GAUSSIAN;
+         valid  = ( pyramid[0].m_metadata.m_type == getPyramidType( PYRAMID_GAUSSIAN ));
+      }
+      if( !valid ) {
+         std::cerr << "updatePyramid: the container does not hold a pyramid of this image"<<std::endl;
+         return false;
+      }
+      if(( width == 0 )||( height == 0 )) {
+         return true;
+      }
+
+      //Level 0 no longer shares the image buffer if the pyramid was loaded or the image reallocated
+      T * level0 = (T *)pyramid[0].m_buffer.m_buffer.get();
+      const T * image = (const T *)source.m_buffer.get();
+      if( level0 != image ) {
+         for( size_t row = y; row < y + height; row++ ) {
+            size_t offset = ( row * metadata.m_width + x ) * channels;
+            memcpy( level0 + offset, image + offset, width * channels * sizeof(T));
+         }
+      }
+
+      reducePyramid<T>( pyramid, metadata, channels, filter, x, y, x + width, y + height, pool );
+      return true;
+   }
+
+   /**
+    * \brief Builds the pyramid of an 8-bit image
+    *
+    * \param [in] source image samples in row-major order
+    * \param [in] metadata image description. m_mode must be APL_MODE_GRAY, APL_MODE_RGB, APL_MODE_BGR or APL_MODE_BGRA
+    * \param [out] pyramid receives one chunk per level. Existing chunks are removed
+    * \param [in] filter PYRAMID_BOX or PYRAMID_GAUSSIAN
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if the image or filter is not supported
+    *
+    * Level 0 shares the source buffer, the other levels are allocated.
+    **/
+   bool buildPyramid( ExtendedBuffer<uint8_t> &source
+                    , ImageMetadata &metadata
+                    , BaseContainer &pyramid
+                    , uint16_t filter
+                    , AThreadPool &pool
+                    )
+   {
+      return buildImagePyramid( source, metadata, pyramid, filter, pool );
+   }
+
+   /**
+    * \brief Builds the pyramid of a 16-bit image
+    *
+    * See the 8-bit version.
+    **/
+   bool buildPyramid( ExtendedBuffer<uint16_t> &source
+                    , ImageMetadata &metadata
+                    , BaseContainer &pyramid
+                    , uint16_t filter
+                    , AThreadPool &pool
+                    )
+   {
+      return buildImagePyramid( source, metadata, pyramid, filter, pool );
+   }
+
+   /**
+    * \brief Updates the pyramid of an 8-bit image after a region of the image changed
+    *
+    * \param [in] source image samples in row-major order
+    * \param [in] metadata image description
+    * \param [in,out] pyramid pyramid built by buildPyramid for this image
+    * \param [in] x first changed column
+    * \param [in] y first changed row
+    * \param [in] width number of changed columns
+    * \param [in] height number of changed rows
+    * \param [in] pool workers that process bands of rows
+    * \return true on success, false if the region or the pyramid does not match the image
+    *
+    * The pyramid is updated with the filter it was built with. If level 0 no
+    * longer shares the source buffer, the region is copied into it first.
+    **/
+   bool updatePyramid( ExtendedBuffer<uint8_t> &source
+                     , ImageMetadata &metadata
+                     , BaseContainer &pyramid
+                     , size_t x
+                     , size_t y
+                     , size_t width
+                     , size_t height
+                     , AThreadPool &pool
+                     )
+   {
+      return updateImagePyramid( source, metadata, pyramid, x, y, width, height, pool );
+   }
+
+   /**
+    * \brief Updates the pyramid of a 16-bit image after a region of the image changed
+    *
+    * See the 8-bit version.
+    **/
+   bool updatePyramid( ExtendedBuffer<uint16_t> &source
+                     , ImageMetadata &metadata
+                     , BaseContainer &pyramid
+                     , size_t x
+                     , size_t y
+                     , size_t width
+                     , size_t height
+                     , AThreadPool &pool
+                     )
+   {
+      return updateImagePyramid( source, metadata, pyramid, x, y, width, height, pool );
+   }
+
+   /**
+    * \brief Reduces a level with direct per-sample filtering
+    **/
+   template <typename T>
+   static std::vector<T> reduceReference( const std::vector<T> &source
+                                        , size_t width
+                                        , size_t height
+                                        , size_t channels
+                                        , uint16_t filter
+                                        )
+   {
+      static const int boxWeights[]      = { 0, 1, 1, 0 };
+      static const int gaussianWeights[] = { 1, 3, 3, 1 };
+      const int * weights = ( filter == PYRAMID_BOX ) ? boxWeights : gaussianWeights;
+      int total = ( filter == PYRAMID_BOX ) ? 4 : 64;
+
+      size_t outWidth  = ( width + 1 ) / 2;
+      size_t outHeight = ( height + 1 ) / 2;
+      std::vector<T> result( outWidth * outHeight * channels );
+      for( size_t y = 0; y < outHeight; y++ ) {
+         for( size_t x = 0; x < outWidth; x++ ) {
+            for( size_t c = 0; c < channels; c++ ) {
+               long sum = 0;
+               for( int j = 0; j < 4; j++ ) {
+                  long row = std::min( std::max( 2 * (long)y - 1 + j, 0L ), (long)height - 1 );
+                  for( int i = 0; i < 4; i++ ) {
+                     long column = std::min( std::max( 2 * (long)x - 1 + i, 0L ), (long)width - 1 );
+                     sum += weights[j] * weights[i] * (long)source[( row * width + column ) * channels + c];
+                  }
+               }
+               result[( y * outWidth + x ) * channels + c] = (T)(( sum + total / 2 ) / total );
+            }
+         }
+      }
+      return result;
+   }
+
+   /**
+    * \brief Compares every level of a pyramid with the reference reduction of an image
+    **/
+   template <typename T>
+   static bool checkPyramid( BaseContainer &pyramid, const ExtendedBuffer<T> &image, ImageMetadata &metadata, uint16_t filter )
+   {
+      size_t channels = getPyramidChannels( metadata.m_mode );
+      size_t width    = metadata.m_width;
+      size_t height   = metadata.m_height;
+      const T * data  = (const T *)image.m_buffer.get();
+      std::vector<T> level( data, data + width * height * channels );
+
+      if( pyramid.m_containerArray.getSize() != getPyramidLevels( metadata )) {
+         return false;
+      }
+      for( size_t i = 0; i < pyramid.m_containerArray.getSize(); i++ ) {
+         BaseChunk chunk = pyramid[i];
+         if(( chunk.m_metadata.m_id != i )
+          ||( chunk.m_metadata.m_elementCount != level.size())
+          ||( memcmp( chunk.m_buffer.m_buffer.get(), level.data(), level.size() * sizeof(T)))) {
+            std::cout << "Pyramid level "<<i<<" of a "<<width<<"x"<<height<<" image with "<<channels<<" channels differs from the reference"<<std::endl;
+            return false;
+         }
+         level  = reduceReference( level, width, height, channels, filter );
+         width  = ( width + 1 ) / 2;
+         height = ( height + 1 ) / 2;
+      }
+      return true;
+   }
+
+   /**
+    * \brief Builds and updates pyramids of random images and checks them against the reference
+    **/
+   template <typename T>
+   static bool testPyramidType( uint16_t mode, size_t width, size_t height, AThreadPool &pool )
+   {
+      ImageMetadata metadata;
+      metadata.m_mode   = mode;
+      metadata.m_width  = width;
+      metadata.m_height = height;
+
+      size_t channels = getPyramidChannels( mode );
+      size_t samples  = width * height * channels;
+      ExtendedBuffer<T> image( samples );
+      for( size_t i = 0; i < samples; i++ ) {
+         image[i] = (T)rand();
+      }
+
+      AThreadPool single( 1 );
+      for( uint16_t filter = PYRAMID_BOX; filter <= PYRAMID_GAUSSIAN; filter++ ) {
+         BaseContainer pyramid;
+         BaseContainer serial;
+         if(( !buildPyramid( image, metadata, pyramid, filter, pool ))
+          ||( !buildPyramid( image, metadata, serial, filter, single ))
+          ||( !checkPyramid( pyramid, image, metadata, filter ))
+          ||( !checkPyramid( serial, image, metadata, filter ))) {
+            std::cout << "Pyramid of a "<<8 * sizeof(T)<<"-bit image failed for filter "<<filter<<std::endl;
+            return false;
+         }
+
+         //Changing a region in place and updating matches a rebuild
+         size_t x = width / 3;
+         size_t y = height / 4;
+         size_t w = width / 5 + 1;
+         size_t h = height / 3 + 1;
+         for( size_t row = y; row < y + h; row++ ) {
+            for( size_t i = ( row * width + x ) * channels; i < ( row * width + x + w ) * channels; i++ ) {
+               image[i] = (T)rand();
+            }
+         }
+         if(( !updatePyramid( image, metadata, pyramid, x, y, w, h, pool ))
+          ||( !checkPyramid( pyramid, image, metadata, filter ))) {
+            std::cout << "Pyramid update of a "<<8 * sizeof(T)<<"-bit image failed for filter "<<filter<<std::endl;
+            return false;
+         }
+
+         //An edited copy of the image is copied into level 0
+         ExtendedBuffer<T> edited( samples );
+         memcpy( edited.m_buffer.get(), image.m_buffer.get(), samples * sizeof(T));
+         for( size_t i = samples - channels; i < samples; i++ ) {
+            edited[i] = (T)rand();
+         }
+         if(( !updatePyramid( edited, metadata, pyramid, width - 1, height - 1, 1, 1, pool ))
+          ||( !checkPyramid( pyramid, edited, metadata, filter ))) {
+            std::cout << "Pyramid update from a copy of the image failed for filter "<<filter<<std::endl;
+            return false;
+         }
+         memcpy( image.m_buffer.get(), edited.m_buffer.get(), samples * sizeof(T));
+      }
+
+      return true;
+   }
+
+   /**
+    * \brief Unit test for image pyramids
+    **/
+   bool testImagePyramid()
+   {
+      AThreadPool pool( 3 );
+      srand( 1 );
+
+      ImageMetadata metadata;
+      ImageMetadata level;
+      metadata.m_mode   = APL_MODE_RGB;
+      metadata.m_width  = 37;
+      metadata.m_height = 21;
+      metadata.m_bpp    = 24;
+      if(( getPyramidLevels( metadata ) != 7 )
+       ||( !getPyramidLevel( metadata, 1, level ))||( level.m_width != 19 )||( level.m_height != 11 )
+       ||( !getPyramidLevel( metadata, 6, level ))||( level.m_width != 1 )||( level.m_height != 1 )||( level.m_bpp != 24 )
+       ||( getPyramidLevel( metadata, 7, level ))) {
+         std::cout << "Pyramid level geometry is wrong"<<std::endl;
+         return false;
+      }
+
+      if(( !testPyramidType<uint8_t>( APL_MODE_GRAY, 37, 21, pool ))
+       ||( !testPyramidType<uint8_t>( APL_MODE_RGB, 64, 48, pool ))
+       ||( !testPyramidType<uint8_t>( APL_MODE_BGRA, 33, 1, pool ))
+       ||( !testPyramidType<uint16_t>( APL_MODE_BGR, 29, 40, pool ))
+       ||( !testPyramidType<uint16_t>( APL_MODE_BGRA, 1, 9, pool ))) {
+         return false;
+      }
+
+      //Level 0 shares the image buffer
+      ImageContainer<uint8_t> image;
+      image.m_metadata = metadata;
+      image.m_data.allocate( 37 * 21 * 3 );
+      memset( image.m_data.m_buffer.get(), 90, 37 * 21 * 3 );
+      BaseContainer pyramid;
+      if(( !image.buildPyramid( pyramid, PYRAMID_GAUSSIAN, pool ))
+       ||( pyramid[0].m_buffer.m_buffer.get() != image.m_data.m_buffer.get())
+       ||( pyramid[6].m_buffer[0] != 90 )) {
+         std::cout << "ImageContainer pyramid failed"<<std::endl;
+         return false;
+      }
+      memset( image.m_data.m_buffer.get(), 30, 37 * 21 * 3 );
+      if(( !image.updatePyramid( pyramid, 0, 0, 37, 21, pool ))||( pyramid[6].m_buffer[2] != 30 )) {
+         std::cout << "ImageContainer pyramid update failed"<<std::endl;
+         return false;
+      }
+
+      //Unsupported images, regions and containers are rejected
+      ImageContainer<uint8_t> other;
+      other.m_metadata = metadata;
+      other.m_metadata.m_width = 36;
+      other.m_data = image.m_data;
+      image.m_metadata.m_mode = APL_MODE_GRBG;
+      if(( image.buildPyramid( pyramid, PYRAMID_BOX, pool ))
+       ||( other.buildPyramid( pyramid, 2, pool ))
+       ||( other.updatePyramid( pyramid, 0, 0, 1, 1, pool ))
+       ||( other.updatePyramid( pyramid, 30, 0, 7, 1, pool ))) {
+         std::cout << "Pyramid accepted invalid input"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+};
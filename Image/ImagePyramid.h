@@ -0,0 +1,72 @@
+//==============================================================================
+// Multi-resolution image pyramids
+//
+// A pyramid holds an image and successively half-size copies of it down to
+// a single pixel, one BaseContainer chunk per level with the chunk id equal
+// to the level. Level 0 shares the buffer of the source image. Each level
+// is reduced from the one above with a 2x2 box filter or a separable 1,3,3,1
+// binomial (Gaussian) filter; samples outside the image repeat the edge.
+//
+// Rows are filtered vertically into a row of wider sums and then
+// horizontally, both with branch-free loops the compiler vectorizes (the
+// build enables vectorization for this file at -O2 as well). Bands of rows
+// run in parallel. updatePyramid recomputes only the pixels of each level
+// that depend on a changed region of the source.
+//==============================================================================
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ExtendedBuffer.tcc>
+#include <ImageMetadata.h>
+#include <BaseContainer.h>
+#include <AThreadPool.h>
+
+#define PYRAMID_BLOCK_PIXELS 65536            //!< Minimum pixels per parallel work item
+
+namespace atl
+{
+   // Pyramid filters
+   const uint16_t PYRAMID_BOX      = 0;       //!< Average of each 2x2 block
+   const uint16_t PYRAMID_GAUSSIAN = 1;       //!< Separable 1,3,3,1 binomial over 4x4 samples
+
+   size_t getPyramidLevels( ImageMetadata &metadata );
+   bool   getPyramidLevel( ImageMetadata &metadata, size_t level, ImageMetadata &levelMetadata );
+
+   bool buildPyramid( ExtendedBuffer<uint8_t> &source
+                    , ImageMetadata &metadata
+                    , BaseContainer &pyramid
+                    , uint16_t filter = PYRAMID_BOX
+                    , AThreadPool &pool = getDefaultThreadPool()
+                    );
+
+   bool buildPyramid( ExtendedBuffer<uint16_t> &source
+                    , ImageMetadata &metadata
+                    , BaseContainer &pyramid
+                    , uint16_t filter = PYRAMID_BOX
+                    , AThreadPool &pool = getDefaultThreadPool()
+                    );
+
+   bool updatePyramid( ExtendedBuffer<uint8_t> &source
+                     , ImageMetadata &metadata
+                     , BaseContainer &pyramid
+                     , size_t x
+                     , size_t y
+                     , size_t width
+                     , size_t height
+                     , AThreadPool &pool = getDefaultThreadPool()
+                     );
+
+   bool updatePyramid( ExtendedBuffer<uint16_t> &source
+                     , ImageMetadata &metadata
+                     , BaseContainer &pyramid
+                     , size_t x
+                     , size_t y
+                     , size_t width
+                     , size_t height
+                     , AThreadPool &pool = getDefaultThreadPool()
+                     );
+
+   //Test functions
+   bool testImagePyramid();
+};
@@ -0,0 +1,502 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include <YuvConvert.h>
+#include <ChannelConvert.h>
+#include <ImageContainer.h>
+
+#define YUV_SHIFT 14                          //!< Fraction bits of the fixed-point coefficients
+
+namespace atl
+{
+   static const double YUV_KR = 0.299;        //!< BT.601 red weight of luma
+   static const double YUV_KB = 0.114;        //!< BT.601 blue weight of luma
+   static const double YUV_KG = 1.0 - YUV_KR - YUV_KB;
+
+   /**
+    * \brief Fixed-point coefficients of the YUV to RGB conversion
+    **/
+   struct YuvDecoder
+   {
+      int m_yOffset;                          //!< Luma of black
+      int m_yScale;                           //!< Luma gain
+      int m_rv;                               //!< V contribution to red
+      int m_gu;                               //!< U contribution to green (subtracted)
+      int m_gv;                               //!< V contribution to green (subtracted)
+      int m_bu;                               //!< U contribution to blue
+   };
+
+   /**
+    * \brief Fixed-point coefficients of the RGB to YUV conversion
+    **/
+   struct YuvEncoder
+   {
+      int m_ry, m_gy, m_by;                   //!< Luma weights
+      int m_ru, m_gu, m_bu;                   //!< U weights
+      int m_rv, m_gv, m_bv;                   //!< V weights
+      int m_yRound;                           //!< Luma of black plus rounding
+   };
+
+   /**
+    * \brief Returns true if the mode is a packed YUV 4:2:2 mode
+    **/
+   bool isYuvMode( uint16_t mode )
+   {
+      return ( mode == APL_MODE_YUV_422 )||( mode == APL_MODE_BT601_YUV_422 );
+   }
+
+   /**
+    * \brief Rounds a coefficient to fixed point
+    **/
+   static int toFixed( double value )
+   {
+      return (int)lround( value * ( 1 << YUV_SHIFT ));
+   }
+
+   /**
+    * \brief Clamps a converted component to 0-255
+    **/
+   static inline uint8_t clampByte( int value )
+   {
+      return (uint8_t)( value < 0 ? 0 : ( value > 255 ? 255 : value ));
+   }
+
+   /**
+    * \brief Coefficients for full range or BT.601 limited range YUV
+    **/
+   static YuvDecoder makeDecoder( bool limited )
+   {
+      double yScale = limited ? 255.0 / 219.0 : 1.0;
+      double cScale = limited ? 255.0 / 224.0 : 1.0;
+
+      YuvDecoder decoder;
+      decoder.m_yOffset = limited ? 16 : 0;
+      decoder.m_yScale  = toFixed( yScale );
+      decoder.m_rv      = toFixed( 2.0 * ( 1.0 - YUV_KR ) * cScale );
+      decoder.m_gu      = toFixed( 2.0 * ( 1.0 - YUV_KB ) * YUV_KB / YUV_KG * cScale );
+      decoder.m_gv      = toFixed( 2.0 * ( 1.0 - YUV_KR ) * YUV_KR / YUV_KG * cScale );
+      decoder.m_bu      = toFixed( 2.0 * ( 1.0 - YUV_KB ) * cScale );
+      return decoder;
+   }
+
+   /**
+    * \brief Coefficients for full range or BT.601 limited range YUV
+    **/
+   static YuvEncoder makeEncoder( bool limited )
+   {
+      double yScale = limited ? 219.0 / 255.0 : 1.0;
+      double cScale = limited ? 224.0 / 255.0 : 1.0;
+
+      YuvEncoder encoder;
+      encoder.m_ry     = toFixed( YUV_KR * yScale );
+      encoder.m_gy     = toFixed( YUV_KG * yScale );
+      encoder.m_by     = toFixed( YUV_KB * yScale );
+      encoder.m_ru     = toFixed( -YUV_KR / ( 2.0 * ( 1.0 - YUV_KB )) * cScale );
+      encoder.m_gu     = toFixed( -YUV_KG / ( 2.0 * ( 1.0 - YUV_KB )) * cScale );
+      encoder.m_bu     = toFixed( 0.5 * cScale );
+      encoder.m_rv     = toFixed( 0.5 * cScale );
+      encoder.m_gv     = toFixed( -YUV_KG / ( 2.0 * ( 1.0 - YUV_KR )) * cScale );
+      encoder.m_bv     = toFixed( -YUV_KB / ( 2.0 * ( 1.0 - YUV_KR )) * cScale );
+      encoder.m_yRound = (( limited ? 16 : 0 ) << YUV_SHIFT ) + ( 1 << ( YUV_SHIFT - 1 ));
+      return encoder;
+   }
+
+   /**
+    * \brief Converts YUV 4:2:2 pixel pairs first to pairs - 1 of a row to BGRA
+    **/
+   static void decodePairs( const YuvDecoder &decoder, const uint8_t * __restrict yuv, uint8_t * __restrict bgra, size_t first, size_t pairs )
+   {
+      const int yOffset = decoder.m_yOffset;
+      const int yScale  = decoder.m_yScale;
+      const int rv      = decoder.m_rv;
+      const int gu      = decoder.m_gu;
+      const int gv      = decoder.m_gv;
+      const int bu      = decoder.m_bu;
+      const int round   = 1 << ( YUV_SHIFT - 1 );
+
+      for( size_t i = first; i < pairs; i++ ) {
+         int y0 = ( yuv[4 * i] - yOffset ) * yScale + round;
+         int u  = yuv[4 * i + 1] - 128;
+         int y1 = ( yuv[4 * i + 2] - yOffset ) * yScale + round;
+         int v  = yuv[4 * i + 3] - 128;
+
+         //Both pixels of the pair share the chroma terms
+         int red   = rv * v;
+         int green = -gu * u - gv * v;
+         int blue  = bu * u;
+
+         uint8_t * pixel = bgra + 8 * i;
+         pixel[0] = clampByte(( y0 + blue ) >> YUV_SHIFT );
+         pixel[1] = clampByte(( y0 + green ) >> YUV_SHIFT );
+         pixel[2] = clampByte(( y0 + red ) >> YUV_SHIFT );
+         pixel[3] = 255;
+         pixel[4] = clampByte(( y1 + blue ) >> YUV_SHIFT );
+         pixel[5] = clampByte(( y1 + green ) >> YUV_SHIFT );
+         pixel[6] = clampByte(( y1 + red ) >> YUV_SHIFT );
+         pixel[7] = 255;
+      }
+   }
+
+#if defined(__x86_64__)
+   /**
+    * \brief Interleaves two 16-bit values into every 32-bit lane
+    **/
+   static inline __m128i pairOf( int low, int high )
+   {
+      return _mm_unpacklo_epi16( _mm_set1_epi16( (short)low ), _mm_set1_epi16( (short)high ));
+   }
+
+   /**
+    * \brief Converts a row of YUV 4:2:2 pixel pairs to BGRA with SSE2
+    *
+    * The auto-vectorized decodePairs is slower than scalar code because it
+    * gathers the samples of each pair and scatters the pixels byte by byte.
+    * This version converts two pairs per step in 32-bit lanes with the same
+    * fixed-point arithmetic, so the results are identical. _mm_madd_epi16
+    * does the multiplications; the chroma gains of red and blue are split in
+    * two halves, as the limited range blue gain does not fit in 16 bits. The
+    * saturating packs clamp to 0-255. SSE2 is part of x86-64.
+    **/
+   static void decodeRow( const YuvDecoder &decoder, const uint8_t * __restrict yuv, uint8_t * __restrict bgra, size_t pairs )
+   {
+      const __m128i zero   = _mm_setzero_si128();
+      const __m128i offset = pairOf( decoder.m_yOffset, 128 );
+      const __m128i lowHalf = _mm_set1_epi32( 0xFFFF );
+      const __m128i one    = _mm_set1_epi32( 0x10000 );
+      const __m128i luma   = pairOf( decoder.m_yScale, 1 << ( YUV_SHIFT - 1 ));
+      const __m128i blue   = pairOf( decoder.m_bu - decoder.m_bu / 2, decoder.m_bu / 2 );
+      const __m128i green  = pairOf( -decoder.m_gu, -decoder.m_gv );
+      const __m128i red    = pairOf( decoder.m_rv - decoder.m_rv / 2, decoder.m_rv / 2 );
+      const __m128i alpha  = _mm_set1_epi32( 255 );
+
+      size_t i = 0;
+      for( ; i + 4 <= pairs; i += 4 ) {
+         __m128i packed = _mm_loadu_si128( (const __m128i *)( yuv + 4 * i ));
+         for( int half = 0; half < 2; half++ ) {
+            //Y0,U,Y1,V,Y2,U,Y3,V minus the offsets, with one pixel per 32-bit lane below
+            __m128i samples = half ? _mm_unpackhi_epi8( packed, zero ) : _mm_unpacklo_epi8( packed, zero );
+            samples = _mm_sub_epi16( samples, offset );
+            __m128i y  = _mm_madd_epi16( _mm_or_si128( _mm_and_si128( samples, lowHalf ), one ), luma );
+            __m128i uv = _mm_shufflehi_epi16( _mm_shufflelo_epi16( samples, _MM_SHUFFLE( 3, 1, 3, 1 )), _MM_SHUFFLE( 3, 1, 3, 1 ));
+            __m128i uu = _mm_shufflehi_epi16( _mm_shufflelo_epi16( samples, _MM_SHUFFLE( 1, 1, 1, 1 )), _MM_SHUFFLE( 1, 1, 1, 1 ));
+            __m128i vv = _mm_shufflehi_epi16( _mm_shufflelo_epi16( samples, _MM_SHUFFLE( 3, 3, 3, 3 )), _MM_SHUFFLE( 3, 3, 3, 3 ));
+
+            __m128i b = _mm_srai_epi32( _mm_add_epi32( y, _mm_madd_epi16( uu, blue )), YUV_SHIFT );
+            __m128i g = _mm_srai_epi32( _mm_add_epi32( y, _mm_madd_epi16( uv, green )), YUV_SHIFT );
+            __m128i r = _mm_srai_epi32( _mm_add_epi32( y, _mm_madd_epi16( vv, red )), YUV_SHIFT );
+
+            //b0..b3,g0..g3 and r0..r3,a.. are interleaved to b,g,r,a per pixel
+            __m128i bg = _mm_packs_epi32( b, g );
+            __m128i ra = _mm_packs_epi32( r, alpha );
+            __m128i br = _mm_unpacklo_epi16( bg, ra );
+            __m128i ga = _mm_unpackhi_epi16( bg, ra );
+            __m128i pixels = _mm_packus_epi16( _mm_unpacklo_epi16( br, ga ), _mm_unpackhi_epi16( br, ga ));
+            _mm_storeu_si128( (__m128i *)( bgra + 8 * i + 16 * half ), pixels );
+         }
+      }
+
+      decodePairs( decoder, yuv, bgra, i, pairs );
+   }
+#else
+   /**
+    * \brief Converts a row of YUV 4:2:2 pixel pairs to BGRA
+    **/
+   static void decodeRow( const YuvDecoder &decoder, const uint8_t * __restrict yuv, uint8_t * __restrict bgra, size_t pairs )
+   {
+      decodePairs( decoder, yuv, bgra, 0, pairs );
+   }
+#endif
+
+   /**
+    * \brief Converts a row of BGRA pixel pairs to YUV 4:2:2
+    *
+    * The chroma of a pair is computed from the sum of its two pixels.
+    **/
+   static void encodeRow( const YuvEncoder &encoder, const uint8_t * __restrict bgra, uint8_t * __restrict yuv, size_t pairs )
+   {
+      const int ry = encoder.m_ry, gy = encoder.m_gy, by = encoder.m_by;
+      const int ru = encoder.m_ru, gu = encoder.m_gu, bu = encoder.m_bu;
+      const int rv = encoder.m_rv, gv = encoder.m_gv, bv = encoder.m_bv;
+      const int yRound = encoder.m_yRound;
+      const int cRound = ( 128 << ( YUV_SHIFT + 1 )) + ( 1 << YUV_SHIFT );
+
+      for( size_t i = 0; i < pairs; i++ ) {
+         const uint8_t * pixel = bgra + 8 * i;
+         int b0 = pixel[0], g0 = pixel[1], r0 = pixel[2];
+         int b1 = pixel[4], g1 = pixel[5], r1 = pixel[6];
+         int red   = r0 + r1;
+         int green = g0 + g1;
+         int blue  = b0 + b1;
+
+         yuv[4 * i]     = clampByte(( ry * r0 + gy * g0 + by * b0 + yRound ) >> YUV_SHIFT );
+         yuv[4 * i + 1] = clampByte(( ru * red + gu * green + bu * blue + cRound ) >> ( YUV_SHIFT + 1 ));
+         yuv[4 * i + 2] = clampByte(( ry * r1 + gy * g1 + by * b1 + yRound ) >> YUV_SHIFT );
+         yuv[4 * i + 3] = clampByte(( rv * red + gv * green + bv * blue + cRound ) >> ( YUV_SHIFT + 1 ));
+      }
+   }
+
+   /**
+    * \brief Converts an 8-bit image between YUV 4:2:2 and RGB, BGR or BGRA
+    *
+    * \param [in] source source pixels
+    * \param [in] metadata description of the source image. m_mode selects the direction and range
+    * \param [out] destination receives the converted pixels. It is reallocated if it is too small
+    * \param [in] mode destination mode. A YUV mode if the source is RGB, BGR or BGRA and vice versa
+    * \param [in] pool workers that convert bands of rows
+    * \return true on success, false if the modes are not supported or the buffers do not fit
+    *
+    * The width must be even. Source and destination must be different buffers.
+    **/
+   bool convertYuv( ExtendedBuffer<uint8_t> &source
+                  , ImageMetadata &metadata
+                  , ExtendedBuffer<uint8_t> &destination
+                  , uint16_t mode
+                  , AThreadPool &pool
+                  )
+   {
+      bool decode = ( isYuvMode( metadata.m_mode ))&&( getChannelCount( mode ) > 0 );
+      bool encode = ( isYuvMode( mode ))&&( getChannelCount( metadata.m_mode ) > 0 );
+      if(( !decode )&&( !encode )) {
+         std::cerr << "convertYuv: unsupported conversion from mode "<<metadata.m_mode<<" to "<<mode<<std::endl;
+         return false;
+      }
+
+      size_t width  = metadata.m_width;
+      size_t height = metadata.m_height;
+      if( width % 2 ) {
+         std::cerr << "convertYuv: width "<<width<<" is not even"<<std::endl;
+         return false;
+      }
+
+      size_t sourceBytes = decode ? 2 : getChannelCount( metadata.m_mode );
+      size_t destBytes   = decode ? getChannelCount( mode ) : 2;
+      if( source.getCapacity() < width * height * sourceBytes ) {
+         std::cerr << "convertYuv: source holds "<<source.getCapacity()<<" of "<<width * height * sourceBytes<<" samples"<<std::endl;
+         return false;
+      }
+      if( source.m_buffer.get() == destination.m_buffer.get()) {
+         std::cerr << "convertYuv: source and destination must be different buffers"<<std::endl;
+         return false;
+      }
+      if( destination.getCapacity() < width * height * destBytes ) {
+         destination.deallocate();
+         if( !destination.allocate( width * height * destBytes )) {
+            return false;
+         }
+      }
+
+      bool limited = ( metadata.m_mode == APL_MODE_BT601_YUV_422 )||( mode == APL_MODE_BT601_YUV_422 );
+      YuvDecoder decoder = makeDecoder( limited );
+      YuvEncoder encoder = makeEncoder( limited );
+      uint16_t   rgbMode = decode ? mode : metadata.m_mode;
+      const uint8_t * input  = source.m_buffer.get();
+      uint8_t       * output = destination.m_buffer.get();
+
+      size_t blocks    = 4 * pool.getThreadCount();
+      size_t blockRows = ( height + blocks - 1 ) / blocks;
+      pool.parallelFor( height, blockRows, [&]( size_t begin, size_t end ) {
+         std::vector<uint8_t> bgra(( rgbMode == APL_MODE_BGRA ) ? 0 : 4 * width );
+         for( size_t y = begin; y < end; y++ ) {
+            const uint8_t * in  = input + y * width * sourceBytes;
+            uint8_t       * out = output + y * width * destBytes;
+            if( decode ) {
+               uint8_t * row = bgra.empty() ? out : bgra.data();
+               decodeRow( decoder, in, row, width / 2 );
+               if( !bgra.empty()) {
+                  convertPixels( row, APL_MODE_BGRA, out, rgbMode, width );
+               }
+            }
+            else {
+               const uint8_t * row = in;
+               if( !bgra.empty()) {
+                  convertPixels( in, rgbMode, bgra.data(), APL_MODE_BGRA, width );
+                  row = bgra.data();
+               }
+               encodeRow( encoder, row, out, width / 2 );
+            }
+         }
+      });
+
+      return true;
+   }
+
+   /**
+    * \brief YUV 4:2:2 is only defined for 8-bit samples
+    **/
+   bool convertYuv( ExtendedBuffer<uint16_t> &
+                  , ImageMetadata &
+                  , ExtendedBuffer<uint16_t> &
+                  , uint16_t
+                  , AThreadPool &
+                  )
+   {
+      std::cerr << "convertYuv: YUV conversion supports 8-bit samples only"<<std::endl;
+      return false;
+   }
+
+   /**
+    * \brief Returns the largest difference between two buffers
+    **/
+   static int getMaxError( const uint8_t * a, const uint8_t * b, size_t bytes )
+   {
+      int error = 0;
+      for( size_t i = 0; i < bytes; i++ ) {
+         int difference = std::abs( a[i] - b[i] );
+         error = difference > error ? difference : error;
+      }
+      return error;
+   }
+
+   /**
+    * \brief Unit test for YUV conversion
+    **/
+   bool testYuvConvert()
+   {
+      AThreadPool pool( 3 );
+
+      //Reference values: white, black, and the extremes of the limited range
+      ImageMetadata metadata;
+      metadata.m_mode   = APL_MODE_YUV_422;
+      metadata.m_width  = 4;
+      metadata.m_height = 1;
+      ExtendedBuffer<uint8_t> yuv( 8 );
+      ExtendedBuffer<uint8_t> rgb;
+      const uint8_t pixels[] = { 255, 128, 0, 128, 235, 128, 16, 128 };
+      memcpy( yuv.m_buffer.get(), pixels, sizeof(pixels));
+      const uint8_t fullExpected[]    = { 255, 255, 255, 0, 0, 0, 235, 235, 235, 16, 16, 16 };
+      const uint8_t limitedExpected[] = { 255, 255, 255, 0, 0, 0, 255, 255, 255, 0, 0, 0 };
+      if(( !convertYuv( yuv, metadata, rgb, APL_MODE_RGB, pool ))
+       ||( memcmp( rgb.m_buffer.get(), fullExpected, sizeof(fullExpected)))) {
+         std::cout << "Full range YUV decode does not match the reference"<<std::endl;
+         return false;
+      }
+      metadata.m_mode = APL_MODE_BT601_YUV_422;
+      if(( !convertYuv( yuv, metadata, rgb, APL_MODE_RGB, pool ))
+       ||( memcmp( rgb.m_buffer.get(), limitedExpected, sizeof(limitedExpected)))) {
+         std::cout << "BT.601 YUV decode does not match the reference"<<std::endl;
+         return false;
+      }
+
+      //Pure red encodes to the BT.601 values
+      ExtendedBuffer<uint8_t> red( 6 );
+      ExtendedBuffer<uint8_t> encoded;
+      const uint8_t redPixels[] = { 255, 0, 0, 255, 0, 0 };
+      memcpy( red.m_buffer.get(), redPixels, sizeof(redPixels));
+      metadata.m_mode  = APL_MODE_RGB;
+      metadata.m_width = 2;
+      const uint8_t fullRed[]    = { 76, 85, 76, 255 };
+      const uint8_t limitedRed[] = { 81, 90, 81, 240 };
+      if(( !convertYuv( red, metadata, encoded, APL_MODE_YUV_422, pool ))
+       ||( getMaxError( encoded.m_buffer.get(), fullRed, 4 ) > 1 )
+       ||( !convertYuv( red, metadata, encoded, APL_MODE_BT601_YUV_422, pool ))
+       ||( getMaxError( encoded.m_buffer.get(), limitedRed, 4 ) > 1 )) {
+         std::cout << "YUV encode of red does not match the reference"<<std::endl;
+         return false;
+      }
+
+      //Pixel pairs of one color survive a round trip in every mode and range
+      const size_t width  = 128;
+      const size_t height = 33;
+      const uint16_t rgbModes[] = { APL_MODE_RGB, APL_MODE_BGR, APL_MODE_BGRA };
+      const uint16_t yuvModes[] = { APL_MODE_YUV_422, APL_MODE_BT601_YUV_422 };
+      srand( 3 );
+      for( size_t m = 0; m < 3; m++ ) {
+         size_t channels = getChannelCount( rgbModes[m] );
+         ExtendedBuffer<uint8_t> original( width * height * channels );
+         for( size_t i = 0; i < width * height; i += 2 ) {
+            for( size_t c = 0; c < channels; c++ ) {
+               uint8_t value = ( c == 3 ) ? 255 : rand();
+               original[i * channels + c]       = value;
+               original[( i + 1 ) * channels + c] = value;
+            }
+         }
+
+         for( size_t r = 0; r < 2; r++ ) {
+            ImageMetadata image;
+            image.m_mode   = rgbModes[m];
+            image.m_width  = width;
+            image.m_height = height;
+            ExtendedBuffer<uint8_t> packed;
+            ExtendedBuffer<uint8_t> restored;
+            ExtendedBuffer<uint8_t> serial;
+            AThreadPool single( 1 );
+            bool rc = convertYuv( original, image, packed, yuvModes[r], pool );
+            image.m_mode = yuvModes[r];
+            rc = rc && convertYuv( packed, image, restored, rgbModes[m], pool )
+                    && convertYuv( packed, image, serial, rgbModes[m], single );
+
+            //Limited range quantizes more coarsely
+            int tolerance = ( r == 0 ) ? 3 : 4;
+            int error = rc ? getMaxError( original.m_buffer.get(), restored.m_buffer.get(), width * height * channels ) : -1;
+            if(( !rc )||( error > tolerance )
+             ||( memcmp( restored.m_buffer.get(), serial.m_buffer.get(), width * height * channels ))) {
+               std::cout << "YUV round trip of mode "<<rgbModes[m]<<" through mode "<<yuvModes[r]<<" failed (error "<<error<<")"<<std::endl;
+               return false;
+            }
+         }
+      }
+
+      //The row kernel matches the per-pair conversion on noise in both ranges
+      ExtendedBuffer<uint8_t> noise( 4 * 19 );
+      ExtendedBuffer<uint8_t> decoded;
+      std::vector<uint8_t> expected( 8 * 19 );
+      for( size_t i = 0; i < noise.getCapacity(); i++ ) {
+         noise[i] = rand();
+      }
+      for( size_t r = 0; r < 2; r++ ) {
+         ImageMetadata row;
+         row.m_mode   = yuvModes[r];
+         row.m_width  = 38;
+         row.m_height = 1;
+         decodePairs( makeDecoder( r == 1 ), noise.m_buffer.get(), expected.data(), 0, 19 );
+         if(( !convertYuv( noise, row, decoded, APL_MODE_BGRA, pool ))
+          ||( memcmp( decoded.m_buffer.get(), expected.data(), expected.size()))) {
+            std::cout << "YUV decode of noise in mode "<<yuvModes[r]<<" differs from the reference"<<std::endl;
+            return false;
+         }
+      }
+
+      //Odd widths and unrelated modes are rejected
+      ImageMetadata odd;
+      odd.m_mode   = APL_MODE_YUV_422;
+      odd.m_width  = 3;
+      odd.m_height = 1;
+      metadata.m_mode  = APL_MODE_YUV_422;
+      metadata.m_width = 4;
+      if(( convertYuv( yuv, odd, rgb, APL_MODE_RGB, pool ))
+       ||( convertYuv( yuv, metadata, rgb, APL_MODE_GRAY, pool ))
+       ||( convertYuv( yuv, metadata, yuv, APL_MODE_RGB, pool ))) {
+         std::cout << "YUV conversion accepted invalid input"<<std::endl;
+         return false;
+      }
+
+      //The container interface selects YUV conversion from the modes
+      ImageContainer<uint8_t> frame;
+      ImageContainer<uint8_t> bgra;
+      frame.m_metadata.m_mode   = APL_MODE_BT601_YUV_422;
+      frame.m_metadata.m_width  = 4;
+      frame.m_metadata.m_height = 1;
+      frame.m_metadata.m_bpp    = 16;
+      frame.m_data = yuv;
+      if(( !frame.convert( bgra, APL_MODE_BGRA, pool ))
+       ||( bgra.m_metadata.m_mode != APL_MODE_BGRA )||( bgra.m_metadata.m_bpp != 32 )
+       ||( bgra.m_data[8] != 255 )||( bgra.m_data[12] != 0 )||( bgra.m_data[15] != 255 )
+       ||( !frame.convert( APL_MODE_RGB, pool ))
+       ||( frame.m_metadata.m_mode != APL_MODE_RGB )||( frame.m_metadata.m_bpp != 24 )
+       ||( memcmp( frame.m_data.m_buffer.get(), limitedExpected, sizeof(limitedExpected)))
+       ||( !frame.convert( APL_MODE_YUV_422, pool ))
+       ||( frame.m_metadata.m_mode != APL_MODE_YUV_422 )||( frame.m_metadata.m_bpp != 16 )) {
+         std::cout << "ImageContainer YUV conversion failed"<<std::endl;
+         return false;
+      }
+
+      return true;
+   }
+};
@@ -0,0 +1,43 @@
+//==============================================================================
+// Conversion between packed YUV 4:2:2 and RGB, BGR and BGRA
+//
+// YUV 4:2:2 pixels are stored as Y0,U,Y1,V for each pair of pixels with the
+// BT.601 color matrix. APL_MODE_YUV_422 uses the full 0-255 range for all
+// components, APL_MODE_BT601_YUV_422 the limited range with Y from 16 to 235
+// and U,V from 16 to 240. The arithmetic is 14-bit fixed point.
+//
+// Rows are converted through BGRA, whose four-byte pixels let the compiler
+// vectorize the fixed-point loops (the build enables vectorization for this
+// file at -O2 as well), and reordered to RGB or BGR with the channel
+// conversion kernel. Decoding uses SSE2 on x86-64. Bands of rows run in
+// parallel.
+//==============================================================================
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#include <ExtendedBuffer.tcc>
+#include <ImageMetadata.h>
+#include <AThreadPool.h>
+
+namespace atl
+{
+   bool isYuvMode( uint16_t mode );
+
+   bool convertYuv( ExtendedBuffer<uint8_t> &source
+                  , ImageMetadata &metadata
+                  , ExtendedBuffer<uint8_t> &destination
+                  , uint16_t mode
+                  , AThreadPool &pool = getDefaultThreadPool()
+                  );
+
+   bool convertYuv( ExtendedBuffer<uint16_t> &source
+                  , ImageMetadata &metadata
+                  , ExtendedBuffer<uint16_t> &destination
+                  , uint16_t mode
+                  , AThreadPool &pool = getDefaultThreadPool()
+                  );
+
+   //Test functions
+   bool testYuvConvert();
+};
@@ -6,12 +6,34 @@
 #include <BaseContainer.h>
 #include <BaseChunk.h>
 #include <ImageMetadata.h>
+#include <Demosaic.h>
+#include <ChannelConvert.h>
+#include <YuvConvert.h>
+#include <ImagePyramid.h>
 #include <BaseBuffer.h>
 #include <DataBuffer.h>
 #include <ExtendedBuffer.tcc>
 #include <BaseSocket.h>
 #include <SocketServer.h>
 #include <TSArray.tcc>
+#include <TSMatrix.tcc>
+#include <TSMatrixView.tcc>
+#include <TSMatrixAlgorithms.tcc>
+#include <AThreadPool.h>
+#include <TSVersionedArray.tcc>
+#include <TSRawArray.tcc>
+#include <TSMappedArray.tcc>
+#include <Checksum.h>
+#include <ContainerReader.h>
+#include <ChunkIndex.h>
+#include <ChunkDeduplicator.h>
+#include <ContainerJournal.h>
+#include <BufferPool.h>
+#include <AsyncWriter.h>
+#include <DirectWriter.h>
+#include <PlaybackReader.h>
+#include <JsonWriter.h>
+#include <JsonReader.h>
 
 using namespace std;
 using namespace atl;
@@ -33,6 +55,16 @@ int main(void)
       return 1;
    }
    */
+   cout << "Testing JsonWriter"<<endl;
+   if( !testJsonWriter()) {
+      std::cout << "JsonWriter test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing JsonReader"<<endl;
+   if( !testJsonReader()) {
+      std::cout << "JsonReader test failed" <<std::endl;
+      return 1;
+   }
    cout << "Testing BaseChunkMetadata"<<endl;
    if( !atl::testBaseChunkMetadata() )
    {
@@ -50,6 +82,41 @@ int main(void)
       std::cout << "TSArray test failed" <<std::endl;
       return 1;
    }
+   cout << "Testing TSVersionedArray"<<endl;
+   if( !testTSVersionedArray()) {
+      std::cout << "TSVersionedArray test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing TSRawArray"<<endl;
+   if( !testTSRawArray()) {
+      std::cout << "TSRawArray test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing TSMappedArray"<<endl;
+   if( !testTSMappedArray()) {
+      std::cout << "TSMappedArray test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing TSMatrix"<<endl;
+   if( !testTSMatrix()) {
+      std::cout << "TSMatrix test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing TSMatrixView"<<endl;
+   if( !testTSMatrixView()) {
+      std::cout << "TSMatrixView test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing AThreadPool"<<endl;
+   if( !testAThreadPool()) {
+      std::cout << "AThreadPool test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing TSMatrixAlgorithms"<<endl;
+   if( !testTSMatrixAlgorithms()) {
+      std::cout << "TSMatrixAlgorithms test failed" <<std::endl;
+      return 1;
+   }
    cout << "Testing BaseContainerMetadata"<<endl;
    if( !testBaseContainerMetadata()) {
       std::cout << "BaseContainerMetadata test failed" <<std::endl;
@@ -60,12 +127,89 @@ int main(void)
       std::cout << "BaseContainer test failed" <<std::endl;
       return 1;
    }
+   cout << "Testing ChunkIndex"<<endl;
+   if( !testChunkIndex()) {
+      std::cout << "ChunkIndex test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing ChunkDeduplicator"<<endl;
+   if( !testChunkDeduplicator()) {
+      std::cout << "ChunkDeduplicator test failed" <<std::endl;
+      return 1;
+   }
+
+   cout << "Testing Checksum"<<endl;
+   if( !testChecksum()) {
+      std::cout << "Checksum test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing ContainerReader"<<endl;
+   if( !testContainerReader()) {
+      std::cout << "ContainerReader test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing ContainerJournal"<<endl;
+   if( !testContainerJournal()) {
+      std::cout << "ContainerJournal test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing BufferPool"<<endl;
+   if( !testBufferPool()) {
+      std::cout << "BufferPool test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing AsyncWriter"<<endl;
+   if( !testAsyncWriter()) {
+      std::cout << "AsyncWriter test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing DirectWriter"<<endl;
+   if( !testDirectWriter()) {
+      std::cout << "DirectWriter test failed" <<std::endl;
+      return 1;
+   }
+   cout << "Testing PlaybackReader"<<endl;
+   if( !testPlaybackReader()) {
+      std::cout << "PlaybackReader test failed" <<std::endl;
+      return 1;
+   }
    cout << "Testing ImageMetadata"<<endl;
    if( !atl::testImageMetadata() )
    {
       cout << "ImageMetadata Test Failed!" << endl;
       return 1;
    }
+   cout << "Testing Demosaic"<<endl;
+   if( !atl::testDemosaic() )
+   {
+      cout << "Demosaic Test Failed!" << endl;
+      return 1;
+   }
+   cout << "Testing ChannelConvert"<<endl;
+   if( !atl::testChannelConvert() )
+   {
+      cout << "ChannelConvert Test Failed!" << endl;
+      return 1;
+   }
+   cout << "Testing YuvConvert"<<endl;
+   if( !atl::testYuvConvert() )
+   {
+      cout << "YuvConvert Test Failed!" << endl;
+      return 1;
+   }
+   cout << "Testing ImagePyramid"<<endl;
+   if( !atl::testImagePyramid() )
+   {
+      cout << "ImagePyramid Test Failed!" << endl;
+      return 1;
+   }
+
+   cout << "Testing MetadataRegistry"<<endl;
+   if( !atl::testMetadataRegistry() )
+   {
+      cout << "MetadataRegistry Test Failed!" << endl;
+      return 1;
+   }
    cout << "Testing BaseBuffer"<<endl;
    if( !atl::testBaseBuffer() )
    {
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <atomic>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ATimer.h>
+#include <AsyncWriter.h>
+#include <FileIO.h>
+
+std::string path    = "./";
+int         count   = 256;
+uint64_t    bufSize = 4194304;   //4MB block
+size_t      depth   = 16;
+
+/**
+ * \brief Writes every block with a blocking pwrite, as the recorder threads do today
+ **/
+double writeBlocking( atl::BufferPool &pool, std::string filename )
+{
+   int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   if( fd < 0 ) {
+      fprintf( stderr, "Unable to open %s\n", filename.c_str());
+      return -1;
+   }
+
+   atl::Timer timer;
+   timer.start();
+
+   bool rc = true;
+   for( int i = 0; ( rc )&&( i < count ); i++ ) {
+      atl::BaseBuffer buffer;
+      rc = pool.acquire( buffer )
+        && atl::pwriteFully( fd, buffer.m_buffer.get(), bufSize, (uint64_t)i * bufSize );
+   }
+
+   rc = rc && ( fdatasync( fd ) == 0 );
+   double elapsed = timer.elapsed();
+   close( fd );
+
+   return rc ? elapsed : -1;
+}
+
+/**
+ * \brief Queues every block on an AsyncWriter
+ **/
+double writeAsync( atl::BufferPool &pool, std::string filename, atl::AsyncWriter::Backend backend )
+{
+   int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   if( fd < 0 ) {
+      fprintf( stderr, "Unable to open %s\n", filename.c_str());
+      return -1;
+   }
+
+   atl::AsyncWriter writer;
+   if( !writer.open( depth, backend, &pool )) {
+      close( fd );
+      return -1;
+   }
+
+   atl::Timer timer;
+   timer.start();
+
+   std::atomic<int> failures( 0 );
+   bool rc = true;
+   for( int i = 0; ( rc )&&( i < count ); i++ ) {
+      atl::BaseBuffer buffer;
+      rc = pool.acquire( buffer )
+        && writer.write( fd, buffer, (uint64_t)i * bufSize, [&failures]( ssize_t result ) {
+              if( result < 0 ) {
+                 failures++;
+              }
+           });
+   }
+   writer.wait();
+
+   rc = rc && ( failures == 0 )&&( fdatasync( fd ) == 0 );
+   double elapsed = timer.elapsed();
+   writer.close();
+   close( fd );
+
+   return rc ? elapsed : -1;
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds )
+{
+   if( seconds < 0 ) {
+      printf("%-18s failed\n", name );
+      return;
+   }
+
+   printf("%-18s %10.3lf s %10.1lf MB/s\n"
+         , name
+         , seconds
+         , (double)bufSize * count / seconds / 1e6
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares blocking writes with the io_uring and thread pool AsyncWriter backends.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of blocks to write (%d)\n", count );
+   printf("\t-s size of each block (%lu)\n", (unsigned long)bufSize );
+   printf("\t-q maximum number of writes in flight (%lu)\n", (unsigned long)depth );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nAsync write benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-q" ))&&( i+1 < argc )) {
+         i++;
+         depth = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   //Blocks are recycled through the pool, one more than can be in flight
+   atl::BufferPool pool;
+   if( !pool.allocate( bufSize, depth + 1 )) {
+      return 1;
+   }
+   bufSize = pool.getBufferSize();
+   memset( pool.getStorage(), 0x5A, bufSize * pool.getCount());
+
+   std::string filename = path + "async_write.bin";
+   printf("%d blocks of %lu bytes in %s, depth %lu\n\n", count, (unsigned long)bufSize, path.c_str(), (unsigned long)depth );
+
+   printResult( "blocking pwrite", writeBlocking( pool, filename ));
+   printResult( "async thread pool", writeAsync( pool, filename, atl::AsyncWriter::THREAD_POOL ));
+   if( atl::AsyncWriter::isIoUringSupported()) {
+      printResult( "async io_uring", writeAsync( pool, filename, atl::AsyncWriter::IO_URING ));
+   }
+   else {
+      printf("io_uring is not supported by this kernel\n");
+   }
+
+   unlink( filename.c_str());
+
+   return 0;
+}
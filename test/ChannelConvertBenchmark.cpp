@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <ATimer.h>
+#include <ImageContainer.h>
+
+int width      = 3840;
+int height     = 2160;
+int iterations = 20;
+int threads    = std::thread::hardware_concurrency();
+int batchSize  = 64;
+
+/**
+ * \brief Per-pixel RGB to BGRA loop as written in application code
+ **/
+void convertLoop( const uint8_t * rgb, uint8_t * bgra, size_t pixels )
+{
+   for( size_t i = 0; i < pixels; i++ ) {
+      bgra[4 * i]     = rgb[3 * i + 2];
+      bgra[4 * i + 1] = rgb[3 * i + 1];
+      bgra[4 * i + 2] = rgb[3 * i];
+      bgra[4 * i + 3] = 255;
+   }
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds, double pixels )
+{
+   printf("%-28s %10.1lf MP/s %10.1lf fps\n", name, pixels / seconds / 1e6, iterations / seconds );
+}
+
+/**
+ * \brief Converts the image between two modes repeatedly
+ **/
+bool runConversion( const char * name, uint16_t from, uint16_t to, bool inPlace, atl::AThreadPool &pool )
+{
+   atl::ImageMetadata metadata;
+   metadata.m_mode   = from;
+   metadata.m_width  = width;
+   metadata.m_height = height;
+
+   size_t pixels = (size_t)width * height;
+   atl::ExtendedBuffer<uint8_t> source( 4 * pixels );
+   atl::ExtendedBuffer<uint8_t> destination;
+   memset( source.m_buffer.get(), 0x5a, 4 * pixels );
+
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      //In place the image alternates between the two modes
+      bool rc = inPlace ? atl::convertChannels( source, metadata, source, to, pool )
+                        : atl::convertChannels( source, metadata, destination, to, pool );
+      if( !rc ) {
+         printf("%-28s failed\n", name );
+         return false;
+      }
+      if( inPlace ) {
+         metadata.m_mode = to;
+         to = from;
+         from = metadata.m_mode;
+      }
+   }
+   printResult( name, timer.elapsed(), (double)pixels * iterations );
+
+   return true;
+}
+
+/**
+ * \brief Converts many small images one at a time and as one batch
+ **/
+bool runBatch( atl::AThreadPool &pool )
+{
+   std::vector<atl::ImageContainer<uint8_t> > images( batchSize );
+   std::vector<atl::ImageContainer<uint8_t> *> pointers;
+   for( int i = 0; i < batchSize; i++ ) {
+      images[i].m_metadata.m_mode   = atl::APL_MODE_RGB;
+      images[i].m_metadata.m_width  = 320;
+      images[i].m_metadata.m_height = 240;
+      images[i].m_data.allocate( 320 * 240 * 4 );
+      pointers.push_back( &images[i] );
+   }
+
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      uint16_t mode = ( i & 1 ) ? atl::APL_MODE_RGB : atl::APL_MODE_BGR;
+      for( int j = 0; j < batchSize; j++ ) {
+         if( !images[j].convert( mode, pool )) {
+            return false;
+         }
+      }
+   }
+   double single = timer.elapsed();
+
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      uint16_t mode = ( i & 1 ) ? atl::APL_MODE_RGB : atl::APL_MODE_BGR;
+      if( !atl::ImageContainer<uint8_t>::convert( pointers, mode, pool )) {
+         return false;
+      }
+   }
+   double batch = timer.elapsed();
+
+   double pixels = 320.0 * 240 * batchSize * iterations;
+   printf("\n%d images of 320x240\n", batchSize );
+   printResult( "one at a time", single, pixels );
+   printResult( "batch", batch, pixels );
+
+   return true;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures channel order conversion throughput.\n");
+   printf("\nUsage:\n");
+   printf("\t-w image width (%d)\n", width );
+   printf("\t-h image height (%d)\n", height );
+   printf("\t-i number of conversions per measurement (%d)\n", iterations );
+   printf("\t-t number of worker threads (%d)\n", threads );
+   printf("\t-b number of images in a batch (%d)\n", batchSize );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nChannel conversion benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-w" ))&&( i+1 < argc )) {
+         i++;
+         width = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-h" ))&&( i+1 < argc )) {
+         i++;
+         height = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-i" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         threads = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-b" ))&&( i+1 < argc )) {
+         i++;
+         batchSize = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   if( threads < 1 ) {
+      threads = 1;
+   }
+   atl::AThreadPool pool( threads );
+   printf("%dx%d 8-bit, %d conversions, %d threads\n\n", width, height, iterations, threads );
+
+   size_t pixels = (size_t)width * height;
+   std::vector<uint8_t> rgb( 3 * pixels, 0x5a );
+   std::vector<uint8_t> bgra( 4 * pixels );
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      convertLoop( rgb.data(), bgra.data(), pixels );
+   }
+   printResult( "per-pixel loop RGB->BGRA", timer.elapsed(), (double)pixels * iterations );
+
+   bool rc = runConversion( "RGB->BGRA", atl::APL_MODE_RGB, atl::APL_MODE_BGRA, false, pool )
+          && runConversion( "BGRA->RGB", atl::APL_MODE_BGRA, atl::APL_MODE_RGB, false, pool )
+          && runConversion( "RGB->BGR", atl::APL_MODE_RGB, atl::APL_MODE_BGR, false, pool )
+          && runConversion( "RGB<->BGR in place", atl::APL_MODE_RGB, atl::APL_MODE_BGR, true, pool )
+          && runConversion( "BGR<->BGRA in place", atl::APL_MODE_BGR, atl::APL_MODE_BGRA, true, pool )
+          && runBatch( pool );
+
+   return rc ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <ATimer.h>
+#include <BaseChunk.h>
+
+std::string path     = "./";
+int         count    = 100;
+uint64_t    bufSize  = 4194304;   //4MB payload
+
+/**
+ * \brief Metadata block written ahead of the payload by the raw dump
+ **/
+struct RawHeader
+{
+   uint64_t id;
+   uint64_t elementSize;
+   uint64_t elementCount;
+   uint64_t offset;
+};
+
+/**
+ * \brief Writes each chunk as a raw dump: a metadata write, a type write and a payload write
+ **/
+double writeRaw( atl::BaseChunk &chunk, std::vector<std::string> &names )
+{
+   atl::Timer timer;
+   timer.start();
+
+   for( size_t i = 0; i < names.size(); i++ ) {
+      int fd = open( names[i].c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+      if( fd < 0 ) {
+         fprintf( stderr, "Unable to open %s\n", names[i].c_str());
+         return -1;
+      }
+
+      RawHeader header;
+      header.id           = chunk.m_metadata.m_id;
+      header.elementSize  = chunk.m_metadata.m_elementSize;
+      header.elementCount = chunk.m_metadata.m_elementCount;
+      header.offset       = chunk.m_metadata.m_offset;
+
+      uint32_t typeLength = chunk.m_metadata.m_type.length();
+      bool rc = ( write( fd, &header, sizeof(header)) == sizeof(header))
+             && ( write( fd, &typeLength, sizeof(typeLength)) == sizeof(typeLength))
+             && ( write( fd, chunk.m_metadata.m_type.data(), typeLength ) == typeLength )
+             && ( write( fd, chunk.m_buffer.m_buffer.get(), bufSize ) == (ssize_t)bufSize );
+      close( fd );
+
+      if( !rc ) {
+         fprintf( stderr, "Unable to write %s\n", names[i].c_str());
+         return -1;
+      }
+   }
+
+   return timer.elapsed();
+}
+
+/**
+ * \brief Reads raw dumps, allocating the type and payload separately
+ **/
+double readRaw( std::vector<std::string> &names )
+{
+   atl::Timer timer;
+   timer.start();
+
+   for( size_t i = 0; i < names.size(); i++ ) {
+      int fd = open( names[i].c_str(), O_RDONLY );
+      if( fd < 0 ) {
+         fprintf( stderr, "Unable to open %s\n", names[i].c_str());
+         return -1;
+      }
+
+      atl::BaseChunk chunk;
+      RawHeader header;
+      uint32_t  typeLength = 0;
+      bool rc = ( read( fd, &header, sizeof(header)) == sizeof(header))
+             && ( read( fd, &typeLength, sizeof(typeLength)) == sizeof(typeLength));
+
+      if( rc ) {
+         std::vector<char> type( typeLength );
+         rc = ( read( fd, type.data(), typeLength ) == typeLength );
+         chunk.m_metadata.m_type.assign( type.begin(), type.end() );
+      }
+
+      if( rc ) {
+         struct stat info;
+         fstat( fd, &info );
+         size_t bytes = info.st_size - sizeof(header) - sizeof(typeLength) - typeLength;
+         chunk.allocate( bytes );
+         rc = ( read( fd, chunk.m_buffer.m_buffer.get(), bytes ) == (ssize_t)bytes );
+      }
+      close( fd );
+
+      if( !rc ) {
+         fprintf( stderr, "Unable to read %s\n", names[i].c_str());
+         return -1;
+      }
+   }
+
+   return timer.elapsed();
+}
+
+/**
+ * \brief Writes each chunk with BaseChunk::save
+ **/
+double writeChunk( atl::BaseChunk &chunk, std::vector<std::string> &names )
+{
+   atl::Timer timer;
+   timer.start();
+
+   for( size_t i = 0; i < names.size(); i++ ) {
+      if( !chunk.save( names[i] )) {
+         return -1;
+      }
+   }
+
+   return timer.elapsed();
+}
+
+/**
+ * \brief Reads each chunk with BaseChunk::load
+ **/
+double readChunk( std::vector<std::string> &names )
+{
+   atl::Timer timer;
+   timer.start();
+
+   for( size_t i = 0; i < names.size(); i++ ) {
+      atl::BaseChunk chunk;
+      if( !chunk.load( names[i] )) {
+         return -1;
+      }
+   }
+
+   return timer.elapsed();
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds )
+{
+   if( seconds < 0 ) {
+      printf("%-12s failed\n", name );
+      return;
+   }
+
+   printf("%-12s %10.3lf s %10.1lf MB/s\n"
+         , name
+         , seconds
+         , (double)bufSize * count / seconds / 1e6
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares the throughput of the binary chunk format (BaseChunk::save/load) with raw dumps.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of chunks to write (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nChunk write benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   atl::BaseChunk chunk(1);
+   chunk.m_metadata.m_type = "float";
+   chunk.m_metadata.m_elementSize  = sizeof(float);
+   chunk.m_metadata.m_elementCount = bufSize / sizeof(float);
+   chunk.allocate( bufSize );
+   memset( chunk.m_buffer.m_buffer.get(), 0x5A, bufSize );
+
+   std::vector<std::string> rawNames;
+   std::vector<std::string> chunkNames;
+   for( int i = 0; i < count; i++ ) {
+      char name[64];
+      snprintf( name, sizeof(name), "raw_%d.bin", i );
+      rawNames.push_back( path + name );
+      snprintf( name, sizeof(name), "chunk_%d.agt", i );
+      chunkNames.push_back( path + name );
+   }
+
+   printf("%d chunks of %lu bytes in %s\n\n", count, (unsigned long)bufSize, path.c_str());
+
+   printResult( "raw write",   writeRaw( chunk, rawNames ));
+   printResult( "chunk write", writeChunk( chunk, chunkNames ));
+   printResult( "raw read",    readRaw( rawNames ));
+   printResult( "chunk read",  readChunk( chunkNames ));
+
+   for( int i = 0; i < count; i++ ) {
+      unlink( rawNames[i].c_str());
+      unlink( chunkNames[i].c_str());
+   }
+
+   return 0;
+}
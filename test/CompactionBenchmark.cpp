@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ATimer.h>
+#include <BaseContainer.h>
+
+int      count   = 2000;
+uint64_t bufSize = 262144;     //256KB payload
+double   slice   = 0.001;      //Time slice of one incremental compaction call
+
+/**
+ * \brief Fills an arena container and erases every other chunk
+ **/
+bool fillContainer( atl::BaseContainer &container )
+{
+   if( !container.reserveArena( count * atl::BaseContainer::getRecordSize( 5, bufSize ))) {
+      return false;
+   }
+
+   for( int i = 0; i < count; i++ ) {
+      atl::BaseChunk chunk( i );
+      chunk.m_metadata.m_type = "frame";
+      if( !container.allocateChunk( chunk, bufSize )) {
+         return false;
+      }
+      memset( chunk.m_buffer.m_buffer.get(), i, bufSize );
+      container.push_back( chunk );
+   }
+
+   for( int i = 0; i < count / 2; i++ ) {
+      container.erase( i );
+   }
+
+   return true;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares full and incremental compaction of an arena container.\n");
+   printf("\nUsage:\n");
+   printf("\t-n number of chunks before removal (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-t time slice of an incremental call in seconds (%.4lf)\n", slice );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nCompaction benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         slice = atof(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   atl::BaseContainer full;
+   atl::BaseContainer incremental;
+   if(( !fillContainer( full ))||( !fillContainer( incremental ))) {
+      printf("Unable to fill the containers\n");
+      return 1;
+   }
+   printf("%d chunks of %lu bytes, %.1lf MB garbage after removing half\n\n"
+         , count
+         , (unsigned long)bufSize
+         , (double)full.getArenaGarbage() / 1e6
+         );
+
+   atl::Timer timer;
+   timer.start();
+   bool rc = full.compact();
+   double fullTime = timer.elapsed();
+
+   atl::Timer total;
+   int    calls    = 0;
+   double maxPause = 0;
+   total.start();
+   for( bool done = false; ( rc )&&( !done ); calls++ ) {
+      timer.start();
+      done = incremental.compact( slice );
+      double pause = timer.elapsed();
+      if( pause > maxPause ) {
+         maxPause = pause;
+      }
+   }
+   double incrementalTime = total.elapsed();
+
+   if(( !rc )||( full.getArenaGarbage() != 0 )||( incremental.getArenaGarbage() != 0 )) {
+      printf("Compaction failed\n");
+      return 1;
+   }
+
+   printf("full         %10.3lf ms pause\n", fullTime * 1e3 );
+   printf("incremental  %10.3lf ms max pause, %d calls, %.3lf ms total\n", maxPause * 1e3, calls, incrementalTime * 1e3 );
+   printf("\n%.1lf MB arena in use after compaction\n", (double)incremental.m_arenaUsed / 1e6 );
+
+   return 0;
+}
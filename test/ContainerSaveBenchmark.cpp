@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include <ATimer.h>
+#include <AThreadPool.h>
+#include <BaseContainer.h>
+
+std::string path       = "./";
+int         count      = 1000;
+uint64_t    bufSize    = 1048576;   //1MB payload
+size_t      maxThreads = std::thread::hardware_concurrency();
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, size_t threads, double seconds )
+{
+   if( seconds < 0 ) {
+      printf("%-14s %3lu threads failed\n", name, (unsigned long)threads );
+      return;
+   }
+
+   printf("%-14s %3lu threads %10.3lf s %10.1lf MB/s\n"
+         , name
+         , (unsigned long)threads
+         , seconds
+         , (double)bufSize * count / seconds / 1e6
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures BaseContainer save and load throughput with an increasing number of workers.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of chunks in the container (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-t maximum number of worker threads (%lu)\n", (unsigned long)maxThreads );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nContainer save benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         maxThreads = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+   if( maxThreads == 0 ) {
+      maxThreads = 1;
+   }
+
+   atl::BaseContainer container;
+   for( int i = 0; i < count; i++ ) {
+      atl::BaseChunk chunk( i );
+      chunk.m_metadata.m_type = "image";
+      chunk.allocate( bufSize );
+      memset( chunk.m_buffer.m_buffer.get(), i, bufSize );
+      container.push_back( chunk );
+   }
+
+   std::string filename = path + "container_benchmark.agc";
+   printf("%d chunks of %lu bytes in %s\n\n", count, (unsigned long)bufSize, path.c_str());
+
+   atl::Timer timer;
+   timer.start();
+   bool rc = container.save( filename );
+   printResult( "save", 1, rc ? timer.elapsed() : -1 );
+
+   for( size_t threads = 1; threads <= maxThreads; threads *= 2 ) {
+      atl::AThreadPool pool( threads );
+
+      timer.start();
+      rc = container.save( filename, pool );
+      printResult( "parallel save", threads, rc ? timer.elapsed() : -1 );
+
+      atl::BaseContainer loaded;
+      timer.start();
+      rc = loaded.load( filename, pool );
+      printResult( "parallel load", threads, rc ? timer.elapsed() : -1 );
+   }
+
+   unlink( filename.c_str());
+
+   return 0;
+}
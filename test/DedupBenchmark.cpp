@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <ATimer.h>
+#include <Checksum.h>
+#include <BaseContainer.h>
+
+std::string path     = "./";
+int         count    = 500;
+uint64_t    bufSize  = 1048576;   //1MB payload
+double      repeated = 0.75;      //Fraction of chunks that repeat the static frame
+
+/**
+ * \brief Saves the container, syncs it and returns the elapsed time
+ **/
+double saveContainer( atl::BaseContainer &container, std::string filename, atl::ChunkDeduplicator * dedup, uint64_t * fileSize )
+{
+   atl::Timer timer;
+   timer.start();
+
+   bool rc = container.save( filename, dedup );
+   int fd = open( filename.c_str(), O_RDONLY );
+   rc = rc && ( fd >= 0 )&&( fdatasync( fd ) == 0 );
+
+   struct stat info;
+   if(( rc )&&( fstat( fd, &info ) == 0 )) {
+      *fileSize = info.st_size;
+   }
+   close( fd );
+
+   return rc ? timer.elapsed() : -1;
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds, uint64_t fileSize )
+{
+   if( seconds < 0 ) {
+      printf("%-8s failed\n", name );
+      return;
+   }
+
+   printf("%-8s %10.3lf s %10.1lf MB/s logical %10.1lf MB written\n"
+         , name
+         , seconds
+         , (double)bufSize * count / seconds / 1e6
+         , (double)fileSize / 1e6
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares container saves with and without payload deduplication.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of chunks in the container (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-r fraction of chunks that repeat a static frame (%.2lf)\n", repeated );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nDedup benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-r" ))&&( i+1 < argc )) {
+         i++;
+         repeated = atof(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   //Repeated chunks hold separate copies of the static frame, as a capture would
+   atl::BaseContainer container;
+   for( int i = 0; i < count; i++ ) {
+      atl::BaseChunk chunk( i );
+      chunk.m_metadata.m_type = "frame";
+      chunk.allocate( bufSize );
+      bool isStatic = ( i % 100 ) < repeated * 100;
+      memset( chunk.m_buffer.m_buffer.get(), isStatic ? 0x42 : i, bufSize );
+      if( !isStatic ) {
+         memcpy( chunk.m_buffer.m_buffer.get(), &i, sizeof(i));
+      }
+      container.push_back( chunk );
+   }
+
+   std::string filename = path + "dedup_benchmark.agc";
+   printf("%d chunks of %lu bytes, %.0lf%% repeated, in %s\n\n", count, (unsigned long)bufSize, repeated * 100, path.c_str());
+
+   atl::BaseChunk first = container[0];
+   atl::Timer timer;
+   timer.start();
+   uint64_t hash = 0;
+   for( int i = 0; i < 10; i++ ) {
+      hash += atl::hash64( first.m_buffer.m_buffer.get(), bufSize );
+   }
+   double hashTime = timer.elapsed();
+   printf("hash64   %10.1lf MB/s (%016llx)\n\n", 10.0 * bufSize / hashTime / 1e6, (unsigned long long)hash );
+
+   uint64_t fileSize = 0;
+   double seconds = saveContainer( container, filename, NULL, &fileSize );
+   printResult( "plain", seconds, fileSize );
+
+   atl::ChunkDeduplicator dedup;
+   seconds = saveContainer( container, filename, &dedup, &fileSize );
+   printResult( "dedup", seconds, fileSize );
+
+   atl::DedupStats stats = dedup.getStats();
+   printf("\n%lu of %lu chunks written as references, %.1lf MB of %.1lf MB payload saved\n"
+         , (unsigned long)stats.m_references
+         , (unsigned long)stats.m_chunks
+         , (double)stats.getSavedBytes() / 1e6
+         , (double)stats.m_payloadBytes / 1e6
+         );
+
+   unlink( filename.c_str());
+
+   return 0;
+}
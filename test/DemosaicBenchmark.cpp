@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <ATimer.h>
+#include <ImageContainer.h>
+
+int width      = 3840;
+int height     = 2160;
+int iterations = 10;
+int threads    = std::thread::hardware_concurrency();
+
+/**
+ * \brief Demosaics the image repeatedly and prints the throughput
+ **/
+template <typename T>
+bool runBenchmark( const char * name, uint16_t method, atl::AThreadPool &pool )
+{
+   atl::ImageMetadata metadata;
+   metadata.m_mode   = atl::APL_MODE_GRBG;
+   metadata.m_width  = width;
+   metadata.m_height = height;
+
+   atl::ExtendedBuffer<T> bayer( (size_t)width * height );
+   atl::ExtendedBuffer<T> rgb;
+   srand( 1 );
+   for( size_t i = 0; i < (size_t)width * height; i++ ) {
+      bayer[i] = (T)rand();
+   }
+
+   //The first pass allocates the output
+   if( !atl::demosaic( bayer, metadata, rgb, method, pool )) {
+      printf("%-22s failed\n", name );
+      return false;
+   }
+
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      atl::demosaic( bayer, metadata, rgb, method, pool );
+   }
+   double seconds = timer.elapsed();
+
+   double megapixels = (double)width * height * iterations / 1e6;
+   printf("%-22s %10.1lf MP/s %10.1lf MP/s per core %8.1lf fps\n"
+         , name
+         , megapixels / seconds
+         , megapixels / seconds / pool.getThreadCount()
+         , iterations / seconds
+         );
+   return true;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures Bayer to RGB conversion throughput.\n");
+   printf("\nUsage:\n");
+   printf("\t-w image width (%d)\n", width );
+   printf("\t-h image height (%d)\n", height );
+   printf("\t-i number of conversions per measurement (%d)\n", iterations );
+   printf("\t-t number of worker threads (%d)\n", threads );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nDemosaic benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-w" ))&&( i+1 < argc )) {
+         i++;
+         width = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-h" ))&&( i+1 < argc )) {
+         i++;
+         height = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-i" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         threads = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   if( threads < 1 ) {
+      threads = 1;
+   }
+   atl::AThreadPool pool( threads );
+   printf("%dx%d GRBG, %d conversions, %d threads\n\n", width, height, iterations, threads );
+
+   bool rc = runBenchmark<uint8_t>( "8-bit bilinear", atl::DEMOSAIC_BILINEAR, pool )
+          && runBenchmark<uint8_t>( "8-bit edge-aware", atl::DEMOSAIC_EDGE_AWARE, pool )
+          && runBenchmark<uint16_t>( "16-bit bilinear", atl::DEMOSAIC_BILINEAR, pool )
+          && runBenchmark<uint16_t>( "16-bit edge-aware", atl::DEMOSAIC_EDGE_AWARE, pool );
+
+   return rc ? 0 : 1;
+}
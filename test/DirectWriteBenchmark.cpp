@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ATimer.h>
+#include <DirectWriter.h>
+
+std::string path    = "./";
+int         count   = 256;
+uint64_t    bufSize = 4194304;   //4MB payload
+uint64_t    staging = DIRECTWRITER_DEFAULT_STAGING;
+
+/**
+ * \brief Streams the chunks through a DirectWriter and syncs the file
+ **/
+double writeStream( atl::BaseChunk &chunk, std::string filename, atl::DirectWriter::Mode mode, bool * direct )
+{
+   atl::DirectWriter writer;
+   if( !writer.open( filename, mode, staging )) {
+      return -1;
+   }
+   *direct = writer.isDirect();
+
+   atl::Timer timer;
+   timer.start();
+
+   bool rc = true;
+   for( int i = 0; ( rc )&&( i < count ); i++ ) {
+      chunk.m_metadata.m_id = i;
+      rc = writer.writeChunk( chunk );
+   }
+
+   //Include writeback of the buffered data in the measurement
+   rc = rc && writer.flush();
+   int fd = open( filename.c_str(), O_RDONLY );
+   rc = rc && ( fd >= 0 )&&( fdatasync( fd ) == 0 );
+   close( fd );
+
+   double elapsed = timer.elapsed();
+   rc = writer.close() && rc;
+
+   return rc ? elapsed : -1;
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds, bool direct )
+{
+   if( seconds < 0 ) {
+      printf("%-10s failed\n", name );
+      return;
+   }
+
+   printf("%-10s %10.3lf s %10.1lf MB/s%s\n"
+         , name
+         , seconds
+         , (double)bufSize * count / seconds / 1e6
+         , direct ? "" : "  (buffered I/O)"
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares buffered and O_DIRECT streaming of chunks with DirectWriter.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of chunks to write (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-b staging buffer size (%lu)\n", (unsigned long)staging );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nDirect write benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-b" ))&&( i+1 < argc )) {
+         i++;
+         staging = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   atl::BaseChunk chunk;
+   chunk.m_metadata.m_type = "uint16";
+   chunk.m_metadata.m_elementSize  = 2;
+   chunk.m_metadata.m_elementCount = bufSize / 2;
+   chunk.allocate( bufSize );
+   memset( chunk.m_buffer.m_buffer.get(), 0x5A, bufSize );
+
+   std::string filename = path + "direct_write.bin";
+   printf("%d chunks of %lu bytes in %s\n\n", count, (unsigned long)bufSize, path.c_str());
+
+   bool direct = false;
+   double seconds = writeStream( chunk, filename, atl::DirectWriter::BUFFERED, &direct );
+   printResult( "buffered", seconds, true );
+   seconds = writeStream( chunk, filename, atl::DirectWriter::DIRECT, &direct );
+   printResult( "direct", seconds, direct );
+
+   unlink( filename.c_str());
+
+   return 0;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ATimer.h>
+#include <ContainerJournal.h>
+
+std::string path       = "./";
+int         count      = 200;       //Chunks per producer
+int         threads    = 8;
+uint64_t    bufSize    = 4096;
+uint64_t    batchBytes = CONTAINERJOURNAL_DEFAULT_BATCH;
+double      maxDelay   = 0;
+
+/**
+ * \brief Writes every chunk with BaseChunk::write followed by its own fdatasync
+ **/
+double writeSyncPerChunk( atl::BaseChunk &chunk, std::string filename )
+{
+   int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+   if( fd < 0 ) {
+      fprintf( stderr, "Unable to open %s\n", filename.c_str());
+      return -1;
+   }
+
+   atl::Timer timer;
+   timer.start();
+
+   for( int i = 0; i < count * threads; i++ ) {
+      if(( !chunk.write( fd ))||( fdatasync( fd ) != 0 )) {
+         fprintf( stderr, "Unable to write %s\n", filename.c_str());
+         close( fd );
+         return -1;
+      }
+   }
+
+   double elapsed = timer.elapsed();
+   close( fd );
+   return elapsed;
+}
+
+/**
+ * \brief Appends the chunks to a journal from several producer threads
+ **/
+double writeJournal( atl::BaseChunk &chunk, std::string filename, uint64_t * commits )
+{
+   unlink( filename.c_str());
+
+   atl::ContainerJournal journal;
+   if( !journal.open( filename, batchBytes, maxDelay )) {
+      return -1;
+   }
+
+   atl::Timer timer;
+   timer.start();
+
+   std::vector<std::thread> producers;
+   std::vector<int>         results( threads, 1 );
+   for( int t = 0; t < threads; t++ ) {
+      producers.push_back( std::thread( [&journal, &chunk, &results, t]() {
+         for( int i = 0; i < count; i++ ) {
+            if( !journal.append( chunk )) {
+               results[t] = 0;
+               return;
+            }
+         }
+      }));
+   }
+
+   bool rc = true;
+   for( int t = 0; t < threads; t++ ) {
+      producers[t].join();
+      rc = rc && results[t];
+   }
+
+   double elapsed = timer.elapsed();
+   *commits = journal.getCommitCount();
+   journal.close();
+
+   return rc ? elapsed : -1;
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds, uint64_t commits )
+{
+   if( seconds < 0 ) {
+      printf("%-16s failed\n", name );
+      return;
+   }
+
+   int chunks = count * threads;
+   printf("%-16s %10.3lf s %10.0lf chunks/s %10.1lf MB/s %8lu syncs\n"
+         , name
+         , seconds
+         , chunks / seconds
+         , (double)bufSize * chunks / seconds / 1e6
+         , (unsigned long)commits
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares group-commit journaling (ContainerJournal) with one fdatasync per chunk.\n");
+   printf("\nUsage:\n");
+   printf("\t-d destination directory (%s)\n", path.c_str());
+   printf("\t-n number of chunks per producer (%d)\n", count );
+   printf("\t-t number of producer threads (%d)\n", threads );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-b maximum bytes per commit (%lu)\n", (unsigned long)batchBytes );
+   printf("\t-l maximum commit delay in seconds (%lf)\n", maxDelay );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nJournal benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         threads = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-b" ))&&( i+1 < argc )) {
+         i++;
+         batchBytes = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-l" ))&&( i+1 < argc )) {
+         i++;
+         maxDelay = atof(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   atl::BaseChunk chunk(1);
+   chunk.m_metadata.m_type = "uint8";
+   chunk.m_metadata.m_elementSize  = 1;
+   chunk.m_metadata.m_elementCount = bufSize;
+   chunk.allocate( bufSize );
+   memset( chunk.m_buffer.m_buffer.get(), 0x5A, bufSize );
+
+   std::string syncName    = path + "sync_per_chunk.agt";
+   std::string journalName = path + "journal.agj";
+
+   printf("%d producers x %d chunks of %lu bytes in %s\n\n", threads, count, (unsigned long)bufSize, path.c_str());
+
+   uint64_t commits = 0;
+   printResult( "fsync per chunk", writeSyncPerChunk( chunk, syncName ), count * threads );
+   double seconds = writeJournal( chunk, journalName, &commits );
+   printResult( "group commit", seconds, commits );
+
+   unlink( syncName.c_str());
+   unlink( journalName.c_str());
+
+   return 0;
+}
@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <ATimer.h>
+#include <ImageMetadata.h>
+
+int count      = 10000000;
+int iterations = 5;
+
+/**
+ * \brief Returns the encoded size by comparing the type string
+ **/
+size_t getSizeByString( const atl::BaseChunkMetadata &metadata, size_t typeLength )
+{
+   if( metadata.m_type == "image" ) {
+      return BASECONTAINERMETA_SIZE + IMAGEMETA_SIZE + typeLength;
+   }
+   if( metadata.m_type == "base" ) {
+      return BASECONTAINERMETA_SIZE + typeLength;
+   }
+   return 0;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares metadata dispatch by type string and by registered type id.\n");
+   printf("\nUsage:\n");
+   printf("\t-n number of metadata objects (%d)\n", count );
+   printf("\t-i number of passes (%d)\n", iterations );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nMetadata dispatch benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-i" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   //Interleave the types so the branch predictor cannot learn a pattern
+   std::vector<atl::BaseChunkMetadata> metadata( count );
+   srand( 1 );
+   for( int i = 0; i < count; i++ ) {
+      metadata[i].m_typeId = rand() & 1;
+      metadata[i].m_type   = atl::MetadataTypes::getName( metadata[i].m_typeId );
+   }
+   printf("%d metadata objects, %d passes\n\n", count, iterations );
+
+   atl::Timer timer;
+   uint64_t   total = 0;
+   timer.start();
+   for( int pass = 0; pass < iterations; pass++ ) {
+      for( int i = 0; i < count; i++ ) {
+         total += getSizeByString( metadata[i], 8 );
+      }
+   }
+   double stringTime = timer.elapsed();
+
+   uint64_t check = 0;
+   timer.start();
+   for( int pass = 0; pass < iterations; pass++ ) {
+      for( int i = 0; i < count; i++ ) {
+         check += atl::MetadataTypes::getEncodedSize( metadata[i].m_typeId, 8 );
+      }
+   }
+   double idTime = timer.elapsed();
+
+   double calls = (double)count * iterations;
+   printf("string compare %8.2lf ns/object\n", stringTime / calls * 1e9 );
+   printf("type id table  %8.2lf ns/object\n", idTime / calls * 1e9 );
+   if( check != total ) {
+      printf("\nResults differ: %llu != %llu\n", (unsigned long long)check, (unsigned long long)total );
+      return 1;
+   }
+
+   return 0;
+}
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <ATimer.h>
+#include <ImageMetadata.h>
+
+int    iterations = 1000000;
+size_t frames     = 1024;
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, double seconds, uint64_t check )
+{
+   printf("%-22s %10.3lf s %12.0lf per second   (check %lu)\n"
+         , name
+         , seconds
+         , iterations / seconds
+         , (unsigned long)check
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures metadata JSON generation and parsing rates for ImageMetadata.\n");
+   printf("\nUsage:\n");
+   printf("\t-n number of operations per test (%d)\n", iterations );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nMetadata JSON benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   //Build a set of per-frame metadata strings
+   std::vector<atl::ImageMetadata> metadata( frames );
+   std::vector<std::string>        json( frames );
+   for( size_t i = 0; i < frames; i++ ) {
+      metadata[i].m_id          = 1000000 + i;
+      metadata[i].m_offset      = i * 4194304;
+      metadata[i].m_elementSize = 2;
+      metadata[i].m_mode        = 1;
+      metadata[i].m_width       = 1920 + i % 64;
+      metadata[i].m_height      = 1080;
+      metadata[i].m_bpp         = 16;
+      json[i] = metadata[i].getJsonString();
+   }
+
+   atl::Timer timer;
+   uint64_t   check = 0;
+
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      check += metadata[i % frames].getJsonString().length();
+   }
+   printResult( "getJsonString", timer.elapsed(), check );
+
+   char buffer[512];
+   atl::JsonWriter writer( buffer, sizeof(buffer));
+   check = 0;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      writer.reset();
+      metadata[i % frames].writeJson( writer );
+      check += writer.getLength();
+   }
+   printResult( "writeJson", timer.elapsed(), check );
+
+   atl::ImageMetadata parsed;
+   check = 0;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      const std::string & text = json[i % frames];
+      if( !parsed.parseJson( text.data(), text.length())) {
+         printf("Parse failed: %s\n", text.c_str());
+         return 1;
+      }
+      check += parsed.m_width;
+   }
+   printResult( "parseJson", timer.elapsed(), check );
+
+   return 0;
+}
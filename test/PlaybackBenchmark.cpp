@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ATimer.h>
+#include <FileIO.h>
+#include <BaseContainer.h>
+#include <ContainerReader.h>
+#include <PlaybackReader.h>
+
+std::string path      = "./";
+int         count     = 200;
+uint64_t    bufSize   = 1048576;   //1MB payload
+double      fps       = 60;
+size_t      lookahead = PLAYBACKREADER_DEFAULT_LOOKAHEAD;
+
+/**
+ * \brief Syncs the file and asks the kernel to drop it from the page cache
+ **/
+bool dropCache( std::string filename )
+{
+   int fd = open( filename.c_str(), O_RDONLY );
+   if( fd < 0 ) {
+      return false;
+   }
+
+   bool rc = ( fdatasync( fd ) == 0 )&&( posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED ) == 0 );
+   close( fd );
+
+   return rc;
+}
+
+/**
+ * \brief Writes the container and removes it from the page cache
+ **/
+bool writeContainer( std::string filename )
+{
+   atl::BaseContainer container;
+   for( int i = 0; i < count; i++ ) {
+      atl::BaseChunk chunk( i );
+      chunk.m_metadata.m_type = "frame";
+      chunk.allocate( bufSize );
+      memset( chunk.m_buffer.m_buffer.get(), i, bufSize );
+      container.push_back( chunk );
+   }
+
+   if( !container.save( filename )) {
+      return false;
+   }
+
+   return dropCache( filename );
+}
+
+/**
+ * \brief Accumulates the wait time of one frame
+ **/
+void addWait( atl::PlaybackStats &stats, double wait )
+{
+   stats.m_chunks++;
+   stats.m_totalWait += wait;
+   if( wait > stats.m_maxWait ) {
+      stats.m_maxWait = wait;
+   }
+   if( wait > PLAYBACKREADER_STALL_TIME ) {
+      stats.m_stalls++;
+   }
+}
+
+/**
+ * \brief Sleeps until the given frame is due
+ **/
+void waitForFrame( std::chrono::steady_clock::time_point start, int frame )
+{
+   if( fps > 0 ) {
+      std::this_thread::sleep_until( start + std::chrono::duration<double>( frame / fps ));
+   }
+}
+
+/**
+ * \brief Plays the container with blocking reads of each record when its frame is due
+ **/
+bool playSynchronous( std::string filename, atl::PlaybackStats &stats )
+{
+   atl::ContainerReader reader;
+   int fd = open( filename.c_str(), O_RDONLY );
+   if(( fd < 0 )||( !reader.open( filename ))) {
+      close( fd );
+      return false;
+   }
+
+   atl::BaseBuffer record;
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   bool rc = true;
+   for( int i = 0; ( rc )&&( i < (int)reader.getChunkCount() ); i++ ) {
+      waitForFrame( start, i );
+
+      atl::ContainerIndexEntry entry;
+      reader.getEntry( i, entry );
+      if( record.getSize() < entry.m_size ) {
+         record.deallocate();
+         record.allocate( entry.m_size );
+      }
+
+      atl::Timer timer;
+      timer.start();
+      rc = atl::preadFully( fd, record.m_buffer.get(), entry.m_size, entry.m_offset );
+      addWait( stats, timer.elapsed());
+   }
+
+   close( fd );
+   return rc;
+}
+
+/**
+ * \brief Plays the container through a PlaybackReader
+ **/
+bool playPrefetched( std::string filename, atl::PlaybackStats &stats )
+{
+   atl::PlaybackReader reader;
+   if( !reader.open( filename, lookahead )) {
+      return false;
+   }
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   bool rc = true;
+   atl::BaseChunk chunk;
+   for( int i = 0; ( rc )&&( i < (int)reader.getChunkCount() ); i++ ) {
+      waitForFrame( start, i );
+      rc = reader.next( chunk );
+   }
+
+   stats = reader.getStats();
+   return rc;
+}
+
+/**
+ * \brief Prints one result line
+ **/
+void printResult( const char * name, bool rc, atl::PlaybackStats &stats )
+{
+   if(( !rc )||( stats.m_chunks == 0 )) {
+      printf("%-12s failed\n", name );
+      return;
+   }
+
+   printf("%-12s mean wait %9.3lf ms  max wait %9.3lf ms  stalls %6lu\n"
+         , name
+         , stats.m_totalWait / stats.m_chunks * 1e3
+         , stats.m_maxWait * 1e3
+         , (unsigned long)stats.m_stalls
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Compares per-frame wait times of blocking reads and PlaybackReader read-ahead.\n");
+   printf("\nUsage:\n");
+   printf("\t-d directory for the container file (%s)\n", path.c_str());
+   printf("\t-n number of chunks (%d)\n", count );
+   printf("\t-s payload size of each chunk (%lu)\n", (unsigned long)bufSize );
+   printf("\t-f playback rate in frames per second, 0 = as fast as possible (%.1lf)\n", fps );
+   printf("\t-l read-ahead depth in chunks (%lu)\n", (unsigned long)lookahead );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nPlayback benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-d"))&&( i+1 < argc )) {
+         i++;
+         path = argv[i];
+         if( path[path.length()-1] != '/' ) {
+            path.append("/");
+         }
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         count = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-s" ))&&( i+1 < argc )) {
+         i++;
+         bufSize = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-f" ))&&( i+1 < argc )) {
+         i++;
+         fps = atof(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-l" ))&&( i+1 < argc )) {
+         i++;
+         lookahead = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   std::string filename = path + "playback.bin";
+   printf("%d chunks of %lu bytes at %.1lf fps in %s\n\n", count, (unsigned long)bufSize, fps, path.c_str());
+
+   if( !writeContainer( filename )) {
+      printf("Unable to write %s\n", filename.c_str());
+      return 1;
+   }
+
+   atl::PlaybackStats stats;
+   bool rc = playSynchronous( filename, stats );
+   printResult( "synchronous", rc, stats );
+
+   dropCache( filename );
+   stats = atl::PlaybackStats();
+   rc = playPrefetched( filename, stats );
+   printResult( "prefetched", rc, stats );
+
+   unlink( filename.c_str());
+
+   return 0;
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <ATimer.h>
+#include <ImageContainer.h>
+
+int width      = 16384;
+int height     = 8192;
+int iterations = 5;
+int threads    = std::thread::hardware_concurrency();
+int region     = 512;
+
+/**
+ * \brief Builds and updates pyramids of an image and prints the throughput
+ **/
+bool runFilter( const char * name, atl::ImageContainer<uint8_t> &image, uint16_t filter, atl::AThreadPool &pool )
+{
+   atl::BaseContainer pyramid;
+   if( !image.buildPyramid( pyramid, filter, pool )) {
+      printf("%-10s failed\n", name );
+      return false;
+   }
+
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      image.buildPyramid( pyramid, filter, pool );
+   }
+   double build = timer.elapsed() / iterations;
+
+   //Regions spread over the image, as edits of a mosaic tile would be
+   int updates = 100;
+   size_t w = std::min( region, width );
+   size_t h = std::min( region, height );
+   timer.start();
+   for( int i = 0; i < updates; i++ ) {
+      size_t x = (size_t)rand() % ( width - w + 1 );
+      size_t y = (size_t)rand() % ( height - h + 1 );
+      image.updatePyramid( pyramid, x, y, w, h, pool );
+   }
+   double update = timer.elapsed() / updates;
+
+   printf("%-10s %3zu levels  build %8.2lf ms %10.1lf MP/s   %dx%d update %8.3lf ms\n"
+         , name
+         , pyramid.m_containerArray.getSize()
+         , build * 1e3
+         , (double)width * height / build / 1e6
+         , (int)w, (int)h
+         , update * 1e3
+         );
+   return true;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures image pyramid generation and region updates.\n");
+   printf("\nUsage:\n");
+   printf("\t-w image width (%d)\n", width );
+   printf("\t-h image height (%d)\n", height );
+   printf("\t-i number of builds per measurement (%d)\n", iterations );
+   printf("\t-r size of the updated region (%d)\n", region );
+   printf("\t-t number of worker threads (%d)\n", threads );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nImage pyramid benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-w" ))&&( i+1 < argc )) {
+         i++;
+         width = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-h" ))&&( i+1 < argc )) {
+         i++;
+         height = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-i" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-r" ))&&( i+1 < argc )) {
+         i++;
+         region = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         threads = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   if(( width < 1 )||( height < 1 )||( width > 65535 )||( height > 65535 )) {
+      printf("Image sizes must be between 1 and 65535\n");
+      return 1;
+   }
+   if( threads < 1 ) {
+      threads = 1;
+   }
+   atl::AThreadPool pool( threads );
+   printf("%dx%d RGB, %d builds, %d threads\n\n", width, height, iterations, threads );
+
+   atl::ImageContainer<uint8_t> image;
+   image.m_metadata.m_mode   = atl::APL_MODE_RGB;
+   image.m_metadata.m_width  = width;
+   image.m_metadata.m_height = height;
+   image.m_metadata.m_bpp    = 24;
+
+   size_t samples = (size_t)width * height * 3;
+   image.m_data.allocate( samples );
+   srand( 1 );
+   for( size_t i = 0; i < samples; i++ ) {
+      image.m_data[i] = (uint8_t)rand();
+   }
+
+   bool rc = runFilter( "box", image, atl::PYRAMID_BOX, pool )
+          && runFilter( "gaussian", image, atl::PYRAMID_GAUSSIAN, pool );
+
+   return rc ? 0 : 1;
+}
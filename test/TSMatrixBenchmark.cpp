@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <ATimer.h>
+#include <TSMatrix.tcc>
+
+using namespace std;
+
+size_t edge = 2048;         //Width and height of the matrix
+int    repeat = 3;          //Number of passes per traversal
+
+/**
+ * \brief Traverses the matrix one row at a time
+ **/
+template <typename Layout>
+double rowTraversal( atl::TSMatrix<float, Layout> &matrix )
+{
+   std::vector<size_t> coords(2);
+   float sum = 0;
+   float value = 0;
+   for( size_t y = 0; y < edge; y++ ) {
+      coords[0] = y;
+      for( size_t x = 0; x < edge; x++ ) {
+         coords[1] = x;
+         matrix.getItem( value, coords );
+         sum += value;
+      }
+   }
+   return sum;
+}
+
+/**
+ * \brief Traverses the matrix one column at a time
+ **/
+template <typename Layout>
+double columnTraversal( atl::TSMatrix<float, Layout> &matrix )
+{
+   std::vector<size_t> coords(2);
+   float sum = 0;
+   float value = 0;
+   for( size_t x = 0; x < edge; x++ ) {
+      coords[1] = x;
+      for( size_t y = 0; y < edge; y++ ) {
+         coords[0] = y;
+         matrix.getItem( value, coords );
+         sum += value;
+      }
+   }
+   return sum;
+}
+
+/**
+ * \brief Computes a 5-point stencil over the interior of the matrix
+ **/
+template <typename Layout>
+double stencilTraversal( atl::TSMatrix<float, Layout> &matrix )
+{
+   std::vector<size_t> coords(2);
+   float sum = 0;
+   float value = 0;
+   const int dy[5] = { 0, -1, 1, 0, 0 };
+   const int dx[5] = { 0, 0, 0, -1, 1 };
+   for( size_t y = 1; y < edge-1; y++ ) {
+      for( size_t x = 1; x < edge-1; x++ ) {
+         for( int k = 0; k < 5; k++ ) {
+            coords[0] = y + dy[k];
+            coords[1] = x + dx[k];
+            matrix.getItem( value, coords );
+            sum += value;
+         }
+      }
+   }
+   return sum;
+}
+
+/**
+ * \brief Runs the row, column and stencil benchmarks for one layout
+ *
+ * \param [in] name name of the layout to print
+ **/
+template <typename Layout>
+void runLayout( std::string name )
+{
+   atl::TSMatrix<float, Layout> matrix;
+   matrix.setDimensions( {edge, edge} );
+
+   std::vector<size_t> coords(2);
+   for( size_t y = 0; y < edge; y++ ) {
+      coords[0] = y;
+      for( size_t x = 0; x < edge; x++ ) {
+         coords[1] = x;
+         matrix.setItem( (float)((x+y)%7), coords );
+      }
+   }
+
+   double elements = (double)edge * (double)edge * repeat;
+   double check = 0;
+   atl::Timer timer;
+
+   timer.start();
+   for( int i = 0; i < repeat; i++ ) {
+      check += rowTraversal( matrix );
+   }
+   double rowTime = timer.elapsed();
+
+   timer.start();
+   for( int i = 0; i < repeat; i++ ) {
+      check += columnTraversal( matrix );
+   }
+   double columnTime = timer.elapsed();
+
+   timer.start();
+   for( int i = 0; i < repeat; i++ ) {
+      check += stencilTraversal( matrix );
+   }
+   double stencilTime = timer.elapsed();
+
+   printf("%-10s %12.2lf %12.2lf %12.2lf   (storage %zu, check %.0lf)\n"
+         , name.c_str()
+         , 1e9 * rowTime / elements
+         , 1e9 * columnTime / elements
+         , 1e9 * stencilTime / (elements*5)
+         , matrix.getSize()
+         , check
+         );
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures row, column and stencil traversal of a 2D TSMatrix for each memory layout.\n");
+   printf("\nUsage:\n");
+   printf("\t-s width and height of the matrix (%zu)\n", edge );
+   printf("\t-n number of passes per traversal (%d)\n", repeat );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nTSMatrix layout benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-s"))&&( i+1 < argc )) {
+         i++;
+         edge = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         repeat = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   printf("%zux%zu floats, %d passes. Times are ns per element access\n\n", edge, edge, repeat);
+   printf("%-10s %12s %12s %12s\n", "layout", "row", "column", "stencil");
+
+   runLayout<atl::RowMajorLayout>( "rowmajor" );
+   runLayout<atl::TiledLayout<32> >( "tiled32" );
+   runLayout<atl::MortonLayout>( "morton" );
+
+   return 0;
+}
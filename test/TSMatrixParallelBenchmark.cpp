@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <ATimer.h>
+#include <AThreadPool.h>
+#include <TSMatrixAlgorithms.tcc>
+
+using namespace std;
+
+size_t edge = 4096;         //Width and height of the matrix
+int    repeat = 5;          //Number of passes per measurement
+size_t maxThreads = 0;      //Largest pool size to test (0 = hardware threads)
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures the scaling of the parallel TSMatrix algorithms across thread counts.\n");
+   printf("\nUsage:\n");
+   printf("\t-s width and height of the matrix (%zu)\n", edge );
+   printf("\t-n number of passes per measurement (%d)\n", repeat );
+   printf("\t-t maximum number of threads (%zu = hardware threads)\n", maxThreads );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nTSMatrix parallel algorithm benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-s"))&&( i+1 < argc )) {
+         i++;
+         edge = atol(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-n" ))&&( i+1 < argc )) {
+         i++;
+         repeat = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         maxThreads = atol(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   if( maxThreads == 0 ) {
+      maxThreads = std::thread::hardware_concurrency();
+   }
+
+   typedef atl::TSMatrix<float> Matrix;
+   Matrix src;
+   Matrix dst;
+   src.setDimensions( {edge, edge} );
+   dst.setDimensions( {edge, edge} );
+   atl::TSMatrixView<Matrix> srcView( src );
+   atl::TSMatrixView<Matrix> dstView( dst );
+
+   std::vector<float> values( edge*edge );
+   for( size_t i = 0; i < values.size(); i++ ) {
+      values[i] = (float)(i % 1000);
+   }
+   srcView.copyIn( values.data(), values.size() );
+
+   double elements = (double)edge * (double)edge * repeat;
+   printf("%zux%zu floats, %d passes. Throughput in Melements/s (speedup vs 1 thread)\n\n", edge, edge, repeat);
+   printf("%8s %20s %20s %20s %20s\n", "threads", "forEach", "transform", "sum", "histogram");
+
+   //Powers of two up to the maximum thread count, plus the maximum itself
+   std::vector<size_t> threadCounts;
+   for( size_t threads = 1; threads < maxThreads; threads *= 2 ) {
+      threadCounts.push_back( threads );
+   }
+   threadCounts.push_back( maxThreads );
+
+   double base[4] = { 0, 0, 0, 0 };
+   double check = 0;
+   for( size_t t = 0; t < threadCounts.size(); t++ ) {
+      size_t threads = threadCounts[t];
+      atl::AThreadPool pool( threads );
+      atl::Timer timer;
+      double rate[4];
+
+      timer.start();
+      for( int i = 0; i < repeat; i++ ) {
+         atl::parallelForEach( dstView, []( float &v ) { v = v*0.5f + 1.0f; }, pool );
+      }
+      rate[0] = elements / timer.elapsed() / 1e6;
+
+      timer.start();
+      for( int i = 0; i < repeat; i++ ) {
+         atl::transform( srcView, dstView, []( float v ) { return v*v + 0.5f; }, pool );
+      }
+      rate[1] = elements / timer.elapsed() / 1e6;
+
+      timer.start();
+      for( int i = 0; i < repeat; i++ ) {
+         check += atl::parallelSum( srcView, pool );
+      }
+      rate[2] = elements / timer.elapsed() / 1e6;
+
+      timer.start();
+      for( int i = 0; i < repeat; i++ ) {
+         check += atl::parallelHistogram( srcView, 256, 0, 1000, pool )[0];
+      }
+      rate[3] = elements / timer.elapsed() / 1e6;
+
+      if( threads == 1 ) {
+         for( int k = 0; k < 4; k++ ) {
+            base[k] = rate[k];
+         }
+      }
+
+      printf("%8zu", threads );
+      for( int k = 0; k < 4; k++ ) {
+         printf(" %12.1lf (%5.2lfx)", rate[k], rate[k]/base[k] );
+      }
+      printf("\n");
+   }
+
+   printf("\ncheck %.0lf\n", check );
+   return 0;
+}
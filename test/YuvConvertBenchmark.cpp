@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <ATimer.h>
+#include <ImageContainer.h>
+
+int width      = 3840;
+int height     = 2160;
+int iterations = 20;
+int threads    = std::thread::hardware_concurrency();
+
+/**
+ * \brief Converts a frame between two modes repeatedly and prints the throughput
+ **/
+bool runConversion( const char * name, uint16_t from, uint16_t to, atl::AThreadPool &pool )
+{
+   atl::ImageMetadata metadata;
+   metadata.m_mode   = from;
+   metadata.m_width  = width;
+   metadata.m_height = height;
+
+   size_t samples = (size_t)width * height * ( atl::isYuvMode( from ) ? 2 : atl::getChannelCount( from ));
+   atl::ExtendedBuffer<uint8_t> source( samples );
+   atl::ExtendedBuffer<uint8_t> destination;
+   srand( 1 );
+   for( size_t i = 0; i < samples; i++ ) {
+      source[i] = (uint8_t)rand();
+   }
+
+   //The first pass allocates the output
+   if( !atl::convertYuv( source, metadata, destination, to, pool )) {
+      printf("%-28s failed\n", name );
+      return false;
+   }
+
+   atl::Timer timer;
+   timer.start();
+   for( int i = 0; i < iterations; i++ ) {
+      atl::convertYuv( source, metadata, destination, to, pool );
+   }
+   double seconds = timer.elapsed();
+
+   printf("%-28s %10.1lf MP/s %10.1lf fps %10.1lf fps per core\n"
+         , name
+         , (double)width * height * iterations / seconds / 1e6
+         , iterations / seconds
+         , iterations / seconds / pool.getThreadCount()
+         );
+   return true;
+}
+
+/**
+ * \brief prints the help
+ **/
+void printHelp() {
+   printf(" Measures YUV 4:2:2 conversion throughput.\n");
+   printf("\nUsage:\n");
+   printf("\t-w image width (%d)\n", width );
+   printf("\t-h image height (%d)\n", height );
+   printf("\t-i number of conversions per measurement (%d)\n", iterations );
+   printf("\t-t number of worker threads (%d)\n", threads );
+   printf("\n\n");
+}
+
+int main(int argc, char * argv[])
+{
+   printf("\nYUV conversion benchmark\n");
+
+   for( int i = 1; i < argc; i++ ) {
+      if(( !strcmp(argv[i], "-w" ))&&( i+1 < argc )) {
+         i++;
+         width = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-h" ))&&( i+1 < argc )) {
+         i++;
+         height = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-i" ))&&( i+1 < argc )) {
+         i++;
+         iterations = atoi(argv[i]);
+      }
+      else if(( !strcmp(argv[i], "-t" ))&&( i+1 < argc )) {
+         i++;
+         threads = atoi(argv[i]);
+      }
+      else {
+         printf("\nUnknown input parameter %d: %s\n", i, argv[i]);
+         printHelp();
+         exit(1);
+      }
+   }
+
+   if( threads < 1 ) {
+      threads = 1;
+   }
+   atl::AThreadPool pool( threads );
+   printf("%dx%d, %d conversions, %d threads\n\n", width, height, iterations, threads );
+
+   bool rc = runConversion( "YUV422 -> BGRA", atl::APL_MODE_YUV_422, atl::APL_MODE_BGRA, pool )
+          && runConversion( "YUV422 -> RGB", atl::APL_MODE_YUV_422, atl::APL_MODE_RGB, pool )
+          && runConversion( "BT601 YUV422 -> BGRA", atl::APL_MODE_BT601_YUV_422, atl::APL_MODE_BGRA, pool )
+          && runConversion( "BT601 YUV422 -> RGB", atl::APL_MODE_BT601_YUV_422, atl::APL_MODE_RGB, pool )
+          && runConversion( "BGRA -> YUV422", atl::APL_MODE_BGRA, atl::APL_MODE_YUV_422, pool )
+          && runConversion( "RGB -> BT601 YUV422", atl::APL_MODE_RGB, atl::APL_MODE_BT601_YUV_422, pool );
+
+   return rc ? 0 : 1;
+}